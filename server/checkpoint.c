@@ -0,0 +1,323 @@
+// Match checkpoints. Each loop owns one file, <stateDir>/loop-<index>.ckpt,
+// rewritten whole:
+//
+//   u32 magic | u32 version | u32 loop index | u32 match count
+//   per match: u32 slot | u32 version | u64 seed | snapshot (snapshot.h)
+//
+// A match is under 200 bytes, so one write and one fsync cover every match
+// on the loop however many there are. The loop only encodes the file into
+// memory and hands it over; one writer thread for the whole server does
+// the write, the fsync and the rename, so a slow disk never stalls a loop.
+// A loop that checkpoints again before the writer got to its last file
+// replaces it. The file is written under a temporary name, renamed over
+// the old one and the directory synced, so a crash at any point leaves the
+// previous checkpoint intact. Matches come back in their old slots, which
+// keeps their ids valid: players resume by joining again.
+//
+// With --record the same writer also writes each finished match's record
+// (record.h) as <recordDir>/<finish time in ms>-<match id>.record. Those
+// are renamed into place but not synced: losing the last few to a crash
+// is fine, a half-written one is not.
+#define _GNU_SOURCE
+#include "server.h"
+#include "snapshot.h"
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CHECKPOINT_MAGIC   0x504B4352u  // "RCKP"
+#define CHECKPOINT_VERSION 1u
+
+enum {
+    CHECKPOINT_HEADER_SIZE = 16,
+    CHECKPOINT_RECORD_SIZE = 16 + SNAPSHOT_MAX_SIZE  // upper bound per match
+};
+
+static void CheckpointPath(const Loop* loop, char* out, size_t size)
+{
+    snprintf(out, size, "%s/loop-%d.ckpt", loop->server->cfg.stateDir, loop->index);
+}
+
+// dir is synced too unless it is NULL
+static bool WriteFile(const char* dir, const char* path, const uint8_t* data, int len)
+{
+    char tmpPath[4096];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath)) return false;
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = true;
+    for (int off = 0; ok && off < len; ) {
+        ssize_t n = write(fd, data + off, (size_t)(len - off));
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) off += (int)n;
+    }
+    ok = ok && (dir == NULL || fsync(fd) == 0);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        unlink(tmpPath);
+        return false;
+    }
+    if (dir == NULL) return true;
+
+    // The rename is only durable once the directory entry is
+    int dirFd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) return false;
+    ok = fsync(dirFd) == 0;
+    close(dirFd);
+    return ok;
+}
+
+static bool Reserve(uint8_t** buf, int* cap, int need)
+{
+    if (need <= *cap) return true;
+    uint8_t* grown = realloc(*buf, (size_t)need);
+    if (grown == NULL) return false;
+    *buf = grown;
+    *cap = need;
+    return true;
+}
+
+bool CheckpointSnapshot(Loop* loop)
+{
+    int live = 0;
+    for (int i = 0; i < loop->matchCount; ++i) live += loop->matches[i].used;
+    if (!Reserve(&loop->checkpointBuf, &loop->checkpointCap, CHECKPOINT_HEADER_SIZE + live * CHECKPOINT_RECORD_SIZE)) {
+        return false;
+    }
+
+    ProtoWriter w;
+    ProtoWriterInit(&w, loop->checkpointBuf, loop->checkpointCap);
+    ProtoPutU32(&w, CHECKPOINT_MAGIC);
+    ProtoPutU32(&w, CHECKPOINT_VERSION);
+    ProtoPutU32(&w, (uint32_t)loop->index);
+    ProtoPutU32(&w, (uint32_t)live);
+    for (int i = 0; i < loop->matchCount; ++i) {
+        const Match* m = &loop->matches[i];
+        if (!m->used) continue;
+        ProtoPutU32(&w, (uint32_t)i);
+        ProtoPutU32(&w, m->version);
+        ProtoPutU64(&w, m->seed);
+        int n = SnapshotEncode(&m->state, w.buf + w.len, w.cap - w.len);
+        if (n == 0) return false;
+        w.len += n;
+    }
+
+    // Swap buffers with the writer's slot; an unwritten older file is dropped
+    Server* server = loop->server;
+    pthread_mutex_lock(&server->checkpointLock);
+    uint8_t* buf = loop->persistBuf;
+    int cap = loop->persistCap;
+    loop->persistBuf = loop->checkpointBuf;
+    loop->persistCap = loop->checkpointCap;
+    loop->persistLen = w.len;
+    loop->persistPending = true;
+    loop->checkpointBuf = buf;
+    loop->checkpointCap = cap;
+    pthread_cond_signal(&server->checkpointWake);
+    pthread_mutex_unlock(&server->checkpointLock);
+    loop->dirty = false;
+    return true;
+}
+
+void CheckpointRecord(Loop* loop, int slot)
+{
+    Match* m = &loop->matches[slot];
+    Server* server = loop->server;
+    if (!m->recording) return;
+    m->recording = false;
+
+    int cap = RecordTextSize(m->record.count);
+    PendingRecord* p = malloc(sizeof(PendingRecord) + (size_t)cap);
+    if (p == NULL) {
+        RecordFree(&m->record);
+        atomic_fetch_add(&server->recordsDropped, 1);
+        return;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t ms = (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+    uint32_t id = ((uint32_t)slot << MATCH_ID_LOOP_BITS) | (uint32_t)loop->index;
+    snprintf(p->name, sizeof(p->name), "%llu-%u.record", (unsigned long long)ms, id);
+    p->len = RecordFormat(&m->record, p->text, cap);
+    p->next = NULL;
+    RecordFree(&m->record);
+
+    bool queued = false;
+    pthread_mutex_lock(&server->checkpointLock);
+    if (server->recordCount < SERVER_MAX_RECORDS) {
+        if (server->recordTail != NULL) server->recordTail->next = p;
+        else server->recordHead = p;
+        server->recordTail = p;
+        server->recordCount++;
+        queued = true;
+        pthread_cond_signal(&server->checkpointWake);
+    }
+    pthread_mutex_unlock(&server->checkpointLock);
+    if (!queued) {
+        free(p);
+        atomic_fetch_add(&server->recordsDropped, 1);
+    }
+}
+
+static void WriteRecord(Server* server, PendingRecord* p)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", server->cfg.recordDir, p->name);
+    TRACE_BEGIN("RecordWrite");
+    bool ok = WriteFile(NULL, path, (const uint8_t*)p->text, p->len);
+    TRACE_END("RecordWrite");
+    if (!ok) fprintf(stderr, "reefd: record %s failed: %s\n", path, strerror(errno));
+    free(p);
+}
+
+// Writes whatever the loops hand over until stopped, then what is left.
+// Checkpoints go first: they are what a restart resumes from.
+static void* WriterMain(void* arg)
+{
+    Server* server = arg;
+    TraceThreadName("checkpoint");
+    pthread_mutex_lock(&server->checkpointLock);
+    for (;;) {
+        Loop* loop = NULL;
+        for (int i = 0; i < server->loopCount && loop == NULL; ++i) {
+            if (server->loops[i].persistPending) loop = &server->loops[i];
+        }
+        if (loop == NULL && server->recordHead != NULL) {
+            PendingRecord* p = server->recordHead;
+            server->recordHead = p->next;
+            if (server->recordHead == NULL) server->recordTail = NULL;
+            server->recordCount--;
+            pthread_mutex_unlock(&server->checkpointLock);
+            WriteRecord(server, p);
+            pthread_mutex_lock(&server->checkpointLock);
+            continue;
+        }
+        if (loop == NULL) {
+            if (server->checkpointStop) break;
+            pthread_cond_wait(&server->checkpointWake, &server->checkpointLock);
+            continue;
+        }
+
+        uint8_t* buf = loop->writerBuf;
+        int cap = loop->writerCap;
+        int len = loop->persistLen;
+        loop->writerBuf = loop->persistBuf;
+        loop->writerCap = loop->persistCap;
+        loop->persistBuf = buf;
+        loop->persistCap = cap;
+        loop->persistPending = false;
+        pthread_mutex_unlock(&server->checkpointLock);
+
+        char path[4096];
+        CheckpointPath(loop, path, sizeof(path));
+        TRACE_BEGIN("CheckpointWrite");
+        bool ok = WriteFile(server->cfg.stateDir, path, loop->writerBuf, len);
+        TRACE_END("CheckpointWrite");
+        if (!ok) {
+            fprintf(stderr, "reefd: checkpoint %s failed: %s\n", path, strerror(errno));
+            atomic_store(&loop->persistFailed, true);
+        }
+        pthread_mutex_lock(&server->checkpointLock);
+    }
+    pthread_mutex_unlock(&server->checkpointLock);
+    return NULL;
+}
+
+bool CheckpointStart(Server* server)
+{
+    if (pthread_mutex_init(&server->checkpointLock, NULL) != 0) return false;
+    if (pthread_cond_init(&server->checkpointWake, NULL) != 0) {
+        pthread_mutex_destroy(&server->checkpointLock);
+        return false;
+    }
+    server->checkpointStop = false;
+    if (pthread_create(&server->checkpointThread, NULL, WriterMain, server) != 0) {
+        pthread_cond_destroy(&server->checkpointWake);
+        pthread_mutex_destroy(&server->checkpointLock);
+        return false;
+    }
+    return true;
+}
+
+void CheckpointStop(Server* server)
+{
+    pthread_mutex_lock(&server->checkpointLock);
+    server->checkpointStop = true;
+    pthread_cond_signal(&server->checkpointWake);
+    pthread_mutex_unlock(&server->checkpointLock);
+    pthread_join(server->checkpointThread, NULL);
+    pthread_cond_destroy(&server->checkpointWake);
+    pthread_mutex_destroy(&server->checkpointLock);
+}
+
+static uint8_t* ReadFile(const char* path, int* len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    uint8_t* data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size < INT32_MAX) {
+        data = malloc((size_t)st.st_size);
+        int off = 0;
+        while (data != NULL && off < st.st_size) {
+            ssize_t n = read(fd, data + off, (size_t)(st.st_size - off));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { free(data); data = NULL; break; }
+            off += (int)n;
+        }
+        *len = off;
+    } else {
+        errno = EINVAL;
+    }
+    close(fd);
+    return data;
+}
+
+int CheckpointRestore(Loop* loop)
+{
+    char path[4096];
+    CheckpointPath(loop, path, sizeof(path));
+    int len = 0;
+    uint8_t* data = ReadFile(path, &len);
+    if (data == NULL) return errno == ENOENT ? 0 : -1;
+
+    ProtoReader r;
+    ProtoReaderInit(&r, data, len);
+    uint32_t magic = ProtoGetU32(&r);
+    uint32_t version = ProtoGetU32(&r);
+    uint32_t index = ProtoGetU32(&r);
+    uint32_t count = ProtoGetU32(&r);
+    if (r.error || magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION || index != (uint32_t)loop->index) {
+        free(data);
+        return -1;
+    }
+
+    // A damaged record ends the restore; the matches before it are kept.
+    // Slots are checked here, before anything sizes the table from them.
+    int restored = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t slot = ProtoGetU32(&r);
+        uint32_t matchVersion = ProtoGetU32(&r);
+        uint64_t seed = ProtoGetU64(&r);
+        GameState g;
+        int used = 0;
+        SnapshotError err = r.error ? SNAPSHOT_ERR_TRUNCATED : SnapshotDecode(r.p, r.left, &g, &used);
+        if (err != SNAPSHOT_OK || slot >= (uint32_t)loop->maxMatches || !MatchRestore(loop, (int)slot, matchVersion, seed, &g)) {
+            fprintf(stderr, "reefd: %s: match %u of %u unusable (%s)\n", path, i + 1, count,
+                    err != SNAPSHOT_OK ? SnapshotErrorString(err) : "bad slot");
+            break;
+        }
+        ProtoGetBytes(&r, used);
+        restored++;
+    }
+    free(data);
+    return restored;
+}
@@ -0,0 +1,514 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include "rng.h"
+#include "trace.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <time.h>
+#include <unistd.h>
+
+// epoll user data: kind in the high word, connection slot in the low word
+enum {
+    TAG_WAKE   = 1,
+    TAG_LISTEN = 2,
+    TAG_CONN   = 3,
+
+    LOOP_MAX_EVENTS = 256,
+    LOOP_MAX_IOV    = 64
+};
+
+static uint64_t MakeTag(uint32_t kind, uint32_t slot)
+{
+    return ((uint64_t)kind << 32) | slot;
+}
+
+static uint64_t NowMs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+SharedBuf* SharedBufNew(const uint8_t* data, int len)
+{
+    SharedBuf* buf = malloc(sizeof(SharedBuf) + (size_t)len);
+    if (buf == NULL) return NULL;
+    buf->refs = 1;
+    buf->len = len;
+    memcpy(buf->data, data, (size_t)len);
+    return buf;
+}
+
+void SharedBufRelease(SharedBuf* buf)
+{
+    if (buf != NULL && --buf->refs == 0) free(buf);
+}
+
+static OutChunk* OutAt(Conn* conn, int i)
+{
+    return &conn->out[(conn->outHead + i) % conn->outCap];
+}
+
+static bool PushChunk(Conn* conn, SharedBuf* buf, int off)
+{
+    if (conn->outCount == conn->outCap) {
+        int newCap = conn->outCap ? conn->outCap * 2 : 8;
+        OutChunk* grown = malloc((size_t)newCap * sizeof(OutChunk));
+        if (grown == NULL) return false;
+        for (int i = 0; i < conn->outCount; ++i) grown[i] = *OutAt(conn, i);
+        free(conn->out);
+        conn->out = grown;
+        conn->outHead = 0;
+        conn->outCap = newCap;
+    }
+    conn->out[(conn->outHead + conn->outCount) % conn->outCap] = (OutChunk){ buf, off };
+    conn->outCount++;
+    conn->outBytes += buf->len - off;
+    return true;
+}
+
+static void FreeOutput(Conn* conn)
+{
+    for (int i = 0; i < conn->outCount; ++i) SharedBufRelease(OutAt(conn, i)->buf);
+    free(conn->out);
+    conn->out = NULL;
+    conn->outHead = conn->outCount = conn->outCap = conn->outBytes = 0;
+}
+
+// Reference counts are loop-local, so a connection leaving for another loop
+// must own every buffer it still has queued
+static bool PrivatizeOutput(Conn* conn)
+{
+    for (int i = 0; i < conn->outCount; ++i) {
+        OutChunk* c = OutAt(conn, i);
+        if (c->buf->refs == 1) continue;
+        SharedBuf* copy = SharedBufNew(c->buf->data + c->off, c->buf->len - c->off);
+        if (copy == NULL) return false;
+        SharedBufRelease(c->buf);
+        c->buf = copy;
+        c->off = 0;
+    }
+    return true;
+}
+
+static void DiscardConn(Conn* conn)
+{
+    close(conn->fd);
+    FreeOutput(conn);
+    free(conn);
+}
+
+bool LoopInit(Loop* loop, Server* server, int index)
+{
+    memset(loop, 0, sizeof(*loop));
+    loop->index = index;
+    loop->server = server;
+    loop->freeMatch = -1;
+    loop->maxMatches = server->cfg.maxMatchesPerLoop;
+    loop->rng = RngSeedFromTime() ^ ((uint64_t)index << 48);
+    pthread_mutex_init(&loop->inboxLock, NULL);
+
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->epfd < 0 || loop->wakeFd < 0) return false;
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.u64 = MakeTag(TAG_WAKE, 0) };
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakeFd, &ev) != 0) return false;
+
+    // Every loop waits on the shared listeners; EPOLLEXCLUSIVE wakes just one
+    for (int i = 0; i < server->listenCount; ++i) {
+        struct epoll_event lev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.u64 = MakeTag(TAG_LISTEN, (uint32_t)i) };
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, server->listenFds[i], &lev) != 0) return false;
+    }
+    return true;
+}
+
+void LoopDestroy(Loop* loop)
+{
+    for (int i = 0; i < loop->connCap; ++i) {
+        if (loop->conns[i]) LoopCloseConn(loop, i);
+    }
+    MatchFreeAll(loop);
+    for (int i = 0; i < loop->inboxLen; ++i) {
+        close(loop->inbox[i].conn.fd);
+        FreeOutput(&loop->inbox[i].conn);
+    }
+    free(loop->inbox);
+    free(loop->conns);
+    free(loop->checkpointBuf);
+    free(loop->persistBuf);
+    free(loop->writerBuf);
+    if (loop->epfd >= 0) close(loop->epfd);
+    if (loop->wakeFd >= 0) close(loop->wakeFd);
+    pthread_mutex_destroy(&loop->inboxLock);
+}
+
+void LoopWake(Loop* loop)
+{
+    uint64_t one = 1;
+    ssize_t n = write(loop->wakeFd, &one, sizeof(one));
+    (void)n; // counter saturation still leaves the fd readable
+}
+
+static int AddConn(Loop* loop, Conn* conn)
+{
+    int slot = -1;
+    for (int i = 0; i < loop->connCap; ++i) {
+        if (loop->conns[i] == NULL) { slot = i; break; }
+    }
+    if (slot < 0) {
+        int newCap = loop->connCap ? loop->connCap * 2 : 64;
+        Conn** grown = realloc(loop->conns, (size_t)newCap * sizeof(Conn*));
+        if (grown == NULL) return -1;
+        memset(grown + loop->connCap, 0, (size_t)(newCap - loop->connCap) * sizeof(Conn*));
+        slot = loop->connCap;
+        loop->conns = grown;
+        loop->connCap = newCap;
+    }
+
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.u64 = MakeTag(TAG_CONN, (uint32_t)slot) };
+    if (conn->outCount > 0) ev.events |= EPOLLOUT;
+    conn->wantWrite = (ev.events & EPOLLOUT) != 0;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, conn->fd, &ev) != 0) return -1;
+
+    loop->conns[slot] = conn;
+    return slot;
+}
+
+void LoopCloseConn(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn == NULL) return;
+    MatchDetachConn(loop, connSlot);
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    DiscardConn(conn);
+    loop->conns[connSlot] = NULL;
+}
+
+static void SetWriteInterest(Loop* loop, int connSlot, bool want)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn->wantWrite == want) return;
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0),
+                              .data.u64 = MakeTag(TAG_CONN, (uint32_t)connSlot) };
+    epoll_ctl(loop->epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+    conn->wantWrite = want;
+}
+
+// Drop a connection from this loop without closing the socket. Seats and
+// subscriptions here are released: the match keeps no slot for a
+// connection that now belongs to another loop.
+static Conn* DetachForHandoff(Loop* loop, int connSlot)
+{
+    MatchDetachConn(loop, connSlot);
+    Conn* conn = loop->conns[connSlot];
+    epoll_ctl(loop->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+    loop->conns[connSlot] = NULL;
+    if (!PrivatizeOutput(conn)) {
+        DiscardConn(conn);
+        return NULL;
+    }
+    return conn;
+}
+
+// Stop using a connection; the hangup event closes it from the loop
+static void MarkClosing(Conn* conn)
+{
+    conn->closing = true;
+    shutdown(conn->fd, SHUT_RDWR);
+}
+
+// Drop n sent bytes from the front of the output queue
+static void ConsumeOutput(Conn* conn, int n)
+{
+    conn->outBytes -= n;
+    while (n > 0) {
+        OutChunk* c = OutAt(conn, 0);
+        int left = c->buf->len - c->off;
+        if (n < left) { c->off += n; return; }
+        n -= left;
+        SharedBufRelease(c->buf);
+        conn->outHead = (conn->outHead + 1) % conn->outCap;
+        conn->outCount--;
+    }
+}
+
+static void FlushConn(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    while (conn->outCount > 0) {
+        struct iovec iov[LOOP_MAX_IOV];
+        int count = conn->outCount < LOOP_MAX_IOV ? conn->outCount : LOOP_MAX_IOV;
+        for (int i = 0; i < count; ++i) {
+            OutChunk* c = OutAt(conn, i);
+            iov[i].iov_base = c->buf->data + c->off;
+            iov[i].iov_len = (size_t)(c->buf->len - c->off);
+        }
+        struct msghdr msg = { .msg_iov = iov, .msg_iovlen = (size_t)count };
+        ssize_t n = sendmsg(conn->fd, &msg, MSG_NOSIGNAL);
+        if (n > 0) { ConsumeOutput(conn, (int)n); continue; }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        MarkClosing(conn);
+        return;
+    }
+    SetWriteInterest(loop, connSlot, conn->outCount > 0);
+
+    // A paused spectator can take more broadcast frames now
+    if (conn->outCount == 0 && conn->spectateSlot >= 0) MatchOnDrained(loop, connSlot);
+}
+
+// Write directly when nothing is queued, otherwise queue the unsent part.
+// shared is queued by reference; plain data is copied.
+static bool SendOrQueue(Loop* loop, int connSlot, const uint8_t* data, int len, SharedBuf* shared)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn == NULL || conn->closing) return false;
+
+    int off = 0;
+    if (conn->outCount == 0) {
+        ssize_t n = send(conn->fd, data, (size_t)len, MSG_NOSIGNAL);
+        if (n == len) return true;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            MarkClosing(conn);
+            return false;
+        }
+        if (n > 0) off = (int)n;
+    }
+
+    if (conn->outBytes + len - off > CONN_MAX_PENDING) {
+        MarkClosing(conn);  // slow consumer
+        return false;
+    }
+    SharedBuf* buf = shared;
+    if (shared == NULL) {
+        buf = SharedBufNew(data + off, len - off);
+        off = 0;
+        if (buf == NULL) { MarkClosing(conn); return false; }
+    }
+    if (!PushChunk(conn, buf, off)) {
+        if (shared == NULL) SharedBufRelease(buf);
+        MarkClosing(conn);
+        return false;
+    }
+    if (shared != NULL) shared->refs++;
+    SetWriteInterest(loop, connSlot, true);
+    return true;
+}
+
+bool LoopSend(Loop* loop, int connSlot, const uint8_t* data, int len)
+{
+    return SendOrQueue(loop, connSlot, data, len, NULL);
+}
+
+bool LoopSendShared(Loop* loop, int connSlot, SharedBuf* buf)
+{
+    return SendOrQueue(loop, connSlot, buf->data, buf->len, buf);
+}
+
+int LoopPendingBytes(const Loop* loop, int connSlot)
+{
+    return loop->conns[connSlot]->outBytes;
+}
+
+// Handle every complete frame in the read buffer. Returns false once the
+// connection has left this loop (closed or handed to another loop).
+static bool ProcessInput(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    while (!conn->closing) {
+        int frameLen = ProtoFrameLength(conn->rbuf, conn->rlen);
+        if (frameLen == 0) break;
+        if (frameLen < 0) { conn->closing = true; break; }
+
+        bool handedOff = false;
+        TRACE_BEGIN("MatchHandleFrame");
+        MatchHandleFrame(loop, connSlot, conn->rbuf + PROTO_HEADER_SIZE, frameLen - PROTO_HEADER_SIZE, &handedOff);
+        TRACE_END("MatchHandleFrame");
+        if (handedOff) return false; // frame stays queued for the owning loop
+
+        conn->rlen -= frameLen;
+        memmove(conn->rbuf, conn->rbuf + frameLen, (size_t)conn->rlen);
+    }
+    if (conn->closing) {
+        LoopCloseConn(loop, connSlot);
+        return false;
+    }
+    return true;
+}
+
+static void ReadConn(Loop* loop, int connSlot)
+{
+    while (true) {
+        Conn* conn = loop->conns[connSlot];
+        ssize_t n = read(conn->fd, conn->rbuf + conn->rlen, (size_t)(CONN_READ_BUF - conn->rlen));
+        if (n > 0) {
+            conn->rlen += (int)n;
+            if (!ProcessInput(loop, connSlot)) return;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        LoopCloseConn(loop, connSlot); // EOF or error
+        return;
+    }
+}
+
+void LoopHandoff(Loop* target, Conn* conn)
+{
+    pthread_mutex_lock(&target->inboxLock);
+    if (target->inboxLen == target->inboxCap) {
+        int newCap = target->inboxCap ? target->inboxCap * 2 : 16;
+        Handoff* grown = realloc(target->inbox, (size_t)newCap * sizeof(Handoff));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&target->inboxLock);
+            DiscardConn(conn);
+            return;
+        }
+        target->inbox = grown;
+        target->inboxCap = newCap;
+    }
+    target->inbox[target->inboxLen++].conn = *conn;
+    pthread_mutex_unlock(&target->inboxLock);
+    free(conn);
+    LoopWake(target);
+}
+
+// Called by match.c when a JOIN names a match pinned to another loop
+void LoopRequestHandoff(Loop* loop, int connSlot, int targetLoop, bool* handedOff)
+{
+    Conn* conn = DetachForHandoff(loop, connSlot);
+    if (conn != NULL) LoopHandoff(&loop->server->loops[targetLoop], conn);
+    *handedOff = true;
+}
+
+static void DrainInbox(Loop* loop)
+{
+    uint64_t count;
+    while (read(loop->wakeFd, &count, sizeof(count)) > 0) {}
+
+    pthread_mutex_lock(&loop->inboxLock);
+    Handoff* items = loop->inbox;
+    int n = loop->inboxLen;
+    loop->inbox = NULL;
+    loop->inboxLen = loop->inboxCap = 0;
+    pthread_mutex_unlock(&loop->inboxLock);
+
+    for (int i = 0; i < n; ++i) {
+        Conn* conn = malloc(sizeof(Conn));
+        if (conn == NULL) { close(items[i].conn.fd); FreeOutput(&items[i].conn); continue; }
+        *conn = items[i].conn;
+        conn->wantWrite = false;
+        int slot = AddConn(loop, conn);
+        if (slot < 0) { DiscardConn(conn); continue; }
+        ProcessInput(loop, slot);
+    }
+    free(items);
+}
+
+static void AcceptAll(Loop* loop, int listenFd)
+{
+    while (true) {
+        int fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: another loop took it, or backlog drained
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // no-op on Unix sockets
+
+        Conn* conn = calloc(1, sizeof(Conn));
+        if (conn == NULL) { close(fd); continue; }
+        conn->fd = fd;
+        conn->matchSlot = -1;
+        conn->spectateSlot = -1;
+        if (AddConn(loop, conn) < 0) {
+            close(fd);
+            free(conn);
+        }
+    }
+}
+
+void* LoopRun(void* arg)
+{
+    Loop* loop = arg;
+    Server* server = loop->server;
+    struct epoll_event events[LOOP_MAX_EVENTS];
+    bool checkpoints = server->cfg.stateDir != NULL;
+    char name[32];
+    snprintf(name, sizeof(name), "loop %d", loop->index);
+    TraceThreadName(name);
+    loop->nextCheckpointMs = NowMs() + (uint64_t)server->cfg.checkpointMs;
+    // Anything here now came from a checkpoint
+    if (loop->matchCount > 0) loop->resumeDeadlineMs = NowMs() + (uint64_t)server->cfg.resumeMs;
+
+    while (!atomic_load_explicit(&server->stopping, memory_order_acquire)) {
+        int timeout = -1;
+        if (checkpoints) {
+            uint64_t now = NowMs();
+            uint64_t due = loop->nextCheckpointMs;
+            if (loop->resumeDeadlineMs != 0 && loop->resumeDeadlineMs < due) due = loop->resumeDeadlineMs;
+            timeout = now >= due ? 0 : (int)(due - now);
+        }
+        int n = epoll_wait(loop->epfd, events, LOOP_MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("reefd: epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            uint32_t kind = (uint32_t)(events[i].data.u64 >> 32);
+            uint32_t slot = (uint32_t)events[i].data.u64;
+            uint32_t ev = events[i].events;
+
+            if (kind == TAG_WAKE) {
+                DrainInbox(loop);
+            } else if (kind == TAG_LISTEN) {
+                AcceptAll(loop, server->listenFds[slot]);
+            } else if (kind == TAG_CONN && (int)slot < loop->connCap && loop->conns[slot] != NULL) {
+                if (ev & (EPOLLERR | EPOLLHUP)) {
+                    LoopCloseConn(loop, (int)slot);
+                    continue;
+                }
+                if (ev & EPOLLOUT) {
+                    FlushConn(loop, (int)slot);
+                    if (loop->conns[slot]->closing) { LoopCloseConn(loop, (int)slot); continue; }
+                }
+                if (ev & (EPOLLIN | EPOLLRDHUP)) {
+                    ReadConn(loop, (int)slot);
+                }
+            }
+        }
+
+        if (loop->resumeDeadlineMs != 0 && NowMs() >= loop->resumeDeadlineMs) {
+            MatchReleaseRestored(loop);
+            loop->resumeDeadlineMs = 0;
+        }
+
+        // One file for every match changed since the last checkpoint, or
+        // again after a failed write; the writer thread persists it
+        if (checkpoints && NowMs() >= loop->nextCheckpointMs) {
+            if (atomic_exchange(&loop->persistFailed, false)) loop->dirty = true;
+            if (loop->dirty) {
+                TRACE_BEGIN("CheckpointSnapshot");
+                CheckpointSnapshot(loop);
+                TRACE_END("CheckpointSnapshot");
+            }
+            loop->nextCheckpointMs = NowMs() + (uint64_t)server->cfg.checkpointMs;
+        }
+    }
+
+    // Shutting down: the last moves are kept too
+    if (checkpoints && (loop->dirty || atomic_load(&loop->persistFailed))) CheckpointSnapshot(loop);
+    return NULL;
+}
@@ -0,0 +1,490 @@
+#include "server.h"
+#include "delta.h"
+#include "rng.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t MatchId(const Loop* loop, int slot)
+{
+    return ((uint32_t)slot << MATCH_ID_LOOP_BITS) | (uint32_t)loop->index;
+}
+
+// Make room for slots 0..count-1
+static bool GrowMatches(Loop* loop, int count)
+{
+    if (count > loop->maxMatches) return false;
+    if (count <= loop->matchCap) return true;
+    int newCap = loop->matchCap ? loop->matchCap * 2 : 256;
+    if (newCap < count) newCap = count;
+    if (newCap > loop->maxMatches) newCap = loop->maxMatches;
+    Match* grown = realloc(loop->matches, (size_t)newCap * sizeof(Match));
+    if (grown == NULL) return false;
+    loop->matches = grown;
+    loop->matchCap = newCap;
+    return true;
+}
+
+static void InitMatch(Match* m)
+{
+    memset(m, 0, sizeof(*m));
+    m->used = true;
+    m->nextFree = -1;
+    for (int i = 0; i < PLAYERS_MAX; ++i) m->seats[i] = -1;
+}
+
+static int AllocMatch(Loop* loop)
+{
+    int slot = loop->freeMatch;
+    if (slot >= 0) {
+        loop->freeMatch = loop->matches[slot].nextFree;
+    } else {
+        if (!GrowMatches(loop, loop->matchCount + 1)) return -1;
+        slot = loop->matchCount++;
+    }
+    InitMatch(&loop->matches[slot]);
+    loop->dirty = true;
+    return slot;
+}
+
+static void FreeBroadcast(Match* m)
+{
+    Broadcast* b = m->broadcast;
+    if (b == NULL) return;
+    SharedBufRelease(b->keyframe);
+    for (int i = 0; i < b->deltaCount; ++i) SharedBufRelease(b->deltas[i]);
+    free(b->spectators);
+    free(b);
+    m->broadcast = NULL;
+}
+
+static void FreeMatch(Loop* loop, int slot)
+{
+    Match* m = &loop->matches[slot];
+    FreeBroadcast(m);
+    RecordFree(&m->record);
+    m->used = false;
+    m->nextFree = loop->freeMatch;
+    loop->freeMatch = slot;
+    loop->dirty = true;
+}
+
+static Match* FindMatch(Loop* loop, uint32_t id)
+{
+    int slot = (int)(id >> MATCH_ID_LOOP_BITS);
+    if (slot >= loop->matchCount || !loop->matches[slot].used) return NULL;
+    return &loop->matches[slot];
+}
+
+static void SendError(Loop* loop, int connSlot, ProtoError code)
+{
+    uint8_t buf[8];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_ERROR);
+    ProtoPutU8(&w, (uint8_t)code);
+    ProtoEndFrame(&w);
+    LoopSend(loop, connSlot, buf, w.len);
+}
+
+static void SendJoined(Loop* loop, int connSlot, int matchSlot, uint8_t seat)
+{
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_JOINED);
+    ProtoPutU32(&w, MatchId(loop, matchSlot));
+    ProtoPutU8(&w, seat);
+    ProtoPutU64(&w, loop->matches[matchSlot].seed);
+    ProtoPutU8(&w, (uint8_t)loop->matches[matchSlot].state.playersCount);
+    ProtoEndFrame(&w);
+    LoopSend(loop, connSlot, buf, w.len);
+}
+
+// Seat conn in the match; seat may be PROTO_SEAT_ANY or PROTO_SEAT_ALL
+static bool SeatConn(Loop* loop, int connSlot, int matchSlot, uint8_t seat, uint8_t* seated)
+{
+    Match* m = &loop->matches[matchSlot];
+    int players = m->state.playersCount;
+
+    if (seat == PROTO_SEAT_ALL) {
+        for (int i = 0; i < players; ++i) {
+            if (m->seats[i] >= 0) return false;
+        }
+        for (int i = 0; i < players; ++i) m->seats[i] = connSlot;
+    } else {
+        if (seat == PROTO_SEAT_ANY) {
+            for (seat = 0; seat < players && m->seats[seat] >= 0; ++seat) {}
+        }
+        if (seat >= players || m->seats[seat] >= 0) return false;
+        m->seats[seat] = connSlot;
+    }
+
+    Conn* conn = loop->conns[connSlot];
+    conn->matchSlot = matchSlot;
+    conn->seat = seat;
+    *seated = seat;
+    return true;
+}
+
+static void HandleCreate(Loop* loop, int connSlot, ProtoReader* r)
+{
+    uint64_t seed = ProtoGetU64(r);
+    uint8_t seat = ProtoGetU8(r);
+    uint8_t players = ProtoGetU8(r);
+    if (r->error || players < PLAYERS_MIN || players > PLAYERS_MAX) { SendError(loop, connSlot, PROTO_ERR_MALFORMED); return; }
+    if (loop->conns[connSlot]->matchSlot >= 0) { SendError(loop, connSlot, PROTO_ERR_ALREADY_SEATED); return; }
+
+    int slot = AllocMatch(loop);
+    if (slot < 0) { SendError(loop, connSlot, PROTO_ERR_FULL); return; }
+
+    Match* m = &loop->matches[slot];
+    m->seed = seed ? seed : RngNext(&loop->rng);
+    RulesNewGame(&m->state, players, m->seed);
+    if (loop->server->cfg.recordDir != NULL) {
+        RecordInit(&m->record, m->seed, players);
+        m->recording = true;
+    }
+
+    uint8_t seated;
+    if (!SeatConn(loop, connSlot, slot, seat, &seated)) {
+        FreeMatch(loop, slot);
+        SendError(loop, connSlot, PROTO_ERR_SEAT_TAKEN);
+        return;
+    }
+    SendJoined(loop, connSlot, slot, seated);
+}
+
+static void HandleJoin(Loop* loop, int connSlot, ProtoReader* r, bool* handedOff)
+{
+    uint32_t id = ProtoGetU32(r);
+    uint8_t seat = ProtoGetU8(r);
+    if (r->error) { SendError(loop, connSlot, PROTO_ERR_MALFORMED); return; }
+    // A spectator LEAVEs first, as for SUBSCRIBE: its subscription lives on
+    // this loop and would be left behind by a handoff
+    Conn* conn = loop->conns[connSlot];
+    if (conn->matchSlot >= 0 || conn->spectateSlot >= 0) { SendError(loop, connSlot, PROTO_ERR_ALREADY_SEATED); return; }
+
+    // Matches never migrate; the connection moves to the owning loop instead
+    int owner = (int)(id & ((1u << MATCH_ID_LOOP_BITS) - 1));
+    if (owner != loop->index) {
+        if (owner >= loop->server->loopCount) { SendError(loop, connSlot, PROTO_ERR_NO_MATCH); return; }
+        LoopRequestHandoff(loop, connSlot, owner, handedOff);
+        return;
+    }
+
+    Match* m = FindMatch(loop, id);
+    if (m == NULL) { SendError(loop, connSlot, PROTO_ERR_NO_MATCH); return; }
+
+    int slot = (int)(m - loop->matches);
+    uint8_t seated;
+    if (!SeatConn(loop, connSlot, slot, seat, &seated)) { SendError(loop, connSlot, PROTO_ERR_SEAT_TAKEN); return; }
+    SendJoined(loop, connSlot, slot, seated);
+}
+
+// Encode one MSG_DELTA frame (or a keyframe when from is NULL)
+static SharedBuf* EncodeDelta(const GameState* from, const GameState* to, uint32_t baseVersion, uint32_t version)
+{
+    uint8_t buf[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_DELTA);
+    if (!DeltaEncode(&w, from, to, baseVersion, version) || !ProtoEndFrame(&w)) return NULL;
+    return SharedBufNew(buf, w.len);
+}
+
+// Start a new delta window with a keyframe at the current version
+static bool RotateKeyframe(Match* m)
+{
+    Broadcast* b = m->broadcast;
+    SharedBuf* key = EncodeDelta(NULL, &m->state, 0, m->version);
+    if (key == NULL) return false;
+    for (int i = 0; i < b->deltaCount; ++i) SharedBufRelease(b->deltas[i]);
+    b->deltaCount = 0;
+    SharedBufRelease(b->keyframe);
+    b->keyframe = key;
+    b->keyVersion = m->version;
+    return true;
+}
+
+static Broadcast* GetBroadcast(Match* m)
+{
+    if (m->broadcast != NULL) return m->broadcast;
+    Broadcast* b = calloc(1, sizeof(Broadcast));
+    if (b == NULL) return NULL;
+    b->prev = m->state;
+    m->broadcast = b;
+    if (!RotateKeyframe(m)) { FreeBroadcast(m); return NULL; }
+    return b;
+}
+
+// Queue frames until the spectator is at the current version or has too
+// much in flight. Cached frames are shared, never re-encoded.
+// latest is the delta into the current version, which may already have
+// rotated out of the window.
+static void SyncSpectator(Loop* loop, Match* m, int connSlot, SharedBuf* latest)
+{
+    Broadcast* b = m->broadcast;
+    Conn* conn = loop->conns[connSlot];
+    conn->stalled = false;
+
+    while (conn->sentVersion != m->version && !conn->closing) {
+        if (LoopPendingBytes(loop, connSlot) > SPECTATOR_MAX_BACKLOG ||
+            conn->sentVersion - conn->ackedVersion > SPECTATOR_MAX_UNACKED) {
+            conn->stalled = true;
+            return;
+        }
+
+        uint32_t v = conn->sentVersion;
+        if (latest != NULL && v == m->version - 1) {
+            LoopSendShared(loop, connSlot, latest);
+            conn->sentVersion = m->version;
+        } else if (v != PROTO_VERSION_NONE && v - b->keyVersion < (uint32_t)b->deltaCount) {
+            LoopSendShared(loop, connSlot, b->deltas[v - b->keyVersion]);
+            conn->sentVersion = v + 1;
+        } else if (v == b->keyVersion) {
+            // The window stopped short after a failed rotation; retry next version
+            conn->stalled = true;
+            return;
+        } else {
+            // Too far behind, or a fresh view: restart from the keyframe
+            LoopSendShared(loop, connSlot, b->keyframe);
+            conn->sentVersion = conn->ackedVersion = b->keyVersion;
+        }
+    }
+}
+
+// Called once per applied action: encode the delta once, then fan it out
+static void BroadcastVersion(Loop* loop, Match* m)
+{
+    Broadcast* b = m->broadcast;
+    SharedBuf* delta = EncodeDelta(&b->prev, &m->state, m->version - 1, m->version);
+    b->prev = m->state;
+
+    if (delta != NULL && b->deltaCount < BROADCAST_KEYFRAME_INTERVAL) {
+        b->deltas[b->deltaCount++] = delta;
+        delta->refs++;
+    } else {
+        RotateKeyframe(m);
+    }
+
+    for (int i = 0; i < b->spectatorCount; ++i) SyncSpectator(loop, m, b->spectators[i], delta);
+    SharedBufRelease(delta);
+}
+
+static void HandleSubscribe(Loop* loop, int connSlot, ProtoReader* r, bool* handedOff)
+{
+    uint32_t id = ProtoGetU32(r);
+    uint32_t known = ProtoGetU32(r);
+    if (r->error) { SendError(loop, connSlot, PROTO_ERR_MALFORMED); return; }
+    Conn* conn = loop->conns[connSlot];
+    if (conn->matchSlot >= 0 || conn->spectateSlot >= 0) { SendError(loop, connSlot, PROTO_ERR_ALREADY_SEATED); return; }
+
+    int owner = (int)(id & ((1u << MATCH_ID_LOOP_BITS) - 1));
+    if (owner != loop->index) {
+        if (owner >= loop->server->loopCount) { SendError(loop, connSlot, PROTO_ERR_NO_MATCH); return; }
+        LoopRequestHandoff(loop, connSlot, owner, handedOff);
+        return;
+    }
+
+    Match* m = FindMatch(loop, id);
+    if (m == NULL) { SendError(loop, connSlot, PROTO_ERR_NO_MATCH); return; }
+    Broadcast* b = GetBroadcast(m);
+    if (b == NULL) { SendError(loop, connSlot, PROTO_ERR_FULL); return; }
+
+    if (b->spectatorCount == b->spectatorCap) {
+        int newCap = b->spectatorCap ? b->spectatorCap * 2 : 8;
+        int32_t* grown = realloc(b->spectators, (size_t)newCap * sizeof(int32_t));
+        if (grown == NULL) { SendError(loop, connSlot, PROTO_ERR_FULL); return; }
+        b->spectators = grown;
+        b->spectatorCap = newCap;
+    }
+    b->spectators[b->spectatorCount++] = connSlot;
+
+    conn->spectateSlot = (int)(m - loop->matches);
+    conn->sentVersion = conn->ackedVersion = known;
+    SyncSpectator(loop, m, connSlot, NULL);
+}
+
+static void HandleAck(Loop* loop, int connSlot, ProtoReader* r)
+{
+    uint32_t version = ProtoGetU32(r);
+    if (r->error) { SendError(loop, connSlot, PROTO_ERR_MALFORMED); return; }
+    Conn* conn = loop->conns[connSlot];
+    if (conn->spectateSlot < 0) return;
+
+    // Only versions between the last ack and the last send move the window
+    if (version - conn->ackedVersion <= conn->sentVersion - conn->ackedVersion) conn->ackedVersion = version;
+    if (conn->stalled) SyncSpectator(loop, &loop->matches[conn->spectateSlot], connSlot, NULL);
+}
+
+static void HandleAction(Loop* loop, int connSlot, ProtoReader* r)
+{
+    uint32_t seq = ProtoGetU32(r);
+    Action a = ProtoGetAction(r);
+    if (r->error) { SendError(loop, connSlot, PROTO_ERR_MALFORMED); return; }
+
+    Conn* conn = loop->conns[connSlot];
+    if (conn->matchSlot < 0) { SendError(loop, connSlot, PROTO_ERR_NOT_SEATED); return; }
+
+    Match* m = &loop->matches[conn->matchSlot];
+    int mover = m->state.currentPlayer;
+    bool ok = m->seats[mover] == connSlot && RulesApply(&m->state, a);
+    if (ok) {
+        m->version++;
+        loop->actionsApplied++;
+        loop->dirty = true;
+        if (m->broadcast != NULL) BroadcastVersion(loop, m);
+        if (m->recording && !RecordAdd(&m->record, a)) {
+            RecordFree(&m->record);
+            m->recording = false;
+        }
+        if (m->state.gameEnded) CheckpointRecord(loop, conn->matchSlot);
+    }
+
+    uint8_t buf[64];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_RESULT);
+    ProtoPutU32(&w, seq);
+    ProtoPutU8(&w, ok ? 1 : 0);
+    ProtoPutU32(&w, m->version);
+    ProtoEndFrame(&w);
+    LoopSend(loop, connSlot, buf, w.len);
+    if (!ok) return;
+
+    // Tell the other seated connections what happened
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_EVENT);
+    ProtoPutU32(&w, m->version);
+    ProtoPutU8(&w, (uint8_t)mover);
+    ProtoPutAction(&w, a);
+    ProtoEndFrame(&w);
+    for (int i = 0; i < m->state.playersCount; ++i) {
+        int other = m->seats[i];
+        bool seen = false;
+        for (int j = 0; j < i; ++j) seen = seen || m->seats[j] == other;
+        if (other >= 0 && other != connSlot && !seen) LoopSend(loop, other, buf, w.len);
+    }
+}
+
+static void HandleStateRequest(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn->matchSlot < 0) { SendError(loop, connSlot, PROTO_ERR_NOT_SEATED); return; }
+
+    const Match* m = &loop->matches[conn->matchSlot];
+    uint8_t buf[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_STATE);
+    ProtoPutU32(&w, m->version);
+    ProtoPutBytes(&w, &m->state, (int)sizeof(GameState));
+    if (ProtoEndFrame(&w)) LoopSend(loop, connSlot, buf, w.len);
+}
+
+void MatchHandleFrame(Loop* loop, int connSlot, const uint8_t* body, int len, bool* handedOff)
+{
+    ProtoReader r;
+    ProtoReaderInit(&r, body + 1, len - 1);
+
+    switch (body[0]) {
+        case MSG_CREATE:    HandleCreate(loop, connSlot, &r); break;
+        case MSG_JOIN:      HandleJoin(loop, connSlot, &r, handedOff); break;
+        case MSG_ACTION:    HandleAction(loop, connSlot, &r); break;
+        case MSG_STATE_REQ: HandleStateRequest(loop, connSlot); break;
+        case MSG_LEAVE:     MatchDetachConn(loop, connSlot); break;
+        case MSG_SUBSCRIBE: HandleSubscribe(loop, connSlot, &r, handedOff); break;
+        case MSG_ACK:       HandleAck(loop, connSlot, &r); break;
+        default:            SendError(loop, connSlot, PROTO_ERR_MALFORMED); break;
+    }
+}
+
+// Recycle the slot once nobody is left to play, resume or watch it
+static void ReleaseIfUnused(Loop* loop, int slot)
+{
+    Match* m = &loop->matches[slot];
+    for (int i = 0; i < PLAYERS_MAX; ++i) {
+        if (m->seats[i] >= 0) return;
+    }
+    if (m->broadcast != NULL && m->broadcast->spectatorCount > 0) return;
+    FreeMatch(loop, slot);
+}
+
+void MatchDetachConn(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn == NULL) return;
+
+    if (conn->spectateSlot >= 0) {
+        int slot = conn->spectateSlot;
+        Broadcast* b = loop->matches[slot].broadcast;
+        for (int i = 0; i < b->spectatorCount; ++i) {
+            if (b->spectators[i] == connSlot) {
+                b->spectators[i] = b->spectators[--b->spectatorCount];
+                break;
+            }
+        }
+        conn->spectateSlot = -1;
+        conn->stalled = false;
+        ReleaseIfUnused(loop, slot);
+    }
+
+    if (conn->matchSlot >= 0) {
+        int slot = conn->matchSlot;
+        Match* m = &loop->matches[slot];
+        for (int i = 0; i < PLAYERS_MAX; ++i) {
+            if (m->seats[i] == connSlot) m->seats[i] = -1;
+        }
+        conn->matchSlot = -1;
+        ReleaseIfUnused(loop, slot);
+    }
+}
+
+void MatchOnDrained(Loop* loop, int connSlot)
+{
+    Conn* conn = loop->conns[connSlot];
+    if (conn->stalled && !conn->closing) SyncSpectator(loop, &loop->matches[conn->spectateSlot], connSlot, NULL);
+}
+
+bool MatchRestore(Loop* loop, int slot, uint32_t version, uint64_t seed, const GameState* g)
+{
+    if (slot < loop->matchCount || slot >= loop->maxMatches || !GrowMatches(loop, slot + 1)) return false;
+
+    // Slots skipped over were free when the checkpoint was taken
+    while (loop->matchCount < slot) {
+        Match* gap = &loop->matches[loop->matchCount];
+        memset(gap, 0, sizeof(*gap));
+        gap->nextFree = loop->freeMatch;
+        loop->freeMatch = loop->matchCount++;
+    }
+    Match* m = &loop->matches[loop->matchCount++];
+    InitMatch(m);
+    m->state = *g;
+    m->version = version;
+    m->seed = seed;
+    m->restored = true;
+    return true;
+}
+
+void MatchReleaseRestored(Loop* loop)
+{
+    for (int i = 0; i < loop->matchCount; ++i) {
+        Match* m = &loop->matches[i];
+        if (!m->used || !m->restored) continue;
+        m->restored = false;
+        ReleaseIfUnused(loop, i);
+    }
+}
+
+void MatchFreeAll(Loop* loop)
+{
+    for (int i = 0; i < loop->matchCount; ++i) {
+        if (!loop->matches[i].used) continue;
+        FreeBroadcast(&loop->matches[i]);
+        RecordFree(&loop->matches[i].record);
+    }
+    free(loop->matches);
+    loop->matches = NULL;
+    loop->matchCap = loop->matchCount = 0;
+    loop->freeMatch = -1;
+}
@@ -0,0 +1,189 @@
+// reefd: headless multi-match Reef server
+//
+//   reefd [--tcp host:port] [--unix path] [--loops N] [--max-matches N] [--no-pin]
+//         [--state-dir DIR] [--checkpoint-ms N] [--resume-ms N] [--record DIR]
+//         [--trace FILE]
+//
+// Defaults to TCP on 127.0.0.1:7878 with one event loop per online CPU.
+// With --state-dir, live matches are checkpointed there (every second by
+// default, and on shutdown) and resumed from it on the next start; run with
+// the same --loops so every checkpoint finds its loop. A resumed match that
+// nobody joins or watches within --resume-ms (five minutes by default) is
+// dropped. --record writes every match played to the end as a game record
+// (record.h) in DIR; a resumed match has lost its moves and is not recorded.
+// --trace records a Chrome trace of frame handling until shutdown.
+#define _GNU_SOURCE
+#include "server.h"
+#include "cards.h"
+#include "trace.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int ListenTcp(const char* addr)
+{
+    char host[256];
+    snprintf(host, sizeof(host), "%s", addr);
+    char* colon = strrchr(host, ':');
+    if (colon == NULL) return -1;
+    *colon = '\0';
+
+    struct sockaddr_in sa = { 0 };
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons((uint16_t)atoi(colon + 1));
+    if (inet_pton(AF_INET, host[0] ? host : "0.0.0.0", &sa.sin_addr) != 1) return -1;
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int ListenUnix(const char* path)
+{
+    struct sockaddr_un sa = { 0 };
+    sa.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(sa.sun_path)) return -1;
+    strcpy(sa.sun_path, path);
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void PinToCpu(pthread_t thread, int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--tcp host:port] [--unix path] [--loops N] [--max-matches N] [--no-pin]\n"
+                    "       [--state-dir DIR] [--checkpoint-ms N] [--resume-ms N] [--record DIR]\n"
+                    "       [--trace FILE]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    Server server = { 0 };
+    server.cfg.maxMatchesPerLoop = 1 << 20;
+    server.cfg.pinThreads = true;
+    server.cfg.checkpointMs = 1000;
+    server.cfg.resumeMs = 5 * 60 * 1000;
+    const char* trace = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--tcp") == 0 && hasValue)              server.cfg.tcpAddr = argv[++i];
+        else if (strcmp(argv[i], "--unix") == 0 && hasValue)        server.cfg.unixPath = argv[++i];
+        else if (strcmp(argv[i], "--loops") == 0 && hasValue)       server.cfg.loops = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-matches") == 0 && hasValue) server.cfg.maxMatchesPerLoop = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-pin") == 0)                  server.cfg.pinThreads = false;
+        else if (strcmp(argv[i], "--state-dir") == 0 && hasValue)   server.cfg.stateDir = argv[++i];
+        else if (strcmp(argv[i], "--checkpoint-ms") == 0 && hasValue) server.cfg.checkpointMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--resume-ms") == 0 && hasValue)   server.cfg.resumeMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0 && hasValue)      server.cfg.recordDir = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && hasValue)       trace = argv[++i];
+        else { Usage(argv[0]); return 1; }
+    }
+    if (server.cfg.tcpAddr == NULL && server.cfg.unixPath == NULL) server.cfg.tcpAddr = "127.0.0.1:7878";
+
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1) cpus = 1;
+    server.loopCount = server.cfg.loops > 0 ? server.cfg.loops : cpus;
+    if (server.loopCount > SERVER_MAX_LOOPS) server.loopCount = SERVER_MAX_LOOPS;
+
+    if (server.cfg.tcpAddr) {
+        int fd = ListenTcp(server.cfg.tcpAddr);
+        if (fd < 0) { fprintf(stderr, "reefd: cannot listen on %s: %s\n", server.cfg.tcpAddr, strerror(errno)); return 1; }
+        server.listenFds[server.listenCount++] = fd;
+    }
+    if (server.cfg.unixPath) {
+        int fd = ListenUnix(server.cfg.unixPath);
+        if (fd < 0) { fprintf(stderr, "reefd: cannot listen on %s: %s\n", server.cfg.unixPath, strerror(errno)); return 1; }
+        server.listenFds[server.listenCount++] = fd;
+    }
+
+    // Loops never see signals; the main thread waits for them below
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (trace != NULL && !TraceStart(trace)) { fprintf(stderr, "reefd: cannot write %s: %s\n", trace, strerror(errno)); return 1; }
+
+    server.loops = calloc((size_t)server.loopCount, sizeof(Loop));
+    for (int i = 0; i < server.loopCount; ++i) {
+        if (!LoopInit(&server.loops[i], &server, i)) {
+            fprintf(stderr, "reefd: loop %d init failed: %s\n", i, strerror(errno));
+            return 1;
+        }
+    }
+    if (server.cfg.stateDir) {
+        int restored = 0;
+        for (int i = 0; i < server.loopCount; ++i) {
+            int n = CheckpointRestore(&server.loops[i]);
+            if (n < 0) fprintf(stderr, "reefd: loop %d: checkpoint in %s unreadable, starting empty\n", i, server.cfg.stateDir);
+            else restored += n;
+        }
+        printf("reefd: resumed %d match(es) from %s\n", restored, server.cfg.stateDir);
+    }
+    bool writer = server.cfg.stateDir != NULL || server.cfg.recordDir != NULL;
+    if (writer && !CheckpointStart(&server)) { fprintf(stderr, "reefd: cannot start the checkpoint writer\n"); return 1; }
+    for (int i = 0; i < server.loopCount; ++i) {
+        pthread_create(&server.loops[i].thread, NULL, LoopRun, &server.loops[i]);
+        if (server.cfg.pinThreads) PinToCpu(server.loops[i].thread, i % cpus);
+    }
+
+    printf("reefd: %d loop(s), %zu bytes per match, listening on%s%s%s%s\n",
+           server.loopCount, sizeof(Match),
+           server.cfg.tcpAddr ? " tcp:" : "", server.cfg.tcpAddr ? server.cfg.tcpAddr : "",
+           server.cfg.unixPath ? " unix:" : "", server.cfg.unixPath ? server.cfg.unixPath : "");
+    fflush(stdout);
+
+    int sig;
+    sigwait(&sigs, &sig);
+
+    atomic_store(&server.stopping, true);
+    uint64_t actions = 0;
+    for (int i = 0; i < server.loopCount; ++i) LoopWake(&server.loops[i]);
+    for (int i = 0; i < server.loopCount; ++i) {
+        pthread_join(server.loops[i].thread, NULL);
+        actions += server.loops[i].actionsApplied;
+    }
+    // The loops' last checkpoints and records are handed over by now
+    if (writer) CheckpointStop(&server);
+    int dropped = atomic_load(&server.recordsDropped);
+    if (dropped > 0) fprintf(stderr, "reefd: %d record(s) dropped, the writer fell behind\n", dropped);
+    for (int i = 0; i < server.loopCount; ++i) LoopDestroy(&server.loops[i]);
+    for (int i = 0; i < server.listenCount; ++i) close(server.listenFds[i]);
+    if (server.cfg.unixPath) unlink(server.cfg.unixPath);
+    free(server.loops);
+
+    TraceStop();
+    printf("reefd: shut down after %llu actions\n", (unsigned long long)actions);
+    return 0;
+}
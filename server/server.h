@@ -0,0 +1,202 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "constants.h"
+#include "protocol.h"
+#include "record.h"
+
+// reefd: many matches per process. One event loop per core, each with its
+// own epoll instance; every match is owned (pinned) by exactly one loop and
+// only that loop's thread ever touches its state, so the hot path is
+// lock-free. A connection that joins a match owned by another loop is
+// handed over to that loop once, on join.
+
+enum {
+    SERVER_MAX_LOOPS   = 256,
+    CONN_READ_BUF      = PROTO_HEADER_SIZE + PROTO_MAX_BODY,
+    CONN_MAX_PENDING   = 1 << 20,   // output backlog before a slow client is dropped
+    MATCH_ID_LOOP_BITS = 8,
+    SERVER_MAX_RECORDS = 4096       // finished games waiting for the writer before more are dropped
+};
+
+typedef struct {
+    const char* tcpAddr;       // "host:port", or NULL
+    const char* unixPath;      // Unix domain socket path, or NULL
+    int loops;                 // 0 = one per online CPU
+    int maxMatchesPerLoop;
+    bool pinThreads;
+    const char* stateDir;      // checkpoint directory, or NULL for none
+    int checkpointMs;          // at most one checkpoint per loop this often
+    int resumeMs;              // restored matches nobody rejoins are dropped after this
+    const char* recordDir;     // a record (record.h) per finished match, or NULL for none
+} ServerConfig;
+
+// Reference-counted output buffer. One encoded broadcast frame is queued on
+// every subscriber by reference instead of being copied per connection.
+// Only the owning loop's thread touches the count.
+typedef struct {
+    int refs;
+    int len;
+    uint8_t data[];
+} SharedBuf;
+
+typedef struct {
+    SharedBuf* buf;
+    int off;                   // bytes already sent
+} OutChunk;
+
+typedef struct {
+    int fd;
+    int matchSlot;             // -1 when not seated
+    uint8_t seat;              // PROTO_SEAT_ALL for hotseat
+    bool closing;
+
+    // Spectating (delta broadcast)
+    int spectateSlot;          // -1 when not subscribed
+    uint32_t sentVersion;      // last version queued to this client
+    uint32_t ackedVersion;     // last version the client confirmed
+    bool stalled;              // broadcasts paused until the backlog drains
+
+    uint8_t rbuf[CONN_READ_BUF];
+    int rlen;
+
+    OutChunk* out;             // ring of unsent output
+    int outHead, outCount, outCap;
+    int outBytes;
+    bool wantWrite;            // EPOLLOUT currently armed
+} Conn;
+
+enum {
+    BROADCAST_KEYFRAME_INTERVAL = 16,       // versions between cached keyframes
+    SPECTATOR_MAX_BACKLOG       = 16 * 1024,// bytes queued before a spectator is paused
+    SPECTATOR_MAX_UNACKED       = 64        // versions sent but not acknowledged
+};
+
+// Delta broadcast for a spectated match; allocated on first subscriber.
+// Every version is encoded once and the same frame is queued on all
+// subscribers. A late joiner gets the cached keyframe plus the deltas since.
+typedef struct {
+    GameState prev;                                 // state at the last encoded version
+    SharedBuf* keyframe;                            // framed MSG_DELTA at keyVersion
+    uint32_t keyVersion;
+    SharedBuf* deltas[BROADCAST_KEYFRAME_INTERVAL]; // keyVersion+i -> keyVersion+i+1
+    int deltaCount;
+    int32_t* spectators;                            // conn slots
+    int spectatorCount, spectatorCap;
+} Broadcast;
+
+// Per-match state stays small: GameState holds card ids and packed boards
+typedef struct {
+    GameState state;
+    uint32_t version;          // bumped on every applied action
+    uint64_t seed;
+    int32_t seats[PLAYERS_MAX];// conn slot per seat, -1 if empty
+    int32_t nextFree;          // free-list link while unused
+    bool used;
+    bool restored;             // from a checkpoint, until the resume deadline
+    bool recording;            // record holds every move since the deal
+    Record record;             // with --record; a checkpoint does not keep it
+    Broadcast* broadcast;      // NULL unless someone is spectating
+} Match;
+
+typedef struct Loop Loop;
+
+typedef struct {
+    Conn conn;                 // moved by value, including unparsed input
+} Handoff;
+
+struct Loop {
+    int index;
+    int epfd;
+    int wakeFd;                // eventfd: handoffs and shutdown
+    pthread_t thread;
+    struct Server* server;
+
+    Conn** conns;              // slot -> connection (NULL if free)
+    int connCap;
+
+    Match* matches;
+    int matchCap, matchCount, freeMatch, maxMatches;
+
+    pthread_mutex_t inboxLock;
+    Handoff* inbox;
+    int inboxLen, inboxCap;
+
+    uint64_t rng;
+    uint64_t actionsApplied;
+
+    // Checkpointing (see checkpoint.c)
+    bool dirty;                // a match changed since the last checkpoint
+    uint64_t nextCheckpointMs; // monotonic
+    uint64_t resumeDeadlineMs; // restored matches still unjoined are dropped then; 0 if none
+    uint8_t* checkpointBuf;    // loop thread: encoded here
+    int checkpointCap;
+    uint8_t* persistBuf;       // under Server::checkpointLock: next for the writer
+    int persistCap, persistLen;
+    bool persistPending;
+    uint8_t* writerBuf;        // writer thread: being written
+    int writerCap;
+    atomic_bool persistFailed; // the last write failed; encode again
+};
+
+// A finished match's record, formatted by its loop for the writer
+typedef struct PendingRecord {
+    struct PendingRecord* next;
+    char name[64];             // file name in ServerConfig::recordDir
+    int len;
+    char text[];
+} PendingRecord;
+
+typedef struct Server {
+    ServerConfig cfg;
+    int listenFds[2];
+    int listenCount;
+    Loop* loops;
+    int loopCount;
+    atomic_bool stopping;
+
+    // Checkpoint writer (checkpoint.c)
+    pthread_t checkpointThread;
+    pthread_mutex_t checkpointLock;
+    pthread_cond_t checkpointWake;
+    bool checkpointStop;       // under checkpointLock
+    PendingRecord* recordHead; // under checkpointLock: records to write, oldest first
+    PendingRecord* recordTail;
+    int recordCount;
+    atomic_int recordsDropped; // refused while the queue was full
+} Server;
+
+// loop.c
+bool LoopInit(Loop* loop, struct Server* server, int index);
+void* LoopRun(void* arg);
+void LoopWake(Loop* loop);
+void LoopDestroy(Loop* loop);
+void LoopHandoff(Loop* target, Conn* conn);
+bool LoopSend(Loop* loop, int connSlot, const uint8_t* data, int len);
+bool LoopSendShared(Loop* loop, int connSlot, SharedBuf* buf);
+int  LoopPendingBytes(const Loop* loop, int connSlot);
+SharedBuf* SharedBufNew(const uint8_t* data, int len);
+void SharedBufRelease(SharedBuf* buf);
+void LoopCloseConn(Loop* loop, int connSlot);
+void LoopRequestHandoff(Loop* loop, int connSlot, int targetLoop, bool* handedOff);
+
+// match.c
+void MatchHandleFrame(Loop* loop, int connSlot, const uint8_t* body, int len, bool* handedOff);
+void MatchDetachConn(Loop* loop, int connSlot);
+void MatchOnDrained(Loop* loop, int connSlot);
+void MatchFreeAll(Loop* loop);
+// Recreate a checkpointed match under its old id; slots must increase
+bool MatchRestore(Loop* loop, int slot, uint32_t version, uint64_t seed, const GameState* g);
+// Drop restored matches nobody has joined or watched since
+void MatchReleaseRestored(Loop* loop);
+
+// checkpoint.c
+bool CheckpointStart(struct Server* server);  // the writer thread, also for records
+void CheckpointStop(struct Server* server);   // after the loops: writes what they handed over
+bool CheckpointSnapshot(Loop* loop);          // loop thread: encode and hand to the writer
+int  CheckpointRestore(Loop* loop);  // matches restored, -1 if the file is unreadable
+void CheckpointRecord(Loop* loop, int slot);  // loop thread: a finished match's record to the writer
+
+#endif
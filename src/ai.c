@@ -0,0 +1,698 @@
+#define _DEFAULT_SOURCE
+#include "ai.h"
+#include "bot.h"
+#include "book.h"
+#include "cards.h"
+#include "jobs.h"
+#include "sim.h"
+#include "trace.h"
+#include "tree.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    AI_MAX_TURNS   = CARD_DISPLAY_SIZE + 1 + MAX_HAND_SIZE * RULES_MAX_ACTIONS * RULES_MAX_ACTIONS,
+    AI_MAX_THREADS = 4
+};
+
+typedef enum {
+    AI_IDLE = 0,
+    AI_THINK,   // computer to move: search `from` until the deadline
+    AI_PONDER   // human to move: predict their turn, search where it leads
+} AiJobKind;
+
+// One whole turn and where it leads
+typedef struct {
+    Action line[AI_MAX_LINE];
+    int len;
+    GameState state;
+} AiTurn;
+
+// A decided turn, with the position before each action so the main thread
+// can tell which one is due
+typedef struct {
+    bool ready;
+    int len;
+    Action line[AI_MAX_LINE];
+    GameState path[AI_MAX_LINE];
+} AiPlan;
+
+typedef struct {
+    const BotConfig* cfg;
+    int me;
+    unsigned generation;
+    int iteration;                   // depth of the iteration being searched
+    bool aborted;
+    TreeCursor cursor;
+    AiTurn* levels[AI_MAX_DEPTH];    // scratch per remaining depth, allocated on first use
+    TreeNode sorted[AI_MAX_TURNS];   // reordering children in place
+} AiWorker;
+
+typedef struct {
+    AiWorker* worker;
+    const GameState* root;
+    uint32_t first;                  // the root's children
+    int count;
+    int depth;
+    atomic_int* next;
+    _Atomic float* alpha;
+} AiRootTask;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;               // a job finished (for AiDecide)
+    pthread_t thread;
+    bool running;
+
+    // Current job, under lock. The main thread replaces it; the search
+    // thread fills in the prediction of a ponder job.
+    AiJobKind kind;
+    unsigned jobGeneration;
+    unsigned doneGeneration;           // last job the search thread finished
+    GameState from;                    // think: the root; ponder: the human's position
+    GameState root;                    // ponder: the position the prediction leads to
+    bool rootKnown;
+    GameState humanPath[AI_MAX_LINE];  // ponder: positions along the predicted human turn
+    int humanLen;
+    AiPlan plan;                       // last decided turn
+    bool seats[PLAYERS_MAX];
+
+    atomic_uint generation;            // jobGeneration, for polling without the lock
+    atomic_ullong deadline;            // CLOCK_MONOTONIC ns; UINT64_MAX while pondering
+    atomic_int depth;
+
+    // Set up before the thread starts
+    int threads;
+    BotConfig cfg;
+    Book book;
+    Tree tree;                         // search thread and its root tasks only
+    uint64_t redeal;                   // search thread: RNG for the searched deals
+
+    // Main thread only
+    bool started;
+    int thinkMs;
+    uint64_t lastPush;
+} gAi;
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool Same(const GameState* a, const GameState* b)
+{
+    return memcmp(a, b, RulesStateSize(a)) == 0;
+}
+
+// Searched positions are redeals of the game (tree.h): the same to the
+// seat that searched them, which is all that tells a ponder hit or a plan
+// step
+static bool SameAsSeen(const GameState* a, const GameState* b, int seat)
+{
+    GameState x, y;
+    RulesCopyState(&x, a);
+    RulesCopyState(&y, b);
+    CardsRedeal(&x, seat, NULL);
+    CardsRedeal(&y, seat, NULL);
+    return Same(&x, &y);
+}
+
+static void Walk(const GameState* g, int mover, Action* line, int len, AiTurn* out, int* n)
+{
+    if (len > 0 && (g->gameEnded || g->currentPlayer != mover || len == AI_MAX_LINE)) {
+        AiTurn* t = &out[(*n)++];
+        memcpy(t->line, line, sizeof(Action) * (size_t)len);
+        t->len = len;
+        RulesCopyState(&t->state, g);
+        return;
+    }
+
+    Action legal[RULES_MAX_ACTIONS];
+    int count = RulesListActions(g, legal);
+    for (int i = 0; i < count; ++i) {
+        GameState next;
+        RulesCopyState(&next, g);
+        if (!RulesApply(&next, legal[i])) continue;
+        line[len] = legal[i];
+        Walk(&next, mover, line, len + 1, out, n);
+    }
+}
+
+// Every way the player to move can finish their turn from g
+static int EnumerateTurns(const GameState* g, AiTurn* out)
+{
+    if (g->gameEnded) return 0;
+    Action line[AI_MAX_LINE];
+    int n = 0;
+    Walk(g, g->currentPlayer, line, 0, out, &n);
+    return n;
+}
+
+static bool Expired(AiWorker* w)
+{
+    if (atomic_load_explicit(&gAi.generation, memory_order_relaxed) != w->generation) return true;
+    return w->iteration > 1 && NowNs() >= atomic_load_explicit(&gAi.deadline, memory_order_relaxed);
+}
+
+typedef struct {
+    float score;
+    int index;
+} AiOrder;
+
+static int CompareDescending(const void* a, const void* b)
+{
+    const AiOrder* x = a;
+    const AiOrder* y = b;
+    if (x->score != y->score) return x->score < y->score ? 1 : -1;
+    return x->index - y->index;
+}
+
+static AiTurn* Scratch(AiWorker* w, int depth)
+{
+    if (w->levels[depth] == NULL) {
+        w->levels[depth] = malloc(sizeof(AiTurn) * AI_MAX_TURNS);
+        if (w->levels[depth] == NULL) w->aborted = true;
+    }
+    return w->levels[depth];
+}
+
+// Store g's turns as node's children, best first for the player to move,
+// each with its static score. False if the tree has no room.
+static bool Expand(AiWorker* w, TreeNode* node, const GameState* g, const AiTurn* turns, int n)
+{
+    uint32_t first = TreeAllocChildren(&gAi.tree, &w->cursor, n);
+    if (first == TREE_NONE) return false;
+
+    float sign = g->currentPlayer == w->me ? 1.0f : -1.0f;
+    AiOrder order[AI_MAX_TURNS];
+    for (int i = 0; i < n; ++i) {
+        order[i].score = sign * BotEvaluate(&turns[i].state, w->me, w->cfg);
+        order[i].index = i;
+    }
+    qsort(order, (size_t)n, sizeof(order[0]), CompareDescending);
+
+    for (int k = 0; k < n; ++k) {
+        const AiTurn* t = &turns[order[k].index];
+        TreeNode* c = TreeNodeAt(&gAi.tree, first + (uint32_t)k);
+        *c = (TreeNode){ .firstChild = TREE_NONE, .score = sign * order[k].score, .len = (uint8_t)t->len };
+        for (int j = 0; j < t->len; ++j) c->line[j] = RulesActionId(t->line[j]);
+    }
+    node->firstChild = first;
+    node->childCount = (uint16_t)n;
+    return true;
+}
+
+// Children back in order of their latest scores, best first for the
+// player to move; ties keep their order
+static void SortChildren(AiWorker* w, TreeNode* node, bool maximize)
+{
+    float sign = maximize ? 1.0f : -1.0f;
+    AiOrder order[AI_MAX_TURNS];
+    for (int k = 0; k < node->childCount; ++k) {
+        order[k].score = sign * TreeNodeAt(&gAi.tree, node->firstChild + (uint32_t)k)->score;
+        order[k].index = k;
+    }
+    qsort(order, node->childCount, sizeof(order[0]), CompareDescending);
+    for (int k = 0; k < node->childCount; ++k) {
+        w->sorted[k] = *TreeNodeAt(&gAi.tree, node->firstChild + (uint32_t)order[k].index);
+    }
+    for (int k = 0; k < node->childCount; ++k) *TreeNodeAt(&gAi.tree, node->firstChild + (uint32_t)k) = w->sorted[k];
+}
+
+static float Search(AiWorker* w, uint32_t index, const GameState* g, int depth, float alpha, float beta);
+
+// Alpha-beta over turns that are not in the tree, ordered by static score
+static float SearchTurns(AiWorker* w, const GameState* g, AiTurn* turns, int n, int depth, float alpha, float beta)
+{
+    bool maximize = g->currentPlayer == w->me;
+    float sign = maximize ? 1.0f : -1.0f;
+    AiOrder order[AI_MAX_TURNS];
+    for (int i = 0; i < n; ++i) {
+        order[i].score = sign * BotEvaluate(&turns[i].state, w->me, w->cfg);
+        order[i].index = i;
+    }
+    if (depth == 1) {
+        float best = -INFINITY;
+        for (int i = 0; i < n; ++i) if (order[i].score > best) best = order[i].score;
+        return sign * best;
+    }
+    qsort(order, (size_t)n, sizeof(order[0]), CompareDescending);
+
+    float best = -sign * INFINITY;
+    for (int k = 0; k < n; ++k) {
+        float v = Search(w, TREE_NONE, &turns[order[k].index].state, depth - 1, alpha, beta);
+        if (w->aborted) return 0.0f;
+        if (maximize) {
+            if (v > best) best = v;
+            if (v > alpha) alpha = v;
+        } else {
+            if (v < best) best = v;
+            if (v < beta) beta = v;
+        }
+        if (alpha >= beta) break;
+    }
+    return best;
+}
+
+// Alpha-beta over whole turns: the computer maximizes, everyone else
+// minimizes its evaluation. Positions with turns left to search below them
+// are kept in the tree, children ordered by their last searched score, so
+// the next iteration (or the next move) starts from the best order found so
+// far. The last ply is scored from scratch and never stored. index is
+// TREE_NONE off the tree.
+static float Search(AiWorker* w, uint32_t index, const GameState* g, int depth, float alpha, float beta)
+{
+    if (g->gameEnded) return BotEvaluate(g, w->me, w->cfg);
+    if (w->aborted || Expired(w)) {
+        w->aborted = true;
+        return 0.0f;
+    }
+
+    TreeNode* node = depth > 1 && index != TREE_NONE ? TreeNodeAt(&gAi.tree, index) : NULL;
+    if (node == NULL || node->firstChild == TREE_NONE) {
+        AiTurn* turns = Scratch(w, depth);
+        if (turns == NULL) return 0.0f;
+        int n = EnumerateTurns(g, turns);
+        if (n == 0) return BotEvaluate(g, w->me, w->cfg);
+        if (node == NULL || !Expand(w, node, g, turns, n)) return SearchTurns(w, g, turns, n, depth, alpha, beta);
+    }
+    if (node->visits < UINT16_MAX) node->visits++;
+
+    bool maximize = g->currentPlayer == w->me;
+    float best = maximize ? -INFINITY : INFINITY;
+    for (int k = 0; k < node->childCount; ++k) {
+        uint32_t child = node->firstChild + (uint32_t)k;
+        GameState next;
+        RulesCopyState(&next, g);
+        TreeApplyLine(&next, TreeNodeAt(&gAi.tree, child));
+        float v = Search(w, child, &next, depth - 1, alpha, beta);
+        if (w->aborted) return 0.0f;
+        TreeNodeAt(&gAi.tree, child)->score = v;
+        if (maximize) {
+            if (v > best) best = v;
+            if (v > alpha) alpha = v;
+        } else {
+            if (v < best) best = v;
+            if (v < beta) beta = v;
+        }
+        if (alpha >= beta) break;
+    }
+    SortChildren(w, node, maximize);
+    return best;
+}
+
+static void RootWorker(void* arg)
+{
+    AiRootTask* t = arg;
+    AiWorker* w = t->worker;
+    int i;
+    while (!w->aborted && (i = atomic_fetch_add(t->next, 1)) < t->count) {
+        uint32_t child = t->first + (uint32_t)i;
+        GameState g;
+        RulesCopyState(&g, t->root);
+        TreeApplyLine(&g, TreeNodeAt(&gAi.tree, child));
+
+        float alpha = atomic_load(t->alpha);
+        float v = Search(w, child, &g, t->depth - 1, alpha, INFINITY);
+        if (w->aborted) break;
+        TreeNodeAt(&gAi.tree, child)->score = v;
+
+        float cur = atomic_load(t->alpha);
+        while (v > cur && !atomic_compare_exchange_weak(t->alpha, &cur, v)) {}
+    }
+}
+
+static void Publish(const GameState* root, const AiTurn* best, unsigned generation)
+{
+    AiPlan plan = { .ready = true, .len = best->len };
+    GameState g = *root;
+    for (int k = 0; k < best->len; ++k) {
+        plan.line[k] = best->line[k];
+        plan.path[k] = g;
+        RulesApply(&g, best->line[k]);
+    }
+
+    pthread_mutex_lock(&gAi.lock);
+    if (gAi.jobGeneration == generation) gAi.plan = plan;
+    pthread_mutex_unlock(&gAi.lock);
+}
+
+// Iterative deepening from root, root moves split across the workers. An
+// aborted iteration is dropped; the previous one's best turn stands. When
+// root was reached through turns already searched, the tree below it is
+// kept and its order is where depth 1 starts.
+//
+// The search never reads cards the player to move has not seen: it runs
+// on one redeal of them (CardsRedeal), drawn afresh whenever the tree
+// starts over. The turn it picks only touches what the player sees (its
+// hand, the display, the deck's top), so it plays the same on root.
+static void SearchRoot(const GameState* root, unsigned generation, AiWorker* workers, AiTurn* turns)
+{
+    Action booked;
+    if (gAi.book.base != NULL && BookLookup(&gAi.book, root, &booked)) {
+        AiTurn t = { .line = { booked }, .len = 1 };
+        Publish(root, &t, generation);
+        return;
+    }
+
+    TRACE_BEGIN("AiSearch");
+    for (int t = 0; t < gAi.threads; ++t) {
+        workers[t].cfg = &gAi.cfg;
+        workers[t].me = root->currentPlayer;
+        workers[t].generation = generation;
+        workers[t].aborted = false;
+    }
+    GameState sample;
+    RulesCopyState(&sample, root);
+    CardsRedeal(&sample, root->currentPlayer, &gAi.redeal);
+    TreeSetRoot(&gAi.tree, root, &sample, root->currentPlayer);
+    const GameState* searched = &gAi.tree.rootState;
+    TreeCompactIfFull(&gAi.tree);
+    TreeNode* node = TreeNodeAt(&gAi.tree, gAi.tree.root);
+    if (node->firstChild == TREE_NONE) {
+        int n = EnumerateTurns(searched, turns);
+        if (n == 0 || !Expand(&workers[0], node, searched, turns, n)) {  // no room only if the cap is below one turn list
+            TRACE_END("AiSearch");
+            return;
+        }
+    }
+    uint32_t first = node->firstChild;
+    int n = node->childCount;
+
+    // Nothing left to decide, or nothing deeper to see
+    bool final = n == 1;
+    for (int i = 0; i < n && !final; ++i) {
+        GameState g;
+        RulesCopyState(&g, searched);
+        TreeApplyLine(&g, TreeNodeAt(&gAi.tree, first + (uint32_t)i));
+        if (!g.gameEnded) break;
+        if (i == n - 1) final = true;
+    }
+
+    for (int depth = 1; depth <= AI_MAX_DEPTH; ++depth) {
+        bool aborted = false;
+        if (depth > 1) {
+            atomic_int next = 0;
+            _Atomic float alpha = -INFINITY;
+            AiRootTask tasks[AI_MAX_THREADS];
+            Job jobs[AI_MAX_THREADS];
+            JobGroup group = { 0 };
+            for (int t = 0; t < gAi.threads; ++t) {
+                AiWorker* w = &workers[t];
+                w->iteration = depth;
+                tasks[t] = (AiRootTask){ w, searched, first, n, depth, &next, &alpha };
+                JobSpawn(&group, &jobs[t], RootWorker, &tasks[t]);
+            }
+            JobWait(&group);
+            for (int t = 0; t < gAi.threads; ++t) aborted = aborted || workers[t].aborted;
+        }
+        if (aborted) break;
+
+        if (node->visits < UINT16_MAX) node->visits++;
+        SortChildren(&workers[0], node, true);
+        atomic_store(&gAi.depth, depth);
+        TRACE_COUNTER("ai.depth", depth);
+        TRACE_COUNTER("ai.treeNodes", TreeNodeCount(&gAi.tree));
+        if (final) break;
+
+        // Nodes only move between iterations
+        TreeCompactIfFull(&gAi.tree);
+        node = TreeNodeAt(&gAi.tree, gAi.tree.root);
+        first = node->firstChild;
+    }
+
+    const TreeNode* best = TreeNodeAt(&gAi.tree, first);
+    AiTurn t = { .len = best->len };
+    for (int k = 0; k < best->len; ++k) t.line[k] = RulesActionFromId(best->line[k]);
+    Publish(root, &t, generation);
+    TRACE_END("AiSearch");
+}
+
+// The turn the human would play by the computer's own evaluation, the
+// positions along it, and where it ends. The human's hidden cards are
+// guessed by a redeal for the player after them, the one to search next.
+static bool Predict(const GameState* from, AiTurn* turns, GameState* path, int* len, GameState* root)
+{
+    GameState g;
+    RulesCopyState(&g, from);
+    CardsRedeal(&g, (from->currentPlayer + 1) % from->playersCount, &gAi.redeal);
+    int n = EnumerateTurns(&g, turns);
+    if (n == 0) return false;
+
+    int best = 0;
+    float bestScore = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        float v = BotEvaluate(&turns[i].state, from->currentPlayer, &gAi.cfg);
+        if (i == 0 || v > bestScore) {
+            best = i;
+            bestScore = v;
+        }
+    }
+
+    *len = turns[best].len;
+    for (int k = 0; k < turns[best].len; ++k) {
+        path[k] = g;
+        RulesApply(&g, turns[best].line[k]);
+    }
+    *root = g;
+    return true;
+}
+
+static void* AiThreadMain(void* arg)
+{
+    (void)arg;
+    TraceThreadName("ai");
+    static AiWorker workers[AI_MAX_THREADS];
+    AiTurn* turns = malloc(sizeof(AiTurn) * AI_MAX_TURNS);
+
+    pthread_mutex_lock(&gAi.lock);
+    while (gAi.running) {
+        if (turns == NULL || gAi.kind == AI_IDLE || gAi.doneGeneration == gAi.jobGeneration) {
+            pthread_cond_wait(&gAi.wake, &gAi.lock);
+            continue;
+        }
+        unsigned generation = gAi.jobGeneration;
+        AiJobKind kind = gAi.kind;
+        GameState root = gAi.from;
+        pthread_mutex_unlock(&gAi.lock);
+
+        GameState path[AI_MAX_LINE];
+        int len = 0;
+        bool search = true;
+        if (kind == AI_PONDER) {
+            GameState from = root;
+            search = Predict(&from, turns, path, &len, &root);
+        }
+
+        pthread_mutex_lock(&gAi.lock);
+        if (kind == AI_PONDER && gAi.jobGeneration == generation) {
+            // Only worth it if the computer moves next
+            search = search && !root.gameEnded && gAi.seats[root.currentPlayer];
+            if (search) {
+                gAi.root = root;
+                memcpy(gAi.humanPath, path, sizeof(path[0]) * (size_t)len);
+                gAi.humanLen = len;
+                gAi.rootKnown = true;
+            }
+        }
+        pthread_mutex_unlock(&gAi.lock);
+
+        if (search) SearchRoot(&root, generation, workers, turns);
+
+        pthread_mutex_lock(&gAi.lock);
+        if (gAi.jobGeneration == generation) gAi.doneGeneration = generation;
+        pthread_cond_broadcast(&gAi.done);
+    }
+    pthread_mutex_unlock(&gAi.lock);
+
+    for (int t = 0; t < AI_MAX_THREADS; ++t) {
+        for (int d = 0; d < AI_MAX_DEPTH; ++d) {
+            free(workers[t].levels[d]);
+            workers[t].levels[d] = NULL;
+        }
+    }
+    free(turns);
+    return NULL;
+}
+
+// Replace the job; callers hold the lock
+static void SetJob(AiJobKind kind, const GameState* g, uint64_t deadline)
+{
+    if (kind == AI_IDLE && gAi.kind == AI_IDLE) return;
+    gAi.kind = kind;
+    if (g != NULL) {
+        gAi.from = *g;
+        gAi.root = *g;
+    }
+    gAi.rootKnown = kind == AI_THINK;
+    gAi.humanLen = 0;
+    gAi.jobGeneration++;
+    atomic_store(&gAi.deadline, deadline);
+    atomic_store(&gAi.depth, 0);
+    atomic_store(&gAi.generation, gAi.jobGeneration);
+    pthread_cond_signal(&gAi.wake);
+}
+
+static void ThinkOn(const GameState* g)
+{
+    uint64_t now = NowNs();
+
+    // A decided turn that passes through g: play its next action
+    if (gAi.plan.ready) {
+        for (int k = 0; k < gAi.plan.len; ++k) {
+            if (!SameAsSeen(&gAi.plan.path[k], g, g->currentPlayer)) continue;
+            if (!SimPending() && now - gAi.lastPush >= (uint64_t)AI_STEP_MS * 1000000ull) {
+                if (SimPushAction(gAi.plan.line[k])) gAi.lastPush = now;
+            }
+            return;
+        }
+    }
+
+    uint64_t deadline = now + (uint64_t)gAi.thinkMs * 1000000ull;
+    if (gAi.kind == AI_PONDER && gAi.rootKnown && SameAsSeen(&gAi.root, g, g->currentPlayer)) {
+        // Ponder hit: the search already under way gets the move's budget
+        gAi.kind = AI_THINK;
+        gAi.from = *g;
+        atomic_store(&gAi.deadline, deadline);
+        return;
+    }
+    if (gAi.kind == AI_THINK && Same(&gAi.from, g)) return;
+    SetJob(AI_THINK, g, deadline);
+}
+
+static void PonderFrom(const GameState* g)
+{
+    if (gAi.kind == AI_PONDER) {
+        if (Same(&gAi.from, g)) return;
+        // Still on the predicted line, mid-turn
+        for (int k = 0; k < gAi.humanLen; ++k) {
+            if (SameAsSeen(&gAi.humanPath[k], g, gAi.root.currentPlayer)) return;
+        }
+    }
+    SetJob(AI_PONDER, g, UINT64_MAX);
+}
+
+bool AiStart(void)
+{
+    BotDefaultConfig(&gAi.cfg, BOT_GREEDY);
+    BookOpen(&gAi.book, BOOK_FILE);  // optional
+    if (!TreeInit(&gAi.tree, (size_t)AI_TREE_MB << 20)) return false;
+
+    // One root task per pool worker; this thread only waits on them
+    gAi.threads = JobsWorkerCount();
+    if (gAi.threads < 1) gAi.threads = 1;
+    if (gAi.threads > AI_MAX_THREADS) gAi.threads = AI_MAX_THREADS;
+    gAi.thinkMs = AI_DEFAULT_THINK_MS;
+    gAi.redeal = 0x5EEDull;
+
+    if (pthread_mutex_init(&gAi.lock, NULL) != 0) {
+        TreeFree(&gAi.tree);
+        return false;
+    }
+    if (pthread_cond_init(&gAi.wake, NULL) != 0) {
+        pthread_mutex_destroy(&gAi.lock);
+        TreeFree(&gAi.tree);
+        return false;
+    }
+    if (pthread_cond_init(&gAi.done, NULL) != 0) {
+        pthread_cond_destroy(&gAi.wake);
+        pthread_mutex_destroy(&gAi.lock);
+        TreeFree(&gAi.tree);
+        return false;
+    }
+    gAi.running = true;
+    if (pthread_create(&gAi.thread, NULL, AiThreadMain, NULL) != 0) {
+        gAi.running = false;
+        pthread_cond_destroy(&gAi.done);
+        pthread_cond_destroy(&gAi.wake);
+        pthread_mutex_destroy(&gAi.lock);
+        TreeFree(&gAi.tree);
+        return false;
+    }
+    gAi.started = true;
+    return true;
+}
+
+void AiStop(void)
+{
+    if (!gAi.started) return;
+    pthread_mutex_lock(&gAi.lock);
+    gAi.running = false;
+    SetJob(AI_IDLE, NULL, 0);  // aborts a running search
+    pthread_cond_signal(&gAi.wake);
+    pthread_mutex_unlock(&gAi.lock);
+    pthread_join(gAi.thread, NULL);
+
+    pthread_cond_destroy(&gAi.done);
+    pthread_cond_destroy(&gAi.wake);
+    pthread_mutex_destroy(&gAi.lock);
+    BookClose(&gAi.book);
+    TreeFree(&gAi.tree);
+    gAi.started = false;
+}
+
+void AiSetSeat(int player, bool computer)
+{
+    if (!gAi.started || player < 0 || player >= PLAYERS_MAX) return;
+    pthread_mutex_lock(&gAi.lock);
+    gAi.seats[player] = computer;
+    pthread_mutex_unlock(&gAi.lock);
+}
+
+bool AiIsSeat(int player)
+{
+    return gAi.started && player >= 0 && player < PLAYERS_MAX && gAi.seats[player];
+}
+
+void AiSetThinkTime(int ms)
+{
+    if (ms > 0) gAi.thinkMs = ms;
+}
+
+bool AiUpdate(const GameState* g)
+{
+    if (!gAi.started) return false;
+
+    bool computerTurn = !g->gameEnded && gAi.seats[g->currentPlayer];
+    bool anyComputer = false;
+    for (int p = 0; p < g->playersCount; ++p) anyComputer = anyComputer || gAi.seats[p];
+
+    pthread_mutex_lock(&gAi.lock);
+    if (computerTurn) ThinkOn(g);
+    else if (anyComputer && !g->gameEnded) PonderFrom(g);
+    else SetJob(AI_IDLE, NULL, 0);
+    pthread_mutex_unlock(&gAi.lock);
+    return computerTurn;
+}
+
+int AiSearchDepth(void)
+{
+    return atomic_load(&gAi.depth);
+}
+
+bool AiDecide(const GameState* g, int thinkMs, Action* line, int* len)
+{
+    if (!gAi.started || g->gameEnded) return false;
+    pthread_mutex_lock(&gAi.lock);
+    gAi.plan.ready = false;
+    SetJob(AI_THINK, g, NowNs() + (uint64_t)thinkMs * 1000000ull);
+    unsigned generation = gAi.jobGeneration;
+    while (gAi.doneGeneration != generation && gAi.jobGeneration == generation) {
+        pthread_cond_wait(&gAi.done, &gAi.lock);
+    }
+    bool ok = gAi.plan.ready;
+    if (ok) {
+        *len = gAi.plan.len;
+        memcpy(line, gAi.plan.line, sizeof(Action) * (size_t)gAi.plan.len);
+    }
+    pthread_mutex_unlock(&gAi.lock);
+    return ok;
+}
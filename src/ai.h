@@ -0,0 +1,55 @@
+#ifndef AI_H
+#define AI_H
+
+#include "rules.h"
+
+// Computer seats for the client. Any player can be handed to the computer;
+// its moves go through SimPushAction like keyboard and mouse input.
+//
+// The search works in whole turns: a move is every action up to the next
+// player's turn, and positions are scored with the greedy bot's evaluation
+// (bot.h). Iterative deepening runs the root moves on a few threads until
+// the per-move budget is spent, always finishing depth 1. Searched
+// positions stay in a memory-capped tree (tree.h) that orders the next
+// iteration, and the next move's search when the game gets there.
+//
+// The computer plays what it can see. Each search runs on one redeal of
+// the cards the player to move has not seen, the deck under its top and
+// the others' face-down hands (CardsRedeal), so its lookahead never draws
+// from the real deck order or plays the opponents' real hidden cards.
+//
+// While a human is to move, the computer predicts the human's turn and
+// already searches the position it expects to face. If the human plays that
+// turn, the search carries on with a fresh budget instead of starting over;
+// any other move discards it.
+
+enum {
+    AI_DEFAULT_THINK_MS = 1000,
+    AI_STEP_MS          = 300,  // pause between a turn's actions, so they can be followed
+    AI_MAX_DEPTH        = 6,    // turns, counting both players'
+    AI_TREE_MB          = 64,   // search tree cap
+    AI_MAX_LINE         = 3     // actions in one turn: play a card, then two placements
+};
+
+bool AiStart(void);
+void AiStop(void);
+
+void AiSetSeat(int player, bool computer);
+bool AiIsSeat(int player);
+void AiSetThinkTime(int ms);
+
+// Main thread, once per frame with the latest snapshot: starts, ponders,
+// cancels searches and pushes the computer's actions. Never waits on the
+// search. True while a computer seat is to move (human input is ignored).
+bool AiUpdate(const GameState* g);
+
+// Deepest completed iteration of the current search, 0 if none
+int AiSearchDepth(void);
+
+// Blocking alternative to AiUpdate for callers without a frame loop (engine
+// mode): search g for thinkMs and return the whole turn the computer would
+// play, up to AI_MAX_LINE actions. False if the game is over. Seats and
+// AiUpdate are not involved; do not mix the two.
+bool AiDecide(const GameState* g, int thinkMs, Action* line, int* len);
+
+#endif
@@ -0,0 +1,398 @@
+#define _DEFAULT_SOURCE
+#include "analysis.h"
+#include "cards.h"
+#include "trace.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ANALYSIS_WINDOW     0.5f   // aspiration half-width, in evaluation units
+#define ANALYSIS_WINDOW_MAX 64.0f  // wider than this, search with the window open
+
+enum {
+    ANALYSIS_SEEN_SLOTS = 2048,   // power of two, above ANALYSIS_MAX_TURNS
+
+    BOUND_EXACT = 1,
+    BOUND_LOWER,                  // the value is at least this
+    BOUND_UPPER                   // the value is at most this
+};
+
+// One turn of the position being searched, and where it leads
+struct AnalysisChild {
+    GameState state;
+    uint64_t hash;
+    uint32_t move;
+    float order;
+};
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Zobrist keys. Every feature of a position has a number, and its key is
+// that number through the splitmix64 finalizer: no table to build or
+// keep, and the same keys in every process.
+enum {
+    FEATURE_TURN    = 0,                                                // + player
+    FEATURE_ENDED   = FEATURE_TURN + PLAYERS_MAX,
+    FEATURE_FINAL   = FEATURE_ENDED + 1,
+    FEATURE_PLACE   = FEATURE_FINAL + 1,                                // + kind * 3 + placed
+    FEATURE_DECK    = FEATURE_PLACE + CARD_KIND_COUNT * 3,              // + size
+    FEATURE_DISPLAY = FEATURE_DECK + DECK_MAX + 1,                      // + slot * kinds + kind
+    FEATURE_TOKENS  = FEATURE_DISPLAY + CARD_DISPLAY_SIZE * CARD_KIND_COUNT,  // + slot * 64 + tokens
+    FEATURE_PLAYER  = FEATURE_TOKENS + CARD_DISPLAY_SIZE * 64,          // + player * FEATURE_PLAYER_SPAN
+
+    // Within a player
+    FEATURE_POINTS  = 0,                                                // + points
+    FEATURE_BOARD   = FEATURE_POINTS + 512,                             // + (cell * height + level) * 5 + color
+    FEATURE_HAND    = FEATURE_BOARD + BOARD_SIZE * BOARD_SIZE * MAX_STACK_HEIGHT * 5,  // + kind * (hand + 1) + copies
+    FEATURE_UNSEEN  = FEATURE_HAND + CARD_KIND_COUNT * (MAX_HAND_SIZE + 1),  // + kind * 64 + copies
+    FEATURE_PLAYER_SPAN = FEATURE_UNSEEN + CARD_KIND_COUNT * 64
+};
+
+static uint64_t Key(uint64_t feature)
+{
+    uint64_t z = feature * 0x9E3779B97F4A7C15ull + 0x2545F4914F6CDD1Dull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Cards count by kind, since copies are interchangeable, and hands as
+// multisets, since a hand's order changes no outcome. The deck is its
+// size alone: it is only ever taken from the top, so within one search
+// the size says which cards are left. Supplies follow from the boards.
+static uint64_t Hash(const GameState* g)
+{
+    uint64_t h = Key(FEATURE_TURN + (uint64_t)g->currentPlayer);
+    if (g->gameEnded) h ^= Key(FEATURE_ENDED);
+    if (g->finalRound) h ^= Key(FEATURE_FINAL);
+    if (g->placement.active) {
+        h ^= Key(FEATURE_PLACE + (uint64_t)(CardKind(g->placement.card) * 3 + g->placement.piecesPlaced));
+    }
+    h ^= Key(FEATURE_DECK + (uint64_t)g->deckSize);
+    for (int s = 0; s < CARD_DISPLAY_SIZE; ++s) {
+        h ^= Key(FEATURE_DISPLAY + (uint64_t)(s * CARD_KIND_COUNT + CardKind(g->display[s])));
+        h ^= Key(FEATURE_TOKENS + (uint64_t)(s * 64 + (g->displayTokens[s] & 63)));
+    }
+
+    for (int p = 0; p < g->playersCount; ++p) {
+        const Player* pl = &g->players[p];
+        uint64_t base = FEATURE_PLAYER + (uint64_t)p * FEATURE_PLAYER_SPAN;
+        h ^= Key(base + FEATURE_POINTS + (uint64_t)(pl->points & 511));
+        for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; ++cell) {
+            const CoralStack* s = &pl->board[cell / BOARD_SIZE][cell % BOARD_SIZE];
+            for (int level = 0; level < s->height; ++level) {
+                h ^= Key(base + FEATURE_BOARD + (uint64_t)((cell * MAX_STACK_HEIGHT + level) * 5 + s->pieces[level]));
+            }
+        }
+        int copies[CARD_KIND_COUNT] = { 0 };
+        for (int i = 0; i < pl->handSize; ++i) copies[CardKind(pl->hand[i])]++;
+        for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+            if (copies[k] > 0) h ^= Key(base + FEATURE_HAND + (uint64_t)(k * (MAX_HAND_SIZE + 1) + copies[k]));
+            if (pl->unseen[k] > 0) h ^= Key(base + FEATURE_UNSEEN + (uint64_t)(k * 64 + (pl->unseen[k] & 63)));
+        }
+    }
+    return h;
+}
+
+// A turn line in one word: its length, then an action id per byte. Never
+// 0 for a real turn, so 0 can mean none.
+static uint32_t Pack(const Action* line, int len)
+{
+    uint32_t m = (uint32_t)len << 24;
+    for (int i = 0; i < len; ++i) m |= (uint32_t)RulesActionId(line[i]) << (16 - 8 * i);
+    return m;
+}
+
+static int Unpack(uint32_t move, Action* line)
+{
+    int len = (int)(move >> 24);
+    for (int i = 0; i < len; ++i) line[i] = RulesActionFromId((uint8_t)(move >> (16 - 8 * i)));
+    return len;
+}
+
+static int FirstId(uint32_t move) { return (int)((move >> 16) & 0xff); }
+static int LastId(uint32_t move) { return (int)((move >> (16 - 8 * ((int)(move >> 24) - 1))) & 0xff); }
+
+bool AnalysisInit(Analysis* a, size_t tableBytes)
+{
+    memset(a, 0, sizeof(*a));
+    size_t entries = 1;
+    while (entries * 2 * sizeof(AnalysisEntry) <= tableBytes && entries < (1u << 31)) entries *= 2;
+    a->table = calloc(entries, sizeof(AnalysisEntry));
+    a->seen = malloc(sizeof(uint16_t) * ANALYSIS_SEEN_SLOTS);
+    if (a->table == NULL || a->seen == NULL) {
+        AnalysisFree(a);
+        return false;
+    }
+    a->tableMask = (uint32_t)(entries - 1);
+    return true;
+}
+
+void AnalysisFree(Analysis* a)
+{
+    free(a->table);
+    free(a->seen);
+    for (int i = 0; i <= ANALYSIS_MAX_DEPTH; ++i) free(a->children[i]);
+    memset(a, 0, sizeof(*a));
+}
+
+static AnalysisEntry* Probe(Analysis* a, uint64_t hash)
+{
+    AnalysisEntry* e = &a->table[hash & a->tableMask];
+    return e->generation == a->generation && e->key == hash ? e : NULL;
+}
+
+// Depth-preferred, but anything from an older search gives way
+static void Store(Analysis* a, uint64_t hash, int depth, float value, int bound, uint32_t move)
+{
+    AnalysisEntry* e = &a->table[hash & a->tableMask];
+    if (e->generation == a->generation && e->key != hash && e->depth > depth) return;
+    e->key = hash;
+    e->value = value;
+    e->move = move;
+    e->depth = (int8_t)depth;
+    e->bound = (uint8_t)bound;
+    e->generation = a->generation;
+}
+
+static void Walk(Analysis* a, const GameState* g, int mover, Action* line, int len, AnalysisChild* out, int* n)
+{
+    if (len > 0 && (g->gameEnded || g->currentPlayer != mover || len == ANALYSIS_MAX_LINE)) {
+        uint64_t hash = Hash(g);
+        // Turns that end alike are one child: the first line there stands
+        uint32_t slot = (uint32_t)hash & (ANALYSIS_SEEN_SLOTS - 1);
+        while (a->seen[slot] != UINT16_MAX) {
+            if (out[a->seen[slot]].hash == hash) return;
+            slot = (slot + 1) & (ANALYSIS_SEEN_SLOTS - 1);
+        }
+        a->seen[slot] = (uint16_t)*n;
+        AnalysisChild* c = &out[(*n)++];
+        RulesCopyState(&c->state, g);
+        c->hash = hash;
+        c->move = Pack(line, len);
+        return;
+    }
+
+    Action legal[RULES_MAX_ACTIONS];
+    int count = RulesListActions(g, legal);
+    for (int i = 0; i < count; ++i) {
+        GameState next;
+        RulesCopyState(&next, g);
+        if (!RulesApply(&next, legal[i])) continue;
+        line[len] = legal[i];
+        Walk(a, &next, mover, line, len + 1, out, n);
+    }
+}
+
+// g's turns into the ply's buffer, each with its ordering score; -1 if
+// there is no memory for it
+static int ListTurns(Analysis* a, const GameState* g, int ply, uint32_t hint)
+{
+    if (a->children[ply] == NULL) {
+        a->children[ply] = malloc(sizeof(AnalysisChild) * ANALYSIS_MAX_TURNS);
+        if (a->children[ply] == NULL) return -1;
+    }
+    AnalysisChild* out = a->children[ply];
+    memset(a->seen, 0xff, sizeof(uint16_t) * ANALYSIS_SEEN_SLOTS);
+    Action line[ANALYSIS_MAX_LINE];
+    int n = 0;
+    Walk(a, g, g->currentPlayer, line, 0, out, &n);
+
+    // Points are whole and history is bounded well below a point's weight
+    int mover = g->currentPlayer;
+    for (int i = 0; i < n; ++i) {
+        AnalysisChild* c = &out[i];
+        if (c->move == hint) {
+            c->order = 3e9f;
+        } else if (c->move == a->killers[ply][0]) {
+            c->order = 2e9f;
+        } else if (c->move == a->killers[ply][1]) {
+            c->order = 1e9f;
+        } else {
+            int gain = c->state.players[mover].points - g->players[mover].points;
+            c->order = (float)gain * 1e6f + (float)a->history[FirstId(c->move)][LastId(c->move)];
+        }
+    }
+    return n;
+}
+
+// Swap the best-ordered of out[k..n) into k. Cutoffs usually come early,
+// so this beats sorting the whole list.
+static void PickNext(AnalysisChild* out, int k, int n)
+{
+    int best = k;
+    for (int i = k + 1; i < n; ++i) {
+        if (out[i].order > out[best].order) best = i;
+    }
+    if (best != k) {
+        AnalysisChild t = out[k];
+        out[k] = out[best];
+        out[best] = t;
+    }
+}
+
+// Read the clock at every inner position: listing its turns costs far
+// more than the read
+static bool Expired(Analysis* a)
+{
+    if (a->nodeLimit > 0 && a->nodes >= a->nodeLimit) return true;
+    return a->deadline != 0 && NowNs() >= a->deadline;
+}
+
+static void Cutoff(Analysis* a, int ply, int depth, uint32_t move)
+{
+    if (a->killers[ply][0] != move) {
+        a->killers[ply][1] = a->killers[ply][0];
+        a->killers[ply][0] = move;
+    }
+    int32_t* h = &a->history[FirstId(move)][LastId(move)];
+    *h += depth * depth;
+    if (*h > 100000) {  // keep history a tiebreak: age the whole table
+        for (int i = 0; i < RULES_ACTION_IDS; ++i) {
+            for (int j = 0; j < RULES_ACTION_IDS; ++j) a->history[i][j] /= 2;
+        }
+    }
+}
+
+// Fail-soft alpha-beta over whole turns; values from a->me's point of view
+static float Search(Analysis* a, const GameState* g, uint64_t hash, int depth, int ply, float alpha, float beta)
+{
+    a->nodes++;
+    if (g->gameEnded || depth == 0) return BotEvaluate(g, a->me, a->cfg);
+    if (a->limited && Expired(a)) {
+        a->aborted = true;
+        return 0.0f;
+    }
+
+    uint32_t hint = 0;
+    const AnalysisEntry* e = Probe(a, hash);
+    if (e != NULL) {
+        hint = e->move;
+        if (ply > 0 && e->depth >= depth) {
+            if (e->bound == BOUND_EXACT) return e->value;
+            if (e->bound == BOUND_LOWER && e->value >= beta) return e->value;
+            if (e->bound == BOUND_UPPER && e->value <= alpha) return e->value;
+        }
+    }
+
+    int n = ListTurns(a, g, ply, hint);
+    if (n < 0) {
+        a->aborted = true;
+        return 0.0f;
+    }
+    if (n == 0) return BotEvaluate(g, a->me, a->cfg);
+
+    AnalysisChild* children = a->children[ply];
+    float alpha0 = alpha, beta0 = beta;
+    bool maximize = g->currentPlayer == a->me;
+    float best = maximize ? -INFINITY : INFINITY;
+    uint32_t bestMove = 0;
+    for (int k = 0; k < n; ++k) {
+        PickNext(children, k, n);
+        const AnalysisChild* c = &children[k];
+        float v = Search(a, &c->state, c->hash, depth - 1, ply + 1, alpha, beta);
+        if (a->aborted) return 0.0f;
+        if (maximize ? v > best : v < best) {
+            best = v;
+            bestMove = c->move;
+        }
+        if (maximize) {
+            if (best > alpha) alpha = best;
+        } else {
+            if (best < beta) beta = best;
+        }
+        if (alpha >= beta) {
+            Cutoff(a, ply, depth, c->move);
+            break;
+        }
+    }
+
+    int bound = best <= alpha0 ? BOUND_UPPER : best >= beta0 ? BOUND_LOWER : BOUND_EXACT;
+    Store(a, hash, depth, best, bound, bestMove);
+    if (ply == 0) a->rootMove = bestMove;
+    return best;
+}
+
+// Follow the table's moves from the root
+static void ExtractLine(Analysis* a, const GameState* root, uint32_t first, int depth, AnalysisResult* out)
+{
+    GameState g;
+    RulesCopyState(&g, root);
+    uint32_t move = first;
+    out->pvLength = 0;
+    while (move != 0 && out->pvLength < depth && !g.gameEnded) {
+        AnalysisTurn* t = &out->pv[out->pvLength];
+        t->len = Unpack(move, t->line);
+        for (int i = 0; i < t->len; ++i) {
+            if (!RulesApply(&g, t->line[i])) return;  // a colliding entry's move
+        }
+        out->pvLength++;
+        const AnalysisEntry* e = Probe(a, Hash(&g));
+        move = e != NULL ? e->move : 0;
+    }
+}
+
+bool AnalysisRun(Analysis* a, const GameState* g, const BotConfig* cfg, const AnalysisLimits* limits,
+                 AnalysisResult* out)
+{
+    memset(out, 0, sizeof(*out));
+    if (g->gameEnded) return false;
+
+    TRACE_BEGIN("AnalysisRun");
+    // A fresh table and fresh ordering per search, so the answer depends
+    // on the position and limits alone
+    if (++a->generation == 0) {
+        memset(a->table, 0, sizeof(AnalysisEntry) * ((size_t)a->tableMask + 1));
+        a->generation = 1;
+    }
+    memset(a->killers, 0, sizeof(a->killers));
+    memset(a->history, 0, sizeof(a->history));
+    a->cfg = cfg;
+    a->me = g->currentPlayer;
+    a->nodes = 0;
+    a->nodeLimit = limits->nodes;
+    a->deadline = limits->ms > 0 ? NowNs() + (uint64_t)limits->ms * 1000000ull : 0;
+    a->aborted = false;
+
+    int maxDepth = limits->depth > 0 && limits->depth < ANALYSIS_MAX_DEPTH ? limits->depth : ANALYSIS_MAX_DEPTH;
+    uint64_t hash = Hash(g);
+    float score = 0.0f;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        a->limited = depth > 1;
+        float window = ANALYSIS_WINDOW;
+        float alpha = depth > 1 ? score - window : -INFINITY;
+        float beta = depth > 1 ? score + window : INFINITY;
+        float v;
+        for (;;) {
+            a->rootMove = 0;
+            v = Search(a, g, hash, depth, 0, alpha, beta);
+            if (a->aborted) break;
+            // Outside the window the value is only a bound: widen that side
+            if (v <= alpha && alpha > -INFINITY) {
+                window *= 4.0f;
+                alpha = window > ANALYSIS_WINDOW_MAX ? -INFINITY : score - window;
+            } else if (v >= beta && beta < INFINITY) {
+                window *= 4.0f;
+                beta = window > ANALYSIS_WINDOW_MAX ? INFINITY : score + window;
+            } else {
+                break;
+            }
+        }
+        if (a->aborted) break;
+
+        score = v;
+        out->depth = depth;
+        out->score = v;
+        ExtractLine(a, g, a->rootMove, depth, out);
+        if (a->rootMove == 0) break;  // nothing to choose between
+    }
+    out->nodes = a->nodes;
+    TRACE_END("AnalysisRun");
+    return out->depth > 0;
+}
@@ -0,0 +1,96 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include "bot.h"
+
+// Exact search for analysis and the open-hands variant. Where everything
+// is visible, sampling is the wrong tool: this searches the game exactly
+// as the rules play it from the given position, deck order included, and
+// gives the same answer for the same position and limits every time.
+//
+// Alpha-beta over whole turns (a move is every action up to the next
+// player's turn), the player to move at the root maximizing the greedy
+// bot's evaluation (bot.h) and everyone else minimizing it, with
+//
+//   - iterative deepening, one turn deeper per iteration;
+//   - aspiration windows around the last iteration's score, widened and
+//     searched again on a fail;
+//   - a transposition table keyed by Zobrist hashes of the position;
+//   - move ordering: the table's move, two killer turns per ply, then the
+//     points the turn scores at once (ScoreCard gains, tokens, the draw's
+//     cost), with the history heuristic breaking ties.
+//
+// Turns that end in the same position are searched once. Single-threaded:
+// an Analysis belongs to one caller, and answers do not depend on timing
+// unless a time limit is set.
+
+enum {
+    ANALYSIS_MAX_DEPTH = 8,   // turns
+    ANALYSIS_MAX_LINE  = 3,   // actions in one turn: play a card, then two placements
+    ANALYSIS_MAX_TURNS = CARD_DISPLAY_SIZE + 1 + MAX_HAND_SIZE * RULES_MAX_ACTIONS * RULES_MAX_ACTIONS,
+    ANALYSIS_TABLE_MB  = 64   // default transposition table size
+};
+
+typedef struct {
+    Action line[ANALYSIS_MAX_LINE];
+    int len;
+} AnalysisTurn;
+
+// Zero for no limit. Limits are checked between positions; the deepest
+// complete iteration stands, and depth 1 always completes. A node limit
+// stops at the same place on every run, a time limit does not.
+typedef struct {
+    int depth;                // turns, at most ANALYSIS_MAX_DEPTH
+    int64_t nodes;
+    int ms;
+} AnalysisLimits;
+
+typedef struct {
+    int depth;                // deepest complete iteration
+    float score;              // for the player to move at the root
+    int64_t nodes;            // positions searched, over all iterations
+    int pvLength;
+    AnalysisTurn pv[ANALYSIS_MAX_DEPTH];  // principal variation, pv[0] the best turn
+} AnalysisResult;
+
+typedef struct {
+    uint64_t key;
+    float value;
+    uint32_t move;            // packed turn line, 0 for none
+    int8_t depth;
+    uint8_t bound;
+    uint8_t generation;
+} AnalysisEntry;
+
+typedef struct AnalysisChild AnalysisChild;
+
+typedef struct {
+    AnalysisEntry* table;
+    uint32_t tableMask;
+    uint8_t generation;       // bumped per search; older entries read as empty
+
+    AnalysisChild* children[ANALYSIS_MAX_DEPTH + 1];  // per ply, allocated on first use
+    uint16_t* seen;           // dedupe set for the turns being listed
+    uint32_t killers[ANALYSIS_MAX_DEPTH + 1][2];
+    int32_t history[RULES_ACTION_IDS][RULES_ACTION_IDS];
+
+    // The search under way
+    const BotConfig* cfg;
+    int me;
+    int64_t nodes, nodeLimit;
+    uint64_t deadline;        // CLOCK_MONOTONIC ns, 0 for none
+    bool limited;             // limits apply: off for depth 1
+    bool aborted;
+    uint32_t rootMove;
+} Analysis;
+
+// tableBytes is rounded down to a power of two entries
+bool AnalysisInit(Analysis* a, size_t tableBytes);
+void AnalysisFree(Analysis* a);
+
+// Search g. False if the game is over or there is no memory for the
+// search; out is filled either way.
+bool AnalysisRun(Analysis* a, const GameState* g, const BotConfig* cfg, const AnalysisLimits* limits,
+                 AnalysisResult* out);
+
+#endif
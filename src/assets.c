@@ -1,71 +1,273 @@
+#define _DEFAULT_SOURCE
 #include "assets.h"
+#include "bundle.h"
+#include "trace.h"
+#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 
 Assets gAssets; // zero-init by C static storage
 
-static bool LoadTextureIfExists(Texture2D* outTex, bool* outFlag, const char* file)
+enum { ASSET_SLOTS_MAX = 12 };
+
+// One loadable asset and where its GPU handle ends up
+typedef struct {
+    const char* basePath;
+    const char* file;
+    Texture2D* tex;     // NULL for the font slot
+    bool* flag;
+} AssetSlot;
+
+// CPU-side result of the loader thread, waiting for GPU upload
+typedef struct {
+    Image image;
+    bool ownsPixels;    // false when pixels point into the bundle mapping
+    bool ok;
+    int baseSize, glyphCount, glyphPadding;
+    Rectangle* recs;
+    GlyphInfo* glyphs;
+} StagedAsset;
+
+static struct {
+    AssetSlot slots[ASSET_SLOTS_MAX];
+    StagedAsset staged[ASSET_SLOTS_MAX];
+    int slotCount;
+
+    Bundle bundle;
+    bool bundleOpen;
+
+    pthread_t thread;
+    bool threadStarted;
+    pthread_mutex_t lock;
+    int stagedCount;    // guarded by lock; written by the loader thread
+    int uploadedCount;  // main thread only
+    bool active;
+} gLoader = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static const int FONT_BASE_SIZE = 32;
+
+static void AddSlot(const char* basePath, const char* file, Texture2D* tex, bool* flag)
 {
-    if (file == NULL) { *outFlag = false; return false; }
+    *flag = false;
+    if (file == NULL || gLoader.slotCount >= ASSET_SLOTS_MAX) return;
+    gLoader.slots[gLoader.slotCount++] = (AssetSlot){ basePath, file, tex, flag };
+}
+
+static bool StageFromBundle(const AssetSlot* slot, StagedAsset* out)
+{
+    if (!gLoader.bundleOpen) return false;
+    const BundleEntry* e = BundleFind(&gLoader.bundle, slot->file);
+    if (e == NULL) return false;
+
+    bool isFont = (slot->tex == NULL);
+    if (isFont != (e->kind == BUNDLE_ENTRY_FONT)) return false;
+    if (isFont && e->baseSize != FONT_BASE_SIZE) return false;
+    // BundleOpen checked the payload is in the file; check it holds the image
+    if (e->width <= 0 || e->height <= 0 || (uint64_t)GetPixelDataSize(e->width, e->height, e->format) > e->size) {
+        return false;
+    }
+
+    // Only this entry's pages: the title is staged first and must not wait
+    // for the rest of the file to be read
+    TRACE_BEGIN("BundlePrefault");
+    BundlePrefault(&gLoader.bundle, e->offset, e->size);
+    TRACE_END("BundlePrefault");
+    out->image = (Image){ (void*)BundleData(&gLoader.bundle, e->offset), e->width, e->height, 1, e->format };
+    out->ownsPixels = false;
+
+    if (isFont) {
+        const BundleGlyph* src = BundleData(&gLoader.bundle, e->glyphOffset);
+        out->baseSize = e->baseSize;
+        out->glyphCount = e->glyphCount;
+        out->glyphPadding = e->glyphPadding;
+        out->recs = MemAlloc((unsigned int)(e->glyphCount * sizeof(Rectangle)));
+        out->glyphs = MemAlloc((unsigned int)(e->glyphCount * sizeof(GlyphInfo)));
+        for (int i = 0; i < e->glyphCount; ++i) {
+            out->recs[i] = (Rectangle){ src[i].x, src[i].y, src[i].width, src[i].height };
+            out->glyphs[i].value = src[i].value;
+            out->glyphs[i].offsetX = src[i].offsetX;
+            out->glyphs[i].offsetY = src[i].offsetY;
+            out->glyphs[i].advanceX = src[i].advanceX;
+        }
+    }
+    return true;
+}
 
+static bool StageFromFile(const AssetSlot* slot, StagedAsset* out)
+{
     char path[512];
-    snprintf(path, sizeof(path), "%s%s", ASSET_PATH, file);
+    snprintf(path, sizeof(path), "%s%s", slot->basePath, slot->file);
+    if (!FileExists(path)) return false;
 
-    if (FileExists(path)) {
-        *outTex = LoadTexture(path);
-        *outFlag = (*outTex).id != 0;
-        return *outFlag;
+    if (slot->tex != NULL) {
+        out->image = LoadImage(path);
+        out->ownsPixels = true;
+        return out->image.data != NULL;
     }
-    *outFlag = false;
-    return false;
+
+    // Font: rasterize the atlas here the same way LoadFontEx would
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(path, &dataSize);
+    if (data == NULL) return false;
+
+    out->baseSize = FONT_BASE_SIZE;
+    out->glyphCount = 95;
+    out->glyphPadding = 4;
+    out->glyphs = LoadFontData(data, dataSize, out->baseSize, NULL, out->glyphCount, FONT_DEFAULT);
+    UnloadFileData(data);
+    if (out->glyphs == NULL) return false;
+
+    out->image = GenImageFontAtlas(out->glyphs, &out->recs, out->glyphCount, out->baseSize, out->glyphPadding, 0);
+    out->ownsPixels = true;
+    return out->image.data != NULL;
 }
 
-static bool LoadFontIfExists(Font* outFont, bool* outFlag, const char* basePath, const char* file, int fontSize)
+static void* LoaderThreadMain(void* arg)
 {
-    if (file == NULL) { *outFlag = false; return false; }
+    (void)arg;
+    TraceThreadName("assets");
+    for (int i = 0; i < gLoader.slotCount; ++i) {
+        StagedAsset* out = &gLoader.staged[i];
+        TRACE_BEGIN("StageAsset");
+        out->ok = StageFromBundle(&gLoader.slots[i], out) || StageFromFile(&gLoader.slots[i], out);
+        TRACE_END("StageAsset");
 
-    char path[512];
-    snprintf(path, sizeof(path), "%s%s", basePath, file);
+        pthread_mutex_lock(&gLoader.lock);
+        gLoader.stagedCount = i + 1;
+        pthread_mutex_unlock(&gLoader.lock);
+    }
+    return NULL;
+}
 
-    if (FileExists(path)) {
-        *outFont = LoadFontEx(path, fontSize, 0, 0);
-        *outFlag = (*outFont).texture.id != 0;
-        return *outFlag;
+static void ReleaseStaged(StagedAsset* s, bool keepFontTables)
+{
+    if (s->ownsPixels && s->image.data != NULL) UnloadImage(s->image);
+    if (!keepFontTables) {
+        if (s->glyphs != NULL) UnloadFontData(s->glyphs, s->glyphCount);
+        if (s->recs != NULL) MemFree(s->recs);
     }
-    *outFlag = false;
-    return false;
+    memset(s, 0, sizeof(*s));
 }
 
-void AssetsLoadAll(void)
+static void UploadStaged(const AssetSlot* slot, StagedAsset* s)
+{
+    if (!s->ok) {
+        ReleaseStaged(s, false);
+        return;
+    }
+
+    Texture2D tex = LoadTextureFromImage(s->image);
+    if (slot->tex != NULL) {
+        *slot->tex = tex;
+        *slot->flag = tex.id != 0;
+        ReleaseStaged(s, false);
+        return;
+    }
+
+    Font font = { 0 };
+    font.baseSize = s->baseSize;
+    font.glyphCount = s->glyphCount;
+    font.glyphPadding = s->glyphPadding;
+    font.texture = tex;
+    font.recs = s->recs;
+    font.glyphs = s->glyphs;
+    gAssets.customFont = font;
+    *slot->flag = tex.id != 0;
+    ReleaseStaged(s, *slot->flag); // font owns recs/glyphs from here on
+}
+
+static void JoinLoader(void)
 {
-    // Coral textures (index 0 unused)
-    for (int i = 0; i < 5; ++i) {
-        gAssets.coralLoaded[i] = false;
+    if (gLoader.threadStarted) {
+        pthread_join(gLoader.thread, NULL);
+        gLoader.threadStarted = false;
     }
+}
+
+void AssetsBeginLoad(void)
+{
+    if (gLoader.active) return;
+
+    gLoader.slotCount = 0;
+    gLoader.stagedCount = 0;
+    gLoader.uploadedCount = 0;
+
+    // Title first so it can be on screen while the rest streams in
+    AddSlot(ASSET_PATH, TEX_TITLE_FILE, &gAssets.title, &gAssets.titleLoaded);
     for (int i = 1; i <= 4; ++i) {
-        LoadTextureIfExists(&gAssets.coral[i], &gAssets.coralLoaded[i], TEX_CORAL_FILE[i]);
+        AddSlot(ASSET_PATH, TEX_CORAL_FILE[i], &gAssets.coral[i], &gAssets.coralLoaded[i]);
+    }
+    AddSlot(ASSET_PATH, TEX_GAMEBOARD_FILE,  &gAssets.gameboard, &gAssets.gameboardLoaded);
+    AddSlot(ASSET_PATH, TEX_CARD_BG_FILE,    &gAssets.cardBg,    &gAssets.cardBgLoaded);
+    AddSlot(ASSET_PATH, TEX_DECK_BACK_FILE,  &gAssets.deckBack,  &gAssets.deckBackLoaded);
+    AddSlot(ASSET_PATH, TEX_BOARD_CELL_FILE, &gAssets.boardCell, &gAssets.boardCellLoaded);
+    AddSlot(ASSET_PATH, TEX_TOKEN_FILE,      &gAssets.token,     &gAssets.tokenLoaded);
+    AddSlot(FONT_PATH,  FONT_FILE,           NULL,               &gAssets.fontLoaded);
+
+    gLoader.bundleOpen = BundleOpen(&gLoader.bundle, BUNDLE_FILE);
+    gLoader.active = true;
+
+    gLoader.threadStarted = pthread_create(&gLoader.thread, NULL, LoaderThreadMain, NULL) == 0;
+    if (!gLoader.threadStarted) {
+        LoaderThreadMain(NULL); // no thread available: stage inline
+    }
+}
+
+bool AssetsPollLoad(void)
+{
+    if (!gLoader.active) return true;
+
+    pthread_mutex_lock(&gLoader.lock);
+    int staged = gLoader.stagedCount;
+    pthread_mutex_unlock(&gLoader.lock);
+
+    while (gLoader.uploadedCount < staged) {
+        int i = gLoader.uploadedCount++;
+        TRACE_BEGIN("UploadAsset");
+        UploadStaged(&gLoader.slots[i], &gLoader.staged[i]);
+        TRACE_END("UploadAsset");
+    }
+
+    if (gLoader.uploadedCount < gLoader.slotCount) return false;
+
+    // Everything lives on the GPU now; the mapping is no longer needed
+    JoinLoader();
+    if (gLoader.bundleOpen) {
+        BundleClose(&gLoader.bundle);
+        gLoader.bundleOpen = false;
     }
+    gLoader.active = false;
+    return true;
+}
 
-    // Other textures
-    gAssets.cardBgLoaded   = false;
-    gAssets.deckBackLoaded = false;
-    gAssets.boardCellLoaded= false;
-    gAssets.tokenLoaded    = false;
-    gAssets.gameboardLoaded= false;
-    gAssets.fontLoaded     = false;
-
-    LoadTextureIfExists(&gAssets.cardBg,   &gAssets.cardBgLoaded,   TEX_CARD_BG_FILE);
-    LoadTextureIfExists(&gAssets.deckBack, &gAssets.deckBackLoaded, TEX_DECK_BACK_FILE);
-    LoadTextureIfExists(&gAssets.boardCell,&gAssets.boardCellLoaded,TEX_BOARD_CELL_FILE);
-    LoadTextureIfExists(&gAssets.token,    &gAssets.tokenLoaded,    TEX_TOKEN_FILE);
-    LoadTextureIfExists(&gAssets.gameboard,&gAssets.gameboardLoaded,TEX_GAMEBOARD_FILE);
-    
-    // Load custom font at base size 32 (will be scaled as needed)
-    LoadFontIfExists(&gAssets.customFont, &gAssets.fontLoaded, FONT_PATH, FONT_FILE, 32);
+float AssetsLoadProgress(void)
+{
+    if (!gLoader.active || gLoader.slotCount == 0) return 1.0f;
+    return (float)gLoader.uploadedCount / (float)gLoader.slotCount;
+}
+
+void AssetsLoadAll(void)
+{
+    AssetsBeginLoad();
+    JoinLoader();
+    AssetsPollLoad();
 }
 
 void AssetsUnloadAll(void)
 {
+    // Closing during startup: let the loader finish, then drop what never made it to the GPU
+    if (gLoader.active) {
+        JoinLoader();
+        for (int i = gLoader.uploadedCount; i < gLoader.slotCount; ++i) {
+            ReleaseStaged(&gLoader.staged[i], false);
+        }
+        if (gLoader.bundleOpen) {
+            BundleClose(&gLoader.bundle);
+            gLoader.bundleOpen = false;
+        }
+        gLoader.active = false;
+    }
+
     for (int i = 1; i <= 4; ++i) {
         if (gAssets.coralLoaded[i]) {
             UnloadTexture(gAssets.coral[i]);
@@ -78,5 +280,6 @@ void AssetsUnloadAll(void)
     if (gAssets.boardCellLoaded){ UnloadTexture(gAssets.boardCell);  gAssets.boardCellLoaded = false; }
     if (gAssets.tokenLoaded)    { UnloadTexture(gAssets.token);      gAssets.tokenLoaded = false; }
     if (gAssets.gameboardLoaded){ UnloadTexture(gAssets.gameboard);  gAssets.gameboardLoaded = false; }
+    if (gAssets.titleLoaded)    { UnloadTexture(gAssets.title);      gAssets.titleLoaded = false; }
     if (gAssets.fontLoaded)     { UnloadFont(gAssets.customFont);    gAssets.fontLoaded = false; }
 }
@@ -22,13 +22,23 @@ typedef struct {
     Texture2D gameboard;
     bool gameboardLoaded;
 
+    Texture2D title;
+    bool titleLoaded;
+
     Font customFont;
     bool fontLoaded;
 } Assets;
 
 extern Assets gAssets;
 
-void AssetsLoadAll(void);
+// Asynchronous loading: a loader thread maps the packed bundle (or decodes the
+// loose files when no bundle is present) and only the GPU upload happens on
+// the main thread inside AssetsPollLoad. The title screen is staged first.
+void  AssetsBeginLoad(void);
+bool  AssetsPollLoad(void);      // call once per frame; true once everything is uploaded
+float AssetsLoadProgress(void);  // 0..1
+
+void AssetsLoadAll(void);        // blocking Begin + Poll until done
 void AssetsUnloadAll(void);
 
 #endif
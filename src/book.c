@@ -0,0 +1,219 @@
+#define _DEFAULT_SOURCE
+#include "book.h"
+#include "cards.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static CoralStack gOpeningBoard[BOARD_SIZE][BOARD_SIZE];
+static pthread_once_t gOpeningOnce = PTHREAD_ONCE_INIT;
+
+static void BuildOpeningBoard(void)
+{
+    GameState g;
+    RulesNewGame(&g, PLAYERS_MIN, 1);
+    memcpy(gOpeningBoard, g.players[0].board, sizeof(gOpeningBoard));
+}
+
+static int Binomial(int n, int k)
+{
+    if (k < 0 || k > n) return 0;
+    int r = 1;
+    for (int i = 1; i <= k; ++i) r = r * (n - k + i) / i;
+    return r;
+}
+
+static void SortKinds(int* kinds, int n)
+{
+    for (int i = 1; i < n; ++i) {
+        int v = kinds[i], j = i;
+        for (; j > 0 && kinds[j - 1] > v; --j) kinds[j] = kinds[j - 1];
+        kinds[j] = v;
+    }
+}
+
+// Multisets of size k over CARD_KIND_COUNT kinds, ranked with the
+// combinatorial number system (sorted kind + position is strictly increasing)
+static int RankMultiset(const int* kinds, int k)
+{
+    int sorted[CARD_DISPLAY_SIZE];
+    memcpy(sorted, kinds, (size_t)k * sizeof(int));
+    SortKinds(sorted, k);
+    int rank = 0;
+    for (int i = 0; i < k; ++i) rank += Binomial(sorted[i] + i, i + 1);
+    return rank;
+}
+
+static void UnrankMultiset(int rank, int* kinds, int k)
+{
+    for (int i = k - 1; i >= 0; --i) {
+        int b = i;
+        while (Binomial(b + 1, i + 1) <= rank) ++b;
+        rank -= Binomial(b, i + 1);
+        kinds[i] = b - i;
+    }
+}
+
+static int MultisetCount(int k)
+{
+    return Binomial(CARD_KIND_COUNT + k - 1, k);
+}
+
+int BookEntryCount(void)
+{
+    return MultisetCount(BOOK_HAND_SIZE) * MultisetCount(CARD_DISPLAY_SIZE);
+}
+
+int BookIndex(const int handKinds[BOOK_HAND_SIZE], const int displayKinds[CARD_DISPLAY_SIZE])
+{
+    return RankMultiset(displayKinds, CARD_DISPLAY_SIZE) * MultisetCount(BOOK_HAND_SIZE) +
+           RankMultiset(handKinds, BOOK_HAND_SIZE);
+}
+
+void BookDecodeIndex(int index, int handKinds[BOOK_HAND_SIZE], int displayKinds[CARD_DISPLAY_SIZE])
+{
+    int hands = MultisetCount(BOOK_HAND_SIZE);
+    UnrankMultiset(index % hands, handKinds, BOOK_HAND_SIZE);
+    UnrankMultiset(index / hands, displayKinds, CARD_DISPLAY_SIZE);
+}
+
+static void HashInt(uint64_t* h, int v)
+{
+    for (int i = 0; i < 4; ++i) {
+        *h ^= (uint8_t)(v >> (8 * i));
+        *h *= 0x100000001B3ull;  // FNV-1a
+    }
+}
+
+uint64_t BookCatalogHash(void)
+{
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+        const Card* c = &CARD_KINDS[k];
+        const ScoringPattern* p = &c->pattern;
+        HashInt(&h, c->piece1);
+        HashInt(&h, c->piece2);
+        HashInt(&h, p->type);
+        HashInt(&h, p->width);
+        HashInt(&h, p->height);
+        HashInt(&h, p->pointValue);
+        for (int r = 0; r < p->height; ++r) {
+            for (int col = 0; col < p->width; ++col) {
+                const PatternCell* cell = &p->cells[r][col];
+                HashInt(&h, cell->color);
+                HashInt(&h, cell->minHeight);
+                HashInt(&h, cell->exactHeight);
+                HashInt(&h, cell->isWild);
+            }
+        }
+    }
+    return h;
+}
+
+bool BookOpen(Book* b, const char* path)
+{
+    memset(b, 0, sizeof(*b));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BookHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const BookHeader* h = (const BookHeader*)map;
+    size_t tableEnd = sizeof(BookHeader) + (size_t)h->entryCount * sizeof(BookEntry);
+    if (h->magic != BOOK_MAGIC || h->version != BOOK_VERSION || h->entryCount != (uint32_t)BookEntryCount() ||
+        tableEnd > (size_t)st.st_size || h->catalogHash != BookCatalogHash()) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    b->base = (const uint8_t*)map;
+    b->size = (size_t)st.st_size;
+    b->entries = (const BookEntry*)(h + 1);
+    b->entryCount = h->entryCount;
+    return true;
+}
+
+void BookClose(Book* b)
+{
+    if (b->base != NULL) {
+        munmap((void*)b->base, b->size);
+    }
+    memset(b, 0, sizeof(*b));
+}
+
+bool BookLookup(const Book* b, const GameState* g, Action* out)
+{
+    if (b == NULL || b->base == NULL || g->gameEnded) return false;
+    if (g->playersCount != BOOK_PLAYERS || g->currentPlayer != BOOK_SEAT) return false;
+
+    // Cheap checks first: untouched points and display, two cards in play
+    const Player* pl = &g->players[g->currentPlayer];
+    const PlacementState* pm = &g->placement;
+    if (pl->points != INITIAL_POINTS) return false;
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+        if (g->displayTokens[i] != 0) return false;
+    }
+
+    int hand[BOOK_HAND_SIZE], display[CARD_DISPLAY_SIZE];
+    if (pm->active) {
+        if (pl->handSize != 1) return false;
+        hand[0] = CardKind(pl->hand[0]);
+        hand[1] = CardKind(pm->card);
+    } else {
+        if (pl->handSize != BOOK_HAND_SIZE) return false;
+        for (int i = 0; i < BOOK_HAND_SIZE; ++i) hand[i] = CardKind(pl->hand[i]);
+    }
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) display[i] = CardKind(g->display[i]);
+
+    const BookEntry* e = &b->entries[BookIndex(hand, display)];
+    if (e->type == ACTION_NONE) return false;
+    if (pm->active && (e->type != ACTION_PLAY_CARD || e->kind != CardKind(pm->card))) return false;
+
+    // The board must be the opening one plus the pieces this line placed
+    pthread_once(&gOpeningOnce, BuildOpeningBoard);
+    CoralStack expected[BOARD_SIZE][BOARD_SIZE];
+    memcpy(expected, gOpeningBoard, sizeof(expected));
+    int placed = pm->active ? pm->piecesPlaced : 0;
+    for (int i = 0; i < placed; ++i) {
+        if (e->cells[i] == BOOK_NO_CELL) return false;
+        CoralStack* s = &expected[e->cells[i] / BOARD_SIZE][e->cells[i] % BOARD_SIZE];
+        if (s->height >= MAX_STACK_HEIGHT) return false;
+        s->pieces[s->height++] = (uint8_t)pm->piecesToPlace[i];
+    }
+    if (memcmp(expected, pl->board, sizeof(expected)) != 0) return false;
+
+    *out = (Action){ e->type, 0, 0, 0 };
+    if (pm->active) {
+        if (placed >= 2 || e->cells[placed] == BOOK_NO_CELL) return false;
+        *out = (Action){ ACTION_PLACE_CORAL, 0, (uint8_t)(e->cells[placed] / BOARD_SIZE), (uint8_t)(e->cells[placed] % BOARD_SIZE) };
+        return true;
+    }
+    switch (e->type) {
+        case ACTION_TAKE_MARKET:
+            for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+                if (display[i] == e->kind) { out->index = (uint8_t)i; return true; }
+            }
+            return false;
+        case ACTION_PLAY_CARD:
+            for (int i = 0; i < BOOK_HAND_SIZE; ++i) {
+                if (hand[i] == e->kind) { out->index = (uint8_t)i; return true; }
+            }
+            return false;
+        case ACTION_DRAW_DECK:
+            return g->deckSize > 0;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include "rules.h"
+
+// Opening book (built offline by tools/reefbook).
+//
+// Every game opens on the same boards, so a first turn is decided by the
+// mover's two cards and the three display cards alone. The book is built
+// for the first mover of a two-player game (BOOK_PLAYERS, BOOK_SEAT) and
+// answers nothing else: with more players, or from a later seat, the
+// opponents and the display differ and its moves do not carry over.
+// Positions are keyed by card kind, sorted, which folds copies and slot
+// order together; the key ranks into a dense table, so a lookup is one
+// array index into an mmap.
+//
+// Layout: BookHeader | BookEntry[entryCount], entry i for key rank i.
+
+#define BOOK_MAGIC   0x4B4F4252u  // "RBOK"
+#define BOOK_VERSION 1u
+
+enum {
+    BOOK_HAND_SIZE = 2,
+    BOOK_PLAYERS   = 2,      // the table the book is built for
+    BOOK_SEAT      = 0,      // and the seat it moves for
+    BOOK_NO_CELL   = 0xFF
+};
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t rollouts;       // builder settings, informational
+    uint32_t turns;
+    uint32_t reserved;
+    uint64_t catalogHash;    // BookCatalogHash() of the cards it was built for
+} BookHeader;
+
+// The best whole first turn for one position
+typedef struct {
+    uint8_t  type;           // ActionType of the first action, ACTION_NONE if unbuilt
+    uint8_t  kind;           // card kind taken or played
+    uint8_t  cells[2];       // row * BOARD_SIZE + col per placed piece, BOOK_NO_CELL if unused
+    int16_t  value;          // expected evaluation after the rollouts, x100
+    uint16_t samples;
+} BookEntry;
+
+typedef struct {
+    const uint8_t*   base;
+    size_t           size;
+    const BookEntry* entries;
+    uint32_t         entryCount;
+} Book;
+
+// Number of distinct opening keys (and entries in a book)
+int BookEntryCount(void);
+
+// Rank a key; kinds may be in any order
+int  BookIndex(const int handKinds[BOOK_HAND_SIZE], const int displayKinds[CARD_DISPLAY_SIZE]);
+void BookDecodeIndex(int index, int handKinds[BOOK_HAND_SIZE], int displayKinds[CARD_DISPLAY_SIZE]);
+
+// Fingerprint of the card catalog; a book built for other cards is rejected
+uint64_t BookCatalogHash(void);
+
+bool BookOpen(Book* b, const char* path);
+void BookClose(Book* b);
+
+// Book move for the current player, also mid-turn while the book's card is
+// being placed. False when g is not an opening position, has no entry, or
+// is not the book's table and seat.
+bool BookLookup(const Book* b, const GameState* g, Action* out);
+
+#endif
@@ -0,0 +1,274 @@
+#include "bot.h"
+#include "cards.h"
+#include "patterns.h"
+#include "rng.h"
+#include "synergy.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Any finished game outranks every unfinished evaluation
+#define BOT_WIN_SCORE 1000.0f
+
+const char* BOT_WEIGHT_NAME[BOT_WEIGHT_COUNT] = { "points", "hand", "cards", "height", "synergy", "supply", "tokens", "unseen" };
+
+static const char* BOT_KIND_NAME[] = { "random", "greedy" };
+
+static const float BOT_DEFAULT_WEIGHTS[BOT_WEIGHT_COUNT] = { 1.0f, 0.5f, 0.3f, 0.05f, 0.8f, 0.0f, 0.0f, 5.0f };
+
+void BotDefaultConfig(BotConfig* cfg, BotKind kind)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->kind = kind;
+    snprintf(cfg->name, sizeof(cfg->name), "%s", BOT_KIND_NAME[kind]);
+    memcpy(cfg->weights, BOT_DEFAULT_WEIGHTS, sizeof(cfg->weights));
+}
+
+bool BotParseConfig(const char* spec, BotConfig* cfg)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", spec);
+
+    char* name = NULL;
+    char* kind = buf;
+    char* eq = strchr(buf, '=');
+    char* colon = strchr(buf, ':');
+    if (eq != NULL && (colon == NULL || eq < colon)) {
+        *eq = '\0';
+        name = buf;
+        kind = eq + 1;
+    }
+
+    char* params = strchr(kind, ':');
+    if (params != NULL) *params++ = '\0';
+
+    if (strcmp(kind, "random") == 0)      BotDefaultConfig(cfg, BOT_RANDOM);
+    else if (strcmp(kind, "greedy") == 0) BotDefaultConfig(cfg, BOT_GREEDY);
+    else return false;
+
+    for (char* tok = params; tok != NULL && *tok != '\0'; ) {
+        char* next = strchr(tok, ',');
+        if (next != NULL) *next++ = '\0';
+        char* value = strchr(tok, '=');
+        if (value == NULL) return false;
+        *value++ = '\0';
+        if (strcmp(tok, "book") == 0) {
+            cfg->useBook = atoi(value) != 0;
+        } else {
+            int w = 0;
+            while (w < BOT_WEIGHT_COUNT && strcmp(tok, BOT_WEIGHT_NAME[w]) != 0) ++w;
+            if (w == BOT_WEIGHT_COUNT) return false;
+            cfg->weights[w] = strtof(value, NULL);
+        }
+        tok = next;
+    }
+
+    snprintf(cfg->name, sizeof(cfg->name), "%.31s", name ? name : spec);
+    return true;
+}
+
+// 0 with every supply full, 1 once a color is out (the final round)
+static float SupplyPressure(const GameState* g)
+{
+    int full = SUPPLY_PER_COLOR[g->playersCount];
+    int least = full;
+    for (int c = CORAL_YELLOW; c <= CORAL_GREEN; ++c) {
+        if (g->supplies[c] < least) least = g->supplies[c];
+    }
+    return full > 0 ? 1.0f - (float)least / (float)full : 0.0f;
+}
+
+// Each kind's score on recent boards, per thread and filled in as kinds
+// are asked for: the opponent's board stays the same through a whole turn
+// search and the mover's recurs across lines, so most lookups are hits
+enum { BOT_KIND_CACHE = 256 };
+
+typedef struct {
+    BoardMasks masks;
+    uint64_t scored;                   // bit per kind
+    int16_t score[CARD_KIND_COUNT];
+} KindScores;
+
+static _Thread_local KindScores tKindScores[BOT_KIND_CACHE];
+
+static KindScores* KindScoresFor(const BoardMasks* masks)
+{
+    uint32_t h = 2166136261u;
+    const uint16_t* w = (const uint16_t*)masks;
+    for (size_t i = 0; i < sizeof(*masks) / sizeof(uint16_t); ++i) h = (h ^ w[i]) * 16777619u;
+    KindScores* e = &tKindScores[(h ^ (h >> 16)) % BOT_KIND_CACHE];
+    if (memcmp(&e->masks, masks, sizeof(*masks)) != 0) {
+        e->masks = *masks;
+        e->scored = 0;
+    }
+    return e;
+}
+
+static int KindScore(KindScores* e, int kind)
+{
+    if (!(e->scored & ((uint64_t)1 << kind))) {
+        e->score[kind] = (int16_t)ScoreCompiled(&e->masks, &CARD_PATTERNS[kind]);
+        e->scored |= (uint64_t)1 << kind;
+    }
+    return e->score[kind];
+}
+
+// Closed form over viewer's unseen counts, scored on e's board; kinds with
+// no unseen copies are not scored
+static float UnseenValue(const Player* viewer, KindScores* e)
+{
+    float value[CARD_KIND_COUNT];
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) value[k] = viewer->unseen[k] > 0 ? (float)KindScore(e, k) : 0.0f;
+    return CardsUnseenMean(viewer, value);
+}
+
+// Features of pl that its board and hand decide, as seer knows them: when
+// pl is another player, its face-down cards count as the mean of what seer
+// has not seen, and so does the card pl would draw next
+static void HandFeatures(const Player* pl, const Player* seer, bool other, bool weighUnseen, float* f)
+{
+    unsigned hidden = other ? pl->hiddenHand : 0;
+    BoardMasks masks;
+    BoardMasksBuild(pl, &masks);
+    KindScores* scores = KindScoresFor(&masks);
+    int hand = 0, faceDown = 0;
+    for (int i = 0; i < pl->handSize; ++i) {
+        if (hidden & (1u << i)) faceDown++;
+        else hand += KindScore(scores, CardKind(pl->hand[i]));
+    }
+    int height = 0;
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) height += pl->board[r][c].height;
+    }
+    bool unseen = weighUnseen || faceDown > 0;
+    float unseenValue = unseen ? UnseenValue(other ? seer : pl, scores) : 0.0f;
+
+    f[BOT_W_POINTS] = (float)pl->points;
+    f[BOT_W_HAND] = (float)hand + unseenValue * (float)faceDown;
+    f[BOT_W_CARDS] = (float)pl->handSize;
+    f[BOT_W_HEIGHT] = (float)height;
+    f[BOT_W_SYNERGY] = pl->handSize == 0 ? 0.0f : faceDown > 0 ? SynergyHandAsSeen(pl, height, seer) : SynergyHand(pl, height);
+    f[BOT_W_UNSEEN] = weighUnseen ? unseenValue : 0.0f;
+}
+
+// The opponent's hand features for the last opponent asked about, per
+// thread: through a turn search only the mover's side changes, and the
+// opponent's features would otherwise be rebuilt for every line
+typedef struct {
+    Player pl;
+    uint8_t unseen[CARD_KIND_COUNT];  // the viewer's
+    bool weighUnseen;
+} TheirKey;
+
+static _Thread_local struct {
+    TheirKey key;
+    float f[BOT_WEIGHT_COUNT];
+    bool valid;
+} tTheirs;
+
+static void PlayerFeatures(const GameState* g, int player, int viewer, float pressure, const BotConfig* cfg, float* f)
+{
+    const Player* pl = &g->players[player];
+    const Player* seer = &g->players[viewer];
+    bool weighUnseen = cfg->weights[BOT_W_UNSEEN] != 0.0f;
+    if (player == viewer) {
+        HandFeatures(pl, seer, false, weighUnseen, f);
+    } else {
+        TheirKey key;
+        memset(&key, 0, sizeof(key));
+        memcpy(&key.pl, pl, sizeof(key.pl));
+        memcpy(key.unseen, seer->unseen, sizeof(key.unseen));
+        key.weighUnseen = weighUnseen;
+        if (!tTheirs.valid || memcmp(&tTheirs.key, &key, sizeof(key)) != 0) {
+            HandFeatures(pl, seer, true, weighUnseen, tTheirs.f);
+            tTheirs.key = key;
+            tTheirs.valid = true;
+        }
+        memcpy(f, tTheirs.f, sizeof(tTheirs.f));
+    }
+    f[BOT_W_SUPPLY] = pressure * (float)pl->points;
+
+    int tokens = 0;
+    if (player == g->currentPlayer && pl->handSize < MAX_HAND_SIZE) {
+        for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+            if (g->displayTokens[i] > tokens) tokens = g->displayTokens[i];
+        }
+    }
+    f[BOT_W_TOKENS] = (float)tokens;
+}
+
+float BotEvaluate(const GameState* g, int player, const BotConfig* cfg)
+{
+    const Player* me = &g->players[player];
+    int opp = -1;
+    for (int p = 0; p < g->playersCount; ++p) {
+        if (p != player && (opp < 0 || g->players[p].points > g->players[opp].points)) opp = p;
+    }
+    if (opp < 0) return (float)me->points;
+
+    if (g->gameEnded) {
+        float diff = (float)(me->points - g->players[opp].points);
+        if (diff > 0) return BOT_WIN_SCORE + diff;
+        if (diff < 0) return -BOT_WIN_SCORE + diff;
+        return 0.0f;
+    }
+
+    float pressure = SupplyPressure(g);
+    float mine[BOT_WEIGHT_COUNT], theirs[BOT_WEIGHT_COUNT];
+    PlayerFeatures(g, player, player, pressure, cfg, mine);
+    PlayerFeatures(g, opp, player, pressure, cfg, theirs);
+
+    float v = 0.0f;
+    for (int i = 0; i < BOT_WEIGHT_COUNT; ++i) v += cfg->weights[i] * (mine[i] - theirs[i]);
+    return v;
+}
+
+typedef struct {
+    const BotConfig* cfg;
+    int me;
+    uint64_t* rng;
+    float best;
+    int ties;
+    Action choice;
+} TurnSearch;
+
+// Walk every line until the turn passes, remembering the first action of
+// the best one (ties broken uniformly)
+static void SearchTurn(TurnSearch* s, const GameState* g, Action first, int depth)
+{
+    if (g->gameEnded || (depth > 0 && g->currentPlayer != s->me)) {
+        float v = BotEvaluate(g, s->me, s->cfg);
+        if (s->ties == 0 || v > s->best) {
+            s->best = v;
+            s->ties = 1;
+            s->choice = first;
+        } else if (v == s->best && RngRange(s->rng, ++s->ties) == 0) {
+            s->choice = first;
+        }
+        return;
+    }
+
+    Action legal[RULES_MAX_ACTIONS];
+    int n = RulesListActions(g, legal);
+    for (int i = 0; i < n; ++i) {
+        GameState next;
+        RulesCopyState(&next, g);
+        if (!RulesApply(&next, legal[i])) continue;
+        SearchTurn(s, &next, depth == 0 ? legal[i] : first, depth + 1);
+    }
+}
+
+Action BotChooseAction(const GameState* g, const BotConfig* cfg, uint64_t* rng)
+{
+    Action legal[RULES_MAX_ACTIONS];
+    int n = RulesListActions(g, legal);
+    if (n == 0) return (Action){ ACTION_NONE, 0, 0, 0 };
+
+    Action booked;
+    if (cfg->book != NULL && BookLookup(cfg->book, g, &booked)) return booked;
+    if (cfg->kind == BOT_RANDOM || n == 1) return legal[RngRange(rng, n)];
+
+    TurnSearch s = { cfg, g->currentPlayer, rng, 0.0f, 0, legal[0] };
+    SearchTurn(&s, g, legal[0], 0);
+    return s.choice;
+}
@@ -0,0 +1,57 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "book.h"
+#include "rules.h"
+
+// Computer players. A bot is plain data (BotConfig), so tournaments, tuners
+// and the in-game opponent can run many of them side by side.
+//
+//   random   uniform over legal actions
+//   greedy   searches the rest of its own turn (take, draw, or play and
+//            both placements) and keeps the line with the best evaluation
+//
+// Either kind plays from an opening book first when one is attached.
+
+typedef enum {
+    BOT_RANDOM = 0,
+    BOT_GREEDY
+} BotKind;
+
+// Evaluation terms, all relative to the strongest opponent
+typedef enum {
+    BOT_W_POINTS = 0,  // point lead
+    BOT_W_HAND,        // what the hand would score on the board as it stands
+    BOT_W_CARDS,       // cards held
+    BOT_W_HEIGHT,      // total stack height
+    BOT_W_SYNERGY,     // what the best play could add to the hand (synergy.h)
+    BOT_W_SUPPLY,      // point lead, scaled by how near the scarcest color is to running out
+    BOT_W_TOKENS,      // display tokens the player to move could collect
+    BOT_W_UNSEEN,      // what the next card out of hiding is expected to score on the board (cards.h)
+    BOT_WEIGHT_COUNT
+} BotWeight;
+
+extern const char* BOT_WEIGHT_NAME[BOT_WEIGHT_COUNT];
+
+typedef struct {
+    char name[32];
+    BotKind kind;
+    float weights[BOT_WEIGHT_COUNT];
+    bool useBook;            // spec asked for "book=1"; the host attaches it
+    const Book* book;        // optional, not owned
+} BotConfig;
+
+void BotDefaultConfig(BotConfig* cfg, BotKind kind);
+
+// "random", "greedy" or "greedy:hand=0.5,height=0.2,book=1"; an optional
+// "name=" prefix ("v2=greedy:cards=1") sets the display name
+bool BotParseConfig(const char* spec, BotConfig* cfg);
+
+// Static evaluation of g from player's point of view; finished games are
+// decided by the final score alone
+float BotEvaluate(const GameState* g, int player, const BotConfig* cfg);
+
+// Pick an action for the current player; rng breaks ties
+Action BotChooseAction(const GameState* g, const BotConfig* cfg, uint64_t* rng);
+
+#endif
@@ -0,0 +1,100 @@
+#define _DEFAULT_SOURCE
+#include "bundle.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// [offset, offset + size) within a file of fileSize bytes, without the
+// sum overflowing for hostile offsets
+static bool InFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+bool BundleOpen(Bundle* b, const char* path)
+{
+    memset(b, 0, sizeof(*b));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(BundleHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (map == MAP_FAILED) return false;
+
+    const BundleHeader* h = (const BundleHeader*)map;
+    size_t tableEnd = sizeof(BundleHeader) + (size_t)h->entryCount * sizeof(BundleEntry);
+    if (h->magic != BUNDLE_MAGIC || h->version != BUNDLE_VERSION || tableEnd > (size_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    // Reject entries pointing outside the file instead of faulting later
+    const BundleEntry* entries = (const BundleEntry*)(h + 1);
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        const BundleEntry* e = &entries[i];
+        bool bad = !InFile(e->offset, e->size, (uint64_t)st.st_size);
+        if (e->kind == BUNDLE_ENTRY_FONT) {
+            bad = bad || e->glyphCount <= 0 ||
+                  !InFile(e->glyphOffset, (uint64_t)e->glyphCount * sizeof(BundleGlyph), (uint64_t)st.st_size);
+        }
+        if (bad) {
+            munmap(map, (size_t)st.st_size);
+            return false;
+        }
+    }
+
+    b->base = (const uint8_t*)map;
+    b->size = (size_t)st.st_size;
+    b->entries = entries;
+    b->entryCount = h->entryCount;
+    return true;
+}
+
+void BundleClose(Bundle* b)
+{
+    if (b->base != NULL) {
+        munmap((void*)b->base, b->size);
+    }
+    memset(b, 0, sizeof(*b));
+}
+
+const BundleEntry* BundleFind(const Bundle* b, const char* name)
+{
+    if (b->base == NULL || name == NULL) return NULL;
+    for (uint32_t i = 0; i < b->entryCount; ++i) {
+        if (strncmp(b->entries[i].name, name, BUNDLE_NAME_MAX) == 0) return &b->entries[i];
+    }
+    return NULL;
+}
+
+const void* BundleData(const Bundle* b, uint64_t offset)
+{
+    return b->base + offset;
+}
+
+void BundlePrefault(const Bundle* b, uint64_t offset, uint64_t size)
+{
+    if (b->base == NULL || !InFile(offset, size, b->size) || size == 0) return;
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    uint64_t start = offset - offset % (uint64_t)page;  // madvise wants page alignment
+    madvise((void*)(b->base + start), (size_t)(offset + size - start), MADV_WILLNEED);
+
+    // Touch one byte per page so the disk reads happen here and not
+    // inside the GPU upload on the main thread
+    volatile uint8_t sink = 0;
+    for (uint64_t off = offset; off < offset + size; off += (uint64_t)page) {
+        sink ^= b->base[off];
+    }
+    sink ^= b->base[offset + size - 1];
+    (void)sink;
+}
@@ -0,0 +1,69 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Packed asset bundle (resources/reef.pak), produced by tools/reefpack.
+// Every image is stored already decoded in a GPU-ready pixel format, so the
+// runtime only has to mmap the file and hand the pixels to the GPU.
+//
+// Layout: BundleHeader | BundleEntry[entryCount] | payloads (each aligned to
+// BUNDLE_ALIGN). A font entry's payload is its atlas pixels followed by
+// glyphCount BundleGlyph records at glyphOffset.
+
+#define BUNDLE_MAGIC   0x4B415052u  // "RPAK"
+#define BUNDLE_VERSION 1u
+#define BUNDLE_ALIGN   4096u        // page aligned so each payload maps cleanly
+
+enum {
+    BUNDLE_NAME_MAX = 48
+};
+
+typedef enum {
+    BUNDLE_ENTRY_IMAGE = 1,
+    BUNDLE_ENTRY_FONT  = 2
+} BundleEntryKind;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+} BundleHeader;
+
+typedef struct {
+    char     name[BUNDLE_NAME_MAX];  // source file name, e.g. "coral_red.png"
+    uint32_t kind;                   // BundleEntryKind
+    int32_t  width, height, format;  // pixel data (raylib PixelFormat)
+    uint64_t offset, size;           // pixel payload within the file
+
+    // Fonts only
+    int32_t  baseSize, glyphCount, glyphPadding;
+    uint32_t reserved;
+    uint64_t glyphOffset;            // BundleGlyph[glyphCount]
+} BundleEntry;
+
+typedef struct {
+    int32_t value, offsetX, offsetY, advanceX;
+    float   x, y, width, height;     // source rectangle in the atlas
+} BundleGlyph;
+
+typedef struct {
+    const uint8_t*     base;
+    size_t             size;
+    const BundleEntry* entries;
+    uint32_t           entryCount;
+} Bundle;
+
+bool BundleOpen(Bundle* b, const char* path);
+void BundleClose(Bundle* b);
+const BundleEntry* BundleFind(const Bundle* b, const char* name);
+const void* BundleData(const Bundle* b, uint64_t offset);
+
+// Pull [offset, offset + size) of the mapping into the page cache (call
+// from a loader thread, one entry at a time as it is staged)
+void BundlePrefault(const Bundle* b, uint64_t offset, uint64_t size);
+
+#endif
@@ -1,147 +1,141 @@
-#include <stdlib.h>
-#include <time.h>
 #include "cards.h"
-#include "patterns.h"
+#include "rng.h"
+#include <string.h>
 
-static void ShuffleDeckInternal(Card* deck, int n)
+static void ShuffleDeckInternal(CardId* deck, int n, uint64_t* rng)
 {
     for (int i = n - 1; i > 0; --i) {
-        int j = rand() % (i + 1);
-        Card tmp = deck[i];
+        int j = RngRange(rng, i + 1);
+        CardId tmp = deck[i];
         deck[i] = deck[j];
         deck[j] = tmp;
     }
 }
 
-// Create a variety of realistic Reef cards based on the image
-static Card CreateReefCard(int cardIndex) {
-    Card card = {0};
-    
-    // Define card templates based on the real Reef cards shown in the image
-    CoralColor colors[] = {CORAL_YELLOW, CORAL_ORANGE, CORAL_PURPLE, CORAL_GREEN};
-    
-    switch (cardIndex % 15) {
-        case 0: // Green pieces -> 2x2 yellow square (4 points)
-            card.piece1 = CORAL_GREEN;
-            card.piece2 = CORAL_GREEN;
-            card.pattern = CreateSquare2x2Pattern(CORAL_YELLOW, 4);
-            break;
-            
-        case 1: // Purple pieces -> 3 purple line (2 points)
-            card.piece1 = CORAL_PURPLE;
-            card.piece2 = CORAL_PURPLE;
-            card.pattern = CreateLine3Pattern(CORAL_PURPLE, 2);
-            break;
-            
-        case 2: // Orange pieces -> height-2 purple (1 point)
-            card.piece1 = CORAL_ORANGE;
-            card.piece2 = CORAL_ORANGE;
-            card.pattern = CreateHeight2Pattern(CORAL_PURPLE, 1);
-            break;
-            
-        case 3: // Yellow pieces -> height-2 any color (1 point)
-            card.piece1 = CORAL_YELLOW;
-            card.piece2 = CORAL_YELLOW;
-            card.pattern = CreateHeight2Pattern(CORAL_NONE, 1);
-            card.pattern.cells[0][0].isWild = true;
-            break;
-            
-        case 4: // Green pieces -> 2 green line (2 points)
-            card.piece1 = CORAL_GREEN;
-            card.piece2 = CORAL_GREEN;
-            card.pattern = CreateLine2Pattern(CORAL_GREEN, 2);
-            break;
-            
-        case 5: // Yellow + Green -> L-shape yellow (5 points)
-            card.piece1 = CORAL_YELLOW;
-            card.piece2 = CORAL_GREEN;
-            card.pattern = CreateLShapePattern(CORAL_YELLOW, 5);
-            break;
-            
-        case 6: // Green pieces -> height-3 green (5 points)
-            card.piece1 = CORAL_GREEN;
-            card.piece2 = CORAL_GREEN;
-            card.pattern = CreateHeight3Pattern(CORAL_GREEN, 5);
-            break;
-            
-        case 7: // Yellow + Orange -> 2x2 orange (2 points)
-            card.piece1 = CORAL_YELLOW;
-            card.piece2 = CORAL_ORANGE;
-            card.pattern = CreateSquare2x2Pattern(CORAL_ORANGE, 2);
-            break;
-            
-        case 8: // Purple pieces -> height-2+ purple (8 points)
-            card.piece1 = CORAL_PURPLE;
-            card.piece2 = CORAL_PURPLE;
-            card.pattern = CreateHeight2Pattern(CORAL_PURPLE, 8);
-            card.pattern.cells[0][0].minHeight = 2;
-            card.pattern.cells[0][0].exactHeight = 0;
-            break;
-            
-        case 9: // Orange + Red -> 3 orange line (4 points)
-            card.piece1 = CORAL_ORANGE;
-            card.piece2 = CORAL_ORANGE;
-            card.pattern = CreateLine3Pattern(CORAL_ORANGE, 4);
-            break;
-            
-        case 10: // Green pieces -> 2 green line (1 point)
-            card.piece1 = CORAL_GREEN;
-            card.piece2 = CORAL_GREEN;
-            card.pattern = CreateLine2Pattern(CORAL_GREEN, 1);
-            break;
-            
-        case 11: // Purple pieces -> 2x2 orange (8 points)
-            card.piece1 = CORAL_PURPLE;
-            card.piece2 = CORAL_PURPLE;
-            card.pattern = CreateSquare2x2Pattern(CORAL_ORANGE, 8);
-            break;
-            
-        case 12: // Orange + Yellow -> height-3 orange (5 points)
-            card.piece1 = CORAL_ORANGE;
-            card.piece2 = CORAL_YELLOW;
-            card.pattern = CreateHeight3Pattern(CORAL_ORANGE, 5);
-            break;
-            
-        case 13: // Purple pieces -> 3 purple line (5 points)
-            card.piece1 = CORAL_PURPLE;
-            card.piece2 = CORAL_PURPLE;
-            card.pattern = CreateLine3Pattern(CORAL_PURPLE, 5);
-            break;
-            
-        case 14: // Orange pieces -> 3 green line (4 points)
-            card.piece1 = CORAL_ORANGE;
-            card.piece2 = CORAL_ORANGE;
-            card.pattern = CreateLine3Pattern(CORAL_GREEN, 4);
-            break;
-            
-        default:
-            // Fallback pattern
-            card.piece1 = colors[cardIndex % 4];
-            card.piece2 = colors[(cardIndex + 1) % 4];
-            card.pattern = CreateLine2Pattern(colors[(cardIndex + 2) % 4], 2);
-            break;
+const Card* CardGet(CardId id)
+{
+    return &CARD_KINDS[CARD_ID_KIND[id]];
+}
+
+int CardKind(CardId id)
+{
+    return CARD_ID_KIND[id];
+}
+
+// player < 0: everyone
+static void Unsee(GameState* g, int player, CardId id, int delta)
+{
+    int kind = CardKind(id);
+    for (int p = 0; p < g->playersCount; ++p) {
+        if (player < 0 || p == player) g->players[p].unseen[kind] = (uint8_t)(g->players[p].unseen[kind] + delta);
     }
-    
-    return card;
+}
+
+static void RevealTop(GameState* g)
+{
+    if (g->deckSize > 0) Unsee(g, -1, g->deck[g->deckSize - 1], -1);
 }
 
 void CardsInitAndShuffle(GameState* g)
 {
     g->deckSize = DECK_MAX;
-
-    // Create realistic Reef cards with proper scoring patterns
     for (int i = 0; i < DECK_MAX; ++i) {
-        g->deck[i] = CreateReefCard(i);
+        g->deck[i] = (CardId)i;
+    }
+
+    // Deck order comes from the game's own RNG so a seed replays the game
+    ShuffleDeckInternal(g->deck, g->deckSize, &g->rng);
+
+    for (int p = 0; p < g->playersCount; ++p) {
+        memset(g->players[p].unseen, 0, sizeof(g->players[p].unseen));
+        g->players[p].hiddenHand = 0;
+    }
+    for (int i = 0; i < DECK_MAX; ++i) Unsee(g, -1, (CardId)i, 1);
+    RevealTop(g);
+}
+
+CardId DeckTakeTop(GameState* g)
+{
+    CardId id = g->deck[--g->deckSize];
+    RevealTop(g);
+    return id;
+}
+
+CardId HandRemove(GameState* g, int player, int slot)
+{
+    Player* pl = &g->players[player];
+    CardId id = pl->hand[slot];
+    for (int i = slot; i < pl->handSize - 1; ++i) {
+        pl->hand[i] = pl->hand[i + 1];
+    }
+    pl->handSize--;
+
+    unsigned hidden = pl->hiddenHand;
+    if (hidden & (1u << slot)) {
+        for (int p = 0; p < g->playersCount; ++p) {
+            if (p != player) Unsee(g, p, id, -1);
+        }
+    }
+    pl->hiddenHand = (uint8_t)((hidden & ((1u << slot) - 1)) | ((hidden >> (slot + 1)) << slot));
+    return id;
+}
+
+void CardsRecountUnseen(GameState* g)
+{
+    for (int p = 0; p < g->playersCount; ++p) memset(g->players[p].unseen, 0, sizeof(g->players[p].unseen));
+    for (int i = 0; i + 1 < g->deckSize; ++i) Unsee(g, -1, g->deck[i], 1);
+    for (int p = 0; p < g->playersCount; ++p) {
+        const Player* pl = &g->players[p];
+        for (int i = 0; i < pl->handSize; ++i) {
+            if (!(pl->hiddenHand & (1u << i))) continue;
+            Unsee(g, -1, pl->hand[i], 1);
+            Unsee(g, p, pl->hand[i], -1);
+        }
+    }
+}
+
+void CardsRedeal(GameState* g, int viewer, uint64_t* rng)
+{
+    CardId* places[DECK_MAX];
+    CardId ids[DECK_MAX];
+    int n = 0;
+    for (int i = 0; i + 1 < g->deckSize; ++i) places[n++] = &g->deck[i];
+    for (int p = 0; p < g->playersCount; ++p) {
+        Player* pl = &g->players[p];
+        for (int i = 0; i < pl->handSize && p != viewer; ++i) {
+            if (pl->hiddenHand & (1u << i)) places[n++] = &pl->hand[i];
+        }
     }
+    for (int i = 0; i < n; ++i) ids[i] = *places[i];
 
-    // Seed once; keep simple and deterministic-ish if desired
-    static bool seeded = false;
-    if (!seeded) {
-        srand((unsigned int)time(NULL));
-        seeded = true;
+    // In order first, so the shuffle depends only on what viewer has seen
+    for (int i = 1; i < n; ++i) {
+        CardId id = ids[i];
+        int j = i;
+        for (; j > 0 && ids[j - 1] > id; --j) ids[j] = ids[j - 1];
+        ids[j] = id;
     }
+    if (rng != NULL) ShuffleDeckInternal(ids, n, rng);
+    for (int i = 0; i < n; ++i) *places[i] = ids[i];
+    CardsRecountUnseen(g);
+}
 
-    ShuffleDeckInternal(g->deck, g->deckSize);
+int CardsUnseenTotal(const Player* player)
+{
+    int total = 0;
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) total += player->unseen[k];
+    return total;
+}
+
+float CardsUnseenMean(const Player* player, const float value[CARD_KIND_COUNT])
+{
+    int total = 0;
+    float sum = 0.0f;
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+        total += player->unseen[k];
+        sum += (float)player->unseen[k] * value[k];
+    }
+    return total > 0 ? sum / (float)total : 0.0f;
 }
 
 void DisplayInit(GameState* g)
@@ -157,30 +151,39 @@ void DisplayRefillSlot(GameState* g, int index)
     if (g->deckSize <= 0) return;
     if (index < 0 || index >= CARD_DISPLAY_SIZE) return;
 
-    g->display[index] = g->deck[g->deckSize - 1];
-    g->deckSize--;
+    g->display[index] = DeckTakeTop(g);
 }
 
+// Face down: the top the display left face up goes back into hiding for
+// all but its receiver, and the next top is only turned up at the end
 void DealInitialHands(GameState* g)
 {
+    bool faceUp = g->deckSize > 0;
     for (int p = 0; p < g->playersCount; ++p) {
-        g->players[p].handSize = 0;
+        Player* pl = &g->players[p];
+        pl->handSize = 0;
         for (int i = 0; i < 2; ++i) {
             if (g->deckSize <= 0) break;
-            g->players[p].hand[g->players[p].handSize] = g->deck[g->deckSize - 1];
-            g->players[p].handSize++;
-            g->deckSize--;
+            CardId id = g->deck[--g->deckSize];
+            if (faceUp) {
+                Unsee(g, -1, id, 1);
+                faceUp = false;
+            }
+            Unsee(g, p, id, -1);
+            pl->hiddenHand |= (uint8_t)(1u << pl->handSize);
+            pl->hand[pl->handSize++] = id;
         }
     }
+    RevealTop(g);
 }
 
 int FindDisplayLowestPointsIndex(const GameState* g)
 {
     int bestIndex = 0;
-    int bestPoints = g->display[0].pattern.pointValue;
+    int bestPoints = CardGet(g->display[0])->pattern.pointValue;
     for (int i = 1; i < CARD_DISPLAY_SIZE; ++i) {
-        if (g->display[i].pattern.pointValue < bestPoints) {
-            bestPoints = g->display[i].pattern.pointValue;
+        if (CardGet(g->display[i])->pattern.pointValue < bestPoints) {
+            bestPoints = CardGet(g->display[i])->pattern.pointValue;
             bestIndex = i;
         }
     }
@@ -2,6 +2,16 @@
 #define CARDS_H
 
 #include "constants.h"
+#include "patterns.h"
+
+// Read-only catalog generated from data/cards.txt (src/card_data.c).
+// Ids in GameState index CARD_ID_KIND; everything else is per kind.
+extern const Card            CARD_KINDS[CARD_KIND_COUNT];
+extern const CompiledPattern CARD_PATTERNS[CARD_KIND_COUNT];
+extern const uint8_t         CARD_ID_KIND[DECK_MAX];
+
+const Card* CardGet(CardId id);
+int CardKind(CardId id);
 
 void CardsInitAndShuffle(GameState* g);
 void DisplayInit(GameState* g);
@@ -9,4 +19,36 @@ void DisplayRefillSlot(GameState* g, int index);
 void DealInitialHands(GameState* g);
 int  FindDisplayLowestPointsIndex(const GameState* g);
 
+// Who has seen what. The top of the deck lies face up and the display is
+// open; the opening hands are dealt face down, and every card taken or
+// played after that is in the open. A player has not seen the deck under
+// its top, nor the other players' dealt cards while they are held:
+// Player::unseen counts those by kind, and Player::hiddenHand marks the
+// dealt cards. The deal, DeckTakeTop and HandRemove keep both as they go.
+
+// Take the top card off the deck and turn up the next
+CardId DeckTakeTop(GameState* g);
+
+// Take a card out of player's hand; it is in the open from now on
+CardId HandRemove(GameState* g, int player, int slot);
+
+// Rebuild every player's counts from the cards' places and the hidden
+// marks, for states put together by hand
+void CardsRecountUnseen(GameState* g);
+
+// Deal the cards viewer has not seen (the deck under its top, the other
+// players' face-down cards) back out to the same places, shuffled with
+// rng, and recount: a position viewer cannot tell from g, for searching
+// without reading hidden cards. Positions that look the same to viewer
+// get the same deal from the same rng. With rng NULL the cards go back in
+// CardId order, so two positions look the same to viewer exactly when
+// they are equal after this.
+void CardsRedeal(GameState* g, int viewer, uint64_t* rng);
+
+// Of the cards player has not seen, how many there are, and the average of
+// value[kind] over them (0 if none): the expectation of the next card to
+// come out of hiding, the new top after a take or a draw among them
+int   CardsUnseenTotal(const Player* player);
+float CardsUnseenMean(const Player* player, const float value[CARD_KIND_COUNT]);
+
 #endif
@@ -1,9 +1,11 @@
 #include "constants.h"
 #include <stddef.h>
 
-const int SUPPLY_PER_COLOR_2P = 18;
+// Fewer players get fewer pieces, so every game runs out at a similar pace
+const int SUPPLY_PER_COLOR[PLAYERS_MAX + 1] = { 0, 0, 18, 24, 28 };
 const int INITIAL_POINTS = 3;
 
+#ifndef REEF_HEADLESS
 const Color CORAL_COLOR_MAP[5] = {
     (Color){ 180, 180, 180, 255 }, // NONE -> GRAY
     YELLOW,
@@ -11,6 +13,7 @@ const Color CORAL_COLOR_MAP[5] = {
     PURPLE,
     GREEN
 };
+#endif
 
 // Assets: base path and filenames (resources may be missing; UI falls back when not found)
 const char* ASSET_PATH = "resources/graphics/";
@@ -28,10 +31,21 @@ const char* TEX_DECK_BACK_FILE  = "deck_back.png";
 const char* TEX_BOARD_CELL_FILE = "board_cell.png";
 const char* TEX_TOKEN_FILE      = "point_token_1.png"; // use 1-point token as generic token icon
 const char* TEX_GAMEBOARD_FILE  = "gameboard.png";
+const char* TEX_TITLE_FILE      = "title_screen.png";
 
 const char* FONT_PATH = "resources/fonts/";
 const char* FONT_FILE = "Lexend-Bold.ttf";
 
+// Pre-decoded bundle of everything above; loose files are the fallback
+const char* BUNDLE_FILE = "resources/reef.pak";
+
+// Opening book for the computer seats; without it they search from move one
+const char* BOOK_FILE = "resources/reef.book";
+
+// Unfinished game, saved on exit and resumed on the next start
+const char* SAVE_FILE = "reef.save";
+const char* RECORD_FILE = "reef.record";
+
 const char* CORAL_COLOR_NAME[5] = {
     "None",
     "Yellow",
@@ -3,7 +3,11 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+
+// Headless builds (reefd and the tools) define REEF_HEADLESS and never see raylib
+#ifndef REEF_HEADLESS
 #include "raylib.h"
+#endif
 
 // Dimensions and limits
 enum 
@@ -15,11 +19,20 @@ enum
     MAX_STACK_HEIGHT  = 4,
     MAX_HAND_SIZE     = 4,
     CARD_DISPLAY_SIZE = 3,
-    DECK_MAX          = 60,
 
-    PLAYERS_MAX = 2
+    PLAYERS_MIN = 2,
+    PLAYERS_MAX = 4
 };
 
+// CARD_KIND_COUNT and DECK_MAX follow data/cards.txt: tools/reefcards
+// generates them along with the card tables, and is itself built against
+// the largest deck the engine takes (card ids fit one 64-bit mask)
+#ifdef REEF_CARDGEN
+enum { CARD_KIND_COUNT = 64, DECK_MAX = 64 };
+#else
+#include "card_count.h"
+#endif
+
 // Coral colors
 typedef enum 
 {
@@ -30,10 +43,10 @@ typedef enum
     CORAL_GREEN  = 4
 } CoralColor;
 
-// Board cell stack
+// Board cell stack (byte-packed: pieces hold CoralColor values)
 typedef struct {
-    CoralColor pieces[MAX_STACK_HEIGHT];
-    int height;
+    uint8_t pieces[MAX_STACK_HEIGHT];
+    uint8_t height;
 } CoralStack;
 
 // Pattern types for scoring
@@ -76,14 +89,20 @@ typedef struct
     ScoringPattern pattern;
 } Card;
 
+// Index into the read-only card catalog (see CardGet); game state stores
+// these instead of full Card copies
+typedef uint8_t CardId;
+
 // Player
 typedef struct 
 {
     CoralStack board[BOARD_SIZE][BOARD_SIZE];
-    Card hand[MAX_HAND_SIZE];
+    CardId hand[MAX_HAND_SIZE];
     int handSize;
     int points;
     int id;
+    uint8_t unseen[CARD_KIND_COUNT];  // copies of each kind this player has not seen (cards.h)
+    uint8_t hiddenHand;               // bit per hand slot: dealt face down, unseen by the others
 } Player;
 
 // Placement state for manual coral placement
@@ -92,34 +111,41 @@ typedef struct {
     CoralColor piecesToPlace[2];    // The two coral pieces to place
     int piecesPlaced;              // How many pieces have been placed (0, 1, or 2)
     int cardPoints;                // Points from the played card
-    ScoringPattern scoringPattern;  // Pattern to score after placement
+    CardId card;                   // Played card; its pattern scores after placement
 } PlacementState;
 
-// Game state
+// Game state. Players come last and only the first playersCount are in
+// use, so copies and comparisons can stop there (RulesStateSize): a
+// 2-player game never pays for the boards of four.
 typedef struct 
             {
     int playersCount;
-    Player players[PLAYERS_MAX];
+    uint64_t rng;                   // Per-game RNG state (see rng.h), so games replay from a seed
 
-    Card deck[DECK_MAX];
+    CardId deck[DECK_MAX];
     int deckSize;
 
-    Card display[CARD_DISPLAY_SIZE];
+    CardId display[CARD_DISPLAY_SIZE];
     int displayTokens[CARD_DISPLAY_SIZE];
 
     int supplies[5]; // index by CoralColor (0 unused)
 
     int currentPlayer;
     bool gameEnded;
+    bool finalRound;                // a supply ran out: play on until seat 0 is next
     
     PlacementState placement;       // Manual placement state
+
+    Player players[PLAYERS_MAX];
 } GameState;
 
 // Shared constants
-extern const int SUPPLY_PER_COLOR_2P;
+extern const int SUPPLY_PER_COLOR[PLAYERS_MAX + 1];  // coral pieces per color, by player count
 extern const int INITIAL_POINTS;
 
+#ifndef REEF_HEADLESS
 extern const Color CORAL_COLOR_MAP[5];
+#endif
 extern const char* CORAL_COLOR_NAME[5];
 
 // Assets (paths and filenames)
@@ -130,8 +156,13 @@ extern const char* TEX_DECK_BACK_FILE;         // e.g., "deck_back.png"
 extern const char* TEX_BOARD_CELL_FILE;        // e.g., "board_cell.png"
 extern const char* TEX_TOKEN_FILE;             // e.g., "token.png"
 extern const char* TEX_GAMEBOARD_FILE;         // e.g., "gameboard.png"
+extern const char* TEX_TITLE_FILE;             // e.g., "title_screen.png"
 extern const char* FONT_PATH;                  // e.g., "resources/fonts/"
 extern const char* FONT_FILE;                  // e.g., "Lexend-Bold.ttf"
+extern const char* BUNDLE_FILE;                // e.g., "resources/reef.pak" (optional, built by `make pack`)
+extern const char* BOOK_FILE;                  // e.g., "resources/reef.book" (optional, built by `make book`)
+extern const char* SAVE_FILE;                  // e.g., "reef.save" (game in progress, written on exit)
+extern const char* RECORD_FILE;                // e.g., "reef.record" (its moves from the deal, see record.h)
 
 // UI layout - Scaled down 62.5% for 720p display (25% smaller than before)
 enum                        {
@@ -159,7 +190,17 @@ enum                        {
     UI_HAND2_Y     = 480,
 
     UI_SUPPLY_X    = 950,     // Supplies on far right
-    UI_SUPPLY_Y    = 80
+    UI_SUPPLY_Y    = 80,
+
+    // Three and four players: a 2x2 grid of smaller boards, each with its
+    // hand fanned out to the right (see UI_ComputeLayout)
+    UI_GRID_X         = 20,
+    UI_GRID_Y         = 100,
+    UI_GRID_COL_W     = 470,
+    UI_GRID_ROW_H     = 248,
+    UI_GRID_CELL_SIZE = 52,
+    UI_GRID_HAND_GAP  = 12,   // board to hand
+    UI_GRID_HAND_STEP = 44    // overlapping hand cards
 };
 
 #endif
@@ -0,0 +1,242 @@
+#include "delta.h"
+#include <string.h>
+
+typedef enum {
+    TAG_PLAYERS = 1,   // u8 playersCount
+    TAG_STACK,         // u8 player, u8 cell, u16 packed stack
+    TAG_SUPPLY,        // u8 color, u8 count
+    TAG_DISPLAY,       // u8 slot, u8 card, u8 tokens
+    TAG_DECK,          // u8 deckSize, u8 top card
+    TAG_HAND,          // u8 player, u8 handSize
+    TAG_POINTS,        // u8 player, u32 points
+    TAG_TURN           // u8 player, u8 flags, u8 piece0, u8 piece1, u8 placed, u8 card
+} DeltaTag;
+
+enum {
+    TURN_ENDED     = 1,
+    TURN_PLACEMENT = 2,
+    TURN_FINAL     = 4
+};
+
+// height in bits 0-2, then 3 bits per piece from the bottom up
+static uint16_t PackStack(const CoralStack* s)
+{
+    uint16_t v = s->height & 7u;
+    for (int h = 0; h < MAX_STACK_HEIGHT; ++h) {
+        v |= (uint16_t)((s->pieces[h] & 7u) << (3 + 3 * h));
+    }
+    return v;
+}
+
+// As snapshot.c: pieces must fill the stack from the bottom with real colors
+static bool UnpackStack(CoralStack* s, uint16_t v)
+{
+    if (v >> (3 + 3 * MAX_STACK_HEIGHT)) return false;
+    s->height = v & 7u;
+    if (s->height > MAX_STACK_HEIGHT) return false;
+    for (int h = 0; h < MAX_STACK_HEIGHT; ++h) {
+        s->pieces[h] = (v >> (3 + 3 * h)) & 7u;
+        bool filled = s->pieces[h] != CORAL_NONE;
+        if (filled != (h < s->height) || s->pieces[h] > CORAL_GREEN) return false;
+    }
+    return true;
+}
+
+static uint8_t DeckTop(const GameState* g)
+{
+    return g->deckSize > 0 ? g->deck[g->deckSize - 1] : DELTA_HIDDEN_CARD;
+}
+
+static uint8_t TurnFlags(const GameState* g)
+{
+    return (uint8_t)((g->gameEnded ? TURN_ENDED : 0) | (g->placement.active ? TURN_PLACEMENT : 0) |
+                     (g->finalRound ? TURN_FINAL : 0));
+}
+
+bool DeltaEncode(ProtoWriter* w, const GameState* from, const GameState* to,
+                 uint32_t baseVersion, uint32_t version)
+{
+    bool key = (from == NULL);
+    ProtoPutU8(w, key ? DELTA_KEYFRAME : 0);
+    ProtoPutU32(w, key ? 0 : baseVersion);
+    ProtoPutU32(w, version);
+
+    if (key || from->playersCount != to->playersCount) {
+        ProtoPutU8(w, TAG_PLAYERS);
+        ProtoPutU8(w, (uint8_t)to->playersCount);
+        key = true; // a different table size invalidates every per-player record
+    }
+
+    for (int p = 0; p < to->playersCount; ++p) {
+        const Player* np = &to->players[p];
+        const Player* op = key ? NULL : &from->players[p];
+
+        for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; ++cell) {
+            const CoralStack* ns = &np->board[cell / BOARD_SIZE][cell % BOARD_SIZE];
+            uint16_t packed = PackStack(ns);
+            if (!key && PackStack(&op->board[cell / BOARD_SIZE][cell % BOARD_SIZE]) == packed) continue;
+            if (key && ns->height == 0) continue; // keyframes start from an empty board
+            ProtoPutU8(w, TAG_STACK);
+            ProtoPutU8(w, (uint8_t)p);
+            ProtoPutU8(w, (uint8_t)cell);
+            ProtoPutU8(w, (uint8_t)(packed & 0xFF));
+            ProtoPutU8(w, (uint8_t)(packed >> 8));
+        }
+        if (key || op->handSize != np->handSize) {
+            ProtoPutU8(w, TAG_HAND);
+            ProtoPutU8(w, (uint8_t)p);
+            ProtoPutU8(w, (uint8_t)np->handSize);
+        }
+        if (key || op->points != np->points) {
+            ProtoPutU8(w, TAG_POINTS);
+            ProtoPutU8(w, (uint8_t)p);
+            ProtoPutU32(w, (uint32_t)np->points);
+        }
+    }
+
+    for (int c = 1; c <= 4; ++c) {
+        if (key || from->supplies[c] != to->supplies[c]) {
+            ProtoPutU8(w, TAG_SUPPLY);
+            ProtoPutU8(w, (uint8_t)c);
+            ProtoPutU8(w, (uint8_t)to->supplies[c]);
+        }
+    }
+
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+        if (key || from->display[i] != to->display[i] || from->displayTokens[i] != to->displayTokens[i]) {
+            ProtoPutU8(w, TAG_DISPLAY);
+            ProtoPutU8(w, (uint8_t)i);
+            ProtoPutU8(w, to->display[i]);
+            ProtoPutU8(w, (uint8_t)to->displayTokens[i]);
+        }
+    }
+
+    if (key || from->deckSize != to->deckSize || DeckTop(from) != DeckTop(to)) {
+        ProtoPutU8(w, TAG_DECK);
+        ProtoPutU8(w, (uint8_t)to->deckSize);
+        ProtoPutU8(w, DeckTop(to));
+    }
+
+    const PlacementState* np = &to->placement;
+    const PlacementState* op = key ? NULL : &from->placement;
+    if (key || from->currentPlayer != to->currentPlayer || TurnFlags(from) != TurnFlags(to) ||
+        op->piecesPlaced != np->piecesPlaced || op->card != np->card ||
+        op->piecesToPlace[0] != np->piecesToPlace[0] || op->piecesToPlace[1] != np->piecesToPlace[1]) {
+        ProtoPutU8(w, TAG_TURN);
+        ProtoPutU8(w, (uint8_t)to->currentPlayer);
+        ProtoPutU8(w, TurnFlags(to));
+        ProtoPutU8(w, (uint8_t)np->piecesToPlace[0]);
+        ProtoPutU8(w, (uint8_t)np->piecesToPlace[1]);
+        ProtoPutU8(w, (uint8_t)np->piecesPlaced);
+        ProtoPutU8(w, np->card);
+    }
+
+    return !w->overflow;
+}
+
+static void ResetView(GameState* view)
+{
+    memset(view, 0, sizeof(*view));
+    for (int p = 0; p < PLAYERS_MAX; ++p) {
+        view->players[p].id = p;
+        memset(view->players[p].hand, DELTA_HIDDEN_CARD, sizeof(view->players[p].hand));
+    }
+    memset(view->deck, DELTA_HIDDEN_CARD, sizeof(view->deck));
+}
+
+bool DeltaApply(GameState* view, uint32_t* viewVersion, const uint8_t* data, int len)
+{
+    ProtoReader r;
+    ProtoReaderInit(&r, data, len);
+    uint8_t flags = ProtoGetU8(&r);
+    uint32_t base = ProtoGetU32(&r);
+    uint32_t version = ProtoGetU32(&r);
+    if (r.error) return false;
+
+    bool key = (flags & DELTA_KEYFRAME) != 0;
+    if (!key && base != *viewVersion) return false;
+
+    // Decode into a scratch copy so a malformed delta leaves the view intact
+    GameState next = *view;
+    if (key) ResetView(&next);
+
+    while (r.left > 0 && !r.error) {
+        uint8_t tag = ProtoGetU8(&r);
+        switch (tag) {
+            case TAG_PLAYERS: {
+                uint8_t n = ProtoGetU8(&r);
+                if (n < PLAYERS_MIN || n > PLAYERS_MAX) return false;
+                next.playersCount = n;
+                break;
+            }
+            case TAG_STACK: {
+                uint8_t p = ProtoGetU8(&r), cell = ProtoGetU8(&r);
+                uint16_t v = ProtoGetU8(&r);
+                v |= (uint16_t)(ProtoGetU8(&r) << 8);
+                if (p >= PLAYERS_MAX || cell >= BOARD_SIZE * BOARD_SIZE) return false;
+                if (!UnpackStack(&next.players[p].board[cell / BOARD_SIZE][cell % BOARD_SIZE], v)) return false;
+                break;
+            }
+            case TAG_SUPPLY: {
+                uint8_t c = ProtoGetU8(&r), n = ProtoGetU8(&r);
+                if (c < CORAL_YELLOW || c > CORAL_GREEN) return false;
+                next.supplies[c] = n;
+                break;
+            }
+            case TAG_DISPLAY: {
+                uint8_t slot = ProtoGetU8(&r), card = ProtoGetU8(&r), tokens = ProtoGetU8(&r);
+                if (slot >= CARD_DISPLAY_SIZE || card >= DECK_MAX) return false;
+                next.display[slot] = card;
+                next.displayTokens[slot] = tokens;
+                break;
+            }
+            case TAG_DECK: {
+                uint8_t size = ProtoGetU8(&r), top = ProtoGetU8(&r);
+                // The top is hidden only once the deck is empty
+                if (size > DECK_MAX || (size > 0 ? top >= DECK_MAX : top != DELTA_HIDDEN_CARD)) return false;
+                next.deckSize = size;
+                if (size > 0) next.deck[size - 1] = top;
+                break;
+            }
+            case TAG_HAND: {
+                uint8_t p = ProtoGetU8(&r), n = ProtoGetU8(&r);
+                if (p >= PLAYERS_MAX || n > MAX_HAND_SIZE) return false;
+                next.players[p].handSize = n;
+                break;
+            }
+            case TAG_POINTS: {
+                uint8_t p = ProtoGetU8(&r);
+                uint32_t pts = ProtoGetU32(&r);
+                if (p >= PLAYERS_MAX) return false;
+                next.players[p].points = (int)pts;
+                break;
+            }
+            case TAG_TURN: {
+                uint8_t cur = ProtoGetU8(&r), f = ProtoGetU8(&r);
+                uint8_t p0 = ProtoGetU8(&r), p1 = ProtoGetU8(&r), placed = ProtoGetU8(&r), card = ProtoGetU8(&r);
+                if (cur >= PLAYERS_MAX || p0 > CORAL_GREEN || p1 > CORAL_GREEN || placed > 2 || card >= DECK_MAX) return false;
+                next.currentPlayer = cur;
+                next.gameEnded = (f & TURN_ENDED) != 0;
+                next.finalRound = (f & TURN_FINAL) != 0;
+                next.placement.active = (f & TURN_PLACEMENT) != 0;
+                next.placement.piecesToPlace[0] = (CoralColor)p0;
+                next.placement.piecesToPlace[1] = (CoralColor)p1;
+                next.placement.piecesPlaced = placed;
+                next.placement.card = card;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    // As SnapshotDecode: a table the rules could not have dealt is refused.
+    // The records above already hold every stack, card and color in range.
+    if (r.error || next.playersCount < PLAYERS_MIN || next.playersCount > PLAYERS_MAX ||
+        next.currentPlayer >= next.playersCount) {
+        return false;
+    }
+
+    *view = next;
+    *viewVersion = version;
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "protocol.h"
+
+// State-diff encoding for spectators and remote views.
+//
+// A delta lists only the parts of the public game view that changed
+// between two versions: touched stacks, supplies, display slots and
+// tokens, deck size and top card, hand counts, points and turn state. A
+// keyframe is the same encoding against an empty state, so a late joiner
+// can start from it. Hands are not public and travel as counts only;
+// decoded views hold DELTA_HIDDEN_CARD in their hand slots.
+//
+//   u8 flags | u32 baseVersion | u32 version | records...
+//
+// Each record is a u8 tag followed by a fixed-size payload (see delta.c).
+
+enum {
+    DELTA_KEYFRAME    = 1,     // flags: applies to any view, baseVersion is 0
+    DELTA_HIDDEN_CARD = 0xFF,
+    DELTA_MAX_SIZE    = PROTO_MAX_BODY - 1 // a keyframe always fits one frame
+};
+
+// Append the change from `from` (NULL for a keyframe) to `to`. Returns
+// false if it did not fit the writer.
+bool DeltaEncode(ProtoWriter* w, const GameState* from, const GameState* to,
+                 uint32_t baseVersion, uint32_t version);
+
+// Apply a delta or keyframe to a view. Fails without touching the view when
+// the delta's base does not match *viewVersion or the data is malformed.
+bool DeltaApply(GameState* view, uint32_t* viewVersion, const uint8_t* data, int len);
+
+#endif
@@ -0,0 +1,503 @@
+#define _DEFAULT_SOURCE
+#include "engine.h"
+#include "ai.h"
+#include "analysis.h"
+#include "bot.h"
+#include "jobs.h"
+#include "protocol.h"
+#include "snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    ENGINE_LINE_MAX    = 8192,  // a snapshot in hex plus a long move list
+    ENGINE_HEADER_SIZE = 4,
+    ENGINE_BATCH_GRAIN = 64     // positions per job
+};
+
+typedef struct {
+    uint8_t count;
+    uint8_t ids[RULES_MAX_ACTIONS];
+    float eval;
+    bool legal;
+} EngineResult;
+
+static struct {
+    FILE* in;
+    FILE* out;
+    GameState game;
+    BotConfig greedy;
+    Analysis analysis;       // table allocated by the first analyze
+    bool analysisReady;
+
+    // Binary batches; buffers only grow
+    EngineOp op;
+    uint8_t* frame;
+    uint32_t frameCap;
+    uint8_t* reply;
+    size_t replyCap;
+    GameState* states;
+    uint8_t* actions;
+    EngineResult* results;
+    uint32_t batchCap;
+} gEngine;
+
+static char* NextToken(char** cursor)
+{
+    char* p = *cursor;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    if (*p == '\0') {
+        *cursor = p;
+        return NULL;
+    }
+    char* start = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    if (*p != '\0') *p++ = '\0';
+    *cursor = p;
+    return start;
+}
+
+static int HexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Bytes decoded, -1 if s is not hex or does not fit
+static int HexDecode(const char* s, uint8_t* out, int cap)
+{
+    int n = 0;
+    for (; s[0] != '\0'; s += 2) {
+        int hi = HexValue(s[0]);
+        int lo = hi >= 0 ? HexValue(s[1]) : -1;
+        if (lo < 0 || n == cap) return -1;
+        out[n++] = (uint8_t)(hi << 4 | lo);
+    }
+    return n;
+}
+
+// Apply the remaining tokens as actions; the first that is not a legal
+// action, or NULL once all are applied
+static const char* ApplyMoves(GameState* g, char** cursor)
+{
+    for (char* tok = NextToken(cursor); tok != NULL; tok = NextToken(cursor)) {
+        Action a;
+        if (!RulesParseAction(tok, &a) || !RulesApply(g, a)) return tok;
+    }
+    return NULL;
+}
+
+static void CmdPosition(char** cursor)
+{
+    FILE* out = gEngine.out;
+    GameState g;
+    char* kind = NextToken(cursor);
+    char* tok;
+    if (kind != NULL && strcmp(kind, "seed") == 0) {
+        char* seed = NextToken(cursor);
+        if (seed == NULL) {
+            fputs("error position seed needs a seed\n", out);
+            return;
+        }
+        int players = PLAYERS_MIN;
+        tok = NextToken(cursor);
+        if (tok != NULL && strcmp(tok, "players") == 0) {
+            char* count = NextToken(cursor);
+            players = count != NULL ? atoi(count) : 0;
+            if (players < PLAYERS_MIN || players > PLAYERS_MAX) {
+                fprintf(out, "error players must be %d-%d\n", PLAYERS_MIN, PLAYERS_MAX);
+                return;
+            }
+            tok = NextToken(cursor);
+        }
+        RulesNewGame(&g, players, strtoull(seed, NULL, 10));
+    } else if (kind != NULL && strcmp(kind, "snapshot") == 0) {
+        char* hex = NextToken(cursor);
+        uint8_t bytes[SNAPSHOT_MAX_SIZE];
+        int n = hex != NULL ? HexDecode(hex, bytes, (int)sizeof(bytes)) : -1;
+        if (n < 0) {
+            fputs("error snapshot is not hex\n", out);
+            return;
+        }
+        int used = 0;
+        SnapshotError err = SnapshotDecode(bytes, n, &g, &used);
+        if (err == SNAPSHOT_OK && used != n) err = SNAPSHOT_ERR_INVALID;
+        if (err != SNAPSHOT_OK) {
+            fprintf(out, "error snapshot: %s\n", SnapshotErrorString(err));
+            return;
+        }
+        tok = NextToken(cursor);
+    } else {
+        fputs("error position needs seed or snapshot\n", out);
+        return;
+    }
+
+    if (tok != NULL) {
+        const char* bad = strcmp(tok, "moves") == 0 ? ApplyMoves(&g, cursor) : tok;
+        if (bad != NULL) {
+            fprintf(out, "error illegal move %s\n", bad);
+            return;
+        }
+    }
+    gEngine.game = g;
+}
+
+static void CmdLegal(void)
+{
+    Action legal[RULES_MAX_ACTIONS];
+    int n = RulesListActions(&gEngine.game, legal);
+    fputs("legal", gEngine.out);
+    for (int i = 0; i < n; ++i) {
+        char a[8];
+        RulesFormatAction(legal[i], a, sizeof(a));
+        fprintf(gEngine.out, " %s", a);
+    }
+    fputc('\n', gEngine.out);
+}
+
+// All or nothing, so a driver never has to guess where it stopped
+static void CmdPlay(char** cursor)
+{
+    GameState g = gEngine.game;
+    const char* bad = ApplyMoves(&g, cursor);
+    if (bad != NULL) {
+        fprintf(gEngine.out, "illegal %s\n", bad);
+        return;
+    }
+    gEngine.game = g;
+    fputs("ok\n", gEngine.out);
+}
+
+static void PutLine(const Action* line, int len)
+{
+    for (int i = 0; i < len; ++i) {
+        char a[8];
+        RulesFormatAction(line[i], a, sizeof(a));
+        fprintf(gEngine.out, " %s", a);
+    }
+}
+
+static void CmdGo(char** cursor)
+{
+    int thinkMs = AI_DEFAULT_THINK_MS;
+    for (char* tok = NextToken(cursor); tok != NULL; tok = NextToken(cursor)) {
+        char* value = strcmp(tok, "movetime") == 0 ? NextToken(cursor) : NULL;
+        if (value == NULL) {
+            fprintf(gEngine.out, "error go: unknown option %s\n", tok);
+            return;
+        }
+        thinkMs = atoi(value);
+    }
+
+    Action line[AI_MAX_LINE];
+    int len = 0;
+    if (!AiDecide(&gEngine.game, thinkMs, line, &len)) {
+        fputs("bestmove none\n", gEngine.out);
+        return;
+    }
+    fprintf(gEngine.out, "info depth %d\nbestmove", AiSearchDepth());
+    PutLine(line, len);
+    fputc('\n', gEngine.out);
+}
+
+static void CmdAnalyze(char** cursor)
+{
+    AnalysisLimits limits = { 0 };
+    bool limited = false;
+    for (char* tok = NextToken(cursor); tok != NULL; tok = NextToken(cursor)) {
+        bool known = strcmp(tok, "depth") == 0 || strcmp(tok, "nodes") == 0 || strcmp(tok, "movetime") == 0;
+        char* value = known ? NextToken(cursor) : NULL;
+        if (value == NULL) {
+            fprintf(gEngine.out, "error analyze: unknown option %s\n", tok);
+            return;
+        }
+        if (tok[0] == 'd') limits.depth = atoi(value);
+        else if (tok[0] == 'n') limits.nodes = atoll(value);
+        else limits.ms = atoi(value);
+        limited = true;
+    }
+    if (!limited) limits.ms = AI_DEFAULT_THINK_MS;
+
+    if (!gEngine.analysisReady) {
+        if (!AnalysisInit(&gEngine.analysis, (size_t)ANALYSIS_TABLE_MB << 20)) {
+            fputs("error analyze: out of memory\n", gEngine.out);
+            return;
+        }
+        gEngine.analysisReady = true;
+    }
+    AnalysisResult r;
+    if (!AnalysisRun(&gEngine.analysis, &gEngine.game, &gEngine.greedy, &limits, &r) || r.pvLength == 0) {
+        fputs("bestmove none\n", gEngine.out);
+        return;
+    }
+    fprintf(gEngine.out, "info depth %d score %.3f nodes %lld pv", r.depth, r.score, (long long)r.nodes);
+    for (int t = 0; t < r.pvLength; ++t) {
+        if (t > 0) fputs(" |", gEngine.out);
+        PutLine(r.pv[t].line, r.pv[t].len);
+    }
+    fputs("\nbestmove", gEngine.out);
+    PutLine(r.pv[0].line, r.pv[0].len);
+    fputc('\n', gEngine.out);
+}
+
+static void CmdState(void)
+{
+    const GameState* g = &gEngine.game;
+    fprintf(gEngine.out, "state turn %d deck %d points", g->currentPlayer, g->deckSize);
+    for (int p = 0; p < g->playersCount; ++p) fprintf(gEngine.out, " %d", g->players[p].points);
+    fputc('\n', gEngine.out);
+}
+
+static void CmdResult(void)
+{
+    const GameState* g = &gEngine.game;
+    if (!g->gameEnded) {
+        fputs("result ongoing\n", gEngine.out);
+        return;
+    }
+    int best = g->players[0].points;
+    fputs("result over points", gEngine.out);
+    for (int p = 0; p < g->playersCount; ++p) {
+        fprintf(gEngine.out, " %d", g->players[p].points);
+        if (g->players[p].points > best) best = g->players[p].points;
+    }
+    fputs(" winners", gEngine.out);
+    for (int p = 0; p < g->playersCount; ++p) {
+        if (g->players[p].points == best) fprintf(gEngine.out, " %d", p);
+    }
+    fputc('\n', gEngine.out);
+}
+
+static void CmdSnapshot(void)
+{
+    uint8_t bytes[SNAPSHOT_MAX_SIZE];
+    int n = SnapshotEncode(&gEngine.game, bytes, (int)sizeof(bytes));
+    fputs("snapshot ", gEngine.out);
+    for (int i = 0; i < n; ++i) fprintf(gEngine.out, "%02x", bytes[i]);
+    fputc('\n', gEngine.out);
+}
+
+static void PutU32At(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static bool Grow(void** buf, size_t* cap, size_t need, size_t item)
+{
+    if (need <= *cap) return true;
+    void* p = realloc(*buf, need * item);
+    if (p == NULL) return false;
+    *buf = p;
+    *cap = need;
+    return true;
+}
+
+static bool GrowBatch(uint32_t count)
+{
+    if (count <= gEngine.batchCap) return true;
+    size_t cap = gEngine.batchCap, cap2 = gEngine.batchCap, cap3 = gEngine.batchCap;
+    if (!Grow((void**)&gEngine.states, &cap, count, sizeof(GameState))) return false;
+    if (!Grow((void**)&gEngine.actions, &cap2, count, 1)) return false;
+    if (!Grow((void**)&gEngine.results, &cap3, count, sizeof(EngineResult))) return false;
+    gEngine.batchCap = count;
+    return true;
+}
+
+static void SendFrame(const uint8_t* frame, int len)
+{
+    PutU32At((uint8_t*)frame, (uint32_t)(len - ENGINE_HEADER_SIZE));
+    fwrite(frame, 1, (size_t)len, gEngine.out);
+    fflush(gEngine.out);
+}
+
+static void SendError(uint32_t position, SnapshotError code)
+{
+    uint8_t frame[ENGINE_HEADER_SIZE + 6];
+    frame[ENGINE_HEADER_SIZE] = ENGINE_MSG_ERROR;
+    PutU32At(frame + ENGINE_HEADER_SIZE + 1, position);
+    frame[ENGINE_HEADER_SIZE + 5] = (uint8_t)code;
+    SendFrame(frame, (int)sizeof(frame));
+}
+
+static void WorkRange(void* ctx, int begin, int end)
+{
+    (void)ctx;
+    for (int i = begin; i < end; ++i) {
+        GameState* g = &gEngine.states[i];
+        EngineResult* res = &gEngine.results[i];
+        switch (gEngine.op) {
+            case ENGINE_OP_LEGAL: {
+                Action legal[RULES_MAX_ACTIONS];
+                res->count = (uint8_t)RulesListActions(g, legal);
+                for (int k = 0; k < res->count; ++k) res->ids[k] = RulesActionId(legal[k]);
+                break;
+            }
+            case ENGINE_OP_BEST: {
+                uint64_t rng = g->rng;  // ties break the same way for the same position
+                res->ids[0] = g->gameEnded ? ENGINE_NO_ACTION : RulesActionId(BotChooseAction(g, &gEngine.greedy, &rng));
+                break;
+            }
+            case ENGINE_OP_EVAL:
+                res->eval = BotEvaluate(g, g->currentPlayer, &gEngine.greedy);
+                break;
+            case ENGINE_OP_APPLY:
+                res->legal = gEngine.actions[i] < RULES_ACTION_IDS && RulesApply(g, RulesActionFromId(gEngine.actions[i]));
+                break;
+        }
+    }
+}
+
+static void RunBatch(const uint8_t* body, int len)
+{
+    ProtoReader r;
+    ProtoReaderInit(&r, body, len);
+    uint8_t op = ProtoGetU8(&r);
+    uint32_t count = ProtoGetU32(&r);
+    if (r.error || op < ENGINE_OP_LEGAL || op > ENGINE_OP_APPLY || count > (uint32_t)len || !GrowBatch(count)) {
+        SendError(UINT32_MAX, SNAPSHOT_ERR_INVALID);
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        int used = 0;
+        SnapshotError err = SnapshotDecode(r.p, r.left, &gEngine.states[i], &used);
+        if (err == SNAPSHOT_OK) {
+            ProtoGetBytes(&r, used);
+            if (op == ENGINE_OP_APPLY) gEngine.actions[i] = ProtoGetU8(&r);
+            if (r.error) err = SNAPSHOT_ERR_TRUNCATED;
+        }
+        if (err != SNAPSHOT_OK) {
+            SendError(i, err);
+            return;
+        }
+    }
+
+    gEngine.op = (EngineOp)op;
+    JobParallelFor((int)count, ENGINE_BATCH_GRAIN, WorkRange, NULL);
+
+    size_t item = op == ENGINE_OP_APPLY ? 1 + SNAPSHOT_MAX_SIZE : 1 + RULES_MAX_ACTIONS + sizeof(float);
+    size_t cap = ENGINE_HEADER_SIZE + 6 + (size_t)count * item;
+    if (cap > INT32_MAX || !Grow((void**)&gEngine.reply, &gEngine.replyCap, cap, 1)) {
+        SendError(UINT32_MAX, SNAPSHOT_ERR_INVALID);
+        return;
+    }
+    ProtoWriter w;
+    ProtoWriterInit(&w, gEngine.reply, (int)cap);
+    ProtoPutU32(&w, 0);  // length, filled in by SendFrame
+    ProtoPutU8(&w, ENGINE_MSG_RESULTS);
+    ProtoPutU8(&w, op);
+    ProtoPutU32(&w, count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const EngineResult* res = &gEngine.results[i];
+        switch (gEngine.op) {
+            case ENGINE_OP_LEGAL:
+                ProtoPutU8(&w, res->count);
+                ProtoPutBytes(&w, res->ids, res->count);
+                break;
+            case ENGINE_OP_BEST:
+                ProtoPutU8(&w, res->ids[0]);
+                break;
+            case ENGINE_OP_EVAL: {
+                uint32_t bits;
+                memcpy(&bits, &res->eval, sizeof(bits));
+                ProtoPutU32(&w, bits);
+                break;
+            }
+            case ENGINE_OP_APPLY: {
+                uint8_t snap[SNAPSHOT_MAX_SIZE];
+                ProtoPutU8(&w, res->legal);
+                ProtoPutBytes(&w, snap, SnapshotEncode(&gEngine.states[i], snap, (int)sizeof(snap)));
+                break;
+            }
+        }
+    }
+    SendFrame(gEngine.reply, w.len);
+}
+
+// Serve frames until one asks for text mode (true) or input ends (false)
+static bool RunBinary(void)
+{
+    for (;;) {
+        uint8_t header[ENGINE_HEADER_SIZE];
+        if (fread(header, 1, sizeof(header), gEngine.in) != sizeof(header)) return false;
+        uint32_t len = (uint32_t)header[0] | (uint32_t)header[1] << 8 | (uint32_t)header[2] << 16 | (uint32_t)header[3] << 24;
+        if (len == 0 || len > ENGINE_MAX_FRAME) {
+            SendError(UINT32_MAX, SNAPSHOT_ERR_INVALID);  // no way to find the next frame
+            return false;
+        }
+        size_t cap = gEngine.frameCap;
+        if (!Grow((void**)&gEngine.frame, &cap, len, 1)) return false;
+        gEngine.frameCap = (uint32_t)cap;
+        if (fread(gEngine.frame, 1, len, gEngine.in) != len) return false;
+
+        if (gEngine.frame[0] == ENGINE_MSG_TEXT) return true;
+        if (gEngine.frame[0] == ENGINE_MSG_BATCH) RunBatch(gEngine.frame + 1, (int)len - 1);
+        else SendError(UINT32_MAX, SNAPSHOT_ERR_INVALID);
+    }
+}
+
+int EngineRun(FILE* in, FILE* out)
+{
+    gEngine.in = in;
+    gEngine.out = out;
+    BotDefaultConfig(&gEngine.greedy, BOT_GREEDY);
+    RulesNewGame(&gEngine.game, PLAYERS_MIN, 1);
+
+    // This thread only reads commands and waits, so the pool gets every core
+    JobsStart(JobsCpuCount(), false);
+    if (!AiStart()) {
+        fprintf(stderr, "reef: engine: could not start the search\n");
+        JobsStop();
+        return 1;
+    }
+
+    static char line[ENGINE_LINE_MAX];
+    while (fgets(line, sizeof(line), in) != NULL) {
+        if (strchr(line, '\n') == NULL && !feof(in)) {
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n') {}
+            fputs("error line too long\n", out);
+            fflush(out);
+            continue;
+        }
+        char* cursor = line;
+        char* cmd = NextToken(&cursor);
+        if (cmd == NULL) continue;
+
+        if (strcmp(cmd, "quit") == 0) break;
+        else if (strcmp(cmd, "reef") == 0) fprintf(out, "id name reef\nplayers %d-%d\nreefok\n", PLAYERS_MIN, PLAYERS_MAX);
+        else if (strcmp(cmd, "isready") == 0) fputs("readyok\n", out);
+        else if (strcmp(cmd, "position") == 0) CmdPosition(&cursor);
+        else if (strcmp(cmd, "legal") == 0) CmdLegal();
+        else if (strcmp(cmd, "play") == 0) CmdPlay(&cursor);
+        else if (strcmp(cmd, "go") == 0) CmdGo(&cursor);
+        else if (strcmp(cmd, "analyze") == 0) CmdAnalyze(&cursor);
+        else if (strcmp(cmd, "state") == 0) CmdState();
+        else if (strcmp(cmd, "result") == 0) CmdResult();
+        else if (strcmp(cmd, "snapshot") == 0) CmdSnapshot();
+        else if (strcmp(cmd, "binary") == 0) {
+            fputs("binaryok\n", out);
+            fflush(out);
+            if (!RunBinary()) break;
+            continue;
+        }
+        else fprintf(out, "error unknown command %s\n", cmd);
+        fflush(out);
+    }
+
+    AiStop();
+    JobsStop();
+    if (gEngine.analysisReady) AnalysisFree(&gEngine.analysis);
+    free(gEngine.frame);
+    free(gEngine.reply);
+    free(gEngine.states);
+    free(gEngine.actions);
+    free(gEngine.results);
+    memset(&gEngine, 0, sizeof(gEngine));
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdio.h>
+#include "rules.h"
+
+// Engine mode (`reef --engine`): the game without a window, driven over
+// stdin/stdout so bots written elsewhere can set up positions, query and
+// play moves, and ask the computer for its move.
+//
+// Text mode is line based, one reply line per command unless noted:
+//
+//   reef                                 id name reef / players 2-4 / reefok
+//   isready                              readyok
+//   position seed S [players N] [moves A...]
+//   position snapshot HEX [moves A...]   (silent on success)
+//   legal                                legal A...
+//   play A...                            ok | illegal A (nothing applied)
+//   go [movetime MS]                     info depth D / bestmove A... | bestmove none
+//   analyze [depth D] [nodes N] [movetime MS]
+//                                        info depth D score S nodes N pv A... | A... /
+//                                        bestmove A... | bestmove none
+//   state                                state turn P deck N points P0 P1...
+//   result                               result ongoing | result over points P0 P1... winners S...
+//   snapshot                             snapshot HEX
+//   binary                               binaryok, then binary frames
+//   quit
+//
+// Problems are answered with `error ...`. Actions are written m0-m2 (take
+// a display card), d (draw from the deck), h0-h3 (play a hand card) and pRC
+// (place on row R, column C); `go` answers with the whole turn. Snapshots
+// are snapshot.h encodings in hex, the same bytes as a saved game.
+//
+// `analyze` is the exact search (analysis.h) for the player to move, every
+// hand open; score is its evaluation, and the pv's turns are split by |.
+// Under depth and node limits alone it answers the same every time;
+// without limits it stops after AI_DEFAULT_THINK_MS.
+//
+// Binary mode is for batches: one frame carries any number of positions
+// and gets one frame back. Frames are
+//
+//   u32 bodyLength | u8 type | payload
+//
+// little-endian, and positions are snapshots back to back:
+//
+//   driver -> engine
+//     ENGINE_MSG_BATCH   u8 op, u32 count, count x (snapshot [, u8 action id])
+//     ENGINE_MSG_TEXT    (empty) back to text mode
+//   engine -> driver
+//     ENGINE_MSG_RESULTS u8 op, u32 count, count x result
+//     ENGINE_MSG_ERROR   u32 position, u8 SnapshotError; position UINT32_MAX
+//                        with SNAPSHOT_ERR_INVALID is a bad frame or op
+//
+// by op (action ids are RulesActionId, ENGINE_NO_ACTION for none):
+//
+//   ENGINE_OP_LEGAL  -> u8 n, n x action id
+//   ENGINE_OP_BEST   -> action id the greedy bot picks (no time limit: it
+//                       sees only the rest of its turn)
+//   ENGINE_OP_EVAL   -> f32 bot evaluation for the player to move
+//   ENGINE_OP_APPLY  (position followed by an action id)
+//                    -> u8 legal, snapshot of the position after it
+//
+// Batches are worked on by the job pool.
+
+enum {
+    ENGINE_NO_ACTION = 0xFF,
+    ENGINE_MAX_FRAME = 64 << 20
+};
+
+typedef enum {
+    ENGINE_MSG_BATCH   = 0x01,
+    ENGINE_MSG_TEXT    = 0x02,
+
+    ENGINE_MSG_RESULTS = 0x81,
+    ENGINE_MSG_ERROR   = 0x85
+} EngineMessage;
+
+typedef enum {
+    ENGINE_OP_LEGAL = 1,
+    ENGINE_OP_BEST,
+    ENGINE_OP_EVAL,
+    ENGINE_OP_APPLY
+} EngineOp;
+
+// Serve commands from in until quit or end of input. Starts and stops the
+// job pool and the computer player itself. Returns the exit status.
+int EngineRun(FILE* in, FILE* out);
+
+#endif
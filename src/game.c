@@ -1,270 +1,252 @@
 #include "game.h"
-#include "cards.h"
 #include "constants.h"
-#include "patterns.h"
 #include "ui.h"
 #include "assets.h"
+#include "pacing.h"
+#include "sim.h"
+#include "hint.h"
+#include "opportunity.h"
+#include "ai.h"
+#include "jobs.h"
+#include "record.h"
+#include "snapshot.h"
+#include "rng.h"
+#include "trace.h"
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
-// Forward declarations
-static void NextPlayer(GameState* g);
-static void CheckEnd(GameState* g);
+static bool gShowHints = false;
+static Record gRecord;           // the game's moves from the deal (record.h)
+static bool gRecording;
+static OpportunityIndex gOpportunity[PLAYERS_MAX];  // shown with the hints
 
-static void InitPlayers(GameState* g)
+// The record of a resumed game, if it leads to start: one left over from
+// another game, or cut short, is not continued
+static bool ResumeRecord(const GameState* start)
 {
-    g->playersCount = PLAYERS_MAX; // 2 for Phase 1
-
-    for (int p = 0; p < g->playersCount; ++p) {
-        Player* pl = &g->players[p];
-        pl->id = p;
-        pl->points = INITIAL_POINTS;
-        pl->handSize = 0;
-
-        for (int r = 0; r < BOARD_SIZE; ++r) {
-            for (int c = 0; c < BOARD_SIZE; ++c) {
-                pl->board[r][c].height = 0;
-                for (int h = 0; h < MAX_STACK_HEIGHT; ++h) {
-                    pl->board[r][c].pieces[h] = CORAL_NONE;
-                }
-            }
-        }
-
-        // Initial center four pieces (one of each color)
-        pl->board[1][1].pieces[0] = CORAL_YELLOW; pl->board[1][1].height = 1;
-        pl->board[1][2].pieces[0] = CORAL_ORANGE; pl->board[1][2].height = 1;
-        pl->board[2][1].pieces[0] = CORAL_PURPLE; pl->board[2][1].height = 1;
-        pl->board[2][2].pieces[0] = CORAL_GREEN;  pl->board[2][2].height = 1;
-    }
-}
-
-static void InitSupplies(GameState* g)
-{
-    g->supplies[CORAL_NONE]   = 0;
-    g->supplies[CORAL_YELLOW] = SUPPLY_PER_COLOR_2P;
-    g->supplies[CORAL_ORANGE] = SUPPLY_PER_COLOR_2P;
-    g->supplies[CORAL_PURPLE] = SUPPLY_PER_COLOR_2P;
-    g->supplies[CORAL_GREEN]  = SUPPLY_PER_COLOR_2P;
-}
-
-static bool PlaceCoralAt(GameState* g, Player* p, CoralColor color, int row, int col)
-{
-    if (color == CORAL_NONE) return false;
-    if (g->supplies[color] <= 0) return false;
-    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) return false;
-    
-    CoralStack* s = &p->board[row][col];
-    if (s->height >= MAX_STACK_HEIGHT) return false;
-    
-    s->pieces[s->height] = color;
-    s->height++;
-    g->supplies[color]--;
-    return true;
-}
-
-static void StartPlacement(GameState* g, Card card)
-{
-    g->placement.active = true;
-    g->placement.piecesToPlace[0] = card.piece1;
-    g->placement.piecesToPlace[1] = card.piece2;
-    g->placement.piecesPlaced = 0;
-    g->placement.cardPoints = card.pattern.pointValue;
-    g->placement.scoringPattern = card.pattern;
-}
-
-static void FinishPlacement(GameState* g)
-{
-    if (g->placement.active && g->placement.piecesPlaced == 2) {
-        // Score the pattern on the current player's board
-        Player* currentPlayer = &g->players[g->currentPlayer];
-        int earnedPoints = ScorePattern(currentPlayer, &g->placement.scoringPattern);
-        currentPlayer->points += earnedPoints;
-        
-        g->placement.active = false;
-        CheckEnd(g);
-        if (!g->gameEnded) {
-            NextPlayer(g);
-        }
+    if (RecordRead(RECORD_FILE, &gRecord) != NULL) return false;  // saved before records were kept
+    GameState g;
+    uint8_t a[SNAPSHOT_MAX_SIZE], b[SNAPSHOT_MAX_SIZE];
+    int n = SnapshotEncode(start, a, sizeof(a));
+    if (RecordPlay(&gRecord, &g) == gRecord.count && n > 0 && SnapshotEncode(&g, b, sizeof(b)) == n &&
+        memcmp(a, b, (size_t)n) == 0) {
+        return true;
     }
+    RecordFree(&gRecord);
+    fprintf(stderr, "reef: %s does not lead to the saved game; this one is not recorded\n", RECORD_FILE);
+    return false;
 }
 
-static bool HandleMousePlacement(GameState* g)
+// Map a click on the current player's board to a placement action
+static bool HandleMousePlacement(const GameState* g)
 {
-    if (!g->placement.active) return false;
     if (!IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) return false;
-    
+
     Vector2 mousePos = GetMousePosition();
-    Player* currentPlayer = &g->players[g->currentPlayer];
-    
+
     // Determine which board was clicked based on player
-    int boardX = (g->currentPlayer == 0) ? UI_BOARD1_X : UI_BOARD2_X;
-    int boardY = (g->currentPlayer == 0) ? UI_BOARD1_Y : UI_BOARD2_Y;
-    
+    UiLayout l;
+    UI_ComputeLayout(g->playersCount, &l);
+    int boardX = l.boardX[g->currentPlayer];
+    int boardY = l.boardY[g->currentPlayer];
+    int boardSize = l.cellSize * BOARD_SIZE;
+
     // Check if click is within current player's board
-    if (mousePos.x >= boardX && mousePos.x < boardX + UI_BOARD_SIZE &&
-        mousePos.y >= boardY && mousePos.y < boardY + UI_BOARD_SIZE) {
-        
+    if (mousePos.x >= boardX && mousePos.x < boardX + boardSize &&
+        mousePos.y >= boardY && mousePos.y < boardY + boardSize) {
+
         // Calculate which cell was clicked
-        int col = (int)((mousePos.x - boardX) / UI_CELL_SIZE);
-        int row = (int)((mousePos.y - boardY) / UI_CELL_SIZE);
-        
-        // Try to place the current coral piece
-        CoralColor colorToPlace = g->placement.piecesToPlace[g->placement.piecesPlaced];
-        if (PlaceCoralAt(g, currentPlayer, colorToPlace, row, col)) {
-            g->placement.piecesPlaced++;
-            if (g->placement.piecesPlaced == 2) {
-                FinishPlacement(g);
-            }
-            return true;
-        }
+        int col = (int)((mousePos.x - boardX) / l.cellSize);
+        int row = (int)((mousePos.y - boardY) / l.cellSize);
+
+        Action a = { ACTION_PLACE_CORAL, 0, (uint8_t)row, (uint8_t)col };
+        return SimPushAction(a);
     }
     return false;
 }
 
-static void NextPlayer(GameState* g)
+void GameInit(int players, bool resume)
 {
-    g->currentPlayer = (g->currentPlayer + 1) % g->playersCount;
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Reef (Phase 1)");
+    SetTargetFPS(PACE_ACTIVE_FPS);
+    AssetsBeginLoad(); // finished behind the title screen in main
+
+    // A missing save is the normal case; a damaged one is reported and left alone
+    GameState start;
+    SnapshotError err = resume ? SnapshotLoad(SAVE_FILE, &start) : SNAPSHOT_ERR_IO;
+    if (err != SNAPSHOT_OK && err != SNAPSHOT_ERR_IO) {
+        fprintf(stderr, "reef: not resuming %s: %s\n", SAVE_FILE, SnapshotErrorString(err));
+    }
+    if (err == SNAPSHOT_OK) {
+        gRecording = ResumeRecord(&start);
+    } else {
+        uint64_t seed = RngSeedFromTime();
+        RulesNewGame(&start, players, seed);
+        RecordInit(&gRecord, seed, players);
+        gRecording = true;
+    }
+    SimStart(&start, gRecording ? &gRecord : NULL);
+    for (int p = 0; p < PLAYERS_MAX; ++p) OpportunityInit(&gOpportunity[p], p, OPPORTUNITY_ALL);
+    JobsStart(JobsCpuCount() - 1, false);  // leave a core to the render loop
+    HintStart();
+    AiStart();
 }
 
-static void CheckEnd(GameState* g)
+void GameShutdown(void)
 {
-    for (int i = 1; i <= 4; ++i) {
-        if (g->supplies[i] <= 0) { g->gameEnded = true; return; }
+    AiStop();
+    HintStop();
+    JobsStop();
+    SimStop();
+
+    // Keep an unfinished game for next time; a finished one is not resumed
+    const GameState* g = SimAcquireSnapshot();
+    if (g->gameEnded) {
+        remove(SAVE_FILE);
+    } else if (SnapshotSave(SAVE_FILE, g) != SNAPSHOT_OK) {
+        fprintf(stderr, "reef: could not save the game to %s\n", SAVE_FILE);
     }
-    if (g->deckSize <= 0) { g->gameEnded = true; }
-}
 
-void GameInit(GameState* g)
-{
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Reef (Phase 1)");
-    SetTargetFPS(60);
-    AssetsLoadAll();
-
-    g->gameEnded = false;
-    g->currentPlayer = 0;
-    
-    // Initialize placement state
-    g->placement.active = false;
-    g->placement.piecesPlaced = 0;
-    g->placement.cardPoints = 0;
-
-    InitSupplies(g);
-    InitPlayers(g);
-
-    CardsInitAndShuffle(g);
-    DisplayInit(g);
-    DealInitialHands(g);
+    // Kept finished too, for `reef --replay`
+    if (gRecording && !RecordWrite(&gRecord, RECORD_FILE)) {
+        fprintf(stderr, "reef: could not write the game record to %s\n", RECORD_FILE);
+    }
+    RecordFree(&gRecord);
 }
 
-void GameUpdate(GameState* g)
+void GameUpdate(const GameState* g)
 {
+    if (IsKeyPressed(KEY_H)) {
+        gShowHints = !gShowHints;
+        PacingRequest(PACE_ACTIVE);
+    }
+
+    // Start or finish a timing capture [F12]
+    if (IsKeyPressed(KEY_F12)) {
+        if (TraceRunning()) TraceStop();
+        else if (!TraceStart(TRACE_FILE)) fprintf(stderr, "reef: cannot write %s\n", TRACE_FILE);
+    }
+
+    // Undo/redo one action [Z, Y] or a whole turn [Left, Right]. Stepping
+    // through history is analysis, so the computer seats go back to humans.
+    int move = 0;
+    if (IsKeyPressed(KEY_Z))          move = SIM_UNDO;
+    else if (IsKeyPressed(KEY_Y))     move = SIM_REDO;
+    else if (IsKeyPressed(KEY_LEFT))  move = SIM_TURN_BACK;
+    else if (IsKeyPressed(KEY_RIGHT)) move = SIM_TURN_FORWARD;
+    if (move != 0) {
+        for (int p = 0; p < PLAYERS_MAX; ++p) AiSetSeat(p, false);
+        if (SimPushHistory((SimHistoryMove)move)) PacingRequest(PACE_ACTIVE);
+        return;
+    }
+
+    // Hand a seat to the computer or take it back [F1..F4]
+    for (int p = 0; p < g->playersCount; ++p) {
+        if (IsKeyPressed(KEY_F1 + p)) {
+            AiSetSeat(p, !AiIsSeat(p));
+            PacingRequest(PACE_ACTIVE);
+        }
+    }
+
+    // The computer's actions go through the same queue as ours; keep frames
+    // coming while it is to move so they are picked up
+    if (AiUpdate(g)) {
+        PacingRequest(PACE_TICK);
+        return;
+    }
+
     if (g->gameEnded) return;
 
     // Handle mouse placement if in placement mode
     if (g->placement.active) {
-        HandleMousePlacement(g);
+        if (HandleMousePlacement(g)) PacingRequest(PACE_ACTIVE);
         return; // Don't process other inputs during placement
     }
 
-    Player* pl = &g->players[g->currentPlayer];
-    bool action = false;
+    // Legality is checked by the simulation; input only names the action
+    Action a = { ACTION_NONE, 0, 0, 0 };
 
     // Take from market [1..3]
-    if (!action) {
-        if (IsKeyPressed(KEY_ONE)) {
-            int idx = 0;
-            if (pl->handSize < MAX_HAND_SIZE) {
-                pl->points += g->displayTokens[idx];
-                g->displayTokens[idx] = 0;
-                pl->hand[pl->handSize++] = g->display[idx];
-                DisplayRefillSlot(g, idx);
-                action = true;
-            }
-        }
-        else if (IsKeyPressed(KEY_TWO)) {
-            int idx = 1;
-            if (pl->handSize < MAX_HAND_SIZE) {
-                pl->points += g->displayTokens[idx];
-                g->displayTokens[idx] = 0;
-                pl->hand[pl->handSize++] = g->display[idx];
-                DisplayRefillSlot(g, idx);
-                action = true;
-            }
-        }
-        else if (IsKeyPressed(KEY_THREE)) {
-            int idx = 2;
-            if (pl->handSize < MAX_HAND_SIZE) {
-                pl->points += g->displayTokens[idx];
-                g->displayTokens[idx] = 0;
-                pl->hand[pl->handSize++] = g->display[idx];
-                DisplayRefillSlot(g, idx);
-                action = true;
-            }
-        }
-    }
+    if (IsKeyPressed(KEY_ONE))        a = (Action){ ACTION_TAKE_MARKET, 0, 0, 0 };
+    else if (IsKeyPressed(KEY_TWO))   a = (Action){ ACTION_TAKE_MARKET, 1, 0, 0 };
+    else if (IsKeyPressed(KEY_THREE)) a = (Action){ ACTION_TAKE_MARKET, 2, 0, 0 };
 
     // Draw from deck [D], pay 1 point -> place on lowest display card
-    if (!action && IsKeyPressed(KEY_D)) {
-        if (pl->handSize < MAX_HAND_SIZE && g->deckSize > 0 && pl->points >= 1) {
-            pl->points -= 1;
-            int idx = FindDisplayLowestPointsIndex(g);
-            g->displayTokens[idx] += 1;
-
-            pl->hand[pl->handSize++] = g->deck[g->deckSize - 1];
-            g->deckSize--;
-            action = true;
-        }
-    }
+    else if (IsKeyPressed(KEY_D))     a = (Action){ ACTION_DRAW_DECK, 0, 0, 0 };
 
     // Play from hand [Q,W,E,R] -> start manual placement mode
-    if (!action) {
-        int playIndex = -1;
-        if (IsKeyPressed(KEY_Q) && pl->handSize >= 1) playIndex = 0;
-        else if (IsKeyPressed(KEY_W) && pl->handSize >= 2) playIndex = 1;
-        else if (IsKeyPressed(KEY_E) && pl->handSize >= 3) playIndex = 2;
-        else if (IsKeyPressed(KEY_R) && pl->handSize >= 4) playIndex = 3;
-
-        if (playIndex >= 0) {
-            Card card = pl->hand[playIndex];
-            // Remove card from hand
-            for (int i = playIndex; i < pl->handSize - 1; ++i) {
-                pl->hand[i] = pl->hand[i + 1];
-            }
-            pl->handSize--;
-
-            // Start manual placement mode
-            StartPlacement(g, card);
-            action = true;
-        }
-    }
+    else if (IsKeyPressed(KEY_Q))     a = (Action){ ACTION_PLAY_CARD, 0, 0, 0 };
+    else if (IsKeyPressed(KEY_W))     a = (Action){ ACTION_PLAY_CARD, 1, 0, 0 };
+    else if (IsKeyPressed(KEY_E))     a = (Action){ ACTION_PLAY_CARD, 2, 0, 0 };
+    else if (IsKeyPressed(KEY_R))     a = (Action){ ACTION_PLAY_CARD, 3, 0, 0 };
 
-    if (action && !g->placement.active) {
-        CheckEnd(g);
-        if (!g->gameEnded) {
-            NextPlayer(g);
-        }
+    if (a.type != ACTION_NONE && SimPushAction(a)) {
+        PacingRequest(PACE_ACTIVE);
     }
 }
 
-void GameDraw(const GameState* g)
+static void DrawPosition(const GameState* g, const char* status, const HintMap* hint,
+                         const OpportunityIndex* opportunity)
 {
     UI_DrawBackground();
-    UI_DrawTopBar(g);
+    UI_DrawTopBar(g, status);
 
-    // Determine if we should highlight valid positions and which color to preview
-    bool highlightPlayer1 = g->placement.active && g->currentPlayer == 0;
-    bool highlightPlayer2 = g->placement.active && g->currentPlayer == 1;
+    // Highlight valid positions on the current player's board only
     CoralColor previewColor = g->placement.active ? 
         g->placement.piecesToPlace[g->placement.piecesPlaced] : CORAL_NONE;
-
-    UI_DrawPlayerBoard(&g->players[0], UI_BOARD1_X, UI_BOARD1_Y, highlightPlayer1, previewColor);
-    UI_DrawPlayerBoard(&g->players[1], UI_BOARD2_X, UI_BOARD2_Y, highlightPlayer2, previewColor);
+    UiLayout l;
+    UI_ComputeLayout(g->playersCount, &l);
+    for (int p = 0; p < g->playersCount; ++p) {
+        bool current = g->currentPlayer == p;
+        UI_DrawPlayerBoard(&g->players[p], l.boardX[p], l.boardY[p], l.cellSize,
+                           g->placement.active && current, previewColor, current ? hint : NULL,
+                           current ? opportunity : NULL);
+    }
 
     UI_DrawMarket(g);
     UI_DrawDeck(g);
 
-    // Draw both players' hands
-    UI_DrawHand(&g->players[0], UI_HAND1_X, UI_HAND1_Y, g->currentPlayer == 0 ? -1 : -2);
-    UI_DrawHand(&g->players[1], UI_HAND2_X, UI_HAND2_Y, g->currentPlayer == 1 ? -1 : -2);
+    // Draw every player's hand
+    for (int p = 0; p < g->playersCount; ++p) {
+        bool current = g->currentPlayer == p;
+        UI_DrawHand(&g->players[p], l.handX[p], l.handY[p], l.handStep, current ? -1 : -2,
+                    current ? hint : NULL);
+    }
 
     UI_DrawSupplies(g);
 }
+
+void GameDraw(const GameState* g)
+{
+    // Hints follow the snapshot being drawn, so a map for an older state is
+    // never shown; while one is streaming in keep frames coming
+    const HintMap* hint = NULL;
+    const OpportunityIndex* opportunity = NULL;
+    if (gShowHints && !g->gameEnded && !AiIsSeat(g->currentPlayer)) {
+        HintSubmit(g);
+        hint = HintAcquire();
+        if (HintPending()) PacingRequest(PACE_TICK);
+        if (g->placement.active) {
+            opportunity = &gOpportunity[g->currentPlayer];
+            OpportunitySync(&gOpportunity[g->currentPlayer], g);
+        }
+    } else {
+        HintCancel();
+    }
+
+    const char* status = NULL;
+    int step, steps;
+    SimHistoryPosition(&step, &steps);
+    if (!g->gameEnded && AiIsSeat(g->currentPlayer)) {
+        status = TextFormat("Computer thinking (depth %d)", AiSearchDepth());
+    } else if (step + 1 < steps) {
+        status = TextFormat("History: step %d of %d, [Y] redo", step, steps - 1);
+    }
+    DrawPosition(g, status, hint, opportunity);
+}
+
+void GameDrawPosition(const GameState* g, const char* status)
+{
+    DrawPosition(g, status, NULL, NULL);
+}
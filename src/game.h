@@ -3,9 +3,18 @@
 
 #include "constants.h"
 
-// Game initialization and lifecycle
-void GameInit(GameState* g);
-void GameUpdate(GameState* g);
+// Game initialization and lifecycle. The rules run on the simulation
+// thread (sim.h); the client only turns input into actions and draws the
+// latest snapshot.
+// resume: continue the game saved on the last exit, if there is one;
+// otherwise a new game for players
+void GameInit(int players, bool resume);
+void GameShutdown(void);
+void GameUpdate(const GameState* g);
 void GameDraw(const GameState* g);
 
+// The board, market, hands and supplies of any position, without the live
+// game's hints; status as for UI_DrawTopBar. For viewers (replay.h).
+void GameDrawPosition(const GameState* g, const char* status);
+
 #endif
@@ -0,0 +1,296 @@
+#define _DEFAULT_SOURCE
+#include "hint.h"
+#include "bot.h"
+#include "cards.h"
+#include "opportunity.h"
+#include "patterns.h"
+#include "trace.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <string.h>
+
+enum {
+    HINT_FRESH = 4  // flag bit on a shared triple-buffer index, as in sim.c
+};
+
+typedef struct {
+    GameState state;
+    unsigned generation;
+} HintJob;
+
+static struct {
+    // Jobs: the main thread writes, the worker reads
+    HintJob jobs[3];
+    atomic_uint jobMiddle;
+    unsigned jobBack;
+    unsigned jobFront;
+
+    // Maps: the worker writes, the main thread reads
+    HintMap maps[3];
+    atomic_uint mapMiddle;
+    unsigned mapBack;
+    unsigned mapFront;
+
+    atomic_uint generation;  // latest submission or cancel
+    atomic_uint completed;   // generation of the last complete map
+    sem_t wake;              // one count per submission (plus one to wake for stop)
+
+    GameState last;          // main thread: what was last submitted
+    bool active;             // main thread: a submission is outstanding
+
+    float handWeight;
+    pthread_t thread;
+    atomic_bool running;
+} gHint;
+
+static bool Cancelled(unsigned generation)
+{
+    return atomic_load_explicit(&gHint.generation, memory_order_relaxed) != generation;
+}
+
+static void Publish(const HintMap* map)
+{
+    gHint.maps[gHint.mapBack] = *map;
+    unsigned prev = atomic_exchange_explicit(&gHint.mapMiddle, gHint.mapBack | HINT_FRESH, memory_order_acq_rel);
+    gHint.mapBack = prev & 3u;
+}
+
+// Points the turn earned plus what the hand left behind would score now
+static float Evaluate(const GameState* g, int player, int pointsBefore)
+{
+    const Player* pl = &g->players[player];
+    BoardMasks masks;
+    BoardMasksBuild(pl, &masks);
+    int hand = 0;
+    for (int i = 0; i < pl->handSize; ++i) {
+        hand += ScoreCompiled(&masks, &CARD_PATTERNS[CardKind(pl->hand[i])]);
+    }
+    return (float)(pl->points - pointsBefore) + gHint.handWeight * (float)hand;
+}
+
+// Evaluate for next with its last piece on (row, col), read off an index
+// synced to next instead of placing it and rescoring
+static float EvaluateLastPiece(const OpportunityIndex* x, const GameState* next, int pointsBefore, int row, int col)
+{
+    const Player* pl = &next->players[x->player];
+    const Opportunity* o = OpportunityAt(x, row, col, next->placement.piecesToPlace[next->placement.piecesPlaced]);
+    int earned = pl->points - pointsBefore + x->score[OPPORTUNITY_PLAYING] + o->delta[OPPORTUNITY_PLAYING];
+    int hand = 0;
+    for (int i = 0; i < pl->handSize; ++i) hand += x->score[OPPORTUNITY_HAND + i] + o->delta[OPPORTUNITY_HAND + i];
+    return (float)earned + gHint.handWeight * (float)hand;
+}
+
+static void ResetMap(HintMap* map, unsigned generation, int card)
+{
+    memset(map, 0, sizeof(*map));
+    map->generation = generation;
+    map->card = card;
+    map->bestRow = map->bestCol = -1;
+}
+
+// Fill map for the next piece of g's placement: each cell gets the best
+// value over every follow-up cell for the second piece. Streams after each
+// cell when stream is set. Returns false if cancelled.
+static bool MapPlacement(const GameState* g, int me, int pointsBefore, HintMap* map, bool stream)
+{
+    // Consecutive first pieces differ by a cell or two, so one index
+    // follows them cheaply
+    OpportunityIndex x;
+    OpportunityInit(&x, me, ((1u << MAX_HAND_SIZE) - 1) << OPPORTUNITY_HAND | 1u << OPPORTUNITY_PLAYING);
+    bool first = true;
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) {
+            if (Cancelled(map->generation)) return false;
+
+            GameState next;
+            RulesCopyState(&next, g);
+            if (!RulesApply(&next, (Action){ ACTION_PLACE_CORAL, 0, (uint8_t)r, (uint8_t)c })) continue;
+
+            float best;
+            if (next.placement.active) {
+                // The second piece's color is in supply (placement would
+                // have moved past it otherwise); only full stacks refuse it
+                OpportunitySync(&x, &next);
+                best = 0.0f;
+                bool any = false;
+                for (int r2 = 0; r2 < BOARD_SIZE; ++r2) {
+                    for (int c2 = 0; c2 < BOARD_SIZE; ++c2) {
+                        if (next.players[me].board[r2][c2].height >= MAX_STACK_HEIGHT) continue;
+                        float v = EvaluateLastPiece(&x, &next, pointsBefore, r2, c2);
+                        if (!any || v > best) best = v;
+                        any = true;
+                    }
+                }
+            } else {
+                best = Evaluate(&next, me, pointsBefore);
+            }
+
+            if (first || best < map->min) map->min = best;
+            if (first || best > map->max) {
+                map->max = best;
+                map->bestRow = r;
+                map->bestCol = c;
+            }
+            map->legal[r][c] = true;
+            map->value[r][c] = best;
+            first = false;
+            if (stream) Publish(map);
+        }
+    }
+    return true;
+}
+
+static void Compute(const HintJob* job)
+{
+    const GameState* g = &job->state;
+    int me = g->currentPlayer;
+    int pointsBefore = g->players[me].points;
+    HintMap map;
+
+    if (g->placement.active) {
+        ResetMap(&map, job->generation, -1);
+        if (!MapPlacement(g, me, pointsBefore, &map, true)) return;
+    } else {
+        // Rank the hand; the map shows the first piece of the best card
+        ResetMap(&map, job->generation, -1);
+        HintMap card;
+        float bestCard = 0.0f;
+        for (int i = 0; i < g->players[me].handSize; ++i) {
+            GameState played;
+            RulesCopyState(&played, g);
+            if (!RulesApply(&played, (Action){ ACTION_PLAY_CARD, (uint8_t)i, 0, 0 })) continue;
+
+            ResetMap(&card, job->generation, i);
+            float v;
+            if (played.placement.active) {
+                if (!MapPlacement(&played, me, pointsBefore, &card, false)) return;
+                v = card.max;
+            } else {
+                v = Evaluate(&played, me, pointsBefore);  // both pieces forfeited
+            }
+            map.handValue[i] = v;
+            if (map.card < 0 || v > bestCard) {
+                bestCard = v;
+                memcpy(map.legal, card.legal, sizeof(map.legal));
+                memcpy(map.value, card.value, sizeof(map.value));
+                map.min = card.min;
+                map.max = card.max;
+                map.bestRow = card.bestRow;
+                map.bestCol = card.bestCol;
+                map.card = i;
+            }
+            Publish(&map);
+        }
+    }
+
+    map.complete = true;
+    Publish(&map);
+    atomic_store_explicit(&gHint.completed, job->generation, memory_order_release);
+}
+
+static void* HintThreadMain(void* arg)
+{
+    (void)arg;
+    TraceThreadName("hint");
+    while (true) {
+        sem_wait(&gHint.wake);
+        if (!atomic_load_explicit(&gHint.running, memory_order_acquire)) break;
+
+        // Submissions that arrived together collapse into the latest one
+        if (!(atomic_load_explicit(&gHint.jobMiddle, memory_order_relaxed) & HINT_FRESH)) continue;
+        unsigned prev = atomic_exchange_explicit(&gHint.jobMiddle, gHint.jobFront, memory_order_acq_rel);
+        gHint.jobFront = prev & 3u;
+
+        const HintJob* job = &gHint.jobs[gHint.jobFront];
+        if (!Cancelled(job->generation)) {
+            TRACE_BEGIN("HintCompute");
+            Compute(job);
+            TRACE_END("HintCompute");
+        }
+    }
+    return NULL;
+}
+
+bool HintStart(void)
+{
+    BotConfig cfg;
+    BotDefaultConfig(&cfg, BOT_GREEDY);
+    gHint.handWeight = cfg.weights[BOT_W_HAND];
+
+    // Maps start at generation 0, which no submission ever uses
+    memset(gHint.maps, 0, sizeof(gHint.maps));
+    gHint.mapFront = 0;
+    atomic_store(&gHint.mapMiddle, 1u);
+    gHint.mapBack = 2;
+    gHint.jobFront = 0;
+    atomic_store(&gHint.jobMiddle, 1u);
+    gHint.jobBack = 2;
+
+    atomic_store(&gHint.generation, 1u);
+    atomic_store(&gHint.completed, 0u);
+    gHint.active = false;
+    if (sem_init(&gHint.wake, 0, 0) != 0) return false;
+
+    atomic_store(&gHint.running, true);
+    if (pthread_create(&gHint.thread, NULL, HintThreadMain, NULL) != 0) {
+        atomic_store(&gHint.running, false);
+        sem_destroy(&gHint.wake);
+        return false;
+    }
+    return true;
+}
+
+void HintStop(void)
+{
+    if (!atomic_load(&gHint.running)) return;
+    HintCancel();
+    atomic_store_explicit(&gHint.running, false, memory_order_release);
+    sem_post(&gHint.wake);
+    pthread_join(gHint.thread, NULL);
+    sem_destroy(&gHint.wake);
+}
+
+void HintSubmit(const GameState* g)
+{
+    if (!atomic_load_explicit(&gHint.running, memory_order_relaxed)) return;
+    if (gHint.active && memcmp(&gHint.last, g, RulesStateSize(g)) == 0) return;
+
+    gHint.last = *g;
+    gHint.active = true;
+    unsigned generation = atomic_fetch_add_explicit(&gHint.generation, 1, memory_order_relaxed) + 1;
+
+    HintJob* job = &gHint.jobs[gHint.jobBack];
+    job->state = *g;
+    job->generation = generation;
+    unsigned prev = atomic_exchange_explicit(&gHint.jobMiddle, gHint.jobBack | HINT_FRESH, memory_order_acq_rel);
+    gHint.jobBack = prev & 3u;
+    sem_post(&gHint.wake);
+}
+
+void HintCancel(void)
+{
+    if (!gHint.active) return;
+    gHint.active = false;
+    atomic_fetch_add_explicit(&gHint.generation, 1, memory_order_relaxed);
+}
+
+const HintMap* HintAcquire(void)
+{
+    if (atomic_load_explicit(&gHint.mapMiddle, memory_order_relaxed) & HINT_FRESH) {
+        unsigned prev = atomic_exchange_explicit(&gHint.mapMiddle, gHint.mapFront, memory_order_acq_rel);
+        gHint.mapFront = prev & 3u;
+    }
+    const HintMap* map = &gHint.maps[gHint.mapFront];
+    if (!gHint.active || map->generation != atomic_load_explicit(&gHint.generation, memory_order_relaxed)) {
+        return NULL;
+    }
+    return map;
+}
+
+bool HintPending(void)
+{
+    return gHint.active &&
+           atomic_load_explicit(&gHint.completed, memory_order_acquire) !=
+           atomic_load_explicit(&gHint.generation, memory_order_relaxed);
+}
@@ -0,0 +1,40 @@
+#ifndef HINT_H
+#define HINT_H
+
+#include "rules.h"
+
+// Placement hints, computed on a worker thread. The main thread submits
+// the snapshot it is drawing; the worker tries every placement pair (and,
+// outside placement, every hand card) and streams its best-so-far into a
+// triple buffer like the simulation's, so drawing never waits on it. A new
+// submission bumps a generation counter that the worker polls between
+// cells, which abandons stale work right away.
+
+// Value of a placement: points the played card scores plus the bot's
+// hand weight times what the rest of the hand would then score
+typedef struct {
+    unsigned generation;             // submission this map belongs to
+    bool complete;                   // false while still streaming
+    int card;                        // hand slot the map is for; -1 during placement
+    float handValue[MAX_HAND_SIZE];  // best value per hand card (outside placement)
+    bool legal[BOARD_SIZE][BOARD_SIZE];
+    float value[BOARD_SIZE][BOARD_SIZE];  // best value with the next piece on this cell
+    float min, max;                  // over legal cells, for shading
+    int bestRow, bestCol;            // -1 until a legal cell is seen
+} HintMap;
+
+bool HintStart(void);
+void HintStop(void);
+
+// Main thread: ask for hints on g (cheap when g is unchanged) or drop them
+void HintSubmit(const GameState* g);
+void HintCancel(void);
+
+// Main thread: latest map for the current submission, or NULL if none has
+// arrived yet. Stays valid until the next call.
+const HintMap* HintAcquire(void);
+
+// True while the worker owes the current submission a complete map
+bool HintPending(void);
+
+#endif
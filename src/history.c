@@ -0,0 +1,219 @@
+#include "history.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTORY_NO_SLOT UINT32_MAX
+
+_Static_assert(HISTORY_REGIONS < 31, "a step's region bits share a word with HISTORY_TURN_START");
+_Static_assert(offsetof(Player, board) == 0, "a player's regions start with the board");
+
+typedef struct {
+    size_t offset;
+    size_t size;
+} Region;
+
+enum { POOL_ROW = HISTORY_SHARED_REGIONS, POOL_HAND };
+
+// Byte ranges of GameState covering it up to the seated players exactly,
+// split along what a single action tends to touch
+static Region RegionAt(int i)
+{
+    // The player count, RNG and deck order are fixed once dealt; what is
+    // left of the deck is market state
+    size_t deck = offsetof(GameState, deck);
+    size_t market = offsetof(GameState, deckSize);
+    size_t supplies = offsetof(GameState, supplies);
+    size_t turn = offsetof(GameState, currentPlayer);
+    size_t players = offsetof(GameState, players);
+    switch (i) {
+        case 0: return (Region){ 0, deck };
+        case 1: return (Region){ deck, market - deck };
+        case 2: return (Region){ market, supplies - market };
+        case 3: return (Region){ supplies, turn - supplies };
+        case 4: return (Region){ turn, players - turn };
+        default: break;
+    }
+
+    // Per player: each board row, then hand, points, id and unseen cards
+    int p = (i - HISTORY_SHARED_REGIONS) / HISTORY_PLAYER_REGIONS;
+    int part = (i - HISTORY_SHARED_REGIONS) % HISTORY_PLAYER_REGIONS;
+    size_t start = players + (size_t)p * sizeof(Player);
+    size_t row = sizeof(((Player*)0)->board[0]);
+    if (part < BOARD_SIZE) return (Region){ start + (size_t)part * row, row };
+    size_t rest = start + BOARD_SIZE * row;
+    return (Region){ rest, start + sizeof(Player) - rest };
+}
+
+static int PoolOf(int region)
+{
+    if (region < HISTORY_SHARED_REGIONS) return region;
+    return (region - HISTORY_SHARED_REGIONS) % HISTORY_PLAYER_REGIONS < BOARD_SIZE ? POOL_ROW : POOL_HAND;
+}
+
+static uint32_t* SlotRefs(const HistoryPool* p, uint32_t slot)
+{
+    return (uint32_t*)(p->slots + (size_t)slot * p->slotSize);
+}
+
+static uint8_t* SlotData(const HistoryPool* p, uint32_t slot)
+{
+    return p->slots + (size_t)slot * p->slotSize + sizeof(uint32_t);
+}
+
+static void Release(HistoryPool* p, uint32_t slot)
+{
+    uint32_t* refs = SlotRefs(p, slot);
+    if (--*refs > 0) return;
+    memcpy(SlotData(p, slot), &p->freeHead, sizeof(p->freeHead));
+    p->freeHead = slot;
+}
+
+static uint32_t NewSlot(HistoryPool* p, const uint8_t* bytes, size_t size)
+{
+    uint32_t slot = p->freeHead;
+    if (slot != HISTORY_NO_SLOT) {
+        memcpy(&p->freeHead, SlotData(p, slot), sizeof(p->freeHead));
+    } else {
+        if (p->count == p->cap) {
+            uint32_t cap = p->cap ? p->cap * 2 : 16;
+            uint8_t* slots = realloc(p->slots, (size_t)cap * p->slotSize);
+            if (slots == NULL) return HISTORY_NO_SLOT;
+            p->slots = slots;
+            p->cap = cap;
+        }
+        slot = p->count++;
+    }
+    *SlotRefs(p, slot) = 1;
+    memcpy(SlotData(p, slot), bytes, size);
+    return slot;
+}
+
+static void ReleaseStep(History* h, const HistoryStep* s)
+{
+    uint32_t ref = s->first;
+    for (int i = 0; i < h->regions; ++i) {
+        if (s->bits & (1u << i)) Release(&h->pools[PoolOf(i)], h->refs[ref++]);
+    }
+}
+
+// Store the regions of g that differ from the current step, or all of
+// them on a key step
+static bool Append(History* h, const GameState* g)
+{
+    if (h->count == h->cap) {
+        int cap = h->cap ? h->cap * 2 : 64;
+        HistoryStep* steps = realloc(h->steps, sizeof(HistoryStep) * (size_t)cap);
+        if (steps == NULL) return false;
+        h->steps = steps;
+        h->cap = cap;
+    }
+    if (h->refCount + (uint32_t)h->regions > h->refCap) {
+        uint32_t cap = h->refCap ? h->refCap * 2 : 256;
+        uint32_t* refs = realloc(h->refs, sizeof(uint32_t) * (size_t)cap);
+        if (refs == NULL) return false;
+        h->refs = refs;
+        h->refCap = cap;
+    }
+
+    bool key = h->count % HISTORY_KEY_STEPS == 0;
+    HistoryStep step = { .bits = g->placement.active ? 0 : HISTORY_TURN_START, .first = h->refCount };
+    uint32_t at[HISTORY_REGIONS];
+    for (int i = 0; i < h->regions; ++i) {
+        Region r = RegionAt(i);
+        const uint8_t* bytes = (const uint8_t*)g + r.offset;
+        HistoryPool* pool = &h->pools[PoolOf(i)];
+        at[i] = h->count > 0 ? h->at[i] : HISTORY_NO_SLOT;
+        bool same = at[i] != HISTORY_NO_SLOT && memcmp(SlotData(pool, at[i]), bytes, r.size) == 0;
+        if (same && !key) continue;
+
+        if (same) {
+            (*SlotRefs(pool, at[i]))++;
+        } else {
+            at[i] = NewSlot(pool, bytes, r.size);
+            if (at[i] == HISTORY_NO_SLOT) {
+                ReleaseStep(h, &step);
+                h->refCount = step.first;
+                return false;
+            }
+        }
+        h->refs[h->refCount++] = at[i];
+        step.bits |= 1u << i;
+    }
+    h->steps[h->count] = step;
+    memcpy(h->at, at, sizeof(uint32_t) * (size_t)h->regions);
+    h->current = h->count++;
+    return true;
+}
+
+bool HistoryInit(History* h, const GameState* g)
+{
+    *h = (History){ 0 };
+    h->regions = HISTORY_SHARED_REGIONS + g->playersCount * HISTORY_PLAYER_REGIONS;
+    for (int i = 0; i < HISTORY_SHARED_REGIONS + HISTORY_PLAYER_REGIONS; ++i) {
+        // Room for the free-list link, rounded so refs stay aligned
+        size_t size = RegionAt(i).size;
+        if (size < sizeof(uint32_t)) size = sizeof(uint32_t);
+        HistoryPool* pool = &h->pools[PoolOf(i)];
+        pool->slotSize = (uint32_t)((sizeof(uint32_t) + size + 3) & ~(size_t)3);
+        pool->freeHead = HISTORY_NO_SLOT;
+    }
+    return Append(h, g);
+}
+
+void HistoryFree(History* h)
+{
+    for (int i = 0; i < HISTORY_POOLS; ++i) free(h->pools[i].slots);
+    free(h->steps);
+    free(h->refs);
+    *h = (History){ 0 };
+}
+
+bool HistoryRecord(History* h, const GameState* g)
+{
+    while (h->count > h->current + 1) {
+        ReleaseStep(h, &h->steps[--h->count]);
+        h->refCount = h->steps[h->count].first;
+    }
+    return Append(h, g);
+}
+
+bool HistoryJump(History* h, int step, GameState* out)
+{
+    if (step < 0 || step >= h->count) return false;
+    for (int s = step - step % HISTORY_KEY_STEPS; s <= step; ++s) {
+        const HistoryStep* hs = &h->steps[s];
+        uint32_t ref = hs->first;
+        for (int i = 0; i < h->regions; ++i) {
+            if (hs->bits & (1u << i)) h->at[i] = h->refs[ref++];
+        }
+    }
+    for (int i = 0; i < h->regions; ++i) {
+        Region r = RegionAt(i);
+        memcpy((uint8_t*)out + r.offset, SlotData(&h->pools[PoolOf(i)], h->at[i]), r.size);
+    }
+    h->current = step;
+    return true;
+}
+
+int HistoryPrevTurn(const History* h)
+{
+    for (int s = h->current - 1; s >= 0; --s) {
+        if (h->steps[s].bits & HISTORY_TURN_START) return s;
+    }
+    return -1;
+}
+
+int HistoryNextTurn(const History* h)
+{
+    for (int s = h->current + 1; s < h->count; ++s) {
+        if (h->steps[s].bits & HISTORY_TURN_START) return s;
+    }
+    return -1;
+}
+
+size_t HistoryBytes(const History* h)
+{
+    size_t bytes = sizeof(HistoryStep) * (size_t)h->cap + sizeof(uint32_t) * (size_t)h->refCap;
+    for (int i = 0; i < HISTORY_POOLS; ++i) bytes += (size_t)h->pools[i].cap * h->pools[i].slotSize;
+    return bytes;
+}
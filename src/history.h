@@ -0,0 +1,75 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include "constants.h"
+
+// Undo/redo history of a game, one step per applied action.
+//
+// A step does not copy the GameState. The state is cut into regions (the
+// deck, the market, the supplies, the turn state, and per seated player
+// each board row and the hand) whose contents live in immutable chunks. A
+// step stores a bit per region that changed since the step before and a
+// 32-bit ref to the new chunk of each, so a placement costs one board row,
+// the supplies and the turn state. Every HISTORY_KEY_STEPS-th step refers
+// to every region; a jump starts from the one before its target, so it
+// costs the same however far it goes. Seats past playersCount are not kept.
+// Chunks of one kind of region share a pool of fixed-size slots, named by
+// index and counted by the steps referring to them.
+//
+// Single-threaded: owned by whoever applies the actions (the simulation).
+
+enum {
+    HISTORY_SHARED_REGIONS = 5,               // header, deck, market, supplies, turn
+    HISTORY_PLAYER_REGIONS = BOARD_SIZE + 1,  // board rows, then the hand
+    HISTORY_REGIONS        = HISTORY_SHARED_REGIONS + PLAYERS_MAX * HISTORY_PLAYER_REGIONS,
+    HISTORY_POOLS          = HISTORY_SHARED_REGIONS + 2,
+    HISTORY_KEY_STEPS      = 16
+};
+
+#define HISTORY_TURN_START 0x80000000u  // HistoryStep::bits: no card mid-placement
+
+typedef struct {
+    uint8_t* slots;          // slotSize bytes each: uint32_t refs, then the region's bytes
+    uint32_t slotSize;
+    uint32_t count;          // slots handed out so far
+    uint32_t cap;
+    uint32_t freeHead;       // released slots, chained through their bytes
+} HistoryPool;
+
+typedef struct {
+    uint32_t bits;           // bit per region with a new chunk here, and HISTORY_TURN_START
+    uint32_t first;          // the chunks' refs in History::refs, in region order
+} HistoryStep;
+
+typedef struct {
+    HistoryPool pools[HISTORY_POOLS];
+    HistoryStep* steps;
+    int count;               // steps 0..count-1 are recorded
+    int cap;
+    int current;             // step the game is at; later ones can be redone
+    uint32_t* refs;
+    uint32_t refCount, refCap;
+    uint32_t at[HISTORY_REGIONS];  // chunk per region at the current step
+    int regions;             // regions of the seated players' game
+} History;
+
+// Start a history whose step 0 is g
+bool HistoryInit(History* h, const GameState* g);
+void HistoryFree(History* h);
+
+// After an action was applied: drop the redo steps and append g
+bool HistoryRecord(History* h, const GameState* g);
+
+// Move to step and write its state to out, up to RulesStateSize; false if
+// out of range
+bool HistoryJump(History* h, int step, GameState* out);
+
+// Nearest turn start before / after the current step, or -1
+int HistoryPrevTurn(const History* h);
+int HistoryNextTurn(const History* h);
+
+// Bytes allocated for steps and chunks
+size_t HistoryBytes(const History* h);
+
+#endif
@@ -0,0 +1,424 @@
+#define _GNU_SOURCE
+#include "jobs.h"
+#include "trace.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    JOBS_DEQUE_SIZE  = 1024,  // power of two; a worker whose deque is full runs the job inline
+    JOBS_MAX_WORKERS = 256,
+    JOBS_MAX_NODES   = 64,
+    JOBS_SPIN_ROUNDS = 64     // empty rounds before an idle worker sleeps
+};
+
+// Chase-Lev deque, fixed size. top and bottom only grow, so they never
+// wrap in practice; slots are indexed modulo the size.
+typedef struct {
+    _Alignas(64) atomic_long top;      // thieves take from here
+    _Alignas(64) atomic_long bottom;   // the owner pushes and pops here
+    _Atomic(Job*) slots[JOBS_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct {
+    JobDeque deque;
+    pthread_t thread;
+    int cpu;                           // -1 when not pinned
+    int node;
+    bool started;
+} JobWorker;
+
+static struct {
+    JobWorker* workers;
+    int count;
+    atomic_bool running;
+
+    // Jobs spawned from threads outside the pool
+    pthread_mutex_t inboxLock;
+    Job* inboxHead;
+    Job* inboxTail;
+    atomic_int inboxCount;
+
+    pthread_mutex_t sleepLock;
+    pthread_cond_t sleepCond;
+    atomic_int sleepers;
+} gJobs;
+
+static _Thread_local int tWorker = -1;
+static _Thread_local unsigned tVictim;  // where the next steal round starts
+
+static bool DequePush(JobDeque* d, Job* job)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    if (b - t >= JOBS_DEQUE_SIZE) return false;
+    atomic_store_explicit(&d->slots[b & (JOBS_DEQUE_SIZE - 1)], job, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+static Job* DequePop(JobDeque* d)
+{
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    Job* job = atomic_load_explicit(&d->slots[b & (JOBS_DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (t == b) {
+        // The last job: a thief may be taking it too
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+static Job* DequeSteal(JobDeque* d)
+{
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+
+    Job* job = atomic_load_explicit(&d->slots[t & (JOBS_DEQUE_SIZE - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;  // lost the race; the caller moves on
+    }
+    return job;
+}
+
+static void InboxPush(Job* job)
+{
+    job->next = NULL;
+    pthread_mutex_lock(&gJobs.inboxLock);
+    if (gJobs.inboxTail != NULL) gJobs.inboxTail->next = job;
+    else gJobs.inboxHead = job;
+    gJobs.inboxTail = job;
+    atomic_fetch_add(&gJobs.inboxCount, 1);
+    pthread_mutex_unlock(&gJobs.inboxLock);
+}
+
+static Job* InboxPop(void)
+{
+    if (atomic_load_explicit(&gJobs.inboxCount, memory_order_relaxed) == 0) return NULL;
+    pthread_mutex_lock(&gJobs.inboxLock);
+    Job* job = gJobs.inboxHead;
+    if (job != NULL) {
+        gJobs.inboxHead = job->next;
+        if (gJobs.inboxHead == NULL) gJobs.inboxTail = NULL;
+        atomic_fetch_sub(&gJobs.inboxCount, 1);
+    }
+    pthread_mutex_unlock(&gJobs.inboxLock);
+    return job;
+}
+
+// Own deque, then the inbox, then the other workers: same node first
+static Job* FindJob(void)
+{
+    int self = tWorker;
+    Job* job = DequePop(&gJobs.workers[self].deque);
+    if (job == NULL) job = InboxPop();
+    if (job != NULL) return job;
+
+    int n = gJobs.count;
+    int node = gJobs.workers[self].node;
+    unsigned start = tVictim++;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int k = 0; k < n; ++k) {
+            int v = (int)((start + (unsigned)k) % (unsigned)n);
+            if (v == self) continue;
+            bool near = gJobs.workers[v].node == node;
+            if (near != (pass == 0)) continue;
+            job = DequeSteal(&gJobs.workers[v].deque);
+            if (job != NULL) return job;
+        }
+    }
+    return NULL;
+}
+
+static void RunJob(Job* job)
+{
+    // The job may be freed by its waiter as soon as the count drops
+    JobGroup* group = job->group;
+    TRACE_BEGIN("Job");
+    job->fn(job->arg);
+    TRACE_END("Job");
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static bool HasWork(void)
+{
+    if (atomic_load(&gJobs.inboxCount) > 0) return true;
+    for (int i = 0; i < gJobs.count; ++i) {
+        const JobDeque* d = &gJobs.workers[i].deque;
+        if (atomic_load(&d->bottom) > atomic_load(&d->top)) return true;
+    }
+    return false;
+}
+
+// Pairs with the sleeper's recheck in WorkerSleep: either it sees the new
+// job, or this sees it registered and signals under the lock
+static void WakeOne(void)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&gJobs.sleepers, memory_order_relaxed) == 0) return;
+    pthread_mutex_lock(&gJobs.sleepLock);
+    pthread_cond_signal(&gJobs.sleepCond);
+    pthread_mutex_unlock(&gJobs.sleepLock);
+}
+
+static void WorkerSleep(void)
+{
+    pthread_mutex_lock(&gJobs.sleepLock);
+    atomic_fetch_add(&gJobs.sleepers, 1);
+    if (!HasWork() && atomic_load(&gJobs.running)) pthread_cond_wait(&gJobs.sleepCond, &gJobs.sleepLock);
+    atomic_fetch_sub(&gJobs.sleepers, 1);
+    pthread_mutex_unlock(&gJobs.sleepLock);
+}
+
+static void* WorkerMain(void* arg)
+{
+    tWorker = (int)(intptr_t)arg;
+    tVictim = (unsigned)tWorker + 1;
+    char name[32];
+    snprintf(name, sizeof(name), "worker %d", tWorker);
+    TraceThreadName(name);
+    int idle = 0;
+    while (atomic_load_explicit(&gJobs.running, memory_order_relaxed)) {
+        Job* job = FindJob();
+        if (job != NULL) {
+            RunJob(job);
+            idle = 0;
+        } else if (++idle < JOBS_SPIN_ROUNDS) {
+            if (idle > JOBS_SPIN_ROUNDS / 2) sched_yield();
+        } else {
+            WorkerSleep();
+            idle = 0;
+        }
+    }
+    return NULL;
+}
+
+static void AllowedCpus(cpu_set_t* set)
+{
+    if (sched_getaffinity(0, sizeof(*set), set) == 0) return;
+    CPU_ZERO(set);
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < online && i < CPU_SETSIZE; ++i) CPU_SET((int)i, set);
+}
+
+// Allowed CPUs listed node by node from sysfs. CPUs it does not mention
+// (or all of them, without NUMA information) count as node 0.
+static int CpuOrder(int* cpus, int* nodes, int cap)
+{
+    cpu_set_t allowed, placed;
+    AllowedCpus(&allowed);
+    CPU_ZERO(&placed);
+    int n = 0;
+
+    for (int node = 0; node < JOBS_MAX_NODES; ++node) {
+        char path[64], list[1024];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* f = fopen(path, "r");
+        if (f == NULL) continue;
+        bool ok = fgets(list, sizeof(list), f) != NULL;
+        fclose(f);
+        if (!ok) continue;
+
+        // "0-3,8-11"
+        for (char* tok = strtok(list, ",\n"); tok != NULL; tok = strtok(NULL, ",\n")) {
+            int lo, hi;
+            int fields = sscanf(tok, "%d-%d", &lo, &hi);
+            if (fields < 1) continue;
+            if (fields == 1) hi = lo;
+            for (int cpu = lo; cpu <= hi && cpu < CPU_SETSIZE && n < cap; ++cpu) {
+                if (cpu < 0 || !CPU_ISSET(cpu, &allowed) || CPU_ISSET(cpu, &placed)) continue;
+                CPU_SET(cpu, &placed);
+                cpus[n] = cpu;
+                nodes[n] = node;
+                n++;
+            }
+        }
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE && n < cap; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || CPU_ISSET(cpu, &placed)) continue;
+        cpus[n] = cpu;
+        nodes[n] = 0;
+        n++;
+    }
+    return n;
+}
+
+int JobsCpuCount(void)
+{
+    cpu_set_t allowed;
+    AllowedCpus(&allowed);
+    int n = CPU_COUNT(&allowed);
+    return n > 0 ? n : 1;
+}
+
+bool JobsStart(int workers, bool pin)
+{
+    if (gJobs.workers != NULL || workers <= 0) return true;  // inline only
+    if (workers > JOBS_MAX_WORKERS) workers = JOBS_MAX_WORKERS;
+
+    gJobs.workers = aligned_alloc(64, sizeof(JobWorker) * (size_t)workers);
+    if (gJobs.workers == NULL) return false;
+    memset(gJobs.workers, 0, sizeof(JobWorker) * (size_t)workers);
+
+    static int cpus[CPU_SETSIZE], nodes[CPU_SETSIZE];
+    int cpuCount = CpuOrder(cpus, nodes, CPU_SETSIZE);
+    for (int i = 0; i < workers; ++i) {
+        gJobs.workers[i].cpu = pin && cpuCount > 0 ? cpus[i % cpuCount] : -1;
+        gJobs.workers[i].node = cpuCount > 0 ? nodes[i % cpuCount] : 0;
+    }
+
+    pthread_mutex_init(&gJobs.inboxLock, NULL);
+    pthread_mutex_init(&gJobs.sleepLock, NULL);
+    pthread_cond_init(&gJobs.sleepCond, NULL);
+    gJobs.inboxHead = gJobs.inboxTail = NULL;
+    atomic_store(&gJobs.inboxCount, 0);
+    atomic_store(&gJobs.sleepers, 0);
+    atomic_store(&gJobs.running, true);
+
+    // Published before the threads start; a worker that failed to start is
+    // only a deque nobody fills
+    gJobs.count = workers;
+    for (int i = 0; i < workers; ++i) {
+        JobWorker* w = &gJobs.workers[i];
+        w->started = pthread_create(&w->thread, NULL, WorkerMain, (void*)(intptr_t)i) == 0;
+        if (w->started && w->cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(w->cpu, &set);
+            pthread_setaffinity_np(w->thread, sizeof(set), &set);
+        }
+    }
+    return true;
+}
+
+void JobsStop(void)
+{
+    if (gJobs.workers == NULL) return;
+    pthread_mutex_lock(&gJobs.sleepLock);
+    atomic_store(&gJobs.running, false);
+    pthread_cond_broadcast(&gJobs.sleepCond);
+    pthread_mutex_unlock(&gJobs.sleepLock);
+    for (int i = 0; i < gJobs.count; ++i) {
+        if (gJobs.workers[i].started) pthread_join(gJobs.workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&gJobs.sleepCond);
+    pthread_mutex_destroy(&gJobs.sleepLock);
+    pthread_mutex_destroy(&gJobs.inboxLock);
+    free(gJobs.workers);
+    gJobs.workers = NULL;
+    gJobs.count = 0;
+}
+
+int JobsWorkerCount(void)
+{
+    return gJobs.count;
+}
+
+int JobsWorkerIndex(void)
+{
+    return tWorker;
+}
+
+void JobSpawn(JobGroup* group, Job* job, JobFn fn, void* arg)
+{
+    job->fn = fn;
+    job->arg = arg;
+    job->group = group;
+    if (gJobs.count == 0) {
+        fn(arg);
+        return;
+    }
+
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    if (tWorker < 0) {
+        InboxPush(job);
+    } else if (!DequePush(&gJobs.workers[tWorker].deque, job)) {
+        RunJob(job);
+        return;
+    }
+    WakeOne();
+}
+
+bool JobGroupDone(JobGroup* group)
+{
+    return atomic_load_explicit(&group->pending, memory_order_acquire) == 0;
+}
+
+// Workers run other jobs while they wait. Other threads only wait: their
+// own spawns go to the inbox, and taking those back oldest first would nest
+// one wait inside another without bound.
+void JobWait(JobGroup* group)
+{
+    int idle = 0;
+    while (!JobGroupDone(group)) {
+        Job* job = tWorker >= 0 ? FindJob() : NULL;
+        if (job != NULL) {
+            RunJob(job);
+            idle = 0;
+        } else if (++idle < JOBS_SPIN_ROUNDS) {
+            sched_yield();
+        } else {
+            // What is left runs elsewhere and is long: stop burning the core
+            nanosleep(&(struct timespec){ 0, 20 * 1000 }, NULL);
+        }
+    }
+}
+
+static void RangeRun(JobRangeFn fn, void* ctx, int begin, int end, int grain);
+
+static void RangeJob(void* arg)
+{
+    JobRange* r = arg;
+    RangeRun(r->fn, r->ctx, r->begin, r->end, r->grain);
+}
+
+// Keep the first half, offer the second: a thief takes the biggest piece
+// left and splits it further on its own deque
+static void RangeRun(JobRangeFn fn, void* ctx, int begin, int end, int grain)
+{
+    if (end - begin <= grain) {
+        fn(ctx, begin, end);
+        return;
+    }
+    int mid = begin + (end - begin) / 2;
+    JobRange right = { .fn = fn, .ctx = ctx, .begin = mid, .end = end, .grain = grain };
+    JobGroup group = { 0 };
+    JobSpawn(&group, &right.job, RangeJob, &right);
+    RangeRun(fn, ctx, begin, mid, grain);
+    JobWait(&group);
+}
+
+void JobParallelForAsync(JobGroup* group, JobRange* range, int count, int grain, JobRangeFn fn, void* ctx)
+{
+    *range = (JobRange){ .fn = fn, .ctx = ctx, .begin = 0, .end = count, .grain = grain > 0 ? grain : 1 };
+    if (count > 0) JobSpawn(group, &range->job, RangeJob, range);
+}
+
+void JobParallelFor(int count, int grain, JobRangeFn fn, void* ctx)
+{
+    JobGroup group = { 0 };
+    JobRange range;
+    JobParallelForAsync(&group, &range, count, grain, fn, ctx);
+    JobWait(&group);
+}
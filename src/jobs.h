@@ -0,0 +1,75 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Engine-wide job system: one fixed pool of worker threads that every
+// CPU-heavy feature (search, batch games, book building) runs on, so they
+// share the cores instead of each starting threads of its own.
+//
+// Each worker owns a lock-free deque (Chase-Lev): it pushes and pops jobs at
+// the bottom, and idle workers steal from the top, trying workers on their
+// own NUMA node first. Threads outside the pool submit through a shared
+// inbox. A job is a function, an argument and the group it belongs to; the
+// caller owns the Job and keeps it alive until the group is waited on, so
+// spawning never allocates. A worker waiting on a group runs other jobs
+// meanwhile, which makes nested fork/join safe at any depth; a thread
+// outside the pool just waits, so the pool is all the parallelism there is
+// and size it for the machine.
+//
+// Without JobsStart (or with no workers) every job runs inline in
+// JobSpawn, so code written against this also runs single-threaded.
+
+typedef void (*JobFn)(void* arg);
+typedef void (*JobRangeFn)(void* ctx, int begin, int end);
+
+typedef struct {
+    atomic_int pending;      // jobs spawned and not finished; zero it to start
+} JobGroup;
+
+typedef struct Job {
+    JobFn fn;
+    void* arg;
+    JobGroup* group;
+    struct Job* next;        // inbox link
+} Job;
+
+// A parallel-for in flight; see JobParallelForAsync
+typedef struct {
+    Job job;
+    JobRangeFn fn;
+    void* ctx;
+    int begin, end, grain;
+} JobRange;
+
+// workers <= 0 starts no threads. With pin, worker i is bound to the i-th
+// allowed CPU, counting node by node.
+bool JobsStart(int workers, bool pin);
+void JobsStop(void);
+
+// CPUs this process may run on
+int JobsCpuCount(void);
+
+// Pool size, and the calling thread's worker index (-1 outside the pool)
+int JobsWorkerCount(void);
+int JobsWorkerIndex(void);
+
+// Fork: run fn(arg) on the pool as part of group. job must stay valid
+// until JobWait(group) returns.
+void JobSpawn(JobGroup* group, Job* job, JobFn fn, void* arg);
+
+// Join: returns once every job of group has finished. On a worker it runs
+// jobs (group's or any other) while it waits.
+void JobWait(JobGroup* group);
+bool JobGroupDone(JobGroup* group);
+
+// fn over [0, count) in ranges of at most grain, split in halves so idle
+// workers steal big pieces first. Returns when all ranges are done.
+void JobParallelFor(int count, int grain, JobRangeFn fn, void* ctx);
+
+// The same without waiting: range is the caller's storage for it, and
+// both range and group must stay valid until JobWait(group)
+void JobParallelForAsync(JobGroup* group, JobRange* range, int count, int grain, JobRangeFn fn, void* ctx);
+
+#endif
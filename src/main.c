@@ -1,19 +1,196 @@
 #include "game.h"
 #include "assets.h"
+#include "ui.h"
+#include "pacing.h"
+#include "sim.h"
+#include "ai.h"
+#include "engine.h"
+#include "replay.h"
+#include "trace.h"
+#include "wall.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
-int main(void)
+// Title screen doubles as the loading screen: assets stream in on the
+// loader thread and are uploaded here as they arrive.
+static bool RunTitleScreen(void)
 {
-    GameState g = {0};
-    GameInit(&g);
+    while (!WindowShouldClose()) {
+        bool ready = AssetsPollLoad();
+        if (ready && (GetKeyPressed() != 0 || IsMouseButtonPressed(MOUSE_BUTTON_LEFT))) {
+            return true;
+        }
+        if (!ready) PacingRequest(PACE_ACTIVE);
+        BeginDrawing();
+        UI_DrawTitleScreen(AssetsLoadProgress(), ready);
+        PacingApply();
+        EndDrawing();
+    }
+    return false;
+}
 
-    while (!WindowShouldClose() && !g.gameEnded) {
-        GameUpdate(&g);
+// With watch set, games is the number of reefd matches in it
+static int RunWall(int games, int players, const BotConfig* bots, int botCount, const char* watch, const uint32_t* matches)
+{
+    bool started = watch != NULL ? WallWatch(watch, matches, games, players) : WallStart(games, players, bots, botCount);
+    if (!started) {
+        fprintf(stderr, "reef: cannot create the spectator wall\n");
+        CloseWindow();
+        return 1;
+    }
+    while (!WindowShouldClose()) {
+        TRACE_BEGIN("WallUpdate");
+        WallUpdate();
+        TRACE_END("WallUpdate");
         BeginDrawing();
-        GameDraw(&g);
+        TRACE_BEGIN("WallDraw");
+        WallDraw();
+        TRACE_END("WallDraw");
+        PacingApply();
         EndDrawing();
     }
+    WallStop();
+    CloseWindow();
+    return 0;
+}
+
+static int RunReplay(const char* path)
+{
+    if (!ReplayLoad(path)) return 1;
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Reef - replay");
+    SetTargetFPS(PACE_ACTIVE_FPS);
+    AssetsBeginLoad();  // drawn without textures until they arrive
+    while (!WindowShouldClose()) {
+        if (!AssetsPollLoad()) PacingRequest(PACE_ACTIVE);
+        ReplayUpdate();
+        BeginDrawing();
+        TRACE_BEGIN("ReplayDraw");
+        ReplayDraw();
+        TRACE_END("ReplayDraw");
+        PacingApply();
+        EndDrawing();
+    }
+    ReplayUnload();
+    AssetsUnloadAll();
+    CloseWindow();
+    return 0;
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--players 2-4] [--ai SEAT]... [--think-ms N] [--new] [--trace FILE]\n"
+                    "       %s --engine [--trace FILE]   (bot protocol on stdin/stdout, see engine.h)\n"
+                    "       %s --wall GAMES [--players 2-4] [--bot SPEC]... [--trace FILE]   (bot games side by side;\n"
+                    "             one --bot per seat, the bots taking turns at each seat)\n"
+                    "       %s --watch ADDRESS MATCH[,MATCH]... [--players 2-4] [--trace FILE]   (reefd matches side by side;\n"
+                    "             ADDRESS is host:port or reefd's Unix socket path)\n"
+                    "       %s --replay FILE [--trace FILE]   (a recorded game, see replay.h)\n",
+            argv0, argv0, argv0, argv0, argv0);
+}
+
+int main(int argc, char** argv)
+{
+    bool computer[PLAYERS_MAX] = { false };
+    int thinkMs = AI_DEFAULT_THINK_MS;
+    int players = PLAYERS_MIN;
+    bool resume = true;
+    const char* trace = NULL;
+    bool engine = false;
+    int wall = 0;
+    const char* watch = NULL;
+    uint32_t matches[WALL_MAX_GAMES];
+    const char* replay = NULL;
+    BotConfig bots[PLAYERS_MAX];
+    int botCount = 0;
+    BotDefaultConfig(&bots[0], BOT_GREEDY);
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--ai") == 0 && hasValue) {
+            int seat = atoi(argv[++i]) - 1;
+            if (seat < 0 || seat >= PLAYERS_MAX) { Usage(argv[0]); return 1; }
+            computer[seat] = true;
+        }
+        else if (strcmp(argv[i], "--players") == 0 && hasValue) {
+            players = atoi(argv[++i]);
+            if (players < PLAYERS_MIN || players > PLAYERS_MAX) { Usage(argv[0]); return 1; }
+        }
+        else if (strcmp(argv[i], "--think-ms") == 0 && hasValue) thinkMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--new") == 0) resume = false;  // ignore the saved game
+        else if (strcmp(argv[i], "--trace") == 0 && hasValue) trace = argv[++i];
+        else if (strcmp(argv[i], "--engine") == 0) engine = true;
+        else if (strcmp(argv[i], "--wall") == 0 && hasValue) {
+            wall = atoi(argv[++i]);
+            if (wall < 1 || wall > WALL_MAX_GAMES) { Usage(argv[0]); return 1; }
+        }
+        else if (strcmp(argv[i], "--watch") == 0 && i + 2 < argc) {
+            watch = argv[++i];
+            wall = 0;
+            for (char* id = argv[++i]; *id != '\0' && wall < WALL_MAX_GAMES; ++wall) {
+                char* end;
+                matches[wall] = (uint32_t)strtoul(id, &end, 0);
+                if (end == id || (*end != ',' && *end != '\0')) { Usage(argv[0]); return 1; }
+                id = *end == ',' ? end + 1 : end;
+            }
+            if (wall == 0) { Usage(argv[0]); return 1; }
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && hasValue) replay = argv[++i];
+        else if (strcmp(argv[i], "--bot") == 0 && hasValue) {
+            if (botCount == PLAYERS_MAX || !BotParseConfig(argv[++i], &bots[botCount])) { Usage(argv[0]); return 1; }
+            botCount++;
+        }
+        else { Usage(argv[0]); return 1; }
+    }
+
+    // From the start, so loading is in the capture; F12 toggles one later
+    TraceThreadName("main");
+    if (trace != NULL && !TraceStart(trace)) fprintf(stderr, "reef: cannot write %s\n", trace);
+    if (engine) {
+        int status = EngineRun(stdin, stdout);  // no window
+        TraceStop();
+        return status;
+    }
+    if (wall > 0) {
+        int status = RunWall(wall, players, bots, botCount > 0 ? botCount : 1, watch, matches);
+        TraceStop();
+        return status;
+    }
+    if (replay != NULL) {
+        int status = RunReplay(replay);
+        TraceStop();
+        return status;
+    }
+
+    GameInit(players, resume);  // a resumed game keeps its own player count
+    AiSetThinkTime(thinkMs);
+    for (int p = 0; p < PLAYERS_MAX; ++p) AiSetSeat(p, computer[p]);
+
+    if (RunTitleScreen()) {
+        const GameState* g = SimAcquireSnapshot();
+        // Runs past the end of the game so the last moves can be undone
+        while (!WindowShouldClose()) {
+            TRACE_BEGIN("GameUpdate");
+            GameUpdate(g);
+            TRACE_END("GameUpdate");
+
+            // Sample pending before acquiring so a late publish is never missed
+            if (SimPending()) PacingRequest(PACE_ACTIVE);
+            g = SimAcquireSnapshot();
+
+            BeginDrawing();
+            TRACE_BEGIN("GameDraw");
+            GameDraw(g);
+            TRACE_END("GameDraw");
+            PacingApply(); // idles on input events when nothing changed
+            TRACE_BEGIN("EndDrawing");
+            EndDrawing();
+            TRACE_END("EndDrawing");
+        }
+    }
 
+    GameShutdown();
     AssetsUnloadAll();
     CloseWindow();
+    TraceStop();
     return 0;
 }
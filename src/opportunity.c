@@ -0,0 +1,214 @@
+#include "opportunity.h"
+#include "cards.h"
+#include <string.h>
+
+void OpportunityInit(OpportunityIndex* x, int player, uint16_t slots)
+{
+    memset(x, 0, sizeof(*x));
+    x->player = player;
+    x->slots = slots;
+    memset(x->card, OPPORTUNITY_NO_CARD, sizeof(x->card));
+}
+
+const Opportunity* OpportunityAt(const OpportunityIndex* x, int row, int col, CoralColor color)
+{
+    return &x->at[row * BOARD_SIZE + col][color - 1];
+}
+
+// The cards the player can see, by slot, of those the index keeps
+static void VisibleCards(const OpportunityIndex* x, const GameState* g, CardId* card)
+{
+    int player = x->player;
+    const Player* pl = &g->players[player];
+    memset(card, OPPORTUNITY_NO_CARD, OPPORTUNITY_SLOTS);
+    for (int i = 0; i < pl->handSize; ++i) card[OPPORTUNITY_HAND + i] = pl->hand[i];
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) card[OPPORTUNITY_DISPLAY + i] = g->display[i];
+    if (g->deckSize > 0) card[OPPORTUNITY_DECK] = g->deck[g->deckSize - 1];
+    if (g->placement.active && g->currentPlayer == player) card[OPPORTUNITY_PLAYING] = g->placement.card;
+    for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) {
+        if (!(x->slots & (1u << s))) card[s] = OPPORTUNITY_NO_CARD;
+    }
+}
+
+// Scores only depend on the kind; copies of a card share a column
+static int SlotKind(CardId id)
+{
+    return id == OPPORTUNITY_NO_CARD ? -1 : CardKind(id);
+}
+
+static void SetDelta(OpportunityIndex* x, int slot, int cell, int color, int delta)
+{
+    Opportunity* o = &x->at[cell][color];
+    o->delta[slot] = (int16_t)delta;
+    if (delta != 0) o->cards |= (uint16_t)(1u << slot);
+    else o->cards &= (uint16_t)~(1u << slot);
+}
+
+// Placements of the slot's card that reach each cell, and its score on
+// the board as it stands
+static void BuildSlot(OpportunityIndex* x, int slot)
+{
+    const CompiledPattern* pattern = &CARD_PATTERNS[CardKind(x->card[slot])];
+    memset(x->cover[slot], 0, sizeof(x->cover[slot]));
+    for (int i = 0; i < pattern->placementCount; ++i) {
+        const PatternPlacement* p = &pattern->placements[i];
+        uint16_t reach = p->cells;
+        for (int g = 0; g < pattern->groupCount; ++g) reach |= p->groups[g];
+        for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+            if (reach & (1u << cell)) x->cover[slot][cell] |= (uint16_t)(1u << i);
+        }
+    }
+    PatternRequirements(&x->masks, pattern, x->ok[slot]);
+    x->matches[slot] = PatternMatches(pattern, x->ok[slot], UINT16_MAX);
+    x->score[slot] = (int16_t)PatternClaim(pattern, x->matches[slot]);
+}
+
+// Rescore the slot's card with a piece on each of cells. Only that cell's
+// requirement bits and the placements reaching it are tested again; the
+// rest keep the board's matches.
+static void ScoreCells(OpportunityIndex* x, int slot, uint16_t cells)
+{
+    const CompiledPattern* pattern = &CARD_PATTERNS[CardKind(x->card[slot])];
+    for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+        if (!(cells & (1u << cell))) continue;
+        const CoralStack* s = &x->board[cell / BOARD_SIZE][cell % BOARD_SIZE];
+        uint16_t cover = x->cover[slot][cell];
+        uint16_t bit = (uint16_t)(1u << cell);
+        for (int color = 0; color < OPPORTUNITY_COLORS; ++color) {
+            int delta = 0;
+            if (s->height < MAX_STACK_HEIGHT && cover != 0) {
+                uint16_t ok[PATTERN_MAX_GROUPS];
+                for (int g = 0; g < pattern->groupCount; ++g) {
+                    bool met = PatternRequirementMet(&pattern->groups[g], (CoralColor)(color + 1), s->height + 1);
+                    ok[g] = (uint16_t)((x->ok[slot][g] & ~bit) | (met ? bit : 0));
+                }
+                uint16_t near = PatternMatches(pattern, ok, cover);
+                if (near != (x->matches[slot] & cover)) {
+                    delta = PatternClaim(pattern, (x->matches[slot] & ~cover) | near) - x->score[slot];
+                }
+            }
+            SetDelta(x, slot, cell, color, delta);
+        }
+    }
+}
+
+static void ClearSlot(OpportunityIndex* x, int slot)
+{
+    for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+        for (int color = 0; color < OPPORTUNITY_COLORS; ++color) SetDelta(x, slot, cell, color, 0);
+    }
+    x->score[slot] = 0;
+    x->matches[slot] = 0;
+    memset(x->ok[slot], 0, sizeof(x->ok[slot]));
+}
+
+// Move columns to the slots their cards went to (a card taken into the
+// hand, the hand closing up after a play), so only new kinds start over
+static void FollowCards(OpportunityIndex* x, const CardId* card, bool* fresh)
+{
+    int from[OPPORTUNITY_SLOTS];
+    bool moved = false;
+    for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) {
+        int kind = SlotKind(card[s]);
+        from[s] = -1;
+        if (kind < 0 || kind == SlotKind(x->card[s])) {
+            fresh[s] = false;
+            continue;
+        }
+        for (int t = 0; t < OPPORTUNITY_SLOTS && from[s] < 0; ++t) {
+            if (SlotKind(x->card[t]) == kind) from[s] = t;
+        }
+        fresh[s] = from[s] < 0;
+        moved = moved || from[s] >= 0;
+    }
+
+    if (moved) {
+        OpportunityIndex old = *x;
+        for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) {
+            int t = from[s];
+            if (t < 0) continue;
+            memcpy(x->cover[s], old.cover[t], sizeof(x->cover[s]));
+            memcpy(x->ok[s], old.ok[t], sizeof(x->ok[s]));
+            x->matches[s] = old.matches[t];
+            x->score[s] = old.score[t];
+            for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+                for (int color = 0; color < OPPORTUNITY_COLORS; ++color) {
+                    SetDelta(x, s, cell, color, old.at[cell][color].delta[t]);
+                }
+            }
+        }
+    }
+    for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) {
+        if (card[s] == OPPORTUNITY_NO_CARD && x->card[s] != OPPORTUNITY_NO_CARD) ClearSlot(x, s);
+        x->card[s] = card[s];
+    }
+}
+
+int OpportunitySync(OpportunityIndex* x, const GameState* g)
+{
+    const Player* pl = &g->players[x->player];
+
+    // Only the top piece and the height of a stack count
+    uint16_t changed = 0;
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) {
+            const CoralStack* was = &x->board[r][c];
+            const CoralStack* now = &pl->board[r][c];
+            bool same = x->built && was->height == now->height &&
+                        (now->height == 0 || was->pieces[now->height - 1] == now->pieces[now->height - 1]);
+            if (!same) changed |= (uint16_t)(1u << (r * BOARD_SIZE + c));
+        }
+    }
+    if (changed != 0) {
+        memcpy(x->board, pl->board, sizeof(x->board));
+        BoardMasksBuild(pl, &x->masks);
+    }
+
+    CardId card[OPPORTUNITY_SLOTS];
+    bool fresh[OPPORTUNITY_SLOTS];
+    VisibleCards(x, g, card);
+    if (x->built) {
+        FollowCards(x, card, fresh);
+    } else {
+        memcpy(x->card, card, sizeof(x->card));
+        for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) fresh[s] = card[s] != OPPORTUNITY_NO_CARD;
+    }
+    x->built = true;
+
+    int rescored = 0;
+    for (int s = 0; s < OPPORTUNITY_SLOTS; ++s) {
+        if (x->card[s] == OPPORTUNITY_NO_CARD) continue;
+        if (fresh[s]) {
+            BuildSlot(x, s);
+            ScoreCells(x, s, UINT16_MAX);
+            rescored++;
+            continue;
+        }
+
+        if (changed == 0) continue;
+        const CompiledPattern* pattern = &CARD_PATTERNS[CardKind(x->card[s])];
+        PatternRequirements(&x->masks, pattern, x->ok[s]);
+        uint16_t reach = 0;
+        for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+            if (changed & (1u << cell)) reach |= x->cover[s][cell];
+        }
+        if (reach == 0) continue;
+
+        // A change in the board's own matches moves every entry's baseline;
+        // otherwise only cells sharing a placement with a changed cell move
+        uint16_t matches = (uint16_t)((x->matches[s] & ~reach) | PatternMatches(pattern, x->ok[s], reach));
+        uint16_t cells = 0;
+        if (matches != x->matches[s]) {
+            x->matches[s] = matches;
+            x->score[s] = (int16_t)PatternClaim(pattern, matches);
+            cells = UINT16_MAX;
+        } else {
+            for (int cell = 0; cell < OPPORTUNITY_CELLS; ++cell) {
+                if (x->cover[s][cell] & reach) cells |= (uint16_t)(1u << cell);
+            }
+        }
+        ScoreCells(x, s, cells);
+        rescored++;
+    }
+    return rescored;
+}
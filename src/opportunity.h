@@ -0,0 +1,67 @@
+#ifndef OPPORTUNITY_H
+#define OPPORTUNITY_H
+
+#include "patterns.h"
+
+// Opportunity index: for one player, what one more piece would do for each
+// card they can see. Every cell and color has the set of visible cards
+// whose score the piece would change, and by how much, so "which cards
+// does a purple piece on (1, 2) help?" is a table read instead of a pattern
+// scan per card.
+//
+// The index keeps the board and the cards it was built from. Syncing with
+// a later position rescores only what changed: a card new to its slot gets
+// its whole column, a changed cell only the entries whose placements reach
+// it. One placed piece costs a handful of placements per card rather than
+// 16 cells x 4 colors of full scans.
+//
+// Supplies and whose turn it is are left to the caller; a full stack has
+// no entries. Kept out of GameState so searches copying states do not pay
+// for it.
+
+typedef enum {
+    OPPORTUNITY_HAND    = 0,                                  // + hand index
+    OPPORTUNITY_DISPLAY = MAX_HAND_SIZE,                      // + display index
+    OPPORTUNITY_DECK    = MAX_HAND_SIZE + CARD_DISPLAY_SIZE,  // top of the deck
+    OPPORTUNITY_PLAYING,                                      // card being placed (own turn)
+    OPPORTUNITY_SLOTS
+} OpportunitySlot;
+
+enum {
+    OPPORTUNITY_CELLS  = BOARD_SIZE * BOARD_SIZE,
+    OPPORTUNITY_COLORS = 4,    // CORAL_YELLOW..CORAL_GREEN, indexed color - 1
+    OPPORTUNITY_NO_CARD = 0xFF,
+    OPPORTUNITY_ALL     = (1 << OPPORTUNITY_SLOTS) - 1
+};
+
+typedef struct {
+    uint16_t cards;                    // bit per OpportunitySlot whose score changes
+    int16_t delta[OPPORTUNITY_SLOTS];  // points change; 0 outside cards
+} Opportunity;
+
+typedef struct {
+    int player;
+    uint16_t slots;                    // bit per OpportunitySlot kept up to date
+    Opportunity at[OPPORTUNITY_CELLS][OPPORTUNITY_COLORS];  // cell r * BOARD_SIZE + c
+    CardId card[OPPORTUNITY_SLOTS];    // OPPORTUNITY_NO_CARD when empty
+    int16_t score[OPPORTUNITY_SLOTS];  // each card on the board as it stands
+
+    // What the table was built from
+    bool built;
+    CoralStack board[BOARD_SIZE][BOARD_SIZE];
+    BoardMasks masks;
+    uint16_t ok[OPPORTUNITY_SLOTS][PATTERN_MAX_GROUPS];  // PatternRequirements of each card
+    uint16_t matches[OPPORTUNITY_SLOTS];                 // and its PatternMatches
+    uint16_t cover[OPPORTUNITY_SLOTS][OPPORTUNITY_CELLS];  // placements reaching each cell
+} OpportunityIndex;
+
+// An empty index for player keeping the given slots (OPPORTUNITY_ALL, or
+// fewer when the rest would go unread); the first sync builds it
+void OpportunityInit(OpportunityIndex* x, int player, uint16_t slots);
+
+// Bring x up to date with g. Returns how many slots were rescored.
+int OpportunitySync(OpportunityIndex* x, const GameState* g);
+
+const Opportunity* OpportunityAt(const OpportunityIndex* x, int row, int col, CoralColor color);
+
+#endif
@@ -0,0 +1,54 @@
+#include "pacing.h"
+#include "raylib.h"
+
+// Keep full rate this long after the last active request so short bursts
+// (a two-click placement, a loader finishing) don't thrash between modes
+static const double PACE_ACTIVE_GRACE = 0.5;
+
+static struct {
+    PaceLevel requested;  // max level requested this frame
+    PaceLevel applied;
+    bool initialized;
+    double lastActive;
+} gPacing;
+
+void PacingRequest(PaceLevel level)
+{
+    if (level > gPacing.requested) gPacing.requested = level;
+}
+
+void PacingApply(void)
+{
+    double now = GetTime();
+    PaceLevel level = gPacing.requested;
+    gPacing.requested = PACE_IDLE;
+
+    if (level == PACE_ACTIVE) gPacing.lastActive = now;
+    else if (now - gPacing.lastActive < PACE_ACTIVE_GRACE) level = PACE_ACTIVE;
+
+    if (gPacing.initialized && level == gPacing.applied) return;
+    gPacing.initialized = true;
+    gPacing.applied = level;
+
+    switch (level) {
+        case PACE_ACTIVE:
+            DisableEventWaiting();
+            SetTargetFPS(PACE_ACTIVE_FPS);
+            break;
+        case PACE_TICK:
+            DisableEventWaiting();
+            SetTargetFPS(PACE_TICK_FPS);
+            break;
+        case PACE_IDLE:
+        default:
+            // Bursts of input (mouse motion) still never exceed the active rate
+            SetTargetFPS(PACE_ACTIVE_FPS);
+            EnableEventWaiting();
+            break;
+    }
+}
+
+PaceLevel PacingCurrentLevel(void)
+{
+    return gPacing.applied;
+}
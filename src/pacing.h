@@ -0,0 +1,24 @@
+#ifndef PACING_H
+#define PACING_H
+
+// Adaptive frame pacing. Anything that needs frames (state changes,
+// loading, background work whose results must show up) requests a level
+// during the frame; PacingApply then picks the frame rate right before
+// EndDrawing. With no requests the loop blocks on input events, so an idle
+// client costs no CPU and still wakes immediately on input.
+typedef enum {
+    PACE_IDLE = 0,   // block until the next input event
+    PACE_TICK,       // low fixed rate, for polling background work
+    PACE_ACTIVE      // full frame rate
+} PaceLevel;
+
+enum {
+    PACE_ACTIVE_FPS = 60,
+    PACE_TICK_FPS   = 10
+};
+
+void PacingRequest(PaceLevel level);
+void PacingApply(void);        // call once per frame, before EndDrawing
+PaceLevel PacingCurrentLevel(void);
+
+#endif
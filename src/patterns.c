@@ -1,181 +1,100 @@
 #include "patterns.h"
-#include <string.h>
+#include "cards.h"
+#include "trace.h"
 
-// Check if a cell matches the pattern requirements
-static bool CellMatches(const CoralStack* stack, const PatternCell* cell) {
-    if (stack->height == 0) return false;
-    
-    CoralColor topColor = stack->pieces[stack->height - 1];
-    
-    // Check color requirement
-    if (!cell->isWild && cell->color != CORAL_NONE && cell->color != topColor) {
-        return false;
-    }
-    
-    // Check exact height requirement
-    if (cell->exactHeight > 0 && stack->height != cell->exactHeight) {
-        return false;
-    }
-    
-    // Check minimum height requirement
-    if (cell->minHeight > 0 && stack->height < cell->minHeight) {
-        return false;
-    }
-    
-    return true;
-}
-
-// Check if pattern matches at specific position
-bool MatchesPatternAt(const Player* player, const ScoringPattern* pattern, int startRow, int startCol) {
-    // Check bounds
-    if (startRow + pattern->height > BOARD_SIZE || startCol + pattern->width > BOARD_SIZE) {
-        return false;
-    }
-    
-    // Check each cell in the pattern
-    for (int r = 0; r < pattern->height; r++) {
-        for (int c = 0; c < pattern->width; c++) {
-            const PatternCell* cell = &pattern->cells[r][c];
-            
-            // Skip empty pattern cells
-            if (cell->color == CORAL_NONE && cell->exactHeight == 0 && cell->minHeight == 0 && !cell->isWild) {
-                continue;
-            }
-            
-            const CoralStack* stack = &player->board[startRow + r][startCol + c];
-            if (!CellMatches(stack, cell)) {
-                return false;
-            }
+void BoardMasksBuild(const Player* player, BoardMasks* m)
+{
+    *m = (BoardMasks){ 0 };
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) {
+            const CoralStack* s = &player->board[r][c];
+            uint16_t bit = (uint16_t)(1u << (r * BOARD_SIZE + c));
+            m->height[s->height] |= bit;
+            if (s->height == 0) continue;
+            m->top[CORAL_NONE] |= bit;
+            m->top[s->pieces[s->height - 1]] |= bit;
         }
     }
-    
-    return true;
 }
 
-// Score a pattern across the entire board
-int ScorePattern(const Player* player, const ScoringPattern* pattern) {
-    int matches = 0;
-    bool used[BOARD_SIZE][BOARD_SIZE] = {false};
-    
-    // Try pattern at each position
-    for (int r = 0; r <= BOARD_SIZE - pattern->height; r++) {
-        for (int c = 0; c <= BOARD_SIZE - pattern->width; c++) {
-            if (MatchesPatternAt(player, pattern, r, c)) {
-                // Check if any cells are already used
-                bool canUse = true;
-                for (int pr = 0; pr < pattern->height && canUse; pr++) {
-                    for (int pc = 0; pc < pattern->width && canUse; pc++) {
-                        const PatternCell* cell = &pattern->cells[pr][pc];
-                        if ((cell->color != CORAL_NONE || cell->exactHeight > 0 || cell->minHeight > 0 || cell->isWild) 
-                            && used[r + pr][c + pc]) {
-                            canUse = false;
-                        }
-                    }
-                }
-                
-                if (canUse) {
-                    // Mark cells as used
-                    for (int pr = 0; pr < pattern->height; pr++) {
-                        for (int pc = 0; pc < pattern->width; pc++) {
-                            const PatternCell* cell = &pattern->cells[pr][pc];
-                            if (cell->color != CORAL_NONE || cell->exactHeight > 0 || cell->minHeight > 0 || cell->isWild) {
-                                used[r + pr][c + pc] = true;
-                            }
-                        }
-                    }
-                    matches++;
-                }
-            }
-        }
+static uint16_t RequirementMask(const BoardMasks* m, const PatternRequirement* req)
+{
+    uint16_t ok = m->top[req->color];
+    if (req->exactHeight > 0) ok &= m->height[req->exactHeight];
+    if (req->minHeight > 0) {
+        uint16_t tall = 0;
+        for (int h = req->minHeight; h <= MAX_STACK_HEIGHT; ++h) tall |= m->height[h];
+        ok &= tall;
     }
-    
-    return matches * pattern->pointValue;
+    return ok;
 }
 
-// Create a 2-piece line pattern
-ScoringPattern CreateLine2Pattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_LINE_2;
-    pattern.width = 2;
-    pattern.height = 1;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[0][1].color = color;
-    
-    return pattern;
+void PatternRequirements(const BoardMasks* m, const CompiledPattern* pattern, uint16_t ok[PATTERN_MAX_GROUPS])
+{
+    for (int g = 0; g < pattern->groupCount; ++g) ok[g] = RequirementMask(m, &pattern->groups[g]);
 }
 
-// Create a 3-piece line pattern
-ScoringPattern CreateLine3Pattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_LINE_3;
-    pattern.width = 3;
-    pattern.height = 1;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[0][1].color = color;
-    pattern.cells[0][2].color = color;
-    
-    return pattern;
+bool PatternRequirementMet(const PatternRequirement* req, CoralColor top, int height)
+{
+    if (height == 0) return false;  // every requirement wants a piece
+    if (req->color != CORAL_NONE && req->color != top) return false;
+    if (req->exactHeight > 0 && height != req->exactHeight) return false;
+    return height >= req->minHeight;
 }
 
-// Create a 2x2 square pattern
-ScoringPattern CreateSquare2x2Pattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_SQUARE_2X2;
-    pattern.width = 2;
-    pattern.height = 2;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[0][1].color = color;
-    pattern.cells[1][0].color = color;
-    pattern.cells[1][1].color = color;
-    
-    return pattern;
+uint16_t PatternMatches(const CompiledPattern* pattern, const uint16_t ok[PATTERN_MAX_GROUPS], uint16_t candidates)
+{
+    uint16_t matches = 0;
+    for (int i = 0; i < pattern->placementCount; ++i) {
+        if (!(candidates & (1u << i))) continue;
+        const PatternPlacement* p = &pattern->placements[i];
+        bool fits = true;
+        for (int g = 0; g < pattern->groupCount && fits; ++g) fits = (p->groups[g] & ~ok[g]) == 0;
+        if (fits) matches |= (uint16_t)(1u << i);
+    }
+    return matches;
 }
 
-// Create an L-shape pattern
-ScoringPattern CreateLShapePattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_L_SHAPE;
-    pattern.width = 2;
-    pattern.height = 2;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[1][0].color = color;
-    pattern.cells[1][1].color = color;
-    
-    return pattern;
+int PatternClaim(const CompiledPattern* pattern, uint16_t matches)
+{
+    uint16_t used = 0;
+    int claimed = 0;
+    for (int i = 0; i < pattern->placementCount; ++i) {
+        const PatternPlacement* p = &pattern->placements[i];
+        if (!(matches & (1u << i)) || (p->cells & used)) continue;
+        used |= p->cells;
+        claimed++;
+    }
+    return claimed * pattern->points;
 }
 
-// Create a height-2 pattern (exactly 2 pieces high)
-ScoringPattern CreateHeight2Pattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_HEIGHT_2;
-    pattern.width = 1;
-    pattern.height = 1;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[0][0].exactHeight = 2;
-    
-    return pattern;
+// Kept in one pass for the searches: placements overlapping a claimed one
+// are skipped before their requirements are tested
+int ScoreCompiled(const BoardMasks* m, const CompiledPattern* pattern)
+{
+    uint16_t ok[PATTERN_MAX_GROUPS];
+    PatternRequirements(m, pattern, ok);
+
+    uint16_t used = 0;
+    int matches = 0;
+    for (int i = 0; i < pattern->placementCount; ++i) {
+        const PatternPlacement* p = &pattern->placements[i];
+        bool fits = (p->cells & used) == 0;
+        for (int g = 0; g < pattern->groupCount && fits; ++g) fits = (p->groups[g] & ~ok[g]) == 0;
+        if (fits) {
+            used |= p->cells;
+            matches++;
+        }
+    }
+    return matches * pattern->points;
 }
 
-// Create a height-3 pattern (exactly 3 pieces high)
-ScoringPattern CreateHeight3Pattern(CoralColor color, int points) {
-    ScoringPattern pattern = {0};
-    pattern.type = PATTERN_HEIGHT_3;
-    pattern.width = 1;
-    pattern.height = 1;
-    pattern.pointValue = points;
-    
-    pattern.cells[0][0].color = color;
-    pattern.cells[0][0].exactHeight = 3;
-    
-    return pattern;
+int ScoreCard(const Player* player, CardId id)
+{
+    TRACE_BEGIN("ScoreCard");
+    BoardMasks m;
+    BoardMasksBuild(player, &m);
+    int points = ScoreCompiled(&m, &CARD_PATTERNS[CardKind(id)]);
+    TRACE_END("ScoreCard");
+    return points;
 }
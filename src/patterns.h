@@ -3,18 +3,59 @@
 
 #include "constants.h"
 
-// Pattern matching functions
-int ScorePattern(const Player* player, const ScoringPattern* pattern);
-bool MatchesPatternAt(const Player* player, const ScoringPattern* pattern, int startRow, int startCol);
-ScoringPattern CreateSimplePattern(PatternType type, CoralColor color, int points);
-ScoringPattern CreateHeightPattern(PatternType type, CoralColor color, int height, int points);
-
-// Predefined pattern creators for common card types
-ScoringPattern CreateLine2Pattern(CoralColor color, int points);
-ScoringPattern CreateLine3Pattern(CoralColor color, int points);
-ScoringPattern CreateSquare2x2Pattern(CoralColor color, int points);
-ScoringPattern CreateLShapePattern(CoralColor color, int points);
-ScoringPattern CreateHeight2Pattern(CoralColor color, int points);
-ScoringPattern CreateHeight3Pattern(CoralColor color, int points);
+// Compiled scoring patterns. tools/reefcards precomputes, for every
+// translation of a card's pattern that fits the board, a 16-bit mask of the
+// cells each requirement group covers (bit r * BOARD_SIZE + c is cell r, c).
+// Scoring then only ANDs those masks against bitboards of the player's
+// board; the ScoringPattern in Card is kept for drawing.
+
+enum {
+    PATTERN_MAX_GROUPS     = 4,
+    PATTERN_MAX_PLACEMENTS = BOARD_SIZE * BOARD_SIZE
+};
+
+// What a covered cell must hold
+typedef struct {
+    uint8_t color;        // top piece; CORAL_NONE = any color
+    uint8_t minHeight;    // 0 = no minimum
+    uint8_t exactHeight;  // 0 = any height
+} PatternRequirement;
+
+typedef struct {
+    uint16_t cells;                       // whole footprint, for the no-overlap rule
+    uint16_t groups[PATTERN_MAX_GROUPS];  // cells under each requirement
+} PatternPlacement;
+
+typedef struct {
+    uint8_t groupCount;
+    uint8_t placementCount;
+    uint16_t points;
+    PatternRequirement groups[PATTERN_MAX_GROUPS];
+    PatternPlacement placements[PATTERN_MAX_PLACEMENTS];  // row-major, the order matches are claimed in
+} CompiledPattern;
+
+// Bitboards of one player's board that every requirement is answered from
+typedef struct {
+    uint16_t top[5];                        // by CoralColor of the top piece; [CORAL_NONE] = occupied
+    uint16_t height[MAX_STACK_HEIGHT + 1];  // exactly h pieces
+} BoardMasks;
+
+void BoardMasksBuild(const Player* player, BoardMasks* m);
+
+// Points for every non-overlapping match, claimed in row-major order
+int ScoreCompiled(const BoardMasks* m, const CompiledPattern* pattern);
+
+// ScoreCompiled in steps, for callers that rescore after small changes:
+// the cells meeting each requirement group, whether one stack meets a
+// requirement (to patch a single cell), which of the candidate placements
+// (bit i = placements[i]) those cells fit, overlaps and all, and the points
+// a set of fitting placements claims
+void PatternRequirements(const BoardMasks* m, const CompiledPattern* pattern, uint16_t ok[PATTERN_MAX_GROUPS]);
+bool PatternRequirementMet(const PatternRequirement* req, CoralColor top, int height);
+uint16_t PatternMatches(const CompiledPattern* pattern, const uint16_t ok[PATTERN_MAX_GROUPS], uint16_t candidates);
+int PatternClaim(const CompiledPattern* pattern, uint16_t matches);
+
+// Score a catalog card's pattern on the player's board
+int ScoreCard(const Player* player, CardId id);
 
 #endif
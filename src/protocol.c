@@ -0,0 +1,142 @@
+#include "protocol.h"
+#include <string.h>
+
+void ProtoWriterInit(ProtoWriter* w, uint8_t* buf, int cap)
+{
+    w->buf = buf;
+    w->len = 0;
+    w->cap = cap;
+    w->frameStart = 0;
+    w->overflow = false;
+}
+
+static uint8_t* Reserve(ProtoWriter* w, int n)
+{
+    if (w->overflow || w->len + n > w->cap) {
+        w->overflow = true;
+        return NULL;
+    }
+    uint8_t* p = w->buf + w->len;
+    w->len += n;
+    return p;
+}
+
+void ProtoBeginFrame(ProtoWriter* w, uint8_t type)
+{
+    w->frameStart = w->len;
+    Reserve(w, PROTO_HEADER_SIZE);
+    ProtoPutU8(w, type);
+}
+
+bool ProtoEndFrame(ProtoWriter* w)
+{
+    int body = w->len - w->frameStart - PROTO_HEADER_SIZE;
+    if (w->overflow || body > PROTO_MAX_BODY) {
+        w->len = w->frameStart;
+        w->overflow = false;
+        return false;
+    }
+    w->buf[w->frameStart]     = (uint8_t)(body & 0xFF);
+    w->buf[w->frameStart + 1] = (uint8_t)(body >> 8);
+    return true;
+}
+
+void ProtoPutU8(ProtoWriter* w, uint8_t v)
+{
+    uint8_t* p = Reserve(w, 1);
+    if (p) p[0] = v;
+}
+
+void ProtoPutU32(ProtoWriter* w, uint32_t v)
+{
+    uint8_t* p = Reserve(w, 4);
+    if (!p) return;
+    for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+void ProtoPutU64(ProtoWriter* w, uint64_t v)
+{
+    uint8_t* p = Reserve(w, 8);
+    if (!p) return;
+    for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+void ProtoPutBytes(ProtoWriter* w, const void* data, int n)
+{
+    uint8_t* p = Reserve(w, n);
+    if (p) memcpy(p, data, (size_t)n);
+}
+
+void ProtoPutAction(ProtoWriter* w, Action a)
+{
+    uint8_t* p = Reserve(w, 4);
+    if (!p) return;
+    p[0] = a.type;
+    p[1] = a.index;
+    p[2] = a.row;
+    p[3] = a.col;
+}
+
+void ProtoReaderInit(ProtoReader* r, const uint8_t* body, int len)
+{
+    r->p = body;
+    r->left = len;
+    r->error = false;
+}
+
+const uint8_t* ProtoGetBytes(ProtoReader* r, int n)
+{
+    if (r->error || r->left < n) {
+        r->error = true;
+        return NULL;
+    }
+    const uint8_t* p = r->p;
+    r->p += n;
+    r->left -= n;
+    return p;
+}
+
+uint8_t ProtoGetU8(ProtoReader* r)
+{
+    const uint8_t* p = ProtoGetBytes(r, 1);
+    return p ? p[0] : 0;
+}
+
+uint32_t ProtoGetU32(ProtoReader* r)
+{
+    const uint8_t* p = ProtoGetBytes(r, 4);
+    if (!p) return 0;
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+uint64_t ProtoGetU64(ProtoReader* r)
+{
+    const uint8_t* p = ProtoGetBytes(r, 8);
+    if (!p) return 0;
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+Action ProtoGetAction(ProtoReader* r)
+{
+    Action a = { ACTION_NONE, 0, 0, 0 };
+    const uint8_t* p = ProtoGetBytes(r, 4);
+    if (p) {
+        a.type = p[0];
+        a.index = p[1];
+        a.row = p[2];
+        a.col = p[3];
+    }
+    return a;
+}
+
+int ProtoFrameLength(const uint8_t* buf, int len)
+{
+    if (len < PROTO_HEADER_SIZE) return 0;
+    int body = buf[0] | (buf[1] << 8);
+    if (body < 1 || body > PROTO_MAX_BODY) return -1;
+    return len >= PROTO_HEADER_SIZE + body ? PROTO_HEADER_SIZE + body : 0;
+}
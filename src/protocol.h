@@ -0,0 +1,112 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "rules.h"
+
+// reefd wire protocol. Every message is a frame:
+//
+//   u16 bodyLength | u8 type | payload
+//
+// with all integers little-endian. Payloads by type:
+//
+//   client -> server
+//     MSG_CREATE     u64 seed (0 = server picks), u8 seat, u8 players
+//     MSG_JOIN       u32 matchId, u8 seat
+//     MSG_ACTION     u32 seq, u8 type, u8 index, u8 row, u8 col
+//     MSG_STATE_REQ  (empty)
+//     MSG_LEAVE      (empty)
+//     MSG_SUBSCRIBE  u32 matchId, u32 knownVersion (PROTO_VERSION_NONE if none)
+//     MSG_ACK        u32 version
+//
+//   server -> client
+//     MSG_JOINED     u32 matchId, u8 seat, u64 seed, u8 players
+//     MSG_RESULT     u32 seq, u8 ok, u32 version
+//     MSG_EVENT      u32 version, u8 seat, u8 type, u8 index, u8 row, u8 col
+//     MSG_STATE      u32 version, GameState (raw, same build only)
+//     MSG_ERROR      u8 code
+//     MSG_DELTA      delta or keyframe (see delta.h)
+//
+// A seat of PROTO_SEAT_ANY takes the first free seat; PROTO_SEAT_ALL takes
+// every seat at once (hotseat play and bot drivers).
+//
+// Spectators SUBSCRIBE instead of joining and receive one DELTA per version:
+// deltas from knownVersion if the server still has them, otherwise a
+// keyframe first. They ACK the versions they have applied; the server stops
+// streaming to a spectator that falls too far behind and resumes once it
+// catches up. LEAVE also ends a subscription.
+
+enum {
+    PROTO_HEADER_SIZE = 2,
+    PROTO_MAX_BODY    = 1024,
+
+    PROTO_SEAT_ANY = 0xFE,
+    PROTO_SEAT_ALL = 0xFF
+};
+
+#define PROTO_VERSION_NONE UINT32_MAX
+
+typedef enum {
+    MSG_CREATE    = 0x01,
+    MSG_JOIN      = 0x02,
+    MSG_ACTION    = 0x03,
+    MSG_STATE_REQ = 0x04,
+    MSG_LEAVE     = 0x05,
+    MSG_SUBSCRIBE = 0x06,
+    MSG_ACK       = 0x07,
+
+    MSG_JOINED    = 0x81,
+    MSG_RESULT    = 0x82,
+    MSG_EVENT     = 0x83,
+    MSG_STATE     = 0x84,
+    MSG_ERROR     = 0x85,
+    MSG_DELTA     = 0x86
+} MessageType;
+
+typedef enum {
+    PROTO_ERR_MALFORMED = 1,
+    PROTO_ERR_NO_MATCH,
+    PROTO_ERR_SEAT_TAKEN,
+    PROTO_ERR_NOT_SEATED,
+    PROTO_ERR_ALREADY_SEATED,
+    PROTO_ERR_FULL
+} ProtoError;
+
+// Append-only frame builder over a caller-provided buffer
+typedef struct {
+    uint8_t* buf;
+    int len;
+    int cap;
+    int frameStart;
+    bool overflow;
+} ProtoWriter;
+
+void ProtoWriterInit(ProtoWriter* w, uint8_t* buf, int cap);
+void ProtoBeginFrame(ProtoWriter* w, uint8_t type);
+bool ProtoEndFrame(ProtoWriter* w);   // false if the frame did not fit
+void ProtoPutU8(ProtoWriter* w, uint8_t v);
+void ProtoPutU32(ProtoWriter* w, uint32_t v);
+void ProtoPutU64(ProtoWriter* w, uint64_t v);
+void ProtoPutBytes(ProtoWriter* w, const void* data, int n);
+void ProtoPutAction(ProtoWriter* w, Action a);
+
+// Bounds-checked reader over one frame body (type byte already consumed)
+typedef struct {
+    const uint8_t* p;
+    int left;
+    bool error;
+} ProtoReader;
+
+void     ProtoReaderInit(ProtoReader* r, const uint8_t* body, int len);
+uint8_t  ProtoGetU8(ProtoReader* r);
+uint32_t ProtoGetU32(ProtoReader* r);
+uint64_t ProtoGetU64(ProtoReader* r);
+Action   ProtoGetAction(ProtoReader* r);
+const uint8_t* ProtoGetBytes(ProtoReader* r, int n);
+
+// Length of the first complete frame in buf (header included), 0 if more
+// bytes are needed, -1 if the stream is corrupt
+int ProtoFrameLength(const uint8_t* buf, int len);
+
+#endif
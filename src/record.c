@@ -0,0 +1,157 @@
+#include "record.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void RecordInit(Record* r, uint64_t seed, int players)
+{
+    memset(r, 0, sizeof(*r));
+    r->seed = seed;
+    r->players = players;
+}
+
+void RecordFree(Record* r)
+{
+    free(r->moves);
+    r->moves = NULL;
+    r->count = r->cap = 0;
+}
+
+bool RecordAdd(Record* r, Action a)
+{
+    if (r->count == r->cap) {
+        int cap = r->cap ? r->cap * 2 : 256;
+        Action* grown = realloc(r->moves, sizeof(Action) * (size_t)cap);
+        if (grown == NULL) return false;
+        r->moves = grown;
+        r->cap = cap;
+    }
+    r->moves[r->count++] = a;
+    return true;
+}
+
+// A move is at most "p44" and a separator
+int RecordTextSize(int count)
+{
+    return RECORD_MAX_SIZE + 4 * count + 1;
+}
+
+int RecordFormat(const Record* r, char* buf, int cap)
+{
+    if (cap < RecordTextSize(r->count)) return 0;
+    int len = snprintf(buf, (size_t)cap, "seed %" PRIu64 " players %d moves", r->seed, r->players);
+    for (int i = 0; i < r->count; ++i) {
+        buf[len++] = i % RECORD_MOVES_PER_LINE == 0 ? '\n' : ' ';
+        char move[8];
+        RulesFormatAction(r->moves[i], move, sizeof(move));
+        len += snprintf(buf + len, (size_t)(cap - len), "%s", move);
+    }
+    buf[len++] = '\n';
+    buf[len] = '\0';
+    return len;
+}
+
+bool RecordWrite(const Record* r, const char* path)
+{
+    int cap = RecordTextSize(r->count);
+    char* text = malloc((size_t)cap);
+    if (text == NULL) return false;
+    int len = RecordFormat(r, text, cap);
+
+    char tmpPath[512];
+    bool ok = snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) < (int)sizeof(tmpPath);
+    FILE* f = ok ? fopen(tmpPath, "w") : NULL;
+    ok = f != NULL && fwrite(text, 1, (size_t)len, f) == (size_t)len;
+    if (f != NULL) ok = fclose(f) == 0 && ok;
+    free(text);
+    if (!ok || rename(tmpPath, path) != 0) {
+        if (f != NULL) remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+static char* ReadAll(const char* path)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    size_t len = 0, cap = 4096;
+    char* text = malloc(cap);
+    while (text != NULL) {
+        len += fread(text + len, 1, cap - len - 1, f);
+        if (len < cap - 1) break;
+        char* grown = realloc(text, cap * 2);
+        if (grown == NULL) free(text);
+        text = grown;
+        cap *= 2;
+    }
+    bool failed = ferror(f);
+    fclose(f);
+    if (text == NULL || failed) {
+        free(text);
+        return NULL;
+    }
+    text[len] = '\0';
+    return text;
+}
+
+static char* NextToken(char** cursor)
+{
+    char* p = *cursor;
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    if (*p == '\0') {
+        *cursor = p;
+        return NULL;
+    }
+    char* start = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    if (*p != '\0') *p++ = '\0';
+    *cursor = p;
+    return start;
+}
+
+static const char* Parse(char* text, Record* r)
+{
+    char* cursor = text;
+    char* tok = NextToken(&cursor);
+    if (tok != NULL && strcmp(tok, "position") == 0) tok = NextToken(&cursor);
+    if (tok == NULL || strcmp(tok, "seed") != 0) return "no seed";
+    char* seed = NextToken(&cursor);
+    if (seed == NULL) return "no seed";
+    r->seed = strtoull(seed, NULL, 10);
+    tok = NextToken(&cursor);
+    if (tok != NULL && strcmp(tok, "players") == 0) {
+        char* count = NextToken(&cursor);
+        r->players = count != NULL ? atoi(count) : 0;
+        if (r->players < PLAYERS_MIN || r->players > PLAYERS_MAX) return "bad player count";
+        tok = NextToken(&cursor);
+    }
+    if (tok != NULL && strcmp(tok, "moves") != 0) return "expected moves";
+
+    while ((tok = NextToken(&cursor)) != NULL) {
+        Action a;
+        if (!RulesParseAction(tok, &a)) return "not a move";
+        if (!RecordAdd(r, a)) return "out of memory";
+    }
+    return NULL;
+}
+
+const char* RecordRead(const char* path, Record* r)
+{
+    RecordInit(r, 0, PLAYERS_MIN);
+    char* text = ReadAll(path);
+    if (text == NULL) return "cannot read it";
+    const char* problem = Parse(text, r);
+    free(text);
+    if (problem != NULL) RecordFree(r);
+    return problem;
+}
+
+int RecordPlay(const Record* r, GameState* g)
+{
+    RulesNewGame(g, r->players, r->seed);
+    int applied = 0;
+    while (applied < r->count && RulesApply(g, r->moves[applied])) applied++;
+    return applied;
+}
@@ -0,0 +1,52 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "rules.h"
+
+// Game records: a game as its deal and the actions played from it, in the
+// engine's position text (engine.h),
+//
+//   seed S players N moves A...
+//
+// over any number of lines, actions as RulesFormatAction writes them. The
+// client keeps one for the game in progress (RECORD_FILE), reefd and
+// reeftourney write one per finished game with --record, and the replay
+// viewer (replay.h) plays them back.
+
+enum {
+    RECORD_MOVES_PER_LINE = 16,
+    RECORD_MAX_SIZE       = 64   // bytes of text besides the moves
+};
+
+typedef struct {
+    uint64_t seed;
+    int players;
+    Action* moves;
+    int count, cap;
+} Record;
+
+void RecordInit(Record* r, uint64_t seed, int players);
+void RecordFree(Record* r);
+
+// False, leaving r as it was, if out of memory
+bool RecordAdd(Record* r, Action a);
+
+// Upper bound on RecordFormat's text for count moves, terminator included
+int RecordTextSize(int count);
+
+// Text of r into buf, NUL-terminated; its length, or 0 if cap is too small
+int RecordFormat(const Record* r, char* buf, int cap);
+
+// Crash-safe like SnapshotSave: written to a temporary file next to path,
+// then renamed over it
+bool RecordWrite(const Record* r, const char* path);
+
+// Read path into r (initialized here); NULL, or what is wrong with it.
+// Moves are parsed, not played: see RecordPlay.
+const char* RecordRead(const char* path, Record* r);
+
+// The deal of r and its first moves up to the first illegal one; the
+// number of moves applied
+int RecordPlay(const Record* r, GameState* g);
+
+#endif
@@ -0,0 +1,165 @@
+#include "replay.h"
+#include "game.h"
+#include "history.h"
+#include "pacing.h"
+#include "record.h"
+#include "rules.h"
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static struct {
+    History history;
+    GameState shown;
+    int step;
+    int steps;
+    int* turnOf;       // per step: the turn it is in, from 1
+    int* turnStep;     // per turn: its first step
+    int turns;
+    bool dragging;
+    bool playing;
+    double due;        // GetTime() of the next step while playing
+    const char* name;
+} gReplay;
+
+// Play the record out into the history; NULL, or the problem
+static const char* Play(const Record* record)
+{
+    GameState g;
+    RulesNewGame(&g, record->players, record->seed);
+    if (!HistoryInit(&gReplay.history, &g)) return "out of memory";
+    for (int i = 0; i < record->count; ++i) {
+        if (!RulesApply(&g, record->moves[i])) {
+            char move[8];
+            RulesFormatAction(record->moves[i], move, sizeof(move));
+            fprintf(stderr, "reef: replay stops before move %d, %s: illegal\n", i + 1, move);
+            break;
+        }
+        if (!HistoryRecord(&gReplay.history, &g)) return "out of memory";
+    }
+    return NULL;
+}
+
+// Turns by who is to move: a turn starts where the player changes
+static bool IndexTurns(void)
+{
+    int steps = gReplay.history.count;
+    gReplay.turnOf = malloc(sizeof(int) * (size_t)steps);
+    gReplay.turnStep = malloc(sizeof(int) * (size_t)(steps + 1));
+    if (gReplay.turnOf == NULL || gReplay.turnStep == NULL) return false;
+
+    GameState g;
+    int player = -1;
+    gReplay.turns = 0;
+    for (int s = 0; s < steps; ++s) {
+        HistoryJump(&gReplay.history, s, &g);
+        if (g.currentPlayer != player) {
+            player = g.currentPlayer;
+            gReplay.turnStep[++gReplay.turns] = s;
+        }
+        gReplay.turnOf[s] = gReplay.turns;
+    }
+    return true;
+}
+
+bool ReplayLoad(const char* path)
+{
+    memset(&gReplay, 0, sizeof(gReplay));
+    Record record;
+    const char* problem = RecordRead(path, &record);
+    if (problem == NULL) {
+        problem = Play(&record);
+        RecordFree(&record);
+    }
+    if (problem == NULL && !IndexTurns()) problem = "out of memory";
+    if (problem != NULL) {
+        fprintf(stderr, "reef: %s is not a game record: %s\n", path, problem);
+        ReplayUnload();
+        return false;
+    }
+
+    const char* slash = strrchr(path, '/');
+    gReplay.name = slash != NULL ? slash + 1 : path;
+    gReplay.steps = gReplay.history.count;
+    HistoryJump(&gReplay.history, 0, &gReplay.shown);
+    return true;
+}
+
+void ReplayUnload(void)
+{
+    HistoryFree(&gReplay.history);
+    free(gReplay.turnOf);
+    free(gReplay.turnStep);
+    memset(&gReplay, 0, sizeof(gReplay));
+}
+
+static int StepAt(float x)
+{
+    float t = (x - REPLAY_BAR_X) / (float)REPLAY_BAR_W;
+    int step = (int)(t * (float)(gReplay.steps - 1) + 0.5f);
+    return step < 0 ? 0 : step >= gReplay.steps ? gReplay.steps - 1 : step;
+}
+
+void ReplayUpdate(void)
+{
+    int target = gReplay.step;
+    int turn = gReplay.turnOf[gReplay.step];
+    double now = GetTime();
+
+    // Drag anywhere on the bar, or a little above and below it
+    Vector2 mouse = GetMousePosition();
+    Rectangle bar = { REPLAY_BAR_X - 8, REPLAY_BAR_Y - 8, REPLAY_BAR_W + 16, REPLAY_BAR_H + 16 };
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(mouse, bar)) gReplay.dragging = true;
+    if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) gReplay.dragging = false;
+
+    // Play [Space], an action back and forward [Z, Y], a whole turn [Left,
+    // Right], the ends [Home, End]
+    if (IsKeyPressed(KEY_SPACE)) {
+        gReplay.playing = !gReplay.playing;
+        if (gReplay.playing && target == gReplay.steps - 1) target = 0;
+        gReplay.due = now + REPLAY_STEP_MS / 1000.0;
+    }
+    if (gReplay.dragging) {
+        target = StepAt(mouse.x);
+        gReplay.playing = false;
+    } else if (IsKeyPressed(KEY_Z)) {
+        target--;
+    } else if (IsKeyPressed(KEY_Y)) {
+        target++;
+    } else if (IsKeyPressed(KEY_LEFT)) {
+        // The start of this turn, or of the one before if already there
+        target = gReplay.turnStep[turn] < target || turn == 1 ? gReplay.turnStep[turn] : gReplay.turnStep[turn - 1];
+    } else if (IsKeyPressed(KEY_RIGHT)) {
+        target = turn < gReplay.turns ? gReplay.turnStep[turn + 1] : gReplay.steps - 1;
+    } else if (IsKeyPressed(KEY_HOME)) {
+        target = 0;
+    } else if (IsKeyPressed(KEY_END)) {
+        target = gReplay.steps - 1;
+    } else if (gReplay.playing && now >= gReplay.due) {
+        target++;
+        gReplay.due = now + REPLAY_STEP_MS / 1000.0;
+    }
+
+    if (target < 0) target = 0;
+    if (target >= gReplay.steps) {
+        target = gReplay.steps - 1;
+        gReplay.playing = false;
+    }
+    if (target != gReplay.step) {
+        HistoryJump(&gReplay.history, target, &gReplay.shown);
+        gReplay.step = target;
+        PacingRequest(PACE_ACTIVE);
+    }
+    if (gReplay.dragging) PacingRequest(PACE_ACTIVE);
+    else if (gReplay.playing) PacingRequest(PACE_TICK);
+}
+
+void ReplayDraw(void)
+{
+    GameDrawPosition(&gReplay.shown, TextFormat("Replay of %s: [Space] play, [Z/Y] action, [Left/Right] turn, or drag",
+                                                gReplay.name));
+    UI_DrawTimeline(REPLAY_BAR_X, REPLAY_BAR_Y, REPLAY_BAR_W, REPLAY_BAR_H, gReplay.step, gReplay.steps,
+                    TextFormat("Turn %d of %d, step %d of %d%s", gReplay.turnOf[gReplay.step], gReplay.turns,
+                               gReplay.step, gReplay.steps - 1, gReplay.shown.gameEnded ? ", game over" : ""));
+}
@@ -0,0 +1,40 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "constants.h"
+
+// Replay viewer (`reef --replay FILE`): a recorded game, drawn like a live
+// one (GameDrawPosition), with a timeline to drag through it.
+//
+// A record is the engine's position text (engine.h), so any driver's game
+// log is one:
+//
+//   [position] seed S [players N] [moves A...]
+//
+// over any number of lines (record.h). The client writes one for the game
+// in progress, and reefd and reeftourney one per game with --record.
+//
+// The whole game is played once on load, each action a step of a History
+// (history.h), which keeps every position with the regions unchanged since
+// the step before shared. Seeking to any step
+// is then a copy of that step's chunks: the same cost at step 5 or 1500,
+// and nothing replayed however far or often the timeline is dragged.
+
+enum {
+    REPLAY_STEP_MS = 400,   // between actions while playing
+    REPLAY_BAR_X   = 420,   // timeline, right of the deck
+    REPLAY_BAR_Y   = 690,
+    REPLAY_BAR_W   = 840,
+    REPLAY_BAR_H   = 12
+};
+
+// Read and play out path; false, with the reason on stderr, if it is not a
+// record. A record that turns illegal is kept up to the bad move.
+bool ReplayLoad(const char* path);
+void ReplayUnload(void);
+
+// Main thread, once per frame, in a window
+void ReplayUpdate(void);
+void ReplayDraw(void);
+
+#endif
@@ -0,0 +1,25 @@
+#define _DEFAULT_SOURCE
+#include "rng.h"
+#include <time.h>
+
+uint64_t RngNext(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+int RngRange(uint64_t* state, int n)
+{
+    // Multiply-shift keeps the bias negligible for the small n used here
+    return (int)(((RngNext(state) >> 32) * (uint64_t)n) >> 32);
+}
+
+uint64_t RngSeedFromTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t seed = (uint64_t)ts.tv_sec * 1000000007ull ^ (uint64_t)ts.tv_nsec;
+    return RngNext(&seed);
+}
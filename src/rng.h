@@ -0,0 +1,13 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// Small deterministic RNG (splitmix64). State lives with its owner
+// (GameState::rng, per-thread simulations), so games reproduce from a seed
+// and many games can run concurrently without sharing rand()'s global state.
+uint64_t RngNext(uint64_t* state);
+int      RngRange(uint64_t* state, int n);   // uniform in [0, n)
+uint64_t RngSeedFromTime(void);
+
+#endif
@@ -0,0 +1,307 @@
+#include "rules.h"
+#include "cards.h"
+#include "patterns.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+
+static void InitPlayers(GameState* g, int players)
+{
+    g->playersCount = players;
+    memset(&g->players[players], 0, sizeof(Player) * (size_t)(PLAYERS_MAX - players));  // never read
+
+    for (int p = 0; p < g->playersCount; ++p) {
+        Player* pl = &g->players[p];
+        pl->id = p;
+        pl->points = INITIAL_POINTS;
+        pl->handSize = 0;
+
+        for (int r = 0; r < BOARD_SIZE; ++r) {
+            for (int c = 0; c < BOARD_SIZE; ++c) {
+                pl->board[r][c].height = 0;
+                for (int h = 0; h < MAX_STACK_HEIGHT; ++h) {
+                    pl->board[r][c].pieces[h] = CORAL_NONE;
+                }
+            }
+        }
+
+        // Initial center four pieces (one of each color)
+        pl->board[1][1].pieces[0] = CORAL_YELLOW; pl->board[1][1].height = 1;
+        pl->board[1][2].pieces[0] = CORAL_ORANGE; pl->board[1][2].height = 1;
+        pl->board[2][1].pieces[0] = CORAL_PURPLE; pl->board[2][1].height = 1;
+        pl->board[2][2].pieces[0] = CORAL_GREEN;  pl->board[2][2].height = 1;
+    }
+}
+
+static void InitSupplies(GameState* g, int players)
+{
+    g->supplies[CORAL_NONE]   = 0;
+    g->supplies[CORAL_YELLOW] = SUPPLY_PER_COLOR[players];
+    g->supplies[CORAL_ORANGE] = SUPPLY_PER_COLOR[players];
+    g->supplies[CORAL_PURPLE] = SUPPLY_PER_COLOR[players];
+    g->supplies[CORAL_GREEN]  = SUPPLY_PER_COLOR[players];
+}
+
+static void NextPlayer(GameState* g)
+{
+    g->currentPlayer = (g->currentPlayer + 1) % g->playersCount;
+}
+
+// An empty deck ends the game at once. An empty supply starts the final
+// round instead, which ends once every seat has had as many turns: when
+// the last seat's turn is over.
+static void CheckEnd(GameState* g)
+{
+    if (g->deckSize <= 0) { g->gameEnded = true; return; }
+    for (int i = 1; i <= 4; ++i) {
+        if (g->supplies[i] <= 0) g->finalRound = true;
+    }
+    if (g->finalRound && g->currentPlayer == g->playersCount - 1) g->gameEnded = true;
+}
+
+static void EndTurn(GameState* g)
+{
+    CheckEnd(g);
+    if (!g->gameEnded) {
+        NextPlayer(g);
+    }
+}
+
+static bool PlaceCoralAt(GameState* g, Player* p, CoralColor color, int row, int col)
+{
+    if (color == CORAL_NONE) return false;
+    if (g->supplies[color] <= 0) return false;
+    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) return false;
+
+    CoralStack* s = &p->board[row][col];
+    if (s->height >= MAX_STACK_HEIGHT) return false;
+
+    s->pieces[s->height] = color;
+    s->height++;
+    g->supplies[color]--;
+    return true;
+}
+
+static bool HasFreeCell(const Player* p)
+{
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) {
+            if (p->board[r][c].height < MAX_STACK_HEIGHT) return true;
+        }
+    }
+    return false;
+}
+
+static void FinishPlacement(GameState* g)
+{
+    // Score the pattern on the current player's board
+    Player* currentPlayer = &g->players[g->currentPlayer];
+    int earnedPoints = ScoreCard(currentPlayer, g->placement.card);
+    currentPlayer->points += earnedPoints;
+
+    g->placement.active = false;
+    EndTurn(g);
+}
+
+// A piece whose color has run out (or with no room left on the board) is
+// forfeited rather than leaving the turn stuck waiting for a legal click
+static void AdvancePlacement(GameState* g)
+{
+    const Player* p = &g->players[g->currentPlayer];
+    while (g->placement.piecesPlaced < 2) {
+        CoralColor next = g->placement.piecesToPlace[g->placement.piecesPlaced];
+        if (next != CORAL_NONE && g->supplies[next] > 0 && HasFreeCell(p)) return;
+        g->placement.piecesPlaced++;
+    }
+    FinishPlacement(g);
+}
+
+static void StartPlacement(GameState* g, CardId id)
+{
+    const Card* card = CardGet(id);
+    g->placement.active = true;
+    g->placement.piecesToPlace[0] = card->piece1;
+    g->placement.piecesToPlace[1] = card->piece2;
+    g->placement.piecesPlaced = 0;
+    g->placement.cardPoints = card->pattern.pointValue;
+    g->placement.card = id;
+    AdvancePlacement(g);
+}
+
+void RulesNewGame(GameState* g, int players, uint64_t seed)
+{
+    if (players < PLAYERS_MIN) players = PLAYERS_MIN;
+    if (players > PLAYERS_MAX) players = PLAYERS_MAX;
+
+    g->rng = seed;
+    g->gameEnded = false;
+    g->finalRound = false;
+    g->currentPlayer = 0;
+
+    // Initialize placement state; the played card and its pieces go out in
+    // deltas and snapshots even when no placement is active
+    memset(&g->placement, 0, sizeof(g->placement));
+
+    InitSupplies(g, players);
+    InitPlayers(g, players);
+
+    TRACE_BEGIN("Deal");
+    CardsInitAndShuffle(g);
+    DisplayInit(g);
+    DealInitialHands(g);
+    TRACE_END("Deal");
+}
+
+bool RulesApply(GameState* g, Action a)
+{
+    if (g->gameEnded) return false;
+
+    Player* pl = &g->players[g->currentPlayer];
+
+    // Only placement clicks are accepted while a played card is resolving
+    if (g->placement.active) {
+        if (a.type != ACTION_PLACE_CORAL) return false;
+
+        CoralColor colorToPlace = g->placement.piecesToPlace[g->placement.piecesPlaced];
+        if (!PlaceCoralAt(g, pl, colorToPlace, a.row, a.col)) return false;
+
+        g->placement.piecesPlaced++;
+        AdvancePlacement(g);
+        return true;
+    }
+
+    switch (a.type) {
+        case ACTION_TAKE_MARKET: {
+            int idx = a.index;
+            if (idx >= CARD_DISPLAY_SIZE || pl->handSize >= MAX_HAND_SIZE) return false;
+
+            pl->points += g->displayTokens[idx];
+            g->displayTokens[idx] = 0;
+            pl->hand[pl->handSize++] = g->display[idx];
+            DisplayRefillSlot(g, idx);
+            EndTurn(g);
+            return true;
+        }
+
+        // Pay 1 point -> token goes on the lowest display card
+        case ACTION_DRAW_DECK: {
+            if (pl->handSize >= MAX_HAND_SIZE || g->deckSize <= 0 || pl->points < 1) return false;
+
+            pl->points -= 1;
+            int idx = FindDisplayLowestPointsIndex(g);
+            g->displayTokens[idx] += 1;
+
+            pl->hand[pl->handSize++] = DeckTakeTop(g);
+            EndTurn(g);
+            return true;
+        }
+
+        case ACTION_PLAY_CARD: {
+            int playIndex = a.index;
+            if (playIndex >= pl->handSize) return false;
+
+            CardId card = HandRemove(g, g->currentPlayer, playIndex);
+
+            // Turn ends once both pieces are placed
+            StartPlacement(g, card);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+int RulesListActions(const GameState* g, Action* out)
+{
+    if (g->gameEnded) return 0;
+
+    const Player* pl = &g->players[g->currentPlayer];
+    int n = 0;
+
+    if (g->placement.active) {
+        for (int r = 0; r < BOARD_SIZE; ++r) {
+            for (int c = 0; c < BOARD_SIZE; ++c) {
+                if (pl->board[r][c].height < MAX_STACK_HEIGHT) {
+                    out[n++] = (Action){ ACTION_PLACE_CORAL, 0, (uint8_t)r, (uint8_t)c };
+                }
+            }
+        }
+        return n;
+    }
+
+    if (pl->handSize < MAX_HAND_SIZE) {
+        for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+            out[n++] = (Action){ ACTION_TAKE_MARKET, (uint8_t)i, 0, 0 };
+        }
+        if (g->deckSize > 0 && pl->points >= 1) {
+            out[n++] = (Action){ ACTION_DRAW_DECK, 0, 0, 0 };
+        }
+    }
+    for (int i = 0; i < pl->handSize; ++i) {
+        out[n++] = (Action){ ACTION_PLAY_CARD, (uint8_t)i, 0, 0 };
+    }
+    return n;
+}
+
+uint8_t RulesActionId(Action a)
+{
+    switch (a.type) {
+        case ACTION_TAKE_MARKET: return a.index;
+        case ACTION_DRAW_DECK:   return CARD_DISPLAY_SIZE;
+        case ACTION_PLAY_CARD:   return (uint8_t)(CARD_DISPLAY_SIZE + 1 + a.index);
+        case ACTION_PLACE_CORAL: return (uint8_t)(CARD_DISPLAY_SIZE + 1 + MAX_HAND_SIZE + a.row * BOARD_SIZE + a.col);
+        default:                 return RULES_ACTION_IDS;
+    }
+}
+
+Action RulesActionFromId(uint8_t id)
+{
+    if (id < CARD_DISPLAY_SIZE) return (Action){ ACTION_TAKE_MARKET, id, 0, 0 };
+    if (id == CARD_DISPLAY_SIZE) return (Action){ ACTION_DRAW_DECK, 0, 0, 0 };
+    id -= CARD_DISPLAY_SIZE + 1;
+    if (id < MAX_HAND_SIZE) return (Action){ ACTION_PLAY_CARD, id, 0, 0 };
+    id -= MAX_HAND_SIZE;
+    if (id < BOARD_SIZE * BOARD_SIZE) return (Action){ ACTION_PLACE_CORAL, 0, (uint8_t)(id / BOARD_SIZE), (uint8_t)(id % BOARD_SIZE) };
+    return (Action){ ACTION_NONE, 0, 0, 0 };
+}
+
+void RulesFormatAction(Action a, char* buf, size_t cap)
+{
+    switch (a.type) {
+        case ACTION_TAKE_MARKET: snprintf(buf, cap, "m%d", a.index); break;
+        case ACTION_DRAW_DECK:   snprintf(buf, cap, "d"); break;
+        case ACTION_PLAY_CARD:   snprintf(buf, cap, "h%d", a.index); break;
+        case ACTION_PLACE_CORAL: snprintf(buf, cap, "p%d%d", a.row, a.col); break;
+        default:                 snprintf(buf, cap, "none"); break;
+    }
+}
+
+bool RulesParseAction(const char* s, Action* a)
+{
+    size_t n = strlen(s);
+    int d1 = n > 1 ? s[1] - '0' : -1;
+    int d2 = n > 2 ? s[2] - '0' : -1;
+    if (n == 1 && s[0] == 'd') {
+        *a = (Action){ ACTION_DRAW_DECK, 0, 0, 0 };
+    } else if (n == 2 && s[0] == 'm' && d1 >= 0 && d1 < CARD_DISPLAY_SIZE) {
+        *a = (Action){ ACTION_TAKE_MARKET, (uint8_t)d1, 0, 0 };
+    } else if (n == 2 && s[0] == 'h' && d1 >= 0 && d1 < MAX_HAND_SIZE) {
+        *a = (Action){ ACTION_PLAY_CARD, (uint8_t)d1, 0, 0 };
+    } else if (n == 3 && s[0] == 'p' && d1 >= 0 && d1 < BOARD_SIZE && d2 >= 0 && d2 < BOARD_SIZE) {
+        *a = (Action){ ACTION_PLACE_CORAL, 0, (uint8_t)d1, (uint8_t)d2 };
+    } else {
+        return false;
+    }
+    return true;
+}
+
+size_t RulesStateSize(const GameState* g)
+{
+    return offsetof(GameState, players) + (size_t)g->playersCount * sizeof(Player);
+}
+
+void RulesCopyState(GameState* dst, const GameState* src)
+{
+    memcpy(dst, src, RulesStateSize(src));
+}
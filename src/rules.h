@@ -0,0 +1,56 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stddef.h>
+#include "constants.h"
+
+// Everything a player can do, as plain data. Keyboard and mouse input is
+// translated into these by the client; the rules never touch raylib input.
+typedef enum {
+    ACTION_NONE = 0,
+    ACTION_TAKE_MARKET,   // index = display slot
+    ACTION_DRAW_DECK,     // pay 1 point, take the top deck card
+    ACTION_PLAY_CARD,     // index = hand slot, starts placement
+    ACTION_PLACE_CORAL    // row/col for the next piece of the played card
+} ActionType;
+
+typedef struct {
+    uint8_t type;   // ActionType
+    uint8_t index;
+    uint8_t row;
+    uint8_t col;
+} Action;
+
+enum {
+    RULES_MAX_ACTIONS = BOARD_SIZE * BOARD_SIZE,  // placement has the widest choice
+    RULES_ACTION_IDS  = CARD_DISPLAY_SIZE + 1 + MAX_HAND_SIZE + BOARD_SIZE * BOARD_SIZE
+};
+
+// Reset g to the opening position for players (PLAYERS_MIN..PLAYERS_MAX,
+// clamped); the deck order follows from seed
+void RulesNewGame(GameState* g, int players, uint64_t seed);
+
+// Validate and apply one action for the current player; false if illegal
+bool RulesApply(GameState* g, Action a);
+
+// Fill out[RULES_MAX_ACTIONS] with every legal action; returns the count
+int RulesListActions(const GameState* g, Action* out);
+
+// Any action as one byte, for compact storage: display slots, the deck,
+// hand slots, then board cells. FromId of an id >= RULES_ACTION_IDS is
+// ACTION_NONE.
+uint8_t RulesActionId(Action a);
+Action  RulesActionFromId(uint8_t id);
+
+// Any action as text, for engine mode and game records: m0-m2 (take a
+// display card), d (draw from the deck), h0-h3 (play a hand card) and pRC
+// (place on row R, column C). Parse is false for anything else.
+void RulesFormatAction(Action a, char* buf, size_t cap);
+bool RulesParseAction(const char* s, Action* a);
+
+// Bytes of g in use: everything up to the last seated player. Searches copy
+// and compare states with these instead of sizeof(GameState).
+size_t RulesStateSize(const GameState* g);
+void RulesCopyState(GameState* dst, const GameState* src);
+
+#endif
@@ -0,0 +1,202 @@
+#define _DEFAULT_SOURCE
+#include "sim.h"
+#include "history.h"
+#include "trace.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+enum {
+    SIM_QUEUE_SIZE = 256,   // power of two
+    SNAPSHOT_FRESH = 4      // flag bit on the shared triple-buffer index
+};
+
+// Queue entry: an action, or a SimHistoryMove when kind is nonzero
+typedef struct {
+    uint8_t kind;
+    Action action;
+} SimCommand;
+
+static struct {
+    // Input queue: main thread produces, simulation thread consumes
+    SimCommand queue[SIM_QUEUE_SIZE];
+    atomic_uint head;       // next slot to read
+    atomic_uint tail;       // next slot to write
+    sem_t available;        // one count per queued action (plus one to wake for stop)
+
+    // Triple buffer: the writer owns `back`, the reader owns `front`, and
+    // `middle` is exchanged atomically together with the FRESH bit
+    GameState slots[3];
+    atomic_uint middle;
+    unsigned back;
+    unsigned front;
+
+    atomic_uint submitted;  // actions pushed
+    atomic_uint processed;  // actions reflected in a published snapshot
+
+    GameState state;        // authoritative, simulation thread only
+    History history;        // simulation thread only
+    Action* line;           // line[i]: the action into history step i + 1
+    int lineCap;
+    Record* record;         // NULL: no record kept
+    atomic_int historyStep;
+    atomic_int historyCount;
+    pthread_t thread;
+    atomic_bool running;
+} gSim;
+
+static void Publish(void)
+{
+    gSim.slots[gSim.back] = gSim.state;
+    unsigned prev = atomic_exchange_explicit(&gSim.middle, gSim.back | SNAPSHOT_FRESH, memory_order_acq_rel);
+    gSim.back = prev & 3u;
+}
+
+static void MoveHistory(SimHistoryMove move)
+{
+    History* h = &gSim.history;
+    int step = -1;
+    switch (move) {
+        case SIM_UNDO:         step = h->current - 1; break;
+        case SIM_REDO:         step = h->current + 1; break;
+        case SIM_TURN_BACK:    step = HistoryPrevTurn(h); break;
+        case SIM_TURN_FORWARD: step = HistoryNextTurn(h); break;
+    }
+    HistoryJump(h, step, &gSim.state);  // out of range leaves everything as is
+}
+
+// After step current was recorded by applying a
+static void RememberAction(Action a)
+{
+    int step = gSim.history.current;
+    if (step > gSim.lineCap) {
+        int cap = gSim.lineCap ? gSim.lineCap * 2 : 256;
+        Action* grown = realloc(gSim.line, sizeof(Action) * (size_t)cap);
+        if (grown == NULL) {
+            gSim.record = NULL;  // rather than a hole: the record ends where this session began
+            return;
+        }
+        gSim.line = grown;
+        gSim.lineCap = cap;
+    }
+    gSim.line[step - 1] = a;
+}
+
+static void* SimThreadMain(void* arg)
+{
+    (void)arg;
+    TraceThreadName("sim");
+    while (true) {
+        sem_wait(&gSim.available);
+        if (!atomic_load_explicit(&gSim.running, memory_order_acquire)) break;
+
+        unsigned head = atomic_load_explicit(&gSim.head, memory_order_relaxed);
+        SimCommand cmd = gSim.queue[head & (SIM_QUEUE_SIZE - 1)];
+        atomic_store_explicit(&gSim.head, head + 1, memory_order_release);
+
+        // Illegal actions still publish so `processed` catches up
+        TRACE_BEGIN("SimApply");
+        if (cmd.kind != 0) MoveHistory((SimHistoryMove)cmd.kind);
+        else if (RulesApply(&gSim.state, cmd.action) && HistoryRecord(&gSim.history, &gSim.state)) {
+            if (gSim.record != NULL) RememberAction(cmd.action);
+        }
+        atomic_store_explicit(&gSim.historyStep, gSim.history.current, memory_order_relaxed);
+        atomic_store_explicit(&gSim.historyCount, gSim.history.count, memory_order_relaxed);
+        Publish();
+        TRACE_END("SimApply");
+        atomic_fetch_add_explicit(&gSim.processed, 1, memory_order_release);
+    }
+    return NULL;
+}
+
+bool SimStart(const GameState* start, Record* record)
+{
+    gSim.state = *start;
+    gSim.record = record;
+    if (!HistoryInit(&gSim.history, &gSim.state)) return false;
+    atomic_store(&gSim.historyStep, 0);
+    atomic_store(&gSim.historyCount, 1);
+    for (int i = 0; i < 3; ++i) gSim.slots[i] = gSim.state;
+    gSim.front = 0;
+    atomic_store(&gSim.middle, 1u);
+    gSim.back = 2;
+
+    atomic_store(&gSim.head, 0u);
+    atomic_store(&gSim.tail, 0u);
+    atomic_store(&gSim.submitted, 0u);
+    atomic_store(&gSim.processed, 0u);
+    if (sem_init(&gSim.available, 0, 0) != 0) {
+        HistoryFree(&gSim.history);
+        return false;
+    }
+
+    atomic_store(&gSim.running, true);
+    if (pthread_create(&gSim.thread, NULL, SimThreadMain, NULL) != 0) {
+        atomic_store(&gSim.running, false);
+        sem_destroy(&gSim.available);
+        HistoryFree(&gSim.history);
+        return false;
+    }
+    return true;
+}
+
+void SimStop(void)
+{
+    if (!atomic_load(&gSim.running)) return;
+    atomic_store_explicit(&gSim.running, false, memory_order_release);
+    sem_post(&gSim.available);
+    pthread_join(gSim.thread, NULL);
+    sem_destroy(&gSim.available);
+    for (int i = 0; gSim.record != NULL && i < gSim.history.current; ++i) {
+        if (!RecordAdd(gSim.record, gSim.line[i])) break;
+    }
+    free(gSim.line);
+    gSim.line = NULL;
+    gSim.lineCap = 0;
+    HistoryFree(&gSim.history);
+}
+
+static bool Push(SimCommand cmd)
+{
+    unsigned tail = atomic_load_explicit(&gSim.tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&gSim.head, memory_order_acquire);
+    if (tail - head >= SIM_QUEUE_SIZE) return false;
+
+    gSim.queue[tail & (SIM_QUEUE_SIZE - 1)] = cmd;
+    atomic_store_explicit(&gSim.tail, tail + 1, memory_order_release);
+    atomic_fetch_add_explicit(&gSim.submitted, 1, memory_order_relaxed);
+    sem_post(&gSim.available);
+    return true;
+}
+
+bool SimPushAction(Action a)
+{
+    return Push((SimCommand){ 0, a });
+}
+
+bool SimPushHistory(SimHistoryMove move)
+{
+    return Push((SimCommand){ (uint8_t)move, { 0 } });
+}
+
+void SimHistoryPosition(int* step, int* count)
+{
+    *step = atomic_load_explicit(&gSim.historyStep, memory_order_relaxed);
+    *count = atomic_load_explicit(&gSim.historyCount, memory_order_relaxed);
+}
+
+const GameState* SimAcquireSnapshot(void)
+{
+    if (atomic_load_explicit(&gSim.middle, memory_order_relaxed) & SNAPSHOT_FRESH) {
+        unsigned prev = atomic_exchange_explicit(&gSim.middle, gSim.front, memory_order_acq_rel);
+        gSim.front = prev & 3u;
+    }
+    return &gSim.slots[gSim.front];
+}
+
+bool SimPending(void)
+{
+    return atomic_load_explicit(&gSim.processed, memory_order_acquire) !=
+           atomic_load_explicit(&gSim.submitted, memory_order_relaxed);
+}
@@ -0,0 +1,43 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "record.h"
+#include "rules.h"
+
+// Game simulation on its own thread. The main thread pushes input actions
+// into a single-producer/single-consumer queue; the simulation applies them
+// and publishes an immutable GameState snapshot through a lock-free triple
+// buffer. Rendering only ever reads the latest published snapshot, so no
+// amount of work behind an action can stall a frame.
+
+// Starts from start, a new or a loaded game; the history begins there.
+// With record, the moves from start to the step the game is at are added
+// to it on SimStop; it is not touched before.
+bool SimStart(const GameState* start, Record* record);
+void SimStop(void);
+
+// Main thread: queue an action for the current player (false if the queue is full)
+bool SimPushAction(Action a);
+
+// Undo/redo. Every applied action is a step in the simulation's history
+// (history.h); moves are queued behind pending actions like one.
+typedef enum {
+    SIM_UNDO = 1,      // one action back
+    SIM_REDO,          // one action forward
+    SIM_TURN_BACK,     // to the start of this turn, or the one before
+    SIM_TURN_FORWARD   // to the start of the next recorded turn
+} SimHistoryMove;
+
+bool SimPushHistory(SimHistoryMove move);
+
+// Main thread: history position as of the latest publish
+void SimHistoryPosition(int* step, int* count);
+
+// Main thread: latest published snapshot. Stays valid and unchanged until
+// the next call.
+const GameState* SimAcquireSnapshot(void);
+
+// True while pushed actions have not been reflected in a published snapshot
+bool SimPending(void);
+
+#endif
@@ -0,0 +1,283 @@
+#define _DEFAULT_SOURCE
+#include "snapshot.h"
+#include "cards.h"
+#include "protocol.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+enum {
+    SNAP_ENDED     = 1,
+    SNAP_PLACEMENT = 2,
+    SNAP_FINAL     = 4
+};
+
+static uint32_t Checksum(const uint8_t* p, int n)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static void PutU16(ProtoWriter* w, unsigned v)
+{
+    ProtoPutU8(w, (uint8_t)(v & 0xFF));
+    ProtoPutU8(w, (uint8_t)(v >> 8));
+}
+
+static unsigned GetU16(ProtoReader* r)
+{
+    unsigned lo = ProtoGetU8(r);
+    return lo | ((unsigned)ProtoGetU8(r) << 8);
+}
+
+// Same packing as delta.c: height in bits 0-2, then 3 bits per piece
+static unsigned PackStack(const CoralStack* s)
+{
+    unsigned v = s->height & 7u;
+    for (int h = 0; h < MAX_STACK_HEIGHT; ++h) v |= (s->pieces[h] & 7u) << (3 + 3 * h);
+    return v;
+}
+
+// Pieces must fill the stack from the bottom with real colors
+static bool UnpackStack(CoralStack* s, unsigned v)
+{
+    if (v >> (3 + 3 * MAX_STACK_HEIGHT)) return false;
+    s->height = v & 7u;
+    if (s->height > MAX_STACK_HEIGHT) return false;
+    for (int h = 0; h < MAX_STACK_HEIGHT; ++h) {
+        s->pieces[h] = (v >> (3 + 3 * h)) & 7u;
+        bool filled = s->pieces[h] != CORAL_NONE;
+        if (filled != (h < s->height) || s->pieces[h] > CORAL_GREEN) return false;
+    }
+    return true;
+}
+
+const char* SnapshotErrorString(SnapshotError err)
+{
+    switch (err) {
+        case SNAPSHOT_OK:            return "ok";
+        case SNAPSHOT_ERR_IO:        return "i/o error";
+        case SNAPSHOT_ERR_TRUNCATED: return "truncated";
+        case SNAPSHOT_ERR_MAGIC:     return "not a saved game";
+        case SNAPSHOT_ERR_VERSION:   return "unsupported version";
+        case SNAPSHOT_ERR_CHECKSUM:  return "checksum mismatch";
+        case SNAPSHOT_ERR_INVALID:   return "invalid game state";
+    }
+    return "unknown error";
+}
+
+int SnapshotEncode(const GameState* g, uint8_t* buf, int cap)
+{
+    if (cap < SNAPSHOT_HEADER_SIZE) return 0;
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, cap);
+    ProtoPutBytes(&w, (const uint8_t[SNAPSHOT_HEADER_SIZE]){ 0 }, SNAPSHOT_HEADER_SIZE);
+
+    ProtoPutU64(&w, g->rng);
+    ProtoPutU8(&w, (uint8_t)g->playersCount);
+    ProtoPutU8(&w, (uint8_t)g->currentPlayer);
+    ProtoPutU8(&w, (uint8_t)((g->gameEnded ? SNAP_ENDED : 0) | (g->placement.active ? SNAP_PLACEMENT : 0) |
+                             (g->finalRound ? SNAP_FINAL : 0)));
+    for (int c = CORAL_YELLOW; c <= CORAL_GREEN; ++c) {
+        if (g->supplies[c] < 0 || g->supplies[c] > 0xFF) return 0;
+        ProtoPutU8(&w, (uint8_t)g->supplies[c]);
+    }
+    if (g->placement.active) {
+        ProtoPutU8(&w, g->placement.card);
+        ProtoPutU8(&w, (uint8_t)g->placement.piecesPlaced);
+    }
+
+    for (int p = 0; p < g->playersCount; ++p) {
+        const Player* pl = &g->players[p];
+        if (pl->points < 0 || pl->points > 0xFFFF) return 0;
+        PutU16(&w, (unsigned)pl->points);
+        ProtoPutU8(&w, (uint8_t)pl->handSize);
+        ProtoPutBytes(&w, pl->hand, pl->handSize);
+        ProtoPutU8(&w, pl->hiddenHand);
+        for (int r = 0; r < BOARD_SIZE; ++r) {
+            for (int c = 0; c < BOARD_SIZE; ++c) PutU16(&w, PackStack(&pl->board[r][c]));
+        }
+    }
+
+    ProtoPutU8(&w, (uint8_t)g->deckSize);
+    ProtoPutBytes(&w, g->deck, g->deckSize);
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+        if (g->displayTokens[i] < 0 || g->displayTokens[i] > 0xFF) return 0;
+        ProtoPutU8(&w, g->display[i]);
+        ProtoPutU8(&w, (uint8_t)g->displayTokens[i]);
+    }
+    if (w.overflow) return 0;
+
+    int body = w.len - SNAPSHOT_HEADER_SIZE;
+    uint32_t sum = Checksum(buf + SNAPSHOT_HEADER_SIZE, body);
+    ProtoWriterInit(&w, buf, SNAPSHOT_HEADER_SIZE);
+    ProtoPutU32(&w, SNAPSHOT_MAGIC);
+    ProtoPutU8(&w, SNAPSHOT_VERSION);
+    ProtoPutU8(&w, 0);
+    PutU16(&w, (unsigned)body);
+    ProtoPutU32(&w, sum);
+    return SNAPSHOT_HEADER_SIZE + body;
+}
+
+// Claim a card id for one place in the game; false if out of range or taken
+static bool TakeCard(uint64_t* seen, unsigned id)
+{
+    if (id >= DECK_MAX || (*seen >> id) & 1u) return false;
+    *seen |= (uint64_t)1 << id;
+    return true;
+}
+
+static SnapshotError DecodeBody(ProtoReader* r, unsigned version, GameState* g)
+{
+    uint64_t seen = 0;
+
+    g->rng = ProtoGetU64(r);
+    g->playersCount = ProtoGetU8(r);
+    g->currentPlayer = ProtoGetU8(r);
+    unsigned flags = ProtoGetU8(r);
+    if (g->playersCount < PLAYERS_MIN || g->playersCount > PLAYERS_MAX || g->currentPlayer >= g->playersCount ||
+        (flags & ~(unsigned)(SNAP_ENDED | SNAP_PLACEMENT | SNAP_FINAL))) {
+        return SNAPSHOT_ERR_INVALID;
+    }
+    g->gameEnded = (flags & SNAP_ENDED) != 0;
+    g->finalRound = (flags & SNAP_FINAL) != 0;
+    bool emptySupply = false;
+    for (int c = CORAL_YELLOW; c <= CORAL_GREEN; ++c) {
+        g->supplies[c] = ProtoGetU8(r);
+        emptySupply = emptySupply || g->supplies[c] == 0;
+    }
+    // Only an empty supply starts the final round
+    if (g->finalRound && !emptySupply) return SNAPSHOT_ERR_INVALID;
+
+    if (flags & SNAP_PLACEMENT) {
+        // The pieces and points follow from the card
+        unsigned card = ProtoGetU8(r);
+        unsigned placed = ProtoGetU8(r);
+        if (g->gameEnded || placed >= 2 || !TakeCard(&seen, card)) return SNAPSHOT_ERR_INVALID;
+        const Card* def = CardGet((CardId)card);
+        g->placement = (PlacementState){
+            .active = true,
+            .piecesToPlace = { def->piece1, def->piece2 },
+            .piecesPlaced = (int)placed,
+            .cardPoints = def->pattern.pointValue,
+            .card = (CardId)card
+        };
+    }
+
+    for (int p = 0; p < g->playersCount; ++p) {
+        Player* pl = &g->players[p];
+        pl->id = p;
+        pl->points = (int)GetU16(r);
+        pl->handSize = ProtoGetU8(r);
+        if (pl->handSize > MAX_HAND_SIZE) return SNAPSHOT_ERR_INVALID;
+        for (int i = 0; i < pl->handSize; ++i) {
+            pl->hand[i] = ProtoGetU8(r);
+            if (!r->error && !TakeCard(&seen, pl->hand[i])) return SNAPSHOT_ERR_INVALID;
+        }
+        pl->hiddenHand = version >= 2 ? ProtoGetU8(r) : 0;
+        if (pl->hiddenHand >> pl->handSize) return SNAPSHOT_ERR_INVALID;
+        for (int cell = 0; cell < BOARD_SIZE * BOARD_SIZE; ++cell) {
+            unsigned v = GetU16(r);
+            if (!r->error && !UnpackStack(&pl->board[cell / BOARD_SIZE][cell % BOARD_SIZE], v)) {
+                return SNAPSHOT_ERR_INVALID;
+            }
+        }
+    }
+
+    g->deckSize = ProtoGetU8(r);
+    if (g->deckSize > DECK_MAX) return SNAPSHOT_ERR_INVALID;
+    for (int i = 0; i < g->deckSize; ++i) {
+        g->deck[i] = ProtoGetU8(r);
+        if (!r->error && !TakeCard(&seen, g->deck[i])) return SNAPSHOT_ERR_INVALID;
+    }
+
+    // A slot the empty deck could not refill keeps the card that was taken
+    for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
+        g->display[i] = ProtoGetU8(r);
+        g->displayTokens[i] = ProtoGetU8(r);
+        if (r->error) break;
+        if (g->display[i] >= DECK_MAX) return SNAPSHOT_ERR_INVALID;
+        if (g->deckSize > 0 && !TakeCard(&seen, g->display[i])) return SNAPSHOT_ERR_INVALID;
+    }
+
+    if (r->error) return SNAPSHOT_ERR_TRUNCATED;
+    if (r->left != 0) return SNAPSHOT_ERR_INVALID;
+    CardsRecountUnseen(g);
+    return SNAPSHOT_OK;
+}
+
+SnapshotError SnapshotDecode(const uint8_t* buf, int len, GameState* out, int* used)
+{
+    if (len < SNAPSHOT_HEADER_SIZE) return SNAPSHOT_ERR_TRUNCATED;
+    ProtoReader r;
+    ProtoReaderInit(&r, buf, SNAPSHOT_HEADER_SIZE);
+    if (ProtoGetU32(&r) != SNAPSHOT_MAGIC) return SNAPSHOT_ERR_MAGIC;
+    unsigned version = ProtoGetU8(&r);
+    if (version < 1 || version > SNAPSHOT_VERSION) return SNAPSHOT_ERR_VERSION;
+    if (ProtoGetU8(&r) != 0) return SNAPSHOT_ERR_VERSION;  // reserved for later formats
+    int body = (int)GetU16(&r);
+    uint32_t sum = ProtoGetU32(&r);
+    if (len - SNAPSHOT_HEADER_SIZE < body) return SNAPSHOT_ERR_TRUNCATED;
+    if (Checksum(buf + SNAPSHOT_HEADER_SIZE, body) != sum) return SNAPSHOT_ERR_CHECKSUM;
+
+    GameState g;
+    memset(&g, 0, sizeof(g));
+    ProtoReaderInit(&r, buf + SNAPSHOT_HEADER_SIZE, body);
+    SnapshotError err = DecodeBody(&r, version, &g);
+    if (err != SNAPSHOT_OK) return err;
+
+    *out = g;
+    if (used) *used = SNAPSHOT_HEADER_SIZE + body;
+    return SNAPSHOT_OK;
+}
+
+static bool WriteAll(int fd, const uint8_t* p, int n)
+{
+    while (n > 0) {
+        ssize_t k = write(fd, p, (size_t)n);
+        if (k <= 0) return false;
+        p += k;
+        n -= (int)k;
+    }
+    return true;
+}
+
+SnapshotError SnapshotSave(const char* path, const GameState* g)
+{
+    uint8_t buf[SNAPSHOT_MAX_SIZE];
+    int len = SnapshotEncode(g, buf, sizeof(buf));
+    if (len == 0) return SNAPSHOT_ERR_INVALID;
+
+    char tmpPath[512];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path) >= (int)sizeof(tmpPath)) return SNAPSHOT_ERR_IO;
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return SNAPSHOT_ERR_IO;
+    bool ok = WriteAll(fd, buf, len) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return SNAPSHOT_ERR_IO;
+    }
+    return SNAPSHOT_OK;
+}
+
+SnapshotError SnapshotLoad(const char* path, GameState* out)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return SNAPSHOT_ERR_IO;
+    uint8_t buf[SNAPSHOT_MAX_SIZE + 1];
+    ssize_t len = read(fd, buf, sizeof(buf));
+    close(fd);
+    if (len < 0) return SNAPSHOT_ERR_IO;
+    if (len > SNAPSHOT_MAX_SIZE) return SNAPSHOT_ERR_INVALID;
+
+    GameState g;
+    int used;
+    SnapshotError err = SnapshotDecode(buf, (int)len, &g, &used);
+    if (err != SNAPSHOT_OK) return err;
+    if (used != len) return SNAPSHOT_ERR_INVALID;
+    *out = g;
+    return SNAPSHOT_OK;
+}
@@ -0,0 +1,60 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "constants.h"
+
+// Saved games: a versioned, compact binary snapshot of a GameState.
+//
+//   u32 magic | u8 version | u8 reserved | u16 bodyLength | u32 checksum | body
+//
+// all little-endian, checksum being FNV-1a over the body. The body holds
+// only what the game can still use: the RNG state, the turn, the supplies,
+// each player's points, hand (card ids, and which of them were dealt face
+// down) and board (one u16 per stack, packed as in delta.c), the undealt
+// deck in order, the display and the card being placed. Everything derived
+// from a card id is rebuilt from the catalog on load, and the unseen card
+// counts from where the cards are (cards.h), so a 2-player game fits in
+// under 200 bytes. Version 1 had no face-down marks; its hands load as
+// open. Version 3 added the final-round flag; older games could not be in
+// the final round, which ended them on the spot.
+//
+// Decoding never trusts the bytes: every id, count and stack is range
+// checked and no card may be in two places, so a snapshot that decodes is
+// one RulesApply can safely continue. A decoded state plays on exactly as
+// the saved one would, deck order and RNG included.
+
+#define SNAPSHOT_MAGIC   0x504E5352u  // "RSNP"
+#define SNAPSHOT_VERSION 3u
+
+enum {
+    SNAPSHOT_HEADER_SIZE = 12,
+    SNAPSHOT_PLAYER_SIZE = 2 + 1 + MAX_HAND_SIZE + 1 + 2 * BOARD_SIZE * BOARD_SIZE,
+    SNAPSHOT_MAX_SIZE    = SNAPSHOT_HEADER_SIZE + 8 + 3 + 4 + 2 + 1 + DECK_MAX +
+                           2 * CARD_DISPLAY_SIZE + PLAYERS_MAX * SNAPSHOT_PLAYER_SIZE
+};
+
+typedef enum {
+    SNAPSHOT_OK = 0,
+    SNAPSHOT_ERR_IO,          // file could not be read or written
+    SNAPSHOT_ERR_TRUNCATED,   // shorter than its header says
+    SNAPSHOT_ERR_MAGIC,       // not a snapshot
+    SNAPSHOT_ERR_VERSION,     // written by a newer build
+    SNAPSHOT_ERR_CHECKSUM,    // damaged
+    SNAPSHOT_ERR_INVALID      // well-formed but not a reachable game
+} SnapshotError;
+
+const char* SnapshotErrorString(SnapshotError err);
+
+// Encode g into buf; returns the bytes written, 0 if cap is too small
+int SnapshotEncode(const GameState* g, uint8_t* buf, int cap);
+
+// Validate and decode; out is only written on SNAPSHOT_OK. *used (if not
+// NULL) gets the snapshot's length, so snapshots can be read back to back.
+SnapshotError SnapshotDecode(const uint8_t* buf, int len, GameState* out, int* used);
+
+// Crash-safe write: a temporary file next to path is written, synced and
+// renamed over it, so path always holds either the old or the new game
+SnapshotError SnapshotSave(const char* path, const GameState* g);
+SnapshotError SnapshotLoad(const char* path, GameState* out);
+
+#endif
@@ -0,0 +1,76 @@
+#include "synergy.h"
+#include <string.h>
+
+int SynergyStage(int pieces)
+{
+    int stage = pieces / SYNERGY_STAGE_PIECES;
+    return stage < SYNERGY_STAGES ? stage : SYNERGY_STAGES - 1;
+}
+
+int SynergyPairIndex(int b, int c)
+{
+    if (b > c) {
+        int t = b;
+        b = c;
+        c = t;
+    }
+    // Rows b = 0, 1, ... hold CARD_KIND_COUNT - b entries each
+    return b * CARD_KIND_COUNT - b * (b - 1) / 2 + (c - b);
+}
+
+// With one card, it can only serve itself; otherwise each candidate play
+// serves the best two cards of the hand, itself among them
+static float SynergyKinds(const int* kinds, int count, int stage)
+{
+    if (count == 1) return (float)SYNERGY_PAIR[stage][kinds[0]][kinds[0]] / SYNERGY_UNIT;
+
+    int best = 0;
+    for (int a = 0; a < count; ++a) {
+        const uint8_t* served = SYNERGY_TRIPLE[stage][kinds[a]];
+        for (int b = 0; b < count; ++b) {
+            for (int c = b + 1; c < count; ++c) {
+                int v = served[SynergyPairIndex(kinds[b], kinds[c])];
+                if (v > best) best = v;
+            }
+        }
+    }
+    return (float)best / SYNERGY_UNIT;
+}
+
+float SynergyHand(const Player* player, int pieces)
+{
+    int kinds[MAX_HAND_SIZE];
+    for (int i = 0; i < player->handSize; ++i) kinds[i] = CardKind(player->hand[i]);
+    return SynergyKinds(kinds, player->handSize, SynergyStage(pieces));
+}
+
+// Hidden slots from slot on take each kind in turn, weighted by its
+// unseen copies and drawn without replacement
+static float SynergyExpected(int* kinds, int count, unsigned hidden, int slot, uint8_t* unseen, int total, int stage)
+{
+    while (slot < count && !(hidden & (1u << slot))) slot++;
+    if (slot == count) return SynergyKinds(kinds, count, stage);
+    if (total <= 0) return 0.0f;
+
+    float sum = 0.0f;
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+        if (unseen[k] == 0) continue;
+        int copies = unseen[k]--;
+        kinds[slot] = k;
+        sum += (float)copies * SynergyExpected(kinds, count, hidden, slot + 1, unseen, total - 1, stage);
+        unseen[k]++;
+    }
+    return sum / (float)total;
+}
+
+float SynergyHandAsSeen(const Player* player, int pieces, const Player* viewer)
+{
+    if (player == viewer || player->hiddenHand == 0) return SynergyHand(player, pieces);
+
+    int kinds[MAX_HAND_SIZE];
+    for (int i = 0; i < player->handSize; ++i) kinds[i] = CardKind(player->hand[i]);
+    uint8_t unseen[CARD_KIND_COUNT];
+    memcpy(unseen, viewer->unseen, sizeof(unseen));
+    return SynergyExpected(kinds, player->handSize, player->hiddenHand, 0, unseen, CardsUnseenTotal(viewer),
+                           SynergyStage(pieces));
+}
@@ -0,0 +1,49 @@
+#ifndef SYNERGY_H
+#define SYNERGY_H
+
+#include "cards.h"
+
+// Card synergy: how many points a card's two pieces can add to the
+// patterns of cards held alongside it. tools/reefsynergy measures it over
+// boards sampled from self-play, placing the played card's pieces every
+// legal way and keeping the best, and writes the averages to
+// src/synergy_data.c (committed; `make synergy` regenerates it). The
+// evaluation then reads a few table entries per hand instead of trying
+// placements.
+//
+// Entries are by the played card's kind and the board's stage (pieces on
+// it), in 1/SYNERGY_UNIT points:
+//
+//   SYNERGY_PAIR[stage][a][b]        a's pieces serving b alone
+//   SYNERGY_TRIPLE[stage][a][bc]     a's pieces serving b and c at once,
+//                                    bc = SynergyPairIndex(b, c)
+//
+// The played card may serve itself (b == a): it scores once its pieces
+// are down.
+
+enum {
+    SYNERGY_STAGES       = 3,
+    SYNERGY_STAGE_PIECES = 12,  // pieces on the board per stage; the last takes the rest
+    SYNERGY_UNIT         = 8,
+    SYNERGY_KIND_PAIRS   = CARD_KIND_COUNT * (CARD_KIND_COUNT + 1) / 2  // b <= c
+};
+
+extern const uint8_t SYNERGY_PAIR[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT];
+extern const uint8_t SYNERGY_TRIPLE[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS];
+
+// Stage of a board with pieces on it
+int SynergyStage(int pieces);
+
+// Index of the unordered kind pair {b, c}
+int SynergyPairIndex(int b, int c);
+
+// Points the best play from the hand is expected to add to the hand's
+// patterns (its own included), on a board with pieces on it
+float SynergyHand(const Player* player, int pieces);
+
+// The same as viewer can tell it: each of player's face-down slots
+// (Player::hiddenHand) counts as any card viewer has not seen, weighted by
+// the copies (cards.h). Exact over the kinds the slots could hold.
+float SynergyHandAsSeen(const Player* player, int pieces, const Player* viewer);
+
+#endif
@@ -0,0 +1,432 @@
+// Generated by tools/reefsynergy: 100522 boards from 2000 games (2 players, greedy, seed 1).
+// Do not edit.
+#include "synergy.h"
+
+#if CARD_KIND_COUNT != 15
+const uint8_t SYNERGY_PAIR[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT];
+const uint8_t SYNERGY_TRIPLE[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS];
+#else
+
+const uint8_t SYNERGY_PAIR[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT] = {
+    [0] = {  // 29455 boards
+        { 0, 0, 0, 15, 17, 0, 56, 0, 0, 0, 9, 0, 0, 0, 22 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 56, 0, 0 },
+        { 5, 0, 0, 15, 0, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        { 0, 0, 0, 15, 17, 0, 56, 0, 0, 0, 9, 0, 0, 0, 22 },
+        { 1, 0, 0, 15, 9, 4, 40, 0, 0, 0, 5, 0, 0, 0, 7 },
+        { 0, 0, 0, 15, 17, 0, 56, 0, 0, 0, 9, 0, 0, 0, 22 },
+        { 1, 0, 0, 15, 0, 4, 0, 0, 0, 3, 0, 2, 40, 0, 0 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 56, 0, 0 },
+        { 0, 0, 0, 15, 17, 0, 56, 0, 0, 0, 9, 0, 0, 0, 22 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 1, 0, 0, 15, 0, 4, 0, 0, 0, 3, 0, 2, 26, 0, 0 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 56, 0, 0 }
+    },
+    [1] = {  // 48739 boards
+        { 0, 0, 0, 15, 19, 0, 69, 0, 0, 0, 10, 0, 0, 0, 25 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 24, 69, 0, 0 },
+        { 7, 0, 0, 15, 0, 24, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        { 0, 0, 0, 15, 19, 0, 69, 0, 0, 0, 10, 0, 0, 0, 25 },
+        { 2, 0, 0, 15, 8, 5, 40, 0, 0, 0, 4, 0, 0, 0, 12 },
+        { 0, 0, 0, 15, 19, 0, 69, 0, 0, 0, 10, 0, 0, 0, 25 },
+        { 2, 0, 0, 15, 0, 5, 0, 1, 0, 10, 0, 6, 40, 0, 0 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 24, 69, 0, 0 },
+        { 0, 0, 0, 15, 19, 0, 69, 0, 0, 0, 10, 0, 0, 0, 25 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 2, 0, 0, 15, 0, 5, 0, 1, 0, 10, 0, 6, 35, 0, 0 },
+        { 0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 24, 69, 0, 0 }
+    },
+    [2] = {  // 22328 boards
+        { 0, 0, 0, 15, 20, 0, 72, 0, 0, 0, 10, 0, 0, 0, 24 },
+        { 0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 72, 0, 0 },
+        { 7, 0, 0, 15, 0, 25, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+        { 0, 0, 0, 15, 20, 0, 72, 0, 0, 0, 10, 0, 0, 0, 24 },
+        { 2, 0, 0, 15, 9, 6, 40, 0, 0, 0, 5, 0, 0, 0, 12 },
+        { 0, 0, 0, 15, 20, 0, 72, 0, 0, 0, 10, 0, 0, 0, 24 },
+        { 2, 0, 0, 15, 0, 6, 0, 2, 0, 13, 0, 8, 40, 0, 0 },
+        { 0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 72, 0, 0 },
+        { 0, 0, 0, 15, 20, 0, 72, 0, 0, 0, 10, 0, 0, 0, 24 },
+        { 0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0 },
+        { 2, 0, 0, 15, 0, 6, 0, 2, 0, 13, 0, 8, 37, 0, 0 },
+        { 0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0 },
+        { 0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 72, 0, 0 }
+    }
+};
+
+const uint8_t SYNERGY_TRIPLE[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS] = {
+    [0] = {
+        {
+            0, 0, 0, 15, 17, 0, 55, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 15, 17, 0,
+            54, 0, 0, 0, 9, 0, 0, 0, 22, 0, 15, 17, 0, 53, 0, 0, 0, 9, 0, 0,
+            0, 22, 31, 30, 15, 49, 15, 15, 15, 21, 15, 15, 15, 32, 35, 17, 68, 17, 17, 17,
+            26, 17, 17, 17, 38, 0, 54, 0, 0, 0, 9, 0, 0, 0, 22, 112, 56, 48, 55, 62,
+            56, 56, 52, 60, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 9, 0, 0, 0, 21, 0,
+            9, 0, 0, 0, 22, 17, 9, 9, 9, 30, 0, 0, 0, 22, 0, 0, 22, 0, 22, 45
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0, 20, 21, 20, 9, 10,
+            10, 10, 130, 10, 10, 10, 10, 36, 10, 31, 31, 15, 15, 15, 15, 142, 15, 15, 15, 15,
+            36, 15, 31, 15, 15, 15, 15, 141, 15, 15, 15, 15, 35, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 126, 0, 0, 0, 0, 25, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 25, 0, 254, 127, 127, 127, 127, 134, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 25, 0, 0, 0, 25, 0, 0, 24, 0, 51, 25, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 55, 0, 0, 0, 0, 15, 0, 0,
+            0, 3, 0, 23, 0, 14, 54, 0, 0, 0, 15, 0, 0, 0, 3, 0, 22, 0, 14, 53,
+            0, 0, 31, 15, 15, 15, 17, 15, 31, 15, 28, 49, 15, 15, 0, 0, 0, 3, 0, 22,
+            0, 14, 55, 0, 0, 0, 0, 3, 0, 22, 0, 14, 54, 0, 0, 0, 3, 0, 22, 0,
+            14, 56, 0, 0, 7, 3, 24, 3, 17, 57, 3, 3, 0, 21, 0, 13, 48, 0, 0, 45,
+            22, 33, 59, 23, 23, 0, 14, 55, 0, 0, 28, 62, 14, 14, 112, 52, 55, 0, 0, 0
+        },
+        {
+            9, 5, 5, 19, 5, 33, 5, 5, 4, 5, 5, 5, 5, 5, 5, 0, 0, 15, 0, 29,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 0, 29, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 31, 15, 40, 15, 15, 15, 15, 15, 15, 15, 15, 15, 0, 29, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 57, 29, 29, 29, 29, 29, 29, 29, 29, 29, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 17, 0, 55, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 15, 17, 0,
+            54, 0, 0, 0, 9, 0, 0, 0, 22, 0, 15, 17, 0, 53, 0, 0, 0, 9, 0, 0,
+            0, 22, 31, 30, 15, 49, 15, 15, 15, 21, 15, 15, 15, 32, 35, 17, 68, 17, 17, 17,
+            26, 17, 17, 17, 38, 0, 54, 0, 0, 0, 9, 0, 0, 0, 22, 112, 56, 48, 55, 62,
+            56, 56, 52, 60, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 9, 0, 0, 0, 21, 0,
+            9, 0, 0, 0, 22, 17, 9, 9, 9, 30, 0, 0, 0, 22, 0, 0, 22, 0, 22, 45
+        },
+        {
+            3, 1, 1, 16, 10, 5, 40, 1, 1, 1, 6, 1, 1, 1, 9, 0, 0, 15, 9, 4,
+            40, 0, 0, 0, 5, 0, 0, 0, 7, 0, 15, 9, 4, 40, 0, 0, 0, 5, 0, 0,
+            0, 7, 31, 23, 19, 40, 15, 15, 15, 18, 15, 15, 15, 21, 19, 13, 47, 9, 9, 9,
+            14, 9, 9, 9, 15, 8, 42, 4, 4, 4, 9, 4, 4, 4, 11, 80, 40, 39, 40, 44,
+            40, 40, 40, 43, 0, 0, 0, 5, 0, 0, 0, 7, 0, 0, 5, 0, 0, 0, 7, 0,
+            5, 0, 0, 0, 7, 9, 5, 5, 5, 11, 0, 0, 0, 7, 0, 0, 7, 0, 7, 15
+        },
+        {
+            0, 0, 0, 15, 17, 0, 55, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 15, 17, 0,
+            54, 0, 0, 0, 9, 0, 0, 0, 22, 0, 15, 17, 0, 53, 0, 0, 0, 9, 0, 0,
+            0, 22, 31, 30, 15, 49, 15, 15, 15, 21, 15, 15, 15, 32, 35, 17, 68, 17, 17, 17,
+            26, 17, 17, 17, 38, 0, 54, 0, 0, 0, 9, 0, 0, 0, 22, 112, 56, 48, 55, 62,
+            56, 56, 52, 60, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 9, 0, 0, 0, 21, 0,
+            9, 0, 0, 0, 22, 17, 9, 9, 9, 30, 0, 0, 0, 22, 0, 0, 22, 0, 22, 45
+        },
+        {
+            3, 1, 1, 16, 1, 5, 1, 2, 1, 4, 1, 3, 40, 1, 1, 0, 0, 15, 0, 4,
+            0, 0, 0, 3, 0, 2, 40, 0, 0, 0, 15, 0, 4, 0, 0, 0, 3, 0, 2, 40,
+            0, 0, 31, 15, 19, 15, 16, 15, 18, 15, 17, 40, 15, 15, 0, 4, 0, 0, 0, 3,
+            0, 2, 40, 0, 0, 8, 4, 4, 4, 7, 4, 6, 42, 4, 4, 0, 0, 0, 3, 0,
+            2, 40, 0, 0, 1, 0, 3, 0, 2, 40, 0, 0, 0, 3, 0, 2, 39, 0, 0, 6,
+            3, 4, 42, 3, 3, 0, 2, 40, 0, 0, 3, 41, 2, 2, 80, 40, 40, 0, 0, 0
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0, 20, 21, 20, 9, 10,
+            10, 10, 130, 10, 10, 10, 10, 36, 10, 31, 31, 15, 15, 15, 15, 142, 15, 15, 15, 15,
+            36, 15, 31, 15, 15, 15, 15, 141, 15, 15, 15, 15, 35, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 126, 0, 0, 0, 0, 25, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 25, 0, 254, 127, 127, 127, 127, 134, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 25, 0, 0, 0, 25, 0, 0, 24, 0, 51, 25, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 55, 0, 0, 0, 0, 15, 0, 0,
+            0, 3, 0, 23, 0, 14, 54, 0, 0, 0, 15, 0, 0, 0, 3, 0, 22, 0, 14, 53,
+            0, 0, 31, 15, 15, 15, 17, 15, 31, 15, 28, 49, 15, 15, 0, 0, 0, 3, 0, 22,
+            0, 14, 55, 0, 0, 0, 0, 3, 0, 22, 0, 14, 54, 0, 0, 0, 3, 0, 22, 0,
+            14, 56, 0, 0, 7, 3, 24, 3, 17, 57, 3, 3, 0, 21, 0, 13, 48, 0, 0, 45,
+            22, 33, 59, 23, 23, 0, 14, 55, 0, 0, 28, 62, 14, 14, 112, 52, 55, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 17, 0, 55, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 15, 17, 0,
+            54, 0, 0, 0, 9, 0, 0, 0, 22, 0, 15, 17, 0, 53, 0, 0, 0, 9, 0, 0,
+            0, 22, 31, 30, 15, 49, 15, 15, 15, 21, 15, 15, 15, 32, 35, 17, 68, 17, 17, 17,
+            26, 17, 17, 17, 38, 0, 54, 0, 0, 0, 9, 0, 0, 0, 22, 112, 56, 48, 55, 62,
+            56, 56, 52, 60, 0, 0, 0, 9, 0, 0, 0, 22, 0, 0, 9, 0, 0, 0, 21, 0,
+            9, 0, 0, 0, 22, 17, 9, 9, 9, 30, 0, 0, 0, 22, 0, 0, 22, 0, 22, 45
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0, 20, 21, 20, 9, 10,
+            10, 10, 130, 10, 10, 10, 10, 36, 10, 31, 31, 15, 15, 15, 15, 142, 15, 15, 15, 15,
+            36, 15, 31, 15, 15, 15, 15, 141, 15, 15, 15, 15, 35, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 126, 0, 0, 0, 0, 25, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 25, 0, 254, 127, 127, 127, 127, 134, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 25, 0, 0, 0, 25, 0, 0, 24, 0, 51, 25, 0
+        },
+        {
+            3, 1, 1, 16, 1, 5, 1, 2, 1, 4, 1, 3, 26, 1, 1, 0, 0, 15, 0, 4,
+            0, 0, 0, 3, 0, 2, 24, 0, 0, 0, 15, 0, 4, 0, 0, 0, 3, 0, 2, 24,
+            0, 0, 31, 15, 19, 15, 16, 15, 18, 15, 17, 31, 15, 15, 0, 4, 0, 0, 0, 3,
+            0, 2, 25, 0, 0, 8, 4, 4, 4, 7, 4, 6, 28, 4, 4, 0, 0, 0, 3, 0,
+            2, 26, 0, 0, 1, 0, 3, 0, 2, 26, 0, 0, 0, 3, 0, 2, 16, 0, 0, 6,
+            3, 4, 27, 3, 3, 0, 2, 26, 0, 0, 3, 27, 2, 2, 52, 22, 25, 0, 0, 0
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 25, 0, 20, 21, 20, 9, 10,
+            10, 10, 130, 10, 10, 10, 10, 36, 10, 31, 31, 15, 15, 15, 15, 142, 15, 15, 15, 15,
+            36, 15, 31, 15, 15, 15, 15, 141, 15, 15, 15, 15, 35, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 126, 0, 0, 0, 0, 25, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 25, 0, 254, 127, 127, 127, 127, 134, 127, 0,
+            0, 0, 0, 25, 0, 0, 0, 0, 25, 0, 0, 0, 25, 0, 0, 24, 0, 51, 25, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 3, 0, 23, 0, 14, 55, 0, 0, 0, 0, 15, 0, 0,
+            0, 3, 0, 23, 0, 14, 54, 0, 0, 0, 15, 0, 0, 0, 3, 0, 22, 0, 14, 53,
+            0, 0, 31, 15, 15, 15, 17, 15, 31, 15, 28, 49, 15, 15, 0, 0, 0, 3, 0, 22,
+            0, 14, 55, 0, 0, 0, 0, 3, 0, 22, 0, 14, 54, 0, 0, 0, 3, 0, 22, 0,
+            14, 56, 0, 0, 7, 3, 24, 3, 17, 57, 3, 3, 0, 21, 0, 13, 48, 0, 0, 45,
+            22, 33, 59, 23, 23, 0, 14, 55, 0, 0, 28, 62, 14, 14, 112, 52, 55, 0, 0, 0
+        }
+    },
+    [1] = {
+        {
+            0, 0, 0, 15, 19, 0, 68, 0, 0, 0, 10, 0, 0, 0, 25, 0, 0, 14, 19, 0,
+            67, 0, 0, 0, 10, 0, 0, 0, 25, 0, 15, 19, 0, 65, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 57, 15, 15, 15, 19, 15, 15, 14, 33, 39, 19, 80, 19, 19, 19,
+            29, 19, 19, 19, 40, 0, 68, 0, 0, 0, 10, 0, 0, 0, 24, 137, 68, 57, 67, 75,
+            67, 69, 64, 78, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 9, 0, 0, 0, 22, 0,
+            10, 0, 0, 0, 25, 19, 10, 10, 10, 32, 0, 0, 0, 24, 0, 0, 23, 0, 24, 49
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 24, 0, 20, 20, 19, 9, 10,
+            9, 9, 134, 10, 9, 9, 9, 34, 10, 30, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15,
+            35, 15, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15, 34, 15, 0, 0, 0, 0, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 126, 0, 0, 0, 0, 24, 0, 0, 0, 126, 0, 0,
+            0, 0, 22, 0, 0, 126, 0, 0, 0, 0, 24, 0, 253, 126, 126, 126, 126, 144, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 24, 0, 0, 0, 24, 0, 0, 22, 0, 49, 24, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 25, 0, 23, 67, 0, 0, 0, 15, 0, 0, 0, 5, 0, 24, 0, 23, 65,
+            0, 0, 30, 14, 15, 15, 17, 15, 32, 14, 34, 57, 14, 15, 0, 0, 0, 5, 0, 24,
+            0, 23, 67, 0, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 5, 0, 23, 0,
+            22, 69, 0, 0, 12, 5, 28, 6, 29, 71, 6, 6, 0, 22, 0, 20, 57, 0, 0, 50,
+            25, 42, 78, 25, 25, 0, 23, 68, 0, 0, 47, 81, 23, 23, 137, 64, 68, 0, 0, 0
+        },
+        {
+            14, 7, 7, 20, 7, 31, 7, 7, 6, 7, 7, 7, 6, 7, 7, 0, 0, 14, 0, 24,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 0, 24, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 30, 14, 33, 15, 15, 15, 15, 14, 15, 15, 14, 15, 0, 24, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 49, 23, 24, 22, 23, 24, 23, 23, 23, 24, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 19, 0, 68, 0, 0, 0, 10, 0, 0, 0, 25, 0, 0, 14, 19, 0,
+            67, 0, 0, 0, 10, 0, 0, 0, 25, 0, 15, 19, 0, 65, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 57, 15, 15, 15, 19, 15, 15, 14, 33, 39, 19, 80, 19, 19, 19,
+            29, 19, 19, 19, 40, 0, 68, 0, 0, 0, 10, 0, 0, 0, 24, 137, 68, 57, 67, 75,
+            67, 69, 64, 78, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 9, 0, 0, 0, 22, 0,
+            10, 0, 0, 0, 25, 19, 10, 10, 10, 32, 0, 0, 0, 24, 0, 0, 23, 0, 24, 49
+        },
+        {
+            5, 2, 2, 17, 10, 8, 42, 2, 2, 2, 6, 2, 2, 2, 14, 0, 0, 14, 8, 5,
+            40, 0, 0, 0, 4, 0, 0, 0, 12, 0, 15, 8, 5, 40, 0, 0, 0, 4, 0, 0,
+            0, 12, 30, 20, 19, 39, 15, 15, 15, 16, 15, 15, 14, 25, 16, 13, 45, 8, 8, 8,
+            12, 8, 8, 8, 18, 11, 44, 5, 5, 5, 9, 5, 5, 5, 17, 80, 40, 39, 40, 43,
+            40, 40, 39, 47, 0, 0, 0, 4, 0, 0, 0, 12, 0, 0, 4, 0, 0, 0, 12, 0,
+            4, 0, 0, 0, 12, 8, 4, 4, 4, 15, 0, 0, 0, 12, 0, 0, 12, 0, 12, 25
+        },
+        {
+            0, 0, 0, 15, 19, 0, 68, 0, 0, 0, 10, 0, 0, 0, 25, 0, 0, 14, 19, 0,
+            67, 0, 0, 0, 10, 0, 0, 0, 25, 0, 15, 19, 0, 65, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 57, 15, 15, 15, 19, 15, 15, 14, 33, 39, 19, 80, 19, 19, 19,
+            29, 19, 19, 19, 40, 0, 68, 0, 0, 0, 10, 0, 0, 0, 24, 137, 68, 57, 67, 75,
+            67, 69, 64, 78, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 9, 0, 0, 0, 22, 0,
+            10, 0, 0, 0, 25, 19, 10, 10, 10, 32, 0, 0, 0, 24, 0, 0, 23, 0, 24, 49
+        },
+        {
+            5, 2, 2, 17, 2, 8, 2, 4, 2, 12, 2, 8, 42, 2, 2, 0, 0, 14, 0, 5,
+            0, 1, 0, 10, 0, 6, 40, 0, 0, 0, 15, 0, 5, 0, 1, 0, 9, 0, 5, 40,
+            0, 0, 30, 14, 19, 15, 16, 15, 22, 14, 20, 39, 14, 15, 0, 5, 0, 1, 0, 9,
+            0, 5, 40, 0, 0, 11, 5, 7, 5, 14, 5, 11, 44, 5, 5, 0, 1, 0, 9, 0,
+            5, 40, 0, 0, 3, 1, 10, 1, 7, 41, 1, 1, 0, 9, 0, 5, 39, 0, 0, 19,
+            9, 14, 46, 10, 10, 0, 6, 40, 0, 0, 11, 44, 5, 5, 80, 39, 40, 0, 0, 0
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 24, 0, 20, 20, 19, 9, 10,
+            9, 9, 134, 10, 9, 9, 9, 34, 10, 30, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15,
+            35, 15, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15, 34, 15, 0, 0, 0, 0, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 126, 0, 0, 0, 0, 24, 0, 0, 0, 126, 0, 0,
+            0, 0, 22, 0, 0, 126, 0, 0, 0, 0, 24, 0, 253, 126, 126, 126, 126, 144, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 24, 0, 0, 0, 24, 0, 0, 22, 0, 49, 24, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 25, 0, 23, 67, 0, 0, 0, 15, 0, 0, 0, 5, 0, 24, 0, 23, 65,
+            0, 0, 30, 14, 15, 15, 17, 15, 32, 14, 34, 57, 14, 15, 0, 0, 0, 5, 0, 24,
+            0, 23, 67, 0, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 5, 0, 23, 0,
+            22, 69, 0, 0, 12, 5, 28, 6, 29, 71, 6, 6, 0, 22, 0, 20, 57, 0, 0, 50,
+            25, 42, 78, 25, 25, 0, 23, 68, 0, 0, 47, 81, 23, 23, 137, 64, 68, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 19, 0, 68, 0, 0, 0, 10, 0, 0, 0, 25, 0, 0, 14, 19, 0,
+            67, 0, 0, 0, 10, 0, 0, 0, 25, 0, 15, 19, 0, 65, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 57, 15, 15, 15, 19, 15, 15, 14, 33, 39, 19, 80, 19, 19, 19,
+            29, 19, 19, 19, 40, 0, 68, 0, 0, 0, 10, 0, 0, 0, 24, 137, 68, 57, 67, 75,
+            67, 69, 64, 78, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 9, 0, 0, 0, 22, 0,
+            10, 0, 0, 0, 25, 19, 10, 10, 10, 32, 0, 0, 0, 24, 0, 0, 23, 0, 24, 49
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 24, 0, 20, 20, 19, 9, 10,
+            9, 9, 134, 10, 9, 9, 9, 34, 10, 30, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15,
+            35, 15, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15, 34, 15, 0, 0, 0, 0, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 126, 0, 0, 0, 0, 24, 0, 0, 0, 126, 0, 0,
+            0, 0, 22, 0, 0, 126, 0, 0, 0, 0, 24, 0, 253, 126, 126, 126, 126, 144, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 24, 0, 0, 0, 24, 0, 0, 22, 0, 49, 24, 0
+        },
+        {
+            5, 2, 2, 17, 2, 8, 2, 4, 2, 12, 2, 8, 37, 2, 2, 0, 0, 14, 0, 5,
+            0, 1, 0, 10, 0, 6, 34, 0, 0, 0, 15, 0, 5, 0, 1, 0, 9, 0, 5, 34,
+            0, 0, 30, 14, 19, 15, 16, 15, 22, 14, 20, 37, 14, 15, 0, 5, 0, 1, 0, 9,
+            0, 5, 34, 0, 0, 11, 5, 7, 5, 14, 5, 11, 39, 5, 5, 0, 1, 0, 9, 0,
+            5, 35, 0, 0, 3, 1, 10, 1, 7, 36, 1, 1, 0, 9, 0, 5, 28, 0, 0, 19,
+            9, 14, 40, 10, 10, 0, 6, 35, 0, 0, 11, 39, 5, 5, 70, 32, 35, 0, 0, 0
+        },
+        {
+            0, 10, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 24, 0, 20, 20, 19, 9, 10,
+            9, 9, 134, 10, 9, 9, 9, 34, 10, 30, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15,
+            35, 15, 30, 14, 15, 15, 15, 141, 15, 14, 15, 15, 34, 15, 0, 0, 0, 0, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 126, 0, 0, 0, 0, 24, 0, 0, 0, 126, 0, 0,
+            0, 0, 22, 0, 0, 126, 0, 0, 0, 0, 24, 0, 253, 126, 126, 126, 126, 144, 126, 0,
+            0, 0, 0, 24, 0, 0, 0, 0, 24, 0, 0, 0, 24, 0, 0, 22, 0, 49, 24, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 25, 0, 23, 67, 0, 0, 0, 15, 0, 0, 0, 5, 0, 24, 0, 23, 65,
+            0, 0, 30, 14, 15, 15, 17, 15, 32, 14, 34, 57, 14, 15, 0, 0, 0, 5, 0, 24,
+            0, 23, 67, 0, 0, 0, 0, 6, 0, 25, 0, 23, 68, 0, 0, 0, 5, 0, 23, 0,
+            22, 69, 0, 0, 12, 5, 28, 6, 29, 71, 6, 6, 0, 22, 0, 20, 57, 0, 0, 50,
+            25, 42, 78, 25, 25, 0, 23, 68, 0, 0, 47, 81, 23, 23, 137, 64, 68, 0, 0, 0
+        }
+    },
+    [2] = {
+        {
+            0, 0, 0, 15, 20, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 14, 20, 0,
+            70, 0, 0, 0, 10, 0, 0, 0, 24, 0, 15, 20, 0, 69, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 59, 15, 15, 15, 19, 15, 15, 14, 32, 40, 20, 83, 20, 19, 20,
+            30, 20, 19, 20, 40, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 144, 71, 61, 71, 78,
+            71, 72, 68, 82, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 10, 0, 0, 0, 21, 0,
+            10, 0, 0, 0, 24, 20, 10, 10, 10, 32, 0, 0, 0, 23, 0, 0, 22, 0, 24, 49
+        },
+        {
+            0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0, 22, 21, 20, 10, 11,
+            9, 10, 136, 11, 10, 10, 9, 38, 11, 30, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15,
+            37, 15, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15, 36, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 26, 0, 0, 0, 0, 127, 0, 0, 0, 0, 26, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 26, 0, 255, 127, 127, 127, 127, 149, 127, 0,
+            0, 0, 0, 27, 0, 0, 0, 0, 26, 0, 0, 0, 25, 0, 0, 24, 0, 54, 27, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 28, 0, 27, 70, 0, 0, 0, 15, 0, 0, 0, 6, 0, 27, 0, 27, 69,
+            0, 0, 30, 14, 15, 15, 17, 15, 35, 14, 37, 59, 14, 15, 0, 0, 0, 6, 0, 27,
+            0, 27, 71, 0, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 6, 0, 25, 0,
+            25, 72, 0, 0, 14, 5, 32, 7, 35, 74, 6, 6, 0, 24, 0, 22, 61, 0, 0, 56,
+            27, 49, 83, 28, 28, 0, 27, 71, 0, 0, 56, 86, 26, 26, 144, 68, 71, 0, 0, 0
+        },
+        {
+            15, 7, 7, 20, 7, 32, 7, 7, 6, 7, 7, 7, 6, 7, 7, 0, 0, 14, 0, 24,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 15, 0, 24, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 30, 14, 33, 15, 15, 15, 15, 14, 15, 15, 14, 15, 0, 24, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 50, 22, 24, 20, 23, 24, 23, 22, 22, 24, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 20, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 14, 20, 0,
+            70, 0, 0, 0, 10, 0, 0, 0, 24, 0, 15, 20, 0, 69, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 59, 15, 15, 15, 19, 15, 15, 14, 32, 40, 20, 83, 20, 19, 20,
+            30, 20, 19, 20, 40, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 144, 71, 61, 71, 78,
+            71, 72, 68, 82, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 10, 0, 0, 0, 21, 0,
+            10, 0, 0, 0, 24, 20, 10, 10, 10, 32, 0, 0, 0, 23, 0, 0, 22, 0, 24, 49
+        },
+        {
+            5, 2, 2, 17, 11, 8, 42, 2, 2, 2, 7, 2, 2, 2, 14, 0, 0, 14, 9, 6,
+            40, 0, 0, 0, 4, 0, 0, 0, 12, 0, 15, 9, 6, 40, 0, 0, 0, 4, 0, 0,
+            0, 12, 30, 20, 19, 40, 15, 15, 15, 16, 15, 15, 14, 25, 18, 14, 46, 9, 8, 9,
+            14, 9, 9, 9, 19, 11, 45, 6, 5, 5, 10, 5, 5, 5, 17, 80, 40, 40, 40, 43,
+            40, 40, 40, 48, 0, 0, 0, 4, 0, 0, 0, 12, 0, 0, 4, 0, 0, 0, 11, 0,
+            4, 0, 0, 0, 12, 9, 4, 4, 4, 16, 0, 0, 0, 12, 0, 0, 11, 0, 12, 25
+        },
+        {
+            0, 0, 0, 15, 20, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 14, 20, 0,
+            70, 0, 0, 0, 10, 0, 0, 0, 24, 0, 15, 20, 0, 69, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 59, 15, 15, 15, 19, 15, 15, 14, 32, 40, 20, 83, 20, 19, 20,
+            30, 20, 19, 20, 40, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 144, 71, 61, 71, 78,
+            71, 72, 68, 82, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 10, 0, 0, 0, 21, 0,
+            10, 0, 0, 0, 24, 20, 10, 10, 10, 32, 0, 0, 0, 23, 0, 0, 22, 0, 24, 49
+        },
+        {
+            5, 2, 2, 17, 2, 8, 2, 4, 2, 15, 2, 10, 42, 2, 2, 0, 0, 14, 0, 6,
+            0, 2, 0, 13, 0, 8, 40, 0, 0, 0, 15, 0, 6, 0, 2, 0, 13, 0, 8, 40,
+            0, 0, 30, 14, 19, 15, 16, 15, 25, 14, 21, 40, 14, 15, 0, 5, 0, 2, 0, 13,
+            0, 8, 40, 0, 0, 11, 5, 7, 5, 18, 6, 13, 44, 5, 5, 0, 2, 0, 12, 0,
+            7, 40, 0, 0, 4, 2, 14, 2, 10, 41, 2, 2, 0, 11, 0, 6, 40, 0, 0, 26,
+            13, 19, 48, 13, 13, 0, 8, 40, 0, 0, 15, 46, 7, 8, 80, 40, 40, 0, 0, 0
+        },
+        {
+            0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0, 22, 21, 20, 10, 11,
+            9, 10, 136, 11, 10, 10, 9, 38, 11, 30, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15,
+            37, 15, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15, 36, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 26, 0, 0, 0, 0, 127, 0, 0, 0, 0, 26, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 26, 0, 255, 127, 127, 127, 127, 149, 127, 0,
+            0, 0, 0, 27, 0, 0, 0, 0, 26, 0, 0, 0, 25, 0, 0, 24, 0, 54, 27, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 28, 0, 27, 70, 0, 0, 0, 15, 0, 0, 0, 6, 0, 27, 0, 27, 69,
+            0, 0, 30, 14, 15, 15, 17, 15, 35, 14, 37, 59, 14, 15, 0, 0, 0, 6, 0, 27,
+            0, 27, 71, 0, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 6, 0, 25, 0,
+            25, 72, 0, 0, 14, 5, 32, 7, 35, 74, 6, 6, 0, 24, 0, 22, 61, 0, 0, 56,
+            27, 49, 83, 28, 28, 0, 27, 71, 0, 0, 56, 86, 26, 26, 144, 68, 71, 0, 0, 0
+        },
+        {
+            0, 0, 0, 15, 20, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 14, 20, 0,
+            70, 0, 0, 0, 10, 0, 0, 0, 24, 0, 15, 20, 0, 69, 0, 0, 0, 10, 0, 0,
+            0, 24, 30, 28, 15, 59, 15, 15, 15, 19, 15, 15, 14, 32, 40, 20, 83, 20, 19, 20,
+            30, 20, 19, 20, 40, 0, 71, 0, 0, 0, 10, 0, 0, 0, 24, 144, 71, 61, 71, 78,
+            71, 72, 68, 82, 0, 0, 0, 10, 0, 0, 0, 24, 0, 0, 10, 0, 0, 0, 21, 0,
+            10, 0, 0, 0, 24, 20, 10, 10, 10, 32, 0, 0, 0, 23, 0, 0, 22, 0, 24, 49
+        },
+        {
+            0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0, 22, 21, 20, 10, 11,
+            9, 10, 136, 11, 10, 10, 9, 38, 11, 30, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15,
+            37, 15, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15, 36, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 26, 0, 0, 0, 0, 127, 0, 0, 0, 0, 26, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 26, 0, 255, 127, 127, 127, 127, 149, 127, 0,
+            0, 0, 0, 27, 0, 0, 0, 0, 26, 0, 0, 0, 25, 0, 0, 24, 0, 54, 27, 0
+        },
+        {
+            5, 2, 2, 17, 2, 8, 2, 4, 2, 15, 2, 10, 39, 2, 2, 0, 0, 14, 0, 6,
+            0, 2, 0, 13, 0, 8, 36, 0, 0, 0, 15, 0, 6, 0, 2, 0, 13, 0, 8, 36,
+            0, 0, 30, 14, 20, 15, 16, 15, 25, 14, 21, 38, 14, 15, 0, 5, 0, 2, 0, 13,
+            0, 8, 36, 0, 0, 11, 5, 7, 5, 18, 6, 13, 41, 5, 5, 0, 2, 0, 12, 0,
+            7, 37, 0, 0, 4, 2, 14, 2, 10, 38, 2, 2, 0, 11, 0, 6, 31, 0, 0, 26,
+            13, 19, 44, 13, 13, 0, 8, 37, 0, 0, 15, 42, 7, 8, 74, 35, 37, 0, 0, 0
+        },
+        {
+            0, 11, 15, 15, 0, 0, 0, 0, 127, 0, 0, 0, 0, 27, 0, 22, 21, 20, 10, 11,
+            9, 10, 136, 11, 10, 10, 9, 38, 11, 30, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15,
+            37, 15, 30, 14, 15, 15, 15, 142, 15, 14, 15, 15, 36, 15, 0, 0, 0, 0, 127, 0,
+            0, 0, 0, 26, 0, 0, 0, 0, 127, 0, 0, 0, 0, 26, 0, 0, 0, 127, 0, 0,
+            0, 0, 24, 0, 0, 127, 0, 0, 0, 0, 26, 0, 255, 127, 127, 127, 127, 149, 127, 0,
+            0, 0, 0, 27, 0, 0, 0, 0, 26, 0, 0, 0, 25, 0, 0, 24, 0, 54, 27, 0
+        },
+        {
+            0, 0, 0, 15, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 0, 14, 0, 0,
+            0, 6, 0, 28, 0, 27, 70, 0, 0, 0, 15, 0, 0, 0, 6, 0, 27, 0, 27, 69,
+            0, 0, 30, 14, 15, 15, 17, 15, 35, 14, 37, 59, 14, 15, 0, 0, 0, 6, 0, 27,
+            0, 27, 71, 0, 0, 0, 0, 7, 0, 28, 0, 28, 71, 0, 0, 0, 6, 0, 25, 0,
+            25, 72, 0, 0, 14, 5, 32, 7, 35, 74, 6, 6, 0, 24, 0, 22, 61, 0, 0, 56,
+            27, 49, 83, 28, 28, 0, 27, 71, 0, 0, 56, 86, 26, 26, 144, 68, 71, 0, 0, 0
+        }
+    }
+};
+#endif
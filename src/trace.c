@@ -0,0 +1,270 @@
+#define _DEFAULT_SOURCE
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+    TRACE_RING_EVENTS = 1 << 14,  // power of two, per thread
+    TRACE_MAX_THREADS = 128,
+    TRACE_NAME_SIZE   = 32,
+    TRACE_MAX_NESTING = 64,       // open spans per thread that can be recorded
+    TRACE_FLUSH_MS    = 10
+};
+
+typedef struct {
+    uint64_t ns;                  // CLOCK_MONOTONIC
+    const char* name;
+    int64_t value;                // counters
+    char phase;
+} TraceEvent;
+
+// Single producer (the owning thread), single consumer (the flusher).
+// head and tail only grow; slots are indexed modulo the size.
+typedef struct {
+    _Alignas(64) atomic_uint head;
+    _Alignas(64) atomic_uint tail;
+    atomic_bool retired;          // the thread has exited: free once drained
+    int tid;
+    char name[TRACE_NAME_SIZE];   // copied once, when the ring is made
+    TraceEvent events[TRACE_RING_EVENTS];
+} TraceRing;
+
+atomic_bool gTraceOn;
+
+static struct {
+    _Atomic(TraceRing*) rings[TRACE_MAX_THREADS];  // NULL: free
+    atomic_int ringCount;         // slots ever used; rings live below it
+    pthread_mutex_t claimLock;    // taking a free slot
+    pthread_key_t exitKey;        // retires a thread's ring when it exits
+    pthread_once_t once;
+    atomic_int nextTid;
+    atomic_uint session;          // bumped per capture
+    atomic_ullong dropped;
+
+    // Controlling thread, and the flusher while it runs
+    FILE* file;
+    bool first;                   // no event written yet
+    uint64_t base;                // capture start, time zero in the file
+    pthread_t flusher;
+    atomic_bool flushing;
+} gTrace = { .once = PTHREAD_ONCE_INIT };
+
+static _Thread_local TraceRing* tRing;
+static _Thread_local bool tNoRing;  // out of slots or memory: this thread is not traced
+static _Thread_local char tName[TRACE_NAME_SIZE];
+
+// Open spans of this thread, one bit each (innermost lowest): whether its
+// begin made it into the ring, so its end is dropped along with it. They
+// belong to one capture: spans left open when it stopped are forgotten at
+// the thread's first event in the next.
+static _Thread_local uint64_t tOpen;
+static _Thread_local int tDepth;
+static _Thread_local unsigned tSession;
+
+static uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int RingCount(void)
+{
+    return atomic_load(&gTrace.ringCount);
+}
+
+static void RetireRing(void* ring)
+{
+    atomic_store_explicit(&((TraceRing*)ring)->retired, true, memory_order_release);
+}
+
+static void InitOnce(void)
+{
+    pthread_mutex_init(&gTrace.claimLock, NULL);
+    pthread_key_create(&gTrace.exitKey, RetireRing);
+}
+
+// The calling thread's ring, made on its first event in a free slot. The
+// slot comes back once the thread has exited and its events are drained.
+static TraceRing* ThreadRing(void)
+{
+    if (tRing != NULL || tNoRing) return tRing;
+
+    pthread_once(&gTrace.once, InitOnce);
+    TraceRing* r = calloc(1, sizeof(TraceRing));
+    int slot = -1;
+    if (r != NULL) {
+        pthread_mutex_lock(&gTrace.claimLock);
+        for (int i = 0; i < TRACE_MAX_THREADS && slot < 0; ++i) {
+            if (atomic_load_explicit(&gTrace.rings[i], memory_order_relaxed) == NULL) slot = i;
+        }
+        if (slot >= 0) {
+            r->tid = atomic_fetch_add(&gTrace.nextTid, 1) + 1;
+            if (tName[0] != '\0') memcpy(r->name, tName, sizeof(r->name));
+            else snprintf(r->name, sizeof(r->name), "thread %d", r->tid);
+            atomic_store_explicit(&gTrace.rings[slot], r, memory_order_release);
+            if (slot >= atomic_load(&gTrace.ringCount)) atomic_store(&gTrace.ringCount, slot + 1);
+        }
+        pthread_mutex_unlock(&gTrace.claimLock);
+    }
+    if (slot < 0) {
+        free(r);
+        tNoRing = true;
+        return NULL;
+    }
+    pthread_setspecific(gTrace.exitKey, r);
+    tRing = r;
+    return r;
+}
+
+void TraceThreadName(const char* name)
+{
+    snprintf(tName, sizeof(tName), "%s", name);
+}
+
+// Ends always fit: everything else leaves room for one per open span
+void TraceRecord(char phase, const char* name, int64_t value)
+{
+    TraceRing* r = ThreadRing();
+    if (r == NULL) return;
+    unsigned session = atomic_load_explicit(&gTrace.session, memory_order_relaxed);
+    if (tSession != session) {
+        tSession = session;
+        tDepth = 0;
+        tOpen = 0;
+    }
+
+    bool keep = true;
+    if (phase == 'E') {
+        if (tDepth == 0) return;  // its begin came before the capture
+        keep = tDepth <= TRACE_MAX_NESTING && (tOpen & 1);
+        if (tDepth <= TRACE_MAX_NESTING) tOpen >>= 1;
+        tDepth--;
+    }
+
+    unsigned head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    unsigned room = phase == 'E' ? TRACE_RING_EVENTS : TRACE_RING_EVENTS - TRACE_MAX_NESTING;
+    if (keep && head - tail >= room) keep = false;
+
+    if (phase == 'B') {
+        keep = keep && tDepth < TRACE_MAX_NESTING;
+        if (tDepth < TRACE_MAX_NESTING) tOpen = (tOpen << 1) | keep;
+        tDepth++;
+    }
+    if (!keep) {
+        atomic_fetch_add_explicit(&gTrace.dropped, 1, memory_order_relaxed);
+        return;
+    }
+    r->events[head & (TRACE_RING_EVENTS - 1)] = (TraceEvent){ NowNs(), name, value, phase };
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+static void WriteEvent(const TraceRing* r, const TraceEvent* e)
+{
+    if (e->ns < gTrace.base) return;  // left over from an earlier capture
+    uint64_t ns = e->ns - gTrace.base;
+    char line[256];
+    int n = snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%d",
+                     gTrace.first ? "" : ",\n", e->name, e->phase, (unsigned long long)(ns / 1000),
+                     (unsigned)(ns % 1000), r->tid);
+    if (e->phase == 'C' && n > 0 && n < (int)sizeof(line)) {
+        n += snprintf(line + n, sizeof(line) - (size_t)n, ",\"args\":{\"value\":%lld}", (long long)e->value);
+    }
+    if (n <= 0 || n >= (int)sizeof(line) - 1) return;  // a name too long for the line
+    line[n++] = '}';
+    fwrite(line, 1, (size_t)n, gTrace.file);
+    gTrace.first = false;
+}
+
+static void WriteThreadName(const TraceRing* r)
+{
+    fprintf(gTrace.file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            gTrace.first ? "" : ",\n", r->tid, r->name);
+    gTrace.first = false;
+}
+
+// With write, everything recorded so far goes to the file; without, it is
+// skipped. Rings of exited threads are freed once empty, named in the file
+// first if they were written to it.
+static void Drain(bool write)
+{
+    for (int i = 0; i < RingCount(); ++i) {
+        TraceRing* r = atomic_load_explicit(&gTrace.rings[i], memory_order_acquire);
+        if (r == NULL) continue;
+        bool retired = atomic_load_explicit(&r->retired, memory_order_acquire);
+        unsigned tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&r->head, memory_order_acquire);
+        for (; write && tail != head; ++tail) WriteEvent(r, &r->events[tail & (TRACE_RING_EVENTS - 1)]);
+        atomic_store_explicit(&r->tail, head, memory_order_release);
+        if (retired) {
+            if (write) WriteThreadName(r);
+            atomic_store_explicit(&gTrace.rings[i], NULL, memory_order_release);
+            free(r);
+        }
+    }
+}
+
+static void* FlusherMain(void* arg)
+{
+    (void)arg;
+    struct timespec pause = { 0, TRACE_FLUSH_MS * 1000000L };
+    while (atomic_load(&gTrace.flushing)) {
+        Drain(true);
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+bool TraceStart(const char* path)
+{
+    if (gTrace.file != NULL) return false;
+    FILE* f = fopen(path, "w");
+    if (f == NULL) return false;
+
+    gTrace.file = f;
+    gTrace.first = true;
+    gTrace.base = NowNs();
+    atomic_fetch_add(&gTrace.session, 1);
+    atomic_store(&gTrace.dropped, 0);
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+    Drain(false);
+
+    atomic_store(&gTrace.flushing, true);
+    if (pthread_create(&gTrace.flusher, NULL, FlusherMain, NULL) != 0) {
+        atomic_store(&gTrace.flushing, false);
+        fclose(f);
+        gTrace.file = NULL;
+        return false;
+    }
+    atomic_store(&gTraceOn, true);
+    return true;
+}
+
+void TraceStop(void)
+{
+    if (gTrace.file == NULL) return;
+    atomic_store(&gTraceOn, false);
+    atomic_store(&gTrace.flushing, false);
+    pthread_join(gTrace.flusher, NULL);
+    Drain(true);
+
+    for (int i = 0; i < RingCount(); ++i) {
+        TraceRing* r = atomic_load_explicit(&gTrace.rings[i], memory_order_acquire);
+        if (r != NULL) WriteThreadName(r);
+    }
+    fputs("\n]}\n", gTrace.file);
+    fclose(gTrace.file);
+    gTrace.file = NULL;
+
+    unsigned long long dropped = atomic_load(&gTrace.dropped);
+    if (dropped > 0) fprintf(stderr, "trace: %llu events dropped (ring full)\n", dropped);
+}
+
+bool TraceRunning(void)
+{
+    return gTrace.file != NULL;
+}
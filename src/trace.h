@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Event tracing to Chrome Trace / Perfetto JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+// Every thread that records gets its own ring of events: the thread is the
+// only writer and a flusher thread the only reader, so recording never
+// takes a lock. The flusher drains the rings into the file every few
+// milliseconds. A full ring drops events (counted, reported at stop) rather
+// than stall the thread being measured. A thread's ring is freed after the
+// thread exits and its events are drained, so threads may come and go;
+// up to 128 are traced at once.
+//
+// Off, each probe is one relaxed load and a branch. TraceStart/TraceStop
+// may be called at any time, from one controlling thread.
+//
+// Names must be string literals (or otherwise outlive the capture): only
+// the pointer is recorded.
+
+#define TRACE_FILE "reef.trace.json"  // captures started from the client's key
+
+extern atomic_bool gTraceOn;
+
+#define TRACE_BEGIN(name)          do { if (atomic_load_explicit(&gTraceOn, memory_order_relaxed)) TraceRecord('B', name, 0); } while (0)
+#define TRACE_END(name)            do { if (atomic_load_explicit(&gTraceOn, memory_order_relaxed)) TraceRecord('E', name, 0); } while (0)
+#define TRACE_COUNTER(name, value) do { if (atomic_load_explicit(&gTraceOn, memory_order_relaxed)) TraceRecord('C', name, (int64_t)(value)); } while (0)
+
+// Begin writing a capture to path; false if it cannot be created or one is
+// already running
+bool TraceStart(const char* path);
+
+// Flush what is left, finish the file and turn the probes off
+void TraceStop(void);
+
+bool TraceRunning(void);
+
+// Label the calling thread in captures; cheap, call it whether or not a
+// capture is running
+void TraceThreadName(const char* name);
+
+// Use the macros; phase is 'B', 'E' or 'C'
+void TraceRecord(char phase, const char* name, int64_t value);
+
+#endif
@@ -0,0 +1,259 @@
+#include "tree.h"
+#include "cards.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+    TREE_VISIT_BUCKETS = 17  // zero, then one per power of two of a uint16_t
+};
+
+static TreeNode* ArenaAt(const TreeArena* a, uint32_t index)
+{
+    return &a->blocks[index / TREE_BLOCK_NODES][index % TREE_BLOCK_NODES];
+}
+
+static bool ArenaInit(TreeArena* a, uint32_t maxNodes)
+{
+    memset(a, 0, sizeof(*a));
+    a->blockCap = (int)(maxNodes / TREE_BLOCK_NODES) + 2;
+    a->blocks = calloc((size_t)a->blockCap, sizeof(TreeNode*));
+    if (a->blocks == NULL) return false;
+    pthread_mutex_init(&a->growLock, NULL);
+    return true;
+}
+
+// Give the blocks back; the arena is empty afterwards
+static void ArenaReset(TreeArena* a)
+{
+    for (int b = 0; b < a->blockCap; ++b) {
+        free(a->blocks[b]);
+        a->blocks[b] = NULL;
+    }
+    atomic_store(&a->next, 0);
+}
+
+static void ArenaFree(TreeArena* a)
+{
+    if (a->blocks == NULL) return;
+    ArenaReset(a);
+    free(a->blocks);
+    pthread_mutex_destroy(&a->growLock);
+    a->blocks = NULL;
+}
+
+// count nodes from the arena, allocating blocks as the range reaches them
+static uint32_t ArenaReserve(TreeArena* a, uint32_t count)
+{
+    uint32_t first = atomic_load_explicit(&a->next, memory_order_relaxed);
+    do {
+        if (count > a->limit || first > a->limit - count) return TREE_NONE;
+    } while (!atomic_compare_exchange_weak(&a->next, &first, first + count));
+
+    int last = (int)((first + count - 1) / TREE_BLOCK_NODES);
+    bool ok = last < a->blockCap;
+    pthread_mutex_lock(&a->growLock);
+    for (int b = (int)(first / TREE_BLOCK_NODES); ok && b <= last; ++b) {
+        if (a->blocks[b] == NULL) a->blocks[b] = malloc(sizeof(TreeNode) * TREE_BLOCK_NODES);
+        ok = a->blocks[b] != NULL;
+    }
+    pthread_mutex_unlock(&a->growLock);
+    return ok ? first : TREE_NONE;
+}
+
+bool TreeInit(Tree* t, size_t capBytes)
+{
+    memset(t, 0, sizeof(*t));
+    size_t nodes = capBytes / sizeof(TreeNode);
+    if (nodes < 16 * TREE_CHUNK_NODES) nodes = 16 * TREE_CHUNK_NODES;
+    if (nodes > UINT32_MAX / 2) nodes = UINT32_MAX / 2;
+    t->capNodes = (uint32_t)nodes;
+
+    if (!ArenaInit(&t->arenas[0], t->capNodes / 4 * 3) || !ArenaInit(&t->arenas[1], t->capNodes / 4 * 3)) {
+        ArenaFree(&t->arenas[0]);
+        return false;
+    }
+    t->arenas[0].limit = t->capNodes / 4 * 3;
+    t->root = TREE_NONE;
+    return true;
+}
+
+void TreeFree(Tree* t)
+{
+    ArenaFree(&t->arenas[0]);
+    ArenaFree(&t->arenas[1]);
+    t->root = TREE_NONE;
+}
+
+TreeNode* TreeNodeAt(const Tree* t, uint32_t index)
+{
+    return ArenaAt(&t->arenas[t->live], index);
+}
+
+void TreeApplyLine(GameState* g, const TreeNode* n)
+{
+    for (int i = 0; i < n->len; ++i) RulesApply(g, RulesActionFromId(n->line[i]));
+}
+
+uint32_t TreeAllocChildren(Tree* t, TreeCursor* c, int count)
+{
+    if (count <= 0 || count > TREE_CHUNK_NODES) return TREE_NONE;
+    if (c->epoch != t->epoch || c->end - c->next < (uint32_t)count) {
+        uint32_t first = ArenaReserve(&t->arenas[t->live], TREE_CHUNK_NODES);
+        if (first == TREE_NONE) {
+            atomic_store(&t->full, true);
+            return TREE_NONE;
+        }
+        *c = (TreeCursor){ first, first + TREE_CHUNK_NODES, t->epoch };
+    }
+    uint32_t first = c->next;
+    c->next += (uint32_t)count;
+    return first;
+}
+
+uint32_t TreeNodeCount(const Tree* t)
+{
+    const TreeArena* a = &t->arenas[t->live];
+    uint32_t n = atomic_load(&a->next);
+    return n < a->limit ? n : a->limit;
+}
+
+static int VisitBucket(uint16_t visits)
+{
+    int b = 0;
+    while (visits > 0) {
+        visits >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Children per bucket of their parent's visits
+static void CountChildren(const Tree* t, uint32_t index, uint64_t* hist)
+{
+    const TreeNode* n = TreeNodeAt(t, index);
+    if (n->firstChild == TREE_NONE || n->childCount == 0) return;
+    hist[VisitBucket(n->visits)] += n->childCount;
+    for (int k = 0; k < n->childCount; ++k) CountChildren(t, n->firstChild + (uint32_t)k, hist);
+}
+
+// Copy the subtree under the root into the spare arena, breadth first,
+// keeping the children of the most visited nodes that fit in a quarter of
+// the cap. The spare arena becomes the live one.
+static void Compact(Tree* t)
+{
+    TreeArena* from = &t->arenas[t->live];
+    TreeArena* to = &t->arenas[!t->live];
+    uint32_t keep = t->capNodes / 4;
+
+    uint64_t hist[TREE_VISIT_BUCKETS] = { 0 };
+    CountChildren(t, t->root, hist);
+    int minBucket = TREE_VISIT_BUCKETS;
+    uint64_t kept = 1;
+    while (minBucket > 0 && kept + hist[minBucket - 1] <= keep) kept += hist[--minBucket];
+
+    ArenaReset(to);
+    to->limit = keep;
+    uint32_t root = ArenaReserve(to, 1);
+    *ArenaAt(to, root) = *ArenaAt(from, t->root);
+    for (uint32_t i = root; i < atomic_load(&to->next); ++i) {
+        TreeNode* n = ArenaAt(to, i);
+        if (n->firstChild == TREE_NONE || n->childCount == 0) continue;
+        uint32_t first = VisitBucket(n->visits) >= minBucket ? ArenaReserve(to, n->childCount) : TREE_NONE;
+        if (first == TREE_NONE) {
+            n->firstChild = TREE_NONE;  // pruned: expanded again if searched again
+            n->childCount = 0;
+            continue;
+        }
+        for (int k = 0; k < n->childCount; ++k) {
+            *ArenaAt(to, first + (uint32_t)k) = *ArenaAt(from, n->firstChild + (uint32_t)k);
+        }
+        n->firstChild = first;
+    }
+
+    ArenaReset(from);
+    to->limit = t->capNodes / 4 * 3;
+    t->live = !t->live;
+    t->root = root;
+    t->epoch++;
+    atomic_store(&t->full, false);
+}
+
+void TreeCompactIfFull(Tree* t)
+{
+    if (t->root != TREE_NONE && atomic_load(&t->full)) Compact(t);
+}
+
+static bool Same(const GameState* a, const GameState* b)
+{
+    return memcmp(a, b, RulesStateSize(a)) == 0;
+}
+
+// a as seat sees it, for comparing with a position seen the same way
+static void AsSeen(GameState* out, const GameState* a, int seat)
+{
+    RulesCopyState(out, a);
+    CardsRedeal(out, seat, NULL);
+}
+
+// The expanded node under index whose position looks like seen to the
+// tree's seat, at most turns turns down, with its position in found. Only
+// the mover's Player changes during a turn, so a child where the seat
+// moved and its Player already differs is not followed.
+static uint32_t Find(const Tree* t, uint32_t index, const GameState* state, const GameState* seen, int turns,
+                     GameState* found)
+{
+    const TreeNode* n = TreeNodeAt(t, index);
+    if (n->firstChild == TREE_NONE) return TREE_NONE;
+    int mover = state->currentPlayer;
+    for (int k = 0; k < n->childCount; ++k) {
+        uint32_t child = n->firstChild + (uint32_t)k;
+        GameState next, view;
+        RulesCopyState(&next, state);
+        TreeApplyLine(&next, TreeNodeAt(t, child));
+        if (mover == t->seat && memcmp(&next.players[mover], &seen->players[mover], sizeof(Player)) != 0) continue;
+        AsSeen(&view, &next, t->seat);
+        if (Same(&view, seen)) {
+            RulesCopyState(found, &next);
+            return child;
+        }
+        if (turns > 1 && !next.gameEnded) {
+            uint32_t deeper = Find(t, child, &next, seen, turns - 1, found);
+            if (deeper != TREE_NONE) return deeper;
+        }
+    }
+    return TREE_NONE;
+}
+
+bool TreeSetRoot(Tree* t, const GameState* g, const GameState* sample, int seat)
+{
+    if (t->root != TREE_NONE && t->seat == seat && t->rootState.playersCount == g->playersCount) {
+        GameState seen, view, found;
+        AsSeen(&seen, g, seat);
+        AsSeen(&view, &t->rootState, seat);
+        uint32_t at;
+        if (Same(&view, &seen)) {
+            at = t->root;
+            RulesCopyState(&found, &t->rootState);
+        } else {
+            at = Find(t, t->root, &t->rootState, &seen, g->playersCount, &found);
+        }
+        if (at != TREE_NONE) {
+            if (at != t->root) {
+                t->root = at;
+                Compact(t);  // everything off the new root is garbage
+            }
+            RulesCopyState(&t->rootState, &found);
+            return true;
+        }
+    }
+
+    TreeArena* a = &t->arenas[t->live];
+    ArenaReset(a);
+    t->epoch++;
+    atomic_store(&t->full, false);
+    t->root = ArenaReserve(a, 1);
+    *TreeNodeAt(t, t->root) = (TreeNode){ .firstChild = TREE_NONE };
+    RulesCopyState(&t->rootState, sample);
+    t->seat = seat;
+    return false;
+}
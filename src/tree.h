@@ -0,0 +1,99 @@
+#ifndef TREE_H
+#define TREE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "rules.h"
+
+// Search tree over whole turns, kept from one move to the next.
+//
+// Nodes are 16 bytes: the turn that leads to the node as action ids
+// (RulesActionId), its children as a range of consecutive indices, a
+// score and a visit count. Positions are not stored; a searcher rebuilds a
+// child's state by applying its line to the parent's. Nodes live in large
+// blocks and are named by 32-bit index. Each searching thread bump-allocates
+// from its own chunk (TreeCursor), so threads only meet on one atomic add
+// per chunk.
+//
+// Memory is capped. The search may fill three quarters of the cap; past
+// that allocation fails and the searcher carries on without storing. The
+// tree is then compacted into the remaining quarter, dropping the children
+// of the least visited nodes first. A child is searched at most once per
+// search of its parent, so visits never grow going down: whatever survives
+// still hangs from the root.
+//
+// When the game moves on, TreeSetRoot finds the new position among the
+// turns already expanded and makes that node the root, keeping what was
+// searched below it. The tree is searched on a redeal of the cards its
+// seat has not seen (CardsRedeal), so positions are matched as the seat
+// sees them and the tree keeps its own deal.
+//
+// Threads may expand disjoint subtrees at the same time; everything else
+// (setting the root, compacting) happens while no search runs.
+
+#define TREE_NONE UINT32_MAX
+
+enum {
+    TREE_MAX_LINE    = 3,         // play a card, then two placements
+    TREE_BLOCK_NODES = 1 << 16,
+    TREE_CHUNK_NODES = 4096       // per-thread allocation unit; more than any node's children
+};
+
+typedef struct {
+    uint32_t firstChild;          // TREE_NONE until expanded
+    uint16_t visits;              // saturating
+    uint16_t childCount;
+    float score;                  // static or last searched value, for the tree's seat
+    uint8_t line[TREE_MAX_LINE];  // action ids of the turn into this node
+    uint8_t len;
+} TreeNode;
+
+typedef struct {
+    TreeNode** blocks;
+    int blockCap;
+    atomic_uint next;             // nodes handed out
+    uint32_t limit;
+    pthread_mutex_t growLock;     // block allocation
+} TreeArena;
+
+typedef struct {
+    uint32_t next, end;
+    unsigned epoch;               // arena the chunk belongs to
+} TreeCursor;
+
+typedef struct {
+    TreeArena arenas[2];          // live one, and the target of the next compaction
+    int live;
+    unsigned epoch;               // bumped when nodes move; stale cursors start over
+    uint32_t capNodes;
+    atomic_bool full;             // an allocation failed since the last compaction
+
+    uint32_t root;
+    GameState rootState;          // the position searched: the seat's view of the game, redealt
+    int seat;                     // player the scores are for
+} Tree;
+
+bool TreeInit(Tree* t, size_t capBytes);
+void TreeFree(Tree* t);
+
+TreeNode* TreeNodeAt(const Tree* t, uint32_t index);
+
+// Play the node's turn on g (the parent's position)
+void TreeApplyLine(GameState* g, const TreeNode* n);
+
+// count consecutive nodes for one node's children; TREE_NONE when the
+// arena is at its limit (and the tree is flagged full)
+uint32_t TreeAllocChildren(Tree* t, TreeCursor* c, int count);
+
+// Root the tree at g for seat: reuse the node that looks like g to seat,
+// reached by up to one turn per player from the current root, else start
+// over from sample (g redealt for seat). True on reuse. Search from
+// rootState either way.
+bool TreeSetRoot(Tree* t, const GameState* g, const GameState* sample, int seat);
+
+// If full, prune into the spare arena; nodes move, cursors go stale
+void TreeCompactIfFull(Tree* t);
+
+uint32_t TreeNodeCount(const Tree* t);
+
+#endif
@@ -2,6 +2,7 @@
 #include "assets.h"
 #include "constants.h"
 #include "patterns.h"
+#include "cards.h"
 #include <stdio.h>
 
 // Helper function to draw text with custom font and 10% larger size
@@ -51,35 +52,85 @@ static void DrawPointToken(int x, int y, int points)
     DrawTextCustom(text, x + radius - textWidth/2, y + radius - 5, 10, BLACK);
 }
 
+static const Color PLAYER_COLOR[PLAYERS_MAX] = { BLUE, RED, DARKGREEN, PURPLE };
+
+void UI_ComputeLayout(int players, UiLayout* out)
+{
+    if (players <= 2) {
+        *out = (UiLayout){
+            .cellSize = UI_CELL_SIZE,
+            .handStep = UI_CARD_W + UI_CARD_GAP,
+            .boardX = { UI_BOARD1_X, UI_BOARD2_X }, .boardY = { UI_BOARD1_Y, UI_BOARD2_Y },
+            .handX = { UI_HAND1_X, UI_HAND2_X },    .handY = { UI_HAND1_Y, UI_HAND2_Y }
+        };
+        return;
+    }
+
+    out->cellSize = UI_GRID_CELL_SIZE;
+    out->handStep = UI_GRID_HAND_STEP;
+    for (int p = 0; p < PLAYERS_MAX; ++p) {
+        out->boardX[p] = UI_GRID_X + (p % 2) * UI_GRID_COL_W;
+        out->boardY[p] = UI_GRID_Y + (p / 2) * UI_GRID_ROW_H;
+        out->handX[p] = out->boardX[p] + BOARD_SIZE * UI_GRID_CELL_SIZE + UI_GRID_HAND_GAP;
+        out->handY[p] = out->boardY[p] + 30;
+    }
+}
+
 void UI_DrawBackground(void)
 {
     ClearBackground(LIGHTGRAY);
 }
 
-void UI_DrawPlayerBoard(const Player* p, int ox, int oy, bool highlightValid, CoralColor placeColor)
+// Cool-to-warm shade for a hint value within the map's range
+static Color HintColor(const HintMap* hint, float v)
+{
+    float t = hint->max > hint->min ? (v - hint->min) / (hint->max - hint->min) : 1.0f;
+    return (Color){ (unsigned char)(40 + 215 * t), (unsigned char)(120 - 40 * t),
+                    (unsigned char)(255 - 255 * t), (unsigned char)(40 + 100 * t) };
+}
+
+// Marker for a card the next piece would help: the card being placed,
+// a hand card, or one the player could still take
+static Color OpportunityColor(int slot, Color playerColor)
+{
+    if (slot == OPPORTUNITY_PLAYING) return GOLD;
+    if (slot < OPPORTUNITY_DISPLAY) return playerColor;
+    return slot == OPPORTUNITY_DECK ? BLACK : DARKGRAY;
+}
+
+void UI_DrawPlayerBoard(const Player* p, int ox, int oy, int cell, bool highlightValid, CoralColor placeColor,
+                        const HintMap* hint, const OpportunityIndex* opportunity)
 {
+    int boardSize = cell * BOARD_SIZE;
+    int layer = cell * 15 / UI_CELL_SIZE;  // stacked pieces step up 15px at full size
+
     // Draw gameboard background texture if available (scaled from 1024x1024 to 512x512)
     if (gAssets.gameboardLoaded) {
         Rectangle src = { 0, 0, (float)gAssets.gameboard.width, (float)gAssets.gameboard.height };
-        Rectangle dst = { (float)ox, (float)oy, (float)UI_BOARD_SIZE, (float)UI_BOARD_SIZE };
+        Rectangle dst = { (float)ox, (float)oy, (float)boardSize, (float)boardSize };
         Vector2 origin = { 0, 0 };
         DrawTexturePro(gAssets.gameboard, src, dst, origin, 0.0f, WHITE);
     }
     
     // Draw board background/grid with player-specific border color
-    Color boardBorderColor = (p->id == 0) ? BLUE : RED;
-    DrawRectangleLines(ox, oy, UI_BOARD_SIZE, UI_BOARD_SIZE, boardBorderColor);
+    Color playerColor = PLAYER_COLOR[p->id];
+    DrawRectangleLines(ox, oy, boardSize, boardSize, playerColor);
     
     for (int r = 0; r < BOARD_SIZE; ++r) {
         for (int c = 0; c < BOARD_SIZE; ++c) {
-            int x = ox + c * UI_CELL_SIZE;
-            int y = oy + r * UI_CELL_SIZE;
+            int x = ox + c * cell;
+            int y = oy + r * cell;
 
             const CoralStack* s = &p->board[r][c];
             
             // Highlight valid placement positions
             if (highlightValid && s->height < MAX_STACK_HEIGHT) {
-                DrawRectangle(x, y, UI_CELL_SIZE, UI_CELL_SIZE, (Color){0, 255, 0, 50});
+                DrawRectangle(x, y, cell, cell, (Color){0, 255, 0, 50});
+            }
+
+            // Hint heatmap: how good the next piece is on this cell
+            if (hint != NULL && hint->legal[r][c]) {
+                DrawRectangle(x, y, cell, cell, HintColor(hint, hint->value[r][c]));
             }
             
             // Draw cell border
@@ -87,34 +138,54 @@ void UI_DrawPlayerBoard(const Player* p, int ox, int oy, bool highlightValid, Co
             if (highlightValid && s->height < MAX_STACK_HEIGHT) {
                 cellBorderColor = GREEN;
             }
-            DrawRectangleLines(x, y, UI_CELL_SIZE, UI_CELL_SIZE, cellBorderColor);
+            DrawRectangleLines(x, y, cell, cell, cellBorderColor);
 
             // Draw all coral pieces in the stack with transparency
             for (int stackLevel = 0; stackLevel < s->height; ++stackLevel) {
                 CoralColor color = s->pieces[stackLevel];
-                // Offset each stacked piece by 15 pixels to show layering clearly (scaled for smaller cells)
-                int offsetY = stackLevel * 15;
-                DrawCoralPiece(x, y - offsetY, UI_CELL_SIZE, color);
+                // Offset each stacked piece to show layering clearly
+                int offsetY = stackLevel * layer;
+                DrawCoralPiece(x, y - offsetY, cell, color);
             }
             
             // Preview the coral piece being placed
             if (highlightValid && placeColor != CORAL_NONE && s->height < MAX_STACK_HEIGHT) {
-                int previewOffsetY = s->height * 15;
+                int previewOffsetY = s->height * layer;
                 Color previewTint = CORAL_COLOR_MAP[placeColor];
                 previewTint.a = 100; // Semi-transparent preview
-                DrawRectangle(x + 8, y - previewOffsetY + 8, 
-                             UI_CELL_SIZE - 16, UI_CELL_SIZE - 16, previewTint);
+                DrawRectangle(x + cell / 12, y - previewOffsetY + cell / 12,
+                             cell - cell / 6, cell - cell / 6, previewTint);
             }
             
             // Draw stack height indicator if more than 1 (bigger font for visibility)
             if (s->height > 1) {
-                DrawTextCustom(TextFormat("%d", s->height), x + UI_CELL_SIZE - 18, y + 5, 16, BLACK);
+                DrawTextCustom(TextFormat("%d", s->height), x + cell - 18, y + 5, 16, BLACK);
+            }
+
+            if (hint != NULL && hint->legal[r][c]) {
+                DrawTextCustom(TextFormat("%.1f", hint->value[r][c]), x + 5, y + cell - 20, 12, BLACK);
+                if (r == hint->bestRow && c == hint->bestCol) {
+                    Rectangle best = { (float)x + 2, (float)y + 2, cell - 4, cell - 4 };
+                    DrawRectangleLinesEx(best, 4.0f, GOLD);
+                }
+            }
+
+            // One dot per visible card that would score more with the piece here,
+            // the card being placed first
+            if (opportunity != NULL && highlightValid && placeColor != CORAL_NONE && s->height < MAX_STACK_HEIGHT) {
+                const Opportunity* o = OpportunityAt(opportunity, r, c, placeColor);
+                int dot = cell / 12;
+                int shown = 0;
+                for (int slot = OPPORTUNITY_SLOTS - 1; slot >= 0; --slot) {
+                    if (o->delta[slot] <= 0) continue;
+                    DrawRectangle(x + 4 + shown * (dot + 2), y + 4, dot, dot, OpportunityColor(slot, playerColor));
+                    shown++;
+                }
             }
         }
     }
 
     // Draw player board title with background to make ownership clear (scaled)
-    Color playerColor = (p->id == 0) ? BLUE : RED;
     DrawRectangle(ox - 5, oy - 30, 200, 20, (Color){playerColor.r, playerColor.g, playerColor.b, 50});
     DrawTextCustom(TextFormat("Player %d Board", p->id + 1), ox, oy - 25, 16, playerColor);
     DrawTextCustom(TextFormat("Points: %d", p->points), ox, oy - 10, 14, BLACK);
@@ -196,7 +267,7 @@ void UI_DrawMarket(const GameState* g)
     for (int i = 0; i < CARD_DISPLAY_SIZE; ++i) {
         int x = UI_MARKET_X + i * (UI_CARD_W + UI_CARD_GAP);
         int y = UI_MARKET_Y;
-        UI_DrawCard(&g->display[i], x, y);
+        UI_DrawCard(CardGet(g->display[i]), x, y);
 
         // Point tokens indicator - always draw as circles with numbers (scaled)
         int t = g->displayTokens[i];
@@ -232,7 +303,7 @@ void UI_DrawDeck(const GameState* g)
     if (g->deckSize > 0) {
         int faceUpX = x;
         int faceUpY = y - 20;  // 20px above deck pile
-        UI_DrawCard(&g->deck[g->deckSize - 1], faceUpX, faceUpY);
+        UI_DrawCard(CardGet(g->deck[g->deckSize - 1]), faceUpX, faceUpY);
         
         // Draw hotkey label for deck card
         DrawTextCustom("D", faceUpX + 4, faceUpY + 4, 12, RED);
@@ -242,7 +313,7 @@ void UI_DrawDeck(const GameState* g)
     }
 }
 
-void UI_DrawHand(const Player* p, int x, int y, int selectedIndex)
+void UI_DrawHand(const Player* p, int x, int y, int step, int selectedIndex, const HintMap* hint)
 {
     // Highlight current player's hand title (scaled)
     Color titleColor = (selectedIndex == -1) ? RED : BLACK;
@@ -250,11 +321,22 @@ void UI_DrawHand(const Player* p, int x, int y, int selectedIndex)
     DrawTextCustom(TextFormat("P%d Hand%s", p->id + 1, turnIndicator), x, y - 18, 14, titleColor);
     
     for (int i = 0; i < p->handSize; ++i) {
-        int cx = x + i * (UI_CARD_W + UI_CARD_GAP);
-        UI_DrawCard(&p->hand[i], cx, y);
+        int cx = x + i * step;
+        UI_DrawCard(CardGet(p->hand[i]), cx, y);
         if (i == selectedIndex) {
             DrawRectangleLines(cx - 2, y - 2, UI_CARD_W + 4, UI_CARD_H + 4, RED);
         }
+
+        // Hint ranking: best value each card can reach this turn
+        if (hint != NULL && hint->card >= 0) {
+            if (i == hint->card) {
+                Rectangle best = { (float)cx - 3, (float)y - 3, UI_CARD_W + 6, UI_CARD_H + 6 };
+                DrawRectangleLinesEx(best, 3.0f, GOLD);
+            }
+            if (hint->complete) {
+                DrawTextCustom(TextFormat("%.1f", hint->handValue[i]), cx + 4, y + UI_CARD_H - 16, 10, DARKGREEN);
+            }
+        }
         
         // Only show hotkeys for current player (scaled)
         if (selectedIndex == -1) {
@@ -266,7 +348,8 @@ void UI_DrawHand(const Player* p, int x, int y, int selectedIndex)
 
 void UI_DrawSupplies(const GameState* g)
 {
-    DrawTextCustom("Supplies", UI_SUPPLY_X, UI_SUPPLY_Y - 18, 16, BLACK);
+    bool finalRound = g->finalRound && !g->gameEnded;
+    DrawTextCustom(finalRound ? "Supplies - final round" : "Supplies", UI_SUPPLY_X, UI_SUPPLY_Y - 18, 16, finalRound ? RED : BLACK);
 
     for (int i = 1; i <= 4; ++i) {
         int x = UI_SUPPLY_X + (i - 1) * 28;
@@ -276,9 +359,10 @@ void UI_DrawSupplies(const GameState* g)
     }
 }
 
-void UI_DrawTopBar(const GameState* g)
+void UI_DrawTopBar(const GameState* g, const char* status)
 {
     DrawTextCustom(TextFormat("Current Player: %d", g->currentPlayer + 1), 20, 20, 18, BLACK);
+    if (status != NULL) DrawTextCustom(status, 260, 22, 14, DARKBLUE);
     
     if (g->placement.active) {
         CoralColor currentColor = g->placement.piecesToPlace[g->placement.piecesPlaced];
@@ -289,6 +373,105 @@ void UI_DrawTopBar(const GameState* g)
         // Draw a preview of the coral being placed
         DrawCoralPiece(400, 35, 20, currentColor);
     } else {
-        DrawTextCustom("Actions: [1-3] Take Market | [D] Draw Deck (-1pt) | Play: [Q,W,E,R]", 20, 40, 12, BLACK);
+        DrawTextCustom(TextFormat("Actions: [1-3] Take Market | [D] Draw Deck (-1pt) | Play: [Q,W,E,R] | [Z/Y] Undo/Redo | [H] Hints | [F1-F%d] Computer",
+                                  g->playersCount), 20, 40, 12, BLACK);
+    }
+}
+
+void UI_DrawTitleScreen(float loadProgress, bool ready)
+{
+    ClearBackground((Color){ 10, 40, 70, 255 });
+
+    // Title art centered, scaled to fit above the progress bar
+    if (gAssets.titleLoaded) {
+        float maxH = SCREEN_HEIGHT - 120.0f;
+        float scale = maxH / (float)gAssets.title.height;
+        float w = gAssets.title.width * scale;
+        Rectangle src = { 0, 0, (float)gAssets.title.width, (float)gAssets.title.height };
+        Rectangle dst = { (SCREEN_WIDTH - w) / 2.0f, 30.0f, w, maxH };
+        DrawTexturePro(gAssets.title, src, dst, (Vector2){0,0}, 0.0f, WHITE);
+    } else {
+        DrawText("REEF", SCREEN_WIDTH / 2 - MeasureText("REEF", 80) / 2, SCREEN_HEIGHT / 2 - 80, 80, RAYWHITE);
+    }
+
+    int barW = 400;
+    int barX = (SCREEN_WIDTH - barW) / 2;
+    int barY = SCREEN_HEIGHT - 60;
+    if (ready) {
+        DrawTextCustom("Press any key or click to start", barX + 40, barY - 6, 16, RAYWHITE);
+    } else {
+        DrawRectangle(barX, barY, (int)(barW * loadProgress), 12, GOLD);
+        DrawRectangleLines(barX, barY, barW, 12, RAYWHITE);
     }
 }
+
+// Tile geometry for a cell size: margin, gap between boards, score line
+static void TileMetrics(int cell, int* pad, int* gap, int* header)
+{
+    *pad = cell / 4 > 2 ? cell / 4 : 2;
+    *gap = cell / 2;
+    *header = cell > 10 ? cell : 10;
+}
+
+void UI_GameTileSize(int players, int cell, int* w, int* h)
+{
+    int pad, gap, header;
+    TileMetrics(cell, &pad, &gap, &header);
+    *w = 2 * pad + players * BOARD_SIZE * cell + (players - 1) * gap;
+    *h = 2 * pad + header + BOARD_SIZE * cell;
+}
+
+// Quads and the default font only: the default font's texture also holds
+// the white texel shapes are drawn with, so a tile stays one batch
+void UI_DrawGameTile(const GameState* g, int x, int y, int cell)
+{
+    int pad, gap, header;
+    TileMetrics(cell, &pad, &gap, &header);
+    int w, h;
+    UI_GameTileSize(g->playersCount, cell, &w, &h);
+    DrawRectangle(x, y, w, h, g->gameEnded ? (Color){ 230, 220, 170, 255 } : (Color){ 235, 235, 235, 255 });
+
+    int best = 0;
+    for (int p = 0; p < g->playersCount; ++p) {
+        if (g->players[p].points > best) best = g->players[p].points;
+    }
+
+    int step = (cell - 2) / MAX_STACK_HEIGHT;
+    int pip = step > 2 ? step - 1 : 1;
+    for (int p = 0; p < g->playersCount; ++p) {
+        const Player* pl = &g->players[p];
+        int bx = x + pad + p * (BOARD_SIZE * cell + gap);
+        int by = y + pad + header;
+        int size = BOARD_SIZE * cell;
+        DrawText(TextFormat("P%d %d", p + 1, pl->points), bx, y + pad, header - 2, PLAYER_COLOR[p]);
+
+        // Frame: the player to move, or the winners once it is over
+        bool framed = g->gameEnded ? pl->points == best : p == g->currentPlayer;
+        Color frame = g->gameEnded ? GOLD : PLAYER_COLOR[p];
+        DrawRectangle(bx - 1, by - 1, size + 2, size + 2, framed ? frame : GRAY);
+
+        for (int r = 0; r < BOARD_SIZE; ++r) {
+            for (int c = 0; c < BOARD_SIZE; ++c) {
+                const CoralStack* s = &pl->board[r][c];
+                int cx = bx + c * cell;
+                int cy = by + r * cell;
+                Color top = s->height > 0 ? CORAL_COLOR_MAP[s->pieces[s->height - 1]] : (Color){ 200, 200, 200, 255 };
+                top.a = 255;
+                DrawRectangle(cx + 1, cy + 1, cell - 2, cell - 2, top);
+                for (int k = 0; k < s->height; ++k) {
+                    DrawRectangle(cx + 2 + k * step, cy + cell - 2 - pip, pip, pip, BLACK);
+                }
+            }
+        }
+    }
+}
+
+void UI_DrawTimeline(int x, int y, int w, int h, int step, int steps, const char* label)
+{
+    DrawRectangle(x, y, w, h, (Color){ 200, 200, 200, 255 });
+    int filled = steps > 1 ? (int)((long)w * step / (steps - 1)) : w;
+    DrawRectangle(x, y, filled, h, (Color){ 70, 130, 180, 255 });
+    DrawRectangleLines(x, y, w, h, BLACK);
+    DrawRectangle(x + filled - 3, y - 3, 6, h + 6, DARKBLUE);
+    if (label != NULL) DrawTextCustom(label, x, y - 20, 14, BLACK);
+}
@@ -2,14 +2,43 @@
 #define UI_H
 
 #include "constants.h"
+#include "hint.h"
+#include "opportunity.h"
+
+// Where each seat's board and hand go. Two players get the full-size boards
+// side by side; three and four share a 2x2 grid of smaller ones.
+typedef struct {
+    int cellSize;
+    int handStep;   // between hand cards; below UI_CARD_W they overlap
+    int boardX[PLAYERS_MAX], boardY[PLAYERS_MAX];
+    int handX[PLAYERS_MAX], handY[PLAYERS_MAX];
+} UiLayout;
+
+void UI_ComputeLayout(int players, UiLayout* out);
 
 void UI_DrawBackground(void);
-void UI_DrawPlayerBoard(const Player* p, int ox, int oy, bool highlightValid, CoralColor placeColor);
+// hint: heatmap for the next piece, or NULL; opportunity: the board's
+// player's index, marking the cards the next piece would score more for,
+// or NULL
+void UI_DrawPlayerBoard(const Player* p, int ox, int oy, int cellSize, bool highlightValid, CoralColor placeColor,
+                        const HintMap* hint, const OpportunityIndex* opportunity);
 void UI_DrawCard(const Card* c, int x, int y);
 void UI_DrawMarket(const GameState* g);
 void UI_DrawDeck(const GameState* g);
-void UI_DrawHand(const Player* p, int x, int y, int selectedIndex);
+void UI_DrawHand(const Player* p, int x, int y, int step, int selectedIndex, const HintMap* hint);
 void UI_DrawSupplies(const GameState* g);
-void UI_DrawTopBar(const GameState* g);
+void UI_DrawTopBar(const GameState* g, const char* status);  // status may be NULL
+void UI_DrawTitleScreen(float loadProgress, bool ready);
+
+// Replay timeline (replay.h): the track, filled up to step of steps, with
+// a knob there and label above it (may be NULL)
+void UI_DrawTimeline(int x, int y, int w, int h, int step, int steps, const char* label);
+
+// Low-detail game for the spectator wall (wall.h): a flat quad per stack
+// in its top color with a pip per piece, the boards side by side under the
+// scores, and no per-cell text. Opaque throughout, so it can be drawn into
+// a render texture over an older copy of itself.
+void UI_GameTileSize(int players, int cellSize, int* w, int* h);
+void UI_DrawGameTile(const GameState* g, int x, int y, int cellSize);
 
 #endif
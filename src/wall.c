@@ -0,0 +1,406 @@
+#define _DEFAULT_SOURCE
+#include "wall.h"
+#include "constants.h"
+#include "delta.h"
+#include "jobs.h"
+#include "pacing.h"
+#include "rng.h"
+#include "trace.h"
+#include "ui.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+enum { WALL_ACK_EVERY = 8 };  // versions between a watcher's ACKs
+
+typedef struct {
+    GameState shown;       // main thread only
+    GameState next;        // the move being computed; its job's only
+    uint64_t botRng;
+    int deal;              // games dealt in this tile; turns the seats among the bots
+    double due;            // GetTime() of the next move or deal
+    bool dirty;            // tile not drawn since the last change
+    int x, y;              // tile in the atlas
+
+    // Watching a reefd match: its subscription, -1 once it has ended
+    int fd;
+    uint32_t matchId;
+    uint32_t version, acked;
+    bool resyncing;        // subscribed again; deltas until the keyframe are stale
+    uint8_t in[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+    int inLen;
+} WallGame;
+
+static struct {
+    WallGame games[WALL_MAX_GAMES];
+    int count;
+    int players;
+    BotConfig bots[PLAYERS_MAX];
+    int botCount;
+    bool watching;         // tiles follow reefd matches instead of local games
+    int cell;              // tile cell size
+    uint64_t seed;         // next deal
+    RenderTexture2D atlas;
+
+    // The batch of moves in flight
+    JobGroup group;
+    JobRange range;
+    int batch[WALL_MAX_GAMES];
+    int stepping;
+
+    int finished;
+    int watched;           // subscriptions still streaming
+    int moves;             // this second, and the last
+    int movesPerSecond;
+    double second;
+} gWall;
+
+// The largest cell size whose tiles all fit in the grid shape that
+// allows it
+static void Layout(void)
+{
+    int width = SCREEN_WIDTH, height = SCREEN_HEIGHT - WALL_BAR_H;
+    int bestCell = 0, bestCols = 1;
+    for (int cols = 1; cols <= gWall.count; ++cols) {
+        int rows = (gWall.count + cols - 1) / cols;
+        for (int cell = UI_GRID_CELL_SIZE; cell > bestCell; --cell) {
+            int w, h;
+            UI_GameTileSize(gWall.players, cell, &w, &h);
+            if (w * cols <= width && h * rows <= height) {
+                bestCell = cell;
+                bestCols = cols;
+                break;
+            }
+        }
+    }
+    if (bestCell < 4) bestCell = 4;  // too many players to fit; let tiles overlap
+
+    int w, h;
+    UI_GameTileSize(gWall.players, bestCell, &w, &h);
+    int rows = (gWall.count + bestCols - 1) / bestCols;
+    int x0 = (width - w * bestCols) / 2;
+    int y0 = WALL_BAR_H + (height - h * rows) / 2;
+    gWall.cell = bestCell;
+    for (int i = 0; i < gWall.count; ++i) {
+        gWall.games[i].x = x0 + (i % bestCols) * w;
+        gWall.games[i].y = y0 + (i / bestCols) * h;
+    }
+}
+
+static void Deal(WallGame* w, double now)
+{
+    uint64_t seed = gWall.seed++;
+    RulesNewGame(&w->shown, gWall.players, seed);
+    w->botRng = seed ^ 0x9E3779B97F4A7C15ull;
+    w->deal++;
+    w->due = now + WALL_STEP_MS / 1000.0;
+    w->dirty = true;
+}
+
+// The bot in seat. Each new deal moves the bots one seat on, as a
+// tournament pairing swaps seats between its games.
+static const BotConfig* SeatBot(const WallGame* w, int seat)
+{
+    return &gWall.bots[(seat + w->deal) % gWall.botCount];
+}
+
+// Worker: one move for each game of the batch
+static void StepGames(void* ctx, int begin, int end)
+{
+    (void)ctx;
+    for (int i = begin; i < end; ++i) {
+        WallGame* w = &gWall.games[gWall.batch[i]];
+        TRACE_BEGIN("WallStep");
+        RulesCopyState(&w->next, &w->shown);
+        Action a = BotChooseAction(&w->next, SeatBot(w, w->next.currentPlayer), &w->botRng);
+        // An illegal choice is a bot bug; end the game rather than retry it forever
+        if (!RulesApply(&w->next, a)) w->next.gameEnded = true;
+        TRACE_END("WallStep");
+    }
+}
+
+static void ClearAtlas(void)
+{
+    BeginTextureMode(gWall.atlas);
+    ClearBackground(DARKGRAY);
+    EndTextureMode();
+}
+
+static bool OpenWall(int games, int players)
+{
+    gWall.count = games < 1 ? 1 : games > WALL_MAX_GAMES ? WALL_MAX_GAMES : games;
+    gWall.players = players;
+    for (int i = 0; i < WALL_MAX_GAMES; ++i) gWall.games[i].fd = -1;
+
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Reef - spectator wall");
+    SetTargetFPS(PACE_ACTIVE_FPS);
+    gWall.atlas = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (gWall.atlas.id == 0) return false;
+    ClearAtlas();
+    Layout();
+    return true;
+}
+
+bool WallStart(int games, int players, const BotConfig* bots, int botCount)
+{
+    gWall.botCount = botCount < 1 ? 1 : botCount > PLAYERS_MAX ? PLAYERS_MAX : botCount;
+    for (int i = 0; i < gWall.botCount; ++i) gWall.bots[i] = bots[i];
+    gWall.seed = RngSeedFromTime();
+    if (!OpenWall(games, players)) return false;
+
+    double now = GetTime();
+    for (int i = 0; i < gWall.count; ++i) {
+        Deal(&gWall.games[i], now);
+        gWall.games[i].due += (double)i * WALL_STEP_MS / 1000.0 / gWall.count;  // staggered
+    }
+    gWall.second = now;
+    JobsStart(JobsCpuCount() - 1, false);  // leave a core to the render loop
+    return true;
+}
+
+// "host:port", or the path of reefd's Unix socket
+static int Connect(const char* address)
+{
+    int fd;
+    if (strchr(address, '/') != NULL) {
+        struct sockaddr_un sa = { 0 };
+        sa.sun_family = AF_UNIX;
+        snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", address);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) { close(fd); return -1; }
+    } else {
+        char host[256];
+        snprintf(host, sizeof(host), "%s", address);
+        char* colon = strrchr(host, ':');
+        if (colon == NULL) return -1;
+        *colon = '\0';
+        struct sockaddr_in sa = { 0 };
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons((uint16_t)atoi(colon + 1));
+        if (inet_pton(AF_INET, host, &sa.sin_addr) != 1) return -1;
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) { close(fd); return -1; }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static void Send(WallGame* w, ProtoWriter* pw)
+{
+    ProtoEndFrame(pw);
+    if (send(w->fd, pw->buf, (size_t)pw->len, MSG_NOSIGNAL) != pw->len) {
+        close(w->fd);
+        w->fd = -1;
+        gWall.watched--;
+    }
+}
+
+// From a keyframe: also after a delta that did not apply
+static void Subscribe(WallGame* w)
+{
+    w->resyncing = true;
+    uint8_t buf[32];
+    ProtoWriter pw;
+    ProtoWriterInit(&pw, buf, sizeof(buf));
+    ProtoBeginFrame(&pw, MSG_LEAVE);
+    ProtoEndFrame(&pw);
+    ProtoBeginFrame(&pw, MSG_SUBSCRIBE);
+    ProtoPutU32(&pw, w->matchId);
+    ProtoPutU32(&pw, PROTO_VERSION_NONE);
+    Send(w, &pw);
+}
+
+static void Ack(WallGame* w)
+{
+    uint8_t buf[16];
+    ProtoWriter pw;
+    ProtoWriterInit(&pw, buf, sizeof(buf));
+    ProtoBeginFrame(&pw, MSG_ACK);
+    ProtoPutU32(&pw, w->version);
+    Send(w, &pw);
+    w->acked = w->version;
+}
+
+bool WallWatch(const char* address, const uint32_t* matches, int count, int players)
+{
+    gWall.watching = true;
+    if (!OpenWall(count, players)) return false;
+    for (int i = 0; i < gWall.count; ++i) {
+        WallGame* w = &gWall.games[i];
+        w->matchId = matches[i];
+        w->fd = Connect(address);
+        if (w->fd < 0) {
+            fprintf(stderr, "reef: cannot connect to %s\n", address);
+            return false;
+        }
+        gWall.watched++;
+        Subscribe(w);
+    }
+    gWall.second = GetTime();
+    return true;
+}
+
+// The frames that arrived for w's match, without waiting for more
+static void Receive(WallGame* w)
+{
+    for (;;) {
+        int n = ProtoFrameLength(w->in, w->inLen);
+        if (n < 0) break;  // corrupt stream: give up on it
+        if (n > 0) {
+            const uint8_t* body = w->in + PROTO_HEADER_SIZE;
+            if (body[0] == MSG_DELTA) {
+                if (DeltaApply(&w->shown, &w->version, body + 1, n - PROTO_HEADER_SIZE - 1)) {
+                    w->dirty = true;
+                    gWall.moves++;
+                    if (w->shown.gameEnded) gWall.finished++;
+                    if (w->version - w->acked >= WALL_ACK_EVERY || w->shown.gameEnded) Ack(w);
+                    if (body[1] & DELTA_KEYFRAME) w->resyncing = false;
+                } else if (!w->resyncing) {
+                    Subscribe(w);
+                }
+            } else if (body[0] == MSG_ERROR) {
+                break;  // no such match
+            }
+            if (w->fd < 0) return;
+            memmove(w->in, w->in + n, (size_t)(w->inLen - n));
+            w->inLen -= n;
+            continue;
+        }
+        ssize_t got = recv(w->fd, w->in + w->inLen, sizeof(w->in) - (size_t)w->inLen, MSG_DONTWAIT);
+        if (got > 0) { w->inLen += (int)got; continue; }
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        break;  // reefd hung up
+    }
+    close(w->fd);
+    w->fd = -1;
+    gWall.watched--;
+}
+
+// Tiles are sized for the largest table seen so far
+static void WatchUpdate(void)
+{
+    int players = gWall.players;
+    for (int i = 0; i < gWall.count; ++i) {
+        WallGame* w = &gWall.games[i];
+        if (w->fd >= 0) Receive(w);
+        if (w->shown.playersCount > players) players = w->shown.playersCount;
+    }
+    if (players != gWall.players) {
+        gWall.players = players;
+        Layout();
+        ClearAtlas();
+        for (int i = 0; i < gWall.count; ++i) gWall.games[i].dirty = true;
+    }
+}
+
+void WallStop(void)
+{
+    for (int i = 0; i < gWall.count; ++i) {
+        if (gWall.games[i].fd >= 0) close(gWall.games[i].fd);
+        gWall.games[i].fd = -1;
+    }
+    if (gWall.stepping > 0) JobWait(&gWall.group);
+    gWall.stepping = 0;
+    if (!gWall.watching) JobsStop();
+    if (gWall.atlas.id != 0) UnloadRenderTexture(gWall.atlas);
+    gWall.atlas.id = 0;
+}
+
+void WallUpdate(void)
+{
+    double now = GetTime();
+    if (now - gWall.second >= 1.0) {
+        gWall.movesPerSecond = gWall.moves;
+        gWall.moves = 0;
+        gWall.second = now;
+    }
+
+    if (gWall.watching) {
+        WatchUpdate();
+        bool dirty = false;
+        for (int i = 0; i < gWall.count && !dirty; ++i) dirty = gWall.games[i].dirty;
+        PacingRequest(dirty ? PACE_ACTIVE : PACE_TICK);
+        return;
+    }
+
+    // One batch at a time: games due meanwhile wait for the next
+    if (gWall.stepping > 0) {
+        if (!JobGroupDone(&gWall.group)) {
+            PacingRequest(PACE_TICK);
+            return;
+        }
+        JobWait(&gWall.group);
+        for (int i = 0; i < gWall.stepping; ++i) {
+            WallGame* w = &gWall.games[gWall.batch[i]];
+            RulesCopyState(&w->shown, &w->next);
+            w->due = now + (w->shown.gameEnded ? WALL_HOLD_MS : WALL_STEP_MS) / 1000.0;
+            w->dirty = true;
+        }
+        gWall.moves += gWall.stepping;
+        gWall.stepping = 0;
+    }
+
+    for (int i = 0; i < gWall.count; ++i) {
+        WallGame* w = &gWall.games[i];
+        if (now < w->due) continue;
+        if (w->shown.gameEnded) {
+            Deal(w, now);
+            gWall.finished++;
+        } else {
+            gWall.batch[gWall.stepping++] = i;
+        }
+    }
+    if (gWall.stepping > 0) {
+        atomic_store(&gWall.group.pending, 0);
+        JobParallelForAsync(&gWall.group, &gWall.range, gWall.stepping, 1, StepGames, NULL);
+    }
+
+    // Games are always about to move; full rate only for frames that change
+    bool dirty = false;
+    for (int i = 0; i < gWall.count && !dirty; ++i) dirty = gWall.games[i].dirty;
+    PacingRequest(dirty ? PACE_ACTIVE : PACE_TICK);
+}
+
+void WallDraw(void)
+{
+    // Changed tiles into the atlas, in one pass
+    bool any = false;
+    for (int i = 0; i < gWall.count; ++i) {
+        WallGame* w = &gWall.games[i];
+        if (!w->dirty || w->shown.playersCount == 0) continue;  // a match not yet heard from
+        if (!any) BeginTextureMode(gWall.atlas);
+        any = true;
+        UI_DrawGameTile(&w->shown, w->x, w->y, gWall.cell);
+        w->dirty = false;
+    }
+    if (any) EndTextureMode();
+
+    // Render textures are stored bottom-up
+    ClearBackground(DARKGRAY);
+    Rectangle src = { 0, 0, (float)gWall.atlas.texture.width, -(float)gWall.atlas.texture.height };
+    DrawTextureRec(gWall.atlas.texture, src, (Vector2){ 0, 0 }, WHITE);
+    const char* status;
+    if (gWall.watching) {
+        status = TextFormat("%d reefd matches, %d streaming, %d finished, %d moves/s", gWall.count, gWall.watched,
+                            gWall.finished, gWall.movesPerSecond);
+    } else {
+        char bots[PLAYERS_MAX * 36] = "";
+        for (int i = 0; i < gWall.botCount; ++i) {
+            if (i > 0) strcat(bots, " vs ");
+            strcat(bots, gWall.bots[i].name);
+        }
+        status = TextFormat("%d games of %s, %d finished, %d moves/s", gWall.count, bots, gWall.finished,
+                            gWall.movesPerSecond);
+    }
+    DrawText(status, 8, 6, 10, RAYWHITE);
+}
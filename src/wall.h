@@ -0,0 +1,43 @@
+#ifndef WALL_H
+#define WALL_H
+
+#include "bot.h"
+
+// Spectator wall: one screen tiling many live bot games, for tournaments.
+//
+// The games come from one of two places. WallWatch subscribes each tile to
+// a reefd match as a spectator and draws the delta stream (delta.h), so the
+// wall shows the games the server is hosting. WallStart plays the games
+// here instead, a move at a time with a pause between moves so they can be
+// followed. The bots take the seats in turn, one seat on per deal, as a
+// pairing does in reeftourney, and the moves are computed on the job
+// system (jobs.h) without the frame ever waiting on them.
+//
+// Each game is a low-detail tile (UI_DrawGameTile) kept in one render
+// texture the size of the screen. A tile is drawn again only when its game
+// has moved, and a frame is the texture as a single quad plus a status
+// line, so the cost of a frame does not grow with the number of games.
+// A finished game stays up for a while, then a new one is dealt in its tile.
+
+enum {
+    WALL_MAX_GAMES = 64,
+    WALL_STEP_MS   = 400,   // between one game's moves
+    WALL_HOLD_MS   = 3000,  // a finished game stays up this long
+    WALL_BAR_H     = 24     // status line above the tiles
+};
+
+// Open the window and play games locally. games is clamped to
+// 1..WALL_MAX_GAMES; seat i of a tile's first game plays bots[i % botCount].
+bool WallStart(int games, int players, const BotConfig* bots, int botCount);
+
+// Open the window and follow reefd matches at address ("host:port" or a
+// Unix socket path), one tile each. Tiles are sized for players until a
+// larger table arrives. False if the server cannot be reached.
+bool WallWatch(const char* address, const uint32_t* matches, int count, int players);
+void WallStop(void);  // before CloseWindow
+
+// Main thread, once per frame: collect finished moves, start the next ones
+void WallUpdate(void);
+void WallDraw(void);
+
+#endif
@@ -0,0 +1,96 @@
+// Regression checks for the delta decoder on corrupted input.
+//
+//   tests/delta_corrupt
+//
+// Plays a few turns, follows them as a remote view would, then feeds the
+// view deltas with one record out of range. Each must be refused and leave
+// the view as it was. Each check prints one line; the exit status is the
+// number that failed.
+#define _GNU_SOURCE
+#include "delta.h"
+#include <stdio.h>
+#include <string.h>
+
+// Record tags and layout as in delta.c
+enum { TAG_STACK = 2, TAG_DISPLAY = 4, TAG_DECK = 5, TAG_TURN = 8 };
+
+static int gFailed;
+
+static void Check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) gFailed++;
+}
+
+// A delta on top of base holding one record: tag and its payload
+static int Corrupt(uint8_t* buf, int cap, uint32_t base, uint8_t tag, const uint8_t* payload, int n)
+{
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, cap);
+    ProtoPutU8(&w, 0);
+    ProtoPutU32(&w, base);
+    ProtoPutU32(&w, base + 1);
+    ProtoPutU8(&w, tag);
+    for (int i = 0; i < n; ++i) ProtoPutU8(&w, payload[i]);
+    return w.len;
+}
+
+// Refused, with the view and its version untouched
+static void Refused(GameState* view, uint32_t* version, uint8_t tag, const uint8_t* payload, int n, const char* what)
+{
+    uint8_t buf[64];
+    int len = Corrupt(buf, sizeof(buf), *version, tag, payload, n);
+    GameState before = *view;
+    uint32_t was = *version;
+    bool applied = DeltaApply(view, version, buf, len);
+    Check(!applied && *version == was && memcmp(&before, view, sizeof(before)) == 0, what);
+}
+
+int main(void)
+{
+    GameState g, prev;
+    RulesNewGame(&g, PLAYERS_MIN, 7);
+
+    // Follow a few turns as a spectator would
+    static uint8_t buf[DELTA_MAX_SIZE];
+    GameState view;
+    memset(&view, 0, sizeof(view));
+    uint32_t version = 0;
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    bool ok = DeltaEncode(&w, NULL, &g, 0, 1) && DeltaApply(&view, &version, buf, w.len);
+    for (uint32_t v = 2; ok && v < 40 && !g.gameEnded; ++v) {
+        Action legal[RULES_MAX_ACTIONS];
+        if (RulesListActions(&g, legal) == 0) break;
+        prev = g;
+        RulesApply(&g, legal[0]);
+        ProtoWriterInit(&w, buf, sizeof(buf));
+        ok = DeltaEncode(&w, &prev, &g, v - 1, v) && DeltaApply(&view, &version, buf, w.len);
+    }
+    Check(ok && view.deckSize == g.deckSize && view.players[0].points == g.players[0].points,
+          "a played game decodes");
+
+    // u8 player, u8 cell, u16 packed stack: height in bits 0-2, then 3 bits a piece
+    Refused(&view, &version, TAG_STACK, (const uint8_t[]){ 0, 0, 7, 0 }, 4, "stack taller than MAX_STACK_HEIGHT");
+    Refused(&view, &version, TAG_STACK, (const uint8_t[]){ 0, 0, 1 | 7 << 3, 0 }, 4, "stack piece of no color");
+    Refused(&view, &version, TAG_STACK, (const uint8_t[]){ 0, 0, 0, 1 << 1 }, 4, "piece above the stack's height");
+
+    // u8 slot, u8 card, u8 tokens
+    Refused(&view, &version, TAG_DISPLAY, (const uint8_t[]){ 0, DECK_MAX, 0 }, 3, "display card past the deck");
+    Refused(&view, &version, TAG_DISPLAY, (const uint8_t[]){ 0, DELTA_HIDDEN_CARD, 0 }, 3, "hidden display card");
+
+    // u8 deckSize, u8 top card
+    Refused(&view, &version, TAG_DECK, (const uint8_t[]){ 5, DECK_MAX }, 2, "deck top past the deck");
+    Refused(&view, &version, TAG_DECK, (const uint8_t[]){ 5, DELTA_HIDDEN_CARD }, 2, "hidden top of a non-empty deck");
+    Refused(&view, &version, TAG_DECK, (const uint8_t[]){ 0, 3 }, 2, "top card of an empty deck");
+
+    // u8 player, u8 flags, u8 piece0, u8 piece1, u8 placed, u8 card
+    Refused(&view, &version, TAG_TURN, (const uint8_t[]){ 0, 2, 1, 2, 0, DECK_MAX }, 6, "placement card past the deck");
+    Refused(&view, &version, TAG_TURN, (const uint8_t[]){ 0, 2, 5, 2, 0, 0 }, 6, "placement piece of no color");
+
+    // The view still takes the next real delta
+    uint8_t good[64];
+    int len = Corrupt(good, sizeof(good), version, TAG_DECK, (const uint8_t[]){ 0, DELTA_HIDDEN_CARD }, 2);
+    Check(DeltaApply(&view, &version, good, len) && view.deckSize == 0, "the view still applies a valid delta");
+    return gFailed;
+}
@@ -0,0 +1,233 @@
+// Regression checks for connections moving between reefd's event loops.
+//
+//   tests/server_handoff ./reefd
+//
+// Starts the server with two loops on a Unix socket. A connection is put
+// on a chosen loop by joining a match id that names it and does not
+// exist: the join is handed over, then refused there. Each check prints
+// one line; the exit status is the number that failed, or 1 if the server
+// crashed.
+#define _GNU_SOURCE
+#include "protocol.h"
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+enum { CHECK_TIMEOUT_MS = 2000 };
+
+typedef struct {
+    int fd;
+    uint8_t buf[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+    int len;
+} Client;
+
+static char gPath[108];
+static int gFailed;
+
+static void Check(bool ok, const char* what)
+{
+    printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) gFailed++;
+}
+
+static bool Connect(Client* c)
+{
+    memset(c, 0, sizeof(*c));
+    struct sockaddr_un sa = { 0 };
+    sa.sun_family = AF_UNIX;
+    snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", gPath);
+    c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    return c->fd >= 0 && connect(c->fd, (struct sockaddr*)&sa, sizeof(sa)) == 0;
+}
+
+static void Send(Client* c, ProtoWriter* w)
+{
+    ProtoEndFrame(w);
+    if (send(c->fd, w->buf, (size_t)w->len, MSG_NOSIGNAL) != w->len) c->fd = -1;
+}
+
+// Next frame other than skip (0 to skip none); its type, 0 on timeout or
+// hangup. body gets the payload after the type byte.
+static uint8_t Receive(Client* c, uint8_t skip, const uint8_t** body, int* len)
+{
+    for (;;) {
+        int n = ProtoFrameLength(c->buf, c->len);
+        if (n < 0) return 0;
+        if (n > 0) {
+            static uint8_t frame[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+            memcpy(frame, c->buf, (size_t)n);
+            memmove(c->buf, c->buf + n, (size_t)(c->len - n));
+            c->len -= n;
+            if (frame[PROTO_HEADER_SIZE] == skip) continue;
+            if (body != NULL) *body = frame + PROTO_HEADER_SIZE + 1;
+            if (len != NULL) *len = n - PROTO_HEADER_SIZE - 1;
+            return frame[PROTO_HEADER_SIZE];
+        }
+        struct pollfd p = { c->fd, POLLIN, 0 };
+        if (poll(&p, 1, CHECK_TIMEOUT_MS) <= 0) return 0;
+        ssize_t got = recv(c->fd, c->buf + c->len, sizeof(c->buf) - (size_t)c->len, 0);
+        if (got <= 0) return 0;
+        c->len += (int)got;
+    }
+}
+
+static void Join(Client* c, uint32_t id, uint8_t seat)
+{
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_JOIN);
+    ProtoPutU32(&w, id);
+    ProtoPutU8(&w, seat);
+    Send(c, &w);
+}
+
+static uint8_t ErrorCode(Client* c)
+{
+    const uint8_t* body;
+    int len;
+    return Receive(c, MSG_DELTA, &body, &len) == MSG_ERROR && len >= 1 ? body[0] : 0;
+}
+
+// Move c onto loop, then create a match there; false on failure
+static bool CreateOn(Client* c, int loop, uint8_t seat, uint64_t seed, uint32_t* id)
+{
+    Join(c, 0xFFFF00u | (uint32_t)loop, 0);
+    if (ErrorCode(c) != PROTO_ERR_NO_MATCH) return false;
+
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_CREATE);
+    ProtoPutU64(&w, seed);
+    ProtoPutU8(&w, seat);
+    ProtoPutU8(&w, PLAYERS_MIN);
+    Send(c, &w);
+
+    const uint8_t* body;
+    int len;
+    if (Receive(c, 0, &body, &len) != MSG_JOINED) return false;
+    ProtoReader r;
+    ProtoReaderInit(&r, body, len);
+    *id = ProtoGetU32(&r);
+    return !r.error;
+}
+
+static void Subscribe(Client* c, uint32_t id)
+{
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_SUBSCRIBE);
+    ProtoPutU32(&w, id);
+    ProtoPutU32(&w, PROTO_VERSION_NONE);
+    Send(c, &w);
+}
+
+static void Leave(Client* c)
+{
+    uint8_t buf[8];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_LEAVE);
+    Send(c, &w);
+}
+
+// Play the first legal action of g for the seat holder c; true if applied
+static bool Play(Client* c, GameState* g, uint32_t seq)
+{
+    Action legal[RULES_MAX_ACTIONS];
+    if (RulesListActions(g, legal) == 0) return false;
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_ACTION);
+    ProtoPutU32(&w, seq);
+    ProtoPutAction(&w, legal[0]);
+    Send(c, &w);
+
+    const uint8_t* body;
+    int len;
+    if (Receive(c, MSG_DELTA, &body, &len) != MSG_RESULT) return false;
+    ProtoReader r;
+    ProtoReaderInit(&r, body, len);
+    ProtoGetU32(&r);
+    return ProtoGetU8(&r) != 0 && RulesApply(g, legal[0]);
+}
+
+static pid_t StartServer(const char* reefd)
+{
+    snprintf(gPath, sizeof(gPath), "/tmp/reef-check-%d.sock", (int)getpid());
+    unlink(gPath);
+    pid_t pid = fork();
+    if (pid == 0) {
+        execl(reefd, reefd, "--unix", gPath, "--loops", "2", "--no-pin", (char*)NULL);
+        _exit(127);
+    }
+    // Up once the socket accepts
+    for (int i = 0; i < 200 && pid > 0; ++i) {
+        Client probe;
+        bool up = Connect(&probe);
+        if (probe.fd >= 0) close(probe.fd);
+        if (up) return pid;
+        nanosleep(&(struct timespec){ 0, 10 * 1000000L }, NULL);
+    }
+    return -1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s path/to/reefd\n", argv[0]);
+        return 2;
+    }
+    pid_t server = StartServer(argv[1]);
+    if (server < 0) {
+        fprintf(stderr, "server_handoff: %s did not start\n", argv[1]);
+        return 2;
+    }
+
+    // a plays every seat of a match on loop 0; b holds seat 0 of one on loop 1
+    Client a, b, s;
+    Connect(&a);
+    Connect(&b);
+    Connect(&s);
+    uint32_t idA = 0, idB = 0;
+    bool created = CreateOn(&a, 0, PROTO_SEAT_ALL, 11, &idA) && CreateOn(&b, 1, 0, 12, &idB);
+    Check(created && (idA & 0xFF) == 0 && (idB & 0xFF) == 1, "matches created on loops 0 and 1");
+    GameState g;
+    RulesNewGame(&g, PLAYERS_MIN, 11);
+
+    // Subscribe on loop 0, then join on loop 1: refused, still subscribed
+    Subscribe(&s, idA);
+    Check(Receive(&s, 0, NULL, NULL) == MSG_DELTA, "subscriber gets the keyframe");
+    Join(&s, idB, PROTO_SEAT_ANY);
+    Check(ErrorCode(&s) == PROTO_ERR_ALREADY_SEATED, "join while subscribed is refused");
+    Check(Play(&a, &g, 1), "the spectated match plays on");
+    Check(Receive(&s, 0, NULL, NULL) == MSG_DELTA, "the subscriber still gets its deltas");
+
+    // Leave first, and the same join goes through
+    Leave(&s);
+    Join(&s, idB, PROTO_SEAT_ANY);
+    Check(Receive(&s, MSG_DELTA, NULL, NULL) == MSG_JOINED, "join after leaving is handed over");
+    Check(Play(&a, &g, 2), "the left match plays on without its spectator");
+
+    close(a.fd);
+    close(b.fd);
+    close(s.fd);
+    kill(server, SIGTERM);
+    int status = 0;
+    waitpid(server, &status, 0);
+    unlink(gPath);
+    bool clean = WIFEXITED(status) || (WIFSIGNALED(status) && WTERMSIG(status) == SIGTERM);
+    Check(clean, "server shut down cleanly");
+    if (!clean) return 1;
+    return gFailed;
+}
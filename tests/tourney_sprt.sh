@@ -0,0 +1,17 @@
+#!/bin/sh
+# A pairing one bot wins every time must still reach a verdict under
+# --sprt, and well before the game cap.
+#
+#   tests/tourney_sprt.sh tools/reeftourney
+tourney=${1:-tools/reeftourney}
+pairs=150
+cap=$((2 * pairs))  # games: every pair is two
+out=$("$tourney" --pairs "$pairs" --seed 1 --sprt 0,5 g=greedy r=random 2>&1) || exit 2
+games=$(printf '%s\n' "$out" | sed -n 's/^--- .*, \([0-9]*\) games.*/\1/p' | tail -n 1)
+if printf '%s\n' "$out" | grep -q ' H1$' && [ "${games:-$cap}" -lt "$cap" ]; then
+    echo "ok   one-sided pairing accepts H1 after $games of at most $cap games"
+else
+    printf '%s\n' "$out"
+    echo "FAIL one-sided pairing did not decide"
+    exit 1
+fi
@@ -0,0 +1,305 @@
+// reefbook: build the opening book.
+//
+//   reefbook [--threads T] [--rollouts R] [--turns N] [--candidates K]
+//            [--limit N] [--seed S] out.book
+//
+// For every opening key (two hand kinds, three display kinds) the builder
+// lists the mover's whole first turns, keeps the K best by static
+// evaluation and plays each out R times against the same sampled deals
+// (deck order and opponent hand), N turns deep with greedy bots. The line
+// with the best mean evaluation goes into the book. Keys run in parallel on
+// the job system, one job each; --limit builds only the first N for quick
+// checks.
+#define _GNU_SOURCE
+#include "book.h"
+#include "bot.h"
+#include "cards.h"
+#include "jobs.h"
+#include "rng.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    BOOK_MAX_CANDIDATES = 32
+};
+
+typedef struct {
+    Action actions[3];
+    int count;
+    float eval;
+} TurnLine;
+
+typedef struct {
+    BookEntry* entries;
+    int count;
+    int rollouts, turns, candidates;
+    uint64_t seed;
+    BotConfig bot;
+    atomic_int done;
+} Builder;
+
+typedef struct {
+    TurnLine lines[BOOK_MAX_CANDIDATES];
+    int count, cap;
+} LineSet;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keep the cap best lines, best first
+static void KeepLine(LineSet* set, const TurnLine* line)
+{
+    if (set->count == set->cap && set->lines[set->count - 1].eval >= line->eval) return;
+    int i = set->count < set->cap ? set->count++ : set->count - 1;
+    while (i > 0 && set->lines[i - 1].eval < line->eval) {
+        set->lines[i] = set->lines[i - 1];
+        --i;
+    }
+    set->lines[i] = *line;
+}
+
+static void ListLines(const Builder* b, const GameState* g, int me, TurnLine* line, LineSet* set)
+{
+    if (g->gameEnded || (line->count > 0 && g->currentPlayer != me)) {
+        line->eval = BotEvaluate(g, me, &b->bot);
+        KeepLine(set, line);
+        return;
+    }
+    Action legal[RULES_MAX_ACTIONS];
+    int n = RulesListActions(g, legal);
+    for (int i = 0; i < n; ++i) {
+        // Copies of a card in two slots are the same move
+        const CardId* slots = NULL;
+        if (legal[i].type == ACTION_TAKE_MARKET) slots = g->display;
+        if (legal[i].type == ACTION_PLAY_CARD) slots = g->players[me].hand;
+        if (slots != NULL) {
+            bool dup = false;
+            for (int j = 0; j < legal[i].index; ++j) dup = dup || CardKind(slots[j]) == CardKind(slots[legal[i].index]);
+            if (dup) continue;
+        }
+        GameState next = *g;
+        if (!RulesApply(&next, legal[i])) continue;
+        line->actions[line->count++] = legal[i];
+        ListLines(b, &next, me, line, set);
+        line->count--;
+    }
+}
+
+// Put the key's cards in place and deal everything else from rng. Fails if
+// the key needs more copies of a kind than the deck has.
+static bool DealPosition(GameState* g, const int* hand, const int* display, uint64_t* rng)
+{
+    RulesNewGame(g, BOOK_PLAYERS, RngNext(rng));  // rollouts are head to head
+
+    bool taken[DECK_MAX] = { false };
+    Player* me = &g->players[BOOK_SEAT];
+    for (int i = 0; i < BOOK_HAND_SIZE + CARD_DISPLAY_SIZE; ++i) {
+        int kind = i < BOOK_HAND_SIZE ? hand[i] : display[i - BOOK_HAND_SIZE];
+        int id = 0;
+        while (id < DECK_MAX && (taken[id] || CardKind((CardId)id) != kind)) ++id;
+        if (id == DECK_MAX) return false;
+        taken[id] = true;
+        if (i < BOOK_HAND_SIZE) me->hand[i] = (CardId)id;
+        else g->display[i - BOOK_HAND_SIZE] = (CardId)id;
+    }
+    me->handSize = BOOK_HAND_SIZE;
+
+    CardId pool[DECK_MAX];
+    int n = 0;
+    for (int id = 0; id < DECK_MAX; ++id) {
+        if (!taken[id]) pool[n++] = (CardId)id;
+    }
+    for (int i = n - 1; i > 0; --i) {
+        int j = RngRange(rng, i + 1);
+        CardId t = pool[i]; pool[i] = pool[j]; pool[j] = t;
+    }
+
+    Player* opp = &g->players[1 - BOOK_SEAT];
+    opp->handSize = BOOK_HAND_SIZE;
+    for (int i = 0; i < BOOK_HAND_SIZE; ++i) opp->hand[i] = pool[--n];
+    memcpy(g->deck, pool, (size_t)n * sizeof(CardId));
+    g->deckSize = n;
+    g->currentPlayer = BOOK_SEAT;
+
+    // Both hands as dealt, face down
+    me->hiddenHand = opp->hiddenHand = (uint8_t)((1u << BOOK_HAND_SIZE) - 1);
+    CardsRecountUnseen(g);
+    return true;
+}
+
+static float Rollout(const Builder* b, const GameState* start, const TurnLine* line, uint64_t seed)
+{
+    GameState g = *start;
+    for (int i = 0; i < line->count; ++i) RulesApply(&g, line->actions[i]);
+
+    uint64_t rng = seed;
+    int turnsLeft = b->turns;
+    int mover = g.currentPlayer;
+    while (!g.gameEnded && turnsLeft > 0) {
+        RulesApply(&g, BotChooseAction(&g, &b->bot, &rng));
+        if (g.currentPlayer != mover) {
+            mover = g.currentPlayer;
+            turnsLeft--;
+        }
+    }
+    return BotEvaluate(&g, BOOK_SEAT, &b->bot);
+}
+
+static void BuildEntry(Builder* b, int index)
+{
+    BookEntry* e = &b->entries[index];
+    memset(e, 0, sizeof(*e));
+    e->cells[0] = e->cells[1] = BOOK_NO_CELL;
+
+    int hand[BOOK_HAND_SIZE], display[CARD_DISPLAY_SIZE];
+    BookDecodeIndex(index, hand, display);
+
+    uint64_t rng = b->seed + (uint64_t)index * 0x9E3779B97F4A7C15ull;
+    GameState start;
+    if (!DealPosition(&start, hand, display, &rng)) return; // impossible key
+
+    LineSet set = { .count = 0, .cap = b->candidates };
+    TurnLine line = { .count = 0 };
+    ListLines(b, &start, BOOK_SEAT, &line, &set);
+
+    // Every candidate sees the same deals (common random numbers)
+    float sums[BOOK_MAX_CANDIDATES] = { 0 };
+    for (int r = 0; r < b->rollouts; ++r) {
+        GameState deal;
+        uint64_t dealSeed = RngNext(&rng);
+        DealPosition(&deal, hand, display, &dealSeed);
+        uint64_t botSeed = RngNext(&rng);
+        for (int c = 0; c < set.count; ++c) sums[c] += Rollout(b, &deal, &set.lines[c], botSeed);
+    }
+
+    if (set.count == 0) return;
+    int best = 0;
+    for (int c = 1; c < set.count; ++c) {
+        if (sums[c] > sums[best]) best = c;
+    }
+
+    const TurnLine* chosen = &set.lines[best];
+    Action first = chosen->actions[0];
+    e->type = first.type;
+    if (first.type == ACTION_TAKE_MARKET) e->kind = (uint8_t)display[first.index];
+    if (first.type == ACTION_PLAY_CARD) e->kind = (uint8_t)CardKind(start.players[BOOK_SEAT].hand[first.index]);
+    for (int i = 1, cell = 0; i < chosen->count && cell < 2; ++i) {
+        if (chosen->actions[i].type == ACTION_PLACE_CORAL) {
+            e->cells[cell++] = (uint8_t)(chosen->actions[i].row * BOARD_SIZE + chosen->actions[i].col);
+        }
+    }
+    float mean = b->rollouts > 0 ? sums[best] / (float)b->rollouts : chosen->eval;
+    if (mean > 327.0f) mean = 327.0f;
+    if (mean < -327.0f) mean = -327.0f;
+    e->value = (int16_t)(mean * 100.0f);
+    e->samples = (uint16_t)b->rollouts;
+}
+
+static void BuildEntries(void* ctx, int begin, int end)
+{
+    Builder* b = ctx;
+    for (int i = begin; i < end; ++i) {
+        BuildEntry(b, i);
+        atomic_fetch_add(&b->done, 1);
+    }
+}
+
+static bool WriteBook(const Builder* b, const char* outPath)
+{
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", outPath);
+    FILE* f = fopen(tmpPath, "wb");
+    if (f == NULL) return false;
+
+    BookHeader h = { 0 };
+    h.magic = BOOK_MAGIC;
+    h.version = BOOK_VERSION;
+    h.entryCount = (uint32_t)BookEntryCount();
+    h.rollouts = (uint32_t)b->rollouts;
+    h.turns = (uint32_t)b->turns;
+    h.catalogHash = BookCatalogHash();
+
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(b->entries, sizeof(BookEntry), h.entryCount, f) == h.entryCount;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmpPath, outPath) != 0) {
+        remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--threads T] [--rollouts R] [--turns N] [--candidates K]\n"
+                    "       [--limit N] [--seed S] out.book\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    static Builder b;
+    int threads = JobsCpuCount();
+    const char* outPath = NULL;
+    b.rollouts = 8;
+    b.turns = 4;
+    b.candidates = 6;
+    b.seed = 0x5EEDB00Cull;
+    b.count = BookEntryCount();
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue)         threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--rollouts") == 0 && hasValue)   b.rollouts = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--turns") == 0 && hasValue)      b.turns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--candidates") == 0 && hasValue) b.candidates = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--limit") == 0 && hasValue)      b.count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)       b.seed = strtoull(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' && outPath == NULL)             outPath = argv[i];
+        else { Usage(argv[0]); return 1; }
+    }
+    if (outPath == NULL) { Usage(argv[0]); return 1; }
+    if (threads < 1) threads = 1;
+    if (b.candidates < 1) b.candidates = 1;
+    if (b.candidates > BOOK_MAX_CANDIDATES) b.candidates = BOOK_MAX_CANDIDATES;
+    if (b.rollouts < 0 || b.rollouts > UINT16_MAX) b.rollouts = 8;
+    if (b.count < 0 || b.count > BookEntryCount()) b.count = BookEntryCount();
+
+    BotDefaultConfig(&b.bot, BOT_GREEDY);
+    b.entries = calloc((size_t)BookEntryCount(), sizeof(BookEntry));
+
+    if (!JobsStart(threads, false)) { perror("reefbook"); return 1; }
+    double start = Now();
+    JobGroup group = { 0 };
+    JobRange range;
+    JobParallelForAsync(&group, &range, b.count, 1, BuildEntries, &b);
+
+    while (atomic_load(&b.done) < b.count) {
+        sleep(1);
+        int done = atomic_load(&b.done);
+        double elapsed = Now() - start;
+        fprintf(stderr, "\rreefbook: %d/%d positions, %.0fs elapsed, ~%.0fs left", done, b.count, elapsed,
+                done > 0 ? elapsed * (b.count - done) / done : 0.0);
+    }
+    JobWait(&group);
+    JobsStop();
+    fprintf(stderr, "\n");
+
+    if (!WriteBook(&b, outPath)) {
+        fprintf(stderr, "reefbook: cannot write %s\n", outPath);
+        return 1;
+    }
+    int built = 0;
+    for (int i = 0; i < BookEntryCount(); ++i) built += b.entries[i].type != ACTION_NONE;
+    printf("reefbook: wrote %s, %d of %d positions, %.1fs\n", outPath, built, BookEntryCount(), Now() - start);
+
+    free(b.entries);
+    return 0;
+}
@@ -0,0 +1,296 @@
+// reefcards: generate the card catalog tables from the card list.
+//
+//   reefcards data/cards.txt src/card_data.c src/card_count.h
+//
+// Emits CARD_KINDS (cards as drawn by the UI), CARD_PATTERNS (requirement
+// groups and per-translation cell masks, see patterns.h) and CARD_ID_KIND
+// as static const data, and the header sizing them: CARD_KIND_COUNT, the
+// lines in the list, and DECK_MAX, their copies together. Copies are dealt
+// ids round-robin across kinds, so with equal copy counts
+// id % CARD_KIND_COUNT is the kind.
+//
+// Built with REEF_CARDGEN, where constants.h gives the upper bounds of
+// both instead of the generated header.
+#include "cards.h"
+#include "patterns.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* name;
+    PatternType type;           // PATTERN_NONE: stack, typed by its height rule
+    int width, height;
+    const char* cells;          // row-major, '#' = covered
+} Shape;
+
+static const Shape SHAPES[] = {
+    { "line2",  PATTERN_LINE_2,     2, 1, "##" },
+    { "line3",  PATTERN_LINE_3,     3, 1, "###" },
+    { "square", PATTERN_SQUARE_2X2, 2, 2, "####" },
+    { "lshape", PATTERN_L_SHAPE,    2, 2, "#.##" },
+    { "stack",  PATTERN_NONE,       1, 1, "#" },
+};
+
+static const char* COLOR_ARG[5]  = { "any", "yellow", "orange", "purple", "green" };
+static const char* COLOR_ENUM[5] = { "CORAL_NONE", "CORAL_YELLOW", "CORAL_ORANGE", "CORAL_PURPLE", "CORAL_GREEN" };
+
+static const char* PATTERN_ENUM[] = {
+    "PATTERN_NONE", "PATTERN_LINE_2", "PATTERN_LINE_3", "PATTERN_SQUARE_2X2", "PATTERN_L_SHAPE",
+    "PATTERN_HEIGHT_2", "PATTERN_HEIGHT_3", "PATTERN_HEIGHT_4", "PATTERN_HEIGHT_2_PLUS",
+    "PATTERN_HEIGHT_3_PLUS", "PATTERN_MIXED_COLORS", "PATTERN_ADJACENCY"
+};
+
+typedef struct {
+    Card card;
+    CompiledPattern compiled;
+    int copies;
+} Kind;
+
+static int ParseColor(const char* s, bool allowAny)
+{
+    for (int c = allowAny ? 0 : 1; c < 5; ++c) {
+        if (strcmp(s, COLOR_ARG[c]) == 0) return c;
+    }
+    return -1;
+}
+
+static bool ParseHeight(const char* s, int* minHeight, int* exactHeight)
+{
+    *minHeight = *exactHeight = 0;
+    if (strcmp(s, "-") == 0) return true;
+    int* target = exactHeight;
+    if (strncmp(s, ">=", 2) == 0) { target = minHeight; s += 2; }
+    else if (s[0] == '=') { s += 1; }
+    else return false;
+    *target = atoi(s);
+    return *target >= 1 && *target <= MAX_STACK_HEIGHT;
+}
+
+static PatternType StackType(int minHeight, int exactHeight)
+{
+    if (exactHeight == 2) return PATTERN_HEIGHT_2;
+    if (exactHeight == 3) return PATTERN_HEIGHT_3;
+    if (exactHeight == 4) return PATTERN_HEIGHT_4;
+    if (minHeight == 2)   return PATTERN_HEIGHT_2_PLUS;
+    if (minHeight == 3)   return PATTERN_HEIGHT_3_PLUS;
+    return PATTERN_NONE;
+}
+
+// Group covered cells by requirement and record every translation that fits
+static bool Compile(const ScoringPattern* p, CompiledPattern* out)
+{
+    memset(out, 0, sizeof(*out));
+    out->points = (uint16_t)p->pointValue;
+
+    int cellGroup[4][4];
+    for (int r = 0; r < p->height; ++r) {
+        for (int c = 0; c < p->width; ++c) {
+            const PatternCell* cell = &p->cells[r][c];
+            cellGroup[r][c] = -1;
+            if (cell->color == CORAL_NONE && cell->exactHeight == 0 && cell->minHeight == 0 && !cell->isWild) continue;
+
+            PatternRequirement req = { (uint8_t)(cell->isWild ? CORAL_NONE : cell->color),
+                                       (uint8_t)cell->minHeight, (uint8_t)cell->exactHeight };
+            int g = 0;
+            while (g < out->groupCount && memcmp(&out->groups[g], &req, sizeof(req)) != 0) ++g;
+            if (g == out->groupCount) {
+                if (g == PATTERN_MAX_GROUPS) return false;
+                out->groups[out->groupCount++] = req;
+            }
+            cellGroup[r][c] = g;
+        }
+    }
+
+    for (int row = 0; row + p->height <= BOARD_SIZE; ++row) {
+        for (int col = 0; col + p->width <= BOARD_SIZE; ++col) {
+            PatternPlacement* pl = &out->placements[out->placementCount++];
+            for (int r = 0; r < p->height; ++r) {
+                for (int c = 0; c < p->width; ++c) {
+                    if (cellGroup[r][c] < 0) continue;
+                    uint16_t bit = (uint16_t)(1u << ((row + r) * BOARD_SIZE + col + c));
+                    pl->cells |= bit;
+                    pl->groups[cellGroup[r][c]] |= bit;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool ParseLine(char* line, Kind* k, char* err, size_t errSize)
+{
+    char p1[16], p2[16], shapeName[16], color[16], height[8];
+    int points, copies;
+    if (sscanf(line, "%15s %15s %15s %15s %7s %d %d", p1, p2, shapeName, color, height, &points, &copies) != 7) {
+        snprintf(err, errSize, "expected 7 fields");
+        return false;
+    }
+
+    const Shape* shape = NULL;
+    for (size_t i = 0; i < sizeof(SHAPES) / sizeof(SHAPES[0]); ++i) {
+        if (strcmp(shapeName, SHAPES[i].name) == 0) shape = &SHAPES[i];
+    }
+    int piece1 = ParseColor(p1, false), piece2 = ParseColor(p2, false), want = ParseColor(color, true);
+    int minHeight, exactHeight;
+    if (shape == NULL) { snprintf(err, errSize, "unknown shape '%s'", shapeName); return false; }
+    if (piece1 < 0 || piece2 < 0 || want < 0) { snprintf(err, errSize, "unknown color"); return false; }
+    if (!ParseHeight(height, &minHeight, &exactHeight)) { snprintf(err, errSize, "bad height '%s'", height); return false; }
+    if (points < 0 || copies < 1) { snprintf(err, errSize, "bad points or copies"); return false; }
+
+    memset(k, 0, sizeof(*k));
+    k->copies = copies;
+    k->card.piece1 = (CoralColor)piece1;
+    k->card.piece2 = (CoralColor)piece2;
+
+    ScoringPattern* p = &k->card.pattern;
+    p->type = shape->type != PATTERN_NONE ? shape->type : StackType(minHeight, exactHeight);
+    p->width = shape->width;
+    p->height = shape->height;
+    p->pointValue = points;
+    for (int r = 0; r < shape->height; ++r) {
+        for (int c = 0; c < shape->width; ++c) {
+            if (shape->cells[r * shape->width + c] != '#') continue;
+            PatternCell* cell = &p->cells[r][c];
+            cell->color = (CoralColor)want;
+            cell->isWild = want == CORAL_NONE;
+            cell->minHeight = minHeight;
+            cell->exactHeight = exactHeight;
+        }
+    }
+    if (!Compile(p, &k->compiled)) { snprintf(err, errSize, "too many requirement groups"); return false; }
+    return true;
+}
+
+static void EmitCard(FILE* f, int index, const Card* card)
+{
+    const ScoringPattern* p = &card->pattern;
+    fprintf(f, "    [%d] = { %s, %s, { %s, {", index, COLOR_ENUM[card->piece1], COLOR_ENUM[card->piece2],
+            PATTERN_ENUM[p->type]);
+    bool first = true;
+    for (int r = 0; r < 4; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            const PatternCell* cell = &p->cells[r][c];
+            if (cell->color == CORAL_NONE && !cell->isWild && cell->minHeight == 0 && cell->exactHeight == 0) continue;
+            fprintf(f, "%s\n        [%d][%d] = { %s, %d, %d, %s }", first ? "" : ",", r, c,
+                    COLOR_ENUM[cell->color], cell->minHeight, cell->exactHeight, cell->isWild ? "true" : "false");
+            first = false;
+        }
+    }
+    fprintf(f, "\n    }, %d, %d, %d } },\n", p->width, p->height, p->pointValue);
+}
+
+static void EmitPattern(FILE* f, int index, const CompiledPattern* cp)
+{
+    fprintf(f, "    [%d] = { %d, %d, %d, {", index, cp->groupCount, cp->placementCount, cp->points);
+    for (int g = 0; g < cp->groupCount; ++g) {
+        fprintf(f, "%s { %s, %d, %d }", g ? "," : "", COLOR_ENUM[cp->groups[g].color],
+                cp->groups[g].minHeight, cp->groups[g].exactHeight);
+    }
+    fprintf(f, " }, {");
+    for (int i = 0; i < cp->placementCount; ++i) {
+        const PatternPlacement* pl = &cp->placements[i];
+        fprintf(f, "%s\n        { 0x%04X, {", i ? "," : "", pl->cells);
+        for (int g = 0; g < cp->groupCount; ++g) fprintf(f, "%s 0x%04X", g ? "," : "", pl->groups[g]);
+        fprintf(f, " } }");
+    }
+    fprintf(f, "\n    } },\n");
+}
+
+// Write to path through a temporary file, so a failed run leaves the old one
+static FILE* Begin(const char* path, char* tmpPath, size_t size)
+{
+    snprintf(tmpPath, size, "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "w");
+    if (f == NULL) fprintf(stderr, "reefcards: cannot write %s\n", tmpPath);
+    return f;
+}
+
+static bool Commit(FILE* f, const char* tmpPath, const char* path)
+{
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        fprintf(stderr, "reefcards: cannot write %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <cards.txt> <out.c> <out.h>\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = fopen(argv[1], "r");
+    if (in == NULL) { fprintf(stderr, "reefcards: cannot read %s\n", argv[1]); return 1; }
+
+    // CARD_KIND_COUNT and DECK_MAX are the bounds here (constants.h)
+    Kind kinds[CARD_KIND_COUNT];
+    int kindCount = 0, total = 0, lineNo = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), in)) {
+        lineNo++;
+        char* s = line;
+        while (*s == ' ' || *s == '\t') ++s;
+        if (*s == '#' || *s == '\n' || *s == '\0') continue;
+
+        char err[128];
+        if (kindCount == CARD_KIND_COUNT) err[0] = '\0';
+        if (kindCount == CARD_KIND_COUNT || !ParseLine(s, &kinds[kindCount], err, sizeof(err))) {
+            fprintf(stderr, "%s:%d: %s\n", argv[1], lineNo, err[0] ? err : "too many kinds");
+            fclose(in);
+            return 1;
+        }
+        total += kinds[kindCount++].copies;
+    }
+    fclose(in);
+    // A dealt hand and the display must fit, and every card id one mask bit
+    int dealt = PLAYERS_MAX * MAX_HAND_SIZE + CARD_DISPLAY_SIZE;
+    if (kindCount == 0 || total < dealt || total > DECK_MAX) {
+        fprintf(stderr, "%s: %d kinds and %d cards; expected %d to %d cards\n",
+                argv[1], kindCount, total, dealt, DECK_MAX);
+        return 1;
+    }
+
+    char tmpPath[512];
+    FILE* f = Begin(argv[2], tmpPath, sizeof(tmpPath));
+    if (f == NULL) return 1;
+
+    fprintf(f, "// Generated by tools/reefcards from %s. Do not edit.\n", argv[1]);
+    fprintf(f, "#include \"cards.h\"\n\n");
+
+    fprintf(f, "const Card CARD_KINDS[CARD_KIND_COUNT] = {\n");
+    for (int k = 0; k < kindCount; ++k) EmitCard(f, k, &kinds[k].card);
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "const CompiledPattern CARD_PATTERNS[CARD_KIND_COUNT] = {\n");
+    for (int k = 0; k < kindCount; ++k) EmitPattern(f, k, &kinds[k].compiled);
+    fprintf(f, "};\n\n");
+
+    // Round-robin: copy 0 of every kind, then copy 1, ...
+    fprintf(f, "const uint8_t CARD_ID_KIND[DECK_MAX] = {");
+    int id = 0;
+    for (int copy = 0; id < total; ++copy) {
+        for (int k = 0; k < kindCount; ++k) {
+            if (copy >= kinds[k].copies) continue;
+            fprintf(f, "%s%d", id % 15 == 0 ? "\n    " : " ", k);
+            fprintf(f, "%s", ++id < total ? "," : "");
+        }
+    }
+    fprintf(f, "\n};\n");
+    if (!Commit(f, tmpPath, argv[2])) return 1;
+
+    f = Begin(argv[3], tmpPath, sizeof(tmpPath));
+    if (f == NULL) return 1;
+    fprintf(f, "// Generated by tools/reefcards from %s. Do not edit.\n", argv[1]);
+    fprintf(f, "#ifndef CARD_COUNT_H\n#define CARD_COUNT_H\n\n");
+    fprintf(f, "enum {\n");
+    fprintf(f, "    CARD_KIND_COUNT = %d,  // distinct cards; copies of one card share a kind (cards.h)\n", kindCount);
+    fprintf(f, "    DECK_MAX        = %d   // every copy of every kind\n", total);
+    fprintf(f, "};\n\n#endif\n");
+    return Commit(f, tmpPath, argv[3]) ? 0 : 1;
+}
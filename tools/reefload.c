@@ -0,0 +1,386 @@
+// reefload: drive reefd with many concurrent hotseat matches and report
+// action round-trip latency.
+//
+//   reefload [--tcp host:port | --unix path] [--conns N] [--threads T] [--seconds S]
+//            [--spectators N] [--players N]
+//
+// Each connection creates a match with a known seed, mirrors it locally and
+// plays random legal actions one at a time, so every server reply is also
+// checked against the local rules. Spectators subscribe to those matches,
+// apply every delta and are checked against the player's mirror when the
+// game ends.
+#define _GNU_SOURCE
+#include "delta.h"
+#include "protocol.h"
+#include "rng.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    int fd;
+    GameState mirror;
+    GameState finished;        // last completed game, for spectator checks
+    uint32_t finishedGames;
+    uint64_t seed;
+    uint32_t seq;
+    Action pending;
+    double sentAt;
+    uint8_t rbuf[PROTO_HEADER_SIZE + PROTO_MAX_BODY];
+    int rlen;
+
+    // Spectators only
+    bool spectator;
+    GameState view;
+    uint32_t viewVersion, ackedVersion;
+    uint32_t gamesSeen;
+    bool checkPending;         // saw the end before its player did
+} LoadConn;
+
+typedef struct {
+    int index, conns, spectators;
+    LoadConn* all;             // players first, then spectators
+    double deadline;
+    uint64_t rng;
+    double* samples;
+    int sampleCount, sampleCap;
+    uint64_t mismatches, games, errors;
+    uint64_t deltas, deltaBytes;
+} LoadThread;
+
+static const char* gTcp = "127.0.0.1:7878";
+static const char* gUnix = NULL;
+static int gPlayers = PLAYERS_MIN;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int Connect(void)
+{
+    int fd;
+    if (gUnix) {
+        struct sockaddr_un sa = { 0 };
+        sa.sun_family = AF_UNIX;
+        snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", gUnix);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) return -1;
+    } else {
+        char host[256];
+        snprintf(host, sizeof(host), "%s", gTcp);
+        char* colon = strrchr(host, ':');
+        if (colon == NULL) return -1;
+        *colon = '\0';
+        struct sockaddr_in sa = { 0 };
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons((uint16_t)atoi(colon + 1));
+        inet_pton(AF_INET, host, &sa.sin_addr);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0) return -1;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+static void SendFrame(LoadThread* t, LoadConn* c, ProtoWriter* w)
+{
+    if (send(c->fd, w->buf, (size_t)w->len, MSG_NOSIGNAL) != w->len) t->errors++;
+}
+
+static void SendCreate(LoadThread* t, LoadConn* c)
+{
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_CREATE);
+    ProtoPutU64(&w, RngNext(&t->rng) | 1);
+    ProtoPutU8(&w, PROTO_SEAT_ALL);
+    ProtoPutU8(&w, (uint8_t)gPlayers);
+    ProtoEndFrame(&w);
+    SendFrame(t, c, &w);
+}
+
+static void SendNextAction(LoadThread* t, LoadConn* c)
+{
+    Action legal[RULES_MAX_ACTIONS];
+    int n = RulesListActions(&c->mirror, legal);
+    c->pending = legal[RngRange(&t->rng, n)];
+
+    uint8_t buf[32];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_ACTION);
+    ProtoPutU32(&w, ++c->seq);
+    ProtoPutAction(&w, c->pending);
+    ProtoEndFrame(&w);
+    c->sentAt = Now();
+    SendFrame(t, c, &w);
+}
+
+static void SendLeave(LoadThread* t, LoadConn* c)
+{
+    uint8_t buf[8];
+    ProtoWriter w;
+    ProtoWriterInit(&w, buf, sizeof(buf));
+    ProtoBeginFrame(&w, MSG_LEAVE);
+    ProtoEndFrame(&w);
+    SendFrame(t, c, &w);
+}
+
+// Spectators watching player i are i, i + conns, i + 2 * conns, ...
+static void SubscribeWatchers(LoadThread* t, int player, uint32_t matchId)
+{
+    for (int k = player; k < t->spectators; k += t->conns) {
+        LoadConn* s = &t->all[t->conns + k];
+        SendLeave(t, s);
+        uint8_t buf[32];
+        ProtoWriter w;
+        ProtoWriterInit(&w, buf, sizeof(buf));
+        ProtoBeginFrame(&w, MSG_SUBSCRIBE);
+        ProtoPutU32(&w, matchId);
+        ProtoPutU32(&w, PROTO_VERSION_NONE);
+        ProtoEndFrame(&w);
+        SendFrame(t, s, &w);
+    }
+}
+
+// Hands are hidden from spectators; everything else must match
+static bool SameAsPublic(const GameState* g, const GameState* view)
+{
+    if (g->playersCount != view->playersCount || g->currentPlayer != view->currentPlayer ||
+        g->deckSize != view->deckSize || g->gameEnded != view->gameEnded || g->finalRound != view->finalRound) return false;
+    if (memcmp(g->supplies, view->supplies, sizeof(g->supplies)) != 0 ||
+        memcmp(g->display, view->display, sizeof(g->display)) != 0 ||
+        memcmp(g->displayTokens, view->displayTokens, sizeof(g->displayTokens)) != 0) return false;
+    for (int p = 0; p < g->playersCount; ++p) {
+        const Player* a = &g->players[p];
+        const Player* b = &view->players[p];
+        if (a->points != b->points || a->handSize != b->handSize) return false;
+        if (memcmp(a->board, b->board, sizeof(a->board)) != 0) return false;
+    }
+    return true;
+}
+
+// Spectator and player sockets race, so whichever side sees the end of
+// game k second does the comparison
+static void CheckFinished(LoadThread* t, LoadConn* spectator, const LoadConn* player)
+{
+    spectator->checkPending = false;
+    if (player->finishedGames < spectator->gamesSeen) { spectator->checkPending = true; return; }
+    if (player->finishedGames == spectator->gamesSeen && !SameAsPublic(&player->finished, &spectator->view)) {
+        t->mismatches++;
+    }
+}
+
+static void HandleDelta(LoadThread* t, LoadConn* c, const uint8_t* data, int len)
+{
+    t->deltas++;
+    t->deltaBytes += (uint64_t)len + PROTO_HEADER_SIZE + 1;
+    if (!DeltaApply(&c->view, &c->viewVersion, data, len)) { t->mismatches++; return; }
+
+    if (c->view.gameEnded) {
+        c->gamesSeen++;
+        CheckFinished(t, c, &t->all[(c - t->all - t->conns) % t->conns]);
+    }
+    if (c->viewVersion - c->ackedVersion >= 8 || c->view.gameEnded) {
+        uint8_t buf[16];
+        ProtoWriter w;
+        ProtoWriterInit(&w, buf, sizeof(buf));
+        ProtoBeginFrame(&w, MSG_ACK);
+        ProtoPutU32(&w, c->viewVersion);
+        ProtoEndFrame(&w);
+        SendFrame(t, c, &w);
+        c->ackedVersion = c->viewVersion;
+    }
+}
+
+static void HandleFrame(LoadThread* t, LoadConn* c, const uint8_t* body, int len)
+{
+    ProtoReader r;
+    ProtoReaderInit(&r, body + 1, len - 1);
+
+    switch (body[0]) {
+        case MSG_JOINED: {
+            uint32_t id = ProtoGetU32(&r);
+            ProtoGetU8(&r);
+            c->seed = ProtoGetU64(&r);
+            int players = ProtoGetU8(&r);
+            RulesNewGame(&c->mirror, players, c->seed);
+            SubscribeWatchers(t, (int)(c - t->all), id);
+            SendNextAction(t, c);
+            break;
+        }
+        case MSG_DELTA:
+            HandleDelta(t, c, body + 1, len - 1);
+            break;
+        case MSG_RESULT: {
+            double rtt = Now() - c->sentAt;
+            ProtoGetU32(&r);
+            bool ok = ProtoGetU8(&r) != 0;
+            if (t->sampleCount < t->sampleCap) t->samples[t->sampleCount++] = rtt;
+            if (!ok || !RulesApply(&c->mirror, c->pending)) t->mismatches++;
+
+            if (c->mirror.gameEnded || !ok) {
+                t->games++;
+                c->finished = c->mirror;
+                c->finishedGames++;
+                for (int k = (int)(c - t->all); k < t->spectators; k += t->conns) {
+                    LoadConn* s = &t->all[t->conns + k];
+                    if (s->checkPending) CheckFinished(t, s, c);
+                }
+                SendLeave(t, c);
+                if (Now() < t->deadline) SendCreate(t, c);
+            } else if (Now() < t->deadline) {
+                SendNextAction(t, c);
+            }
+            break;
+        }
+        case MSG_ERROR:
+            t->errors++;
+            break;
+        default:
+            break;
+    }
+}
+
+static void* LoadThreadMain(void* arg)
+{
+    LoadThread* t = arg;
+    int total = t->conns + t->spectators;
+    LoadConn* conns = calloc((size_t)total, sizeof(LoadConn));
+    t->all = conns;
+    int epfd = epoll_create1(0);
+
+    // Spectators connect first so they are ready when the first JOINED arrives
+    for (int i = total - 1; i >= 0; --i) {
+        conns[i].fd = Connect();
+        if (conns[i].fd < 0) {
+            fprintf(stderr, "reefload: connect failed: %s\n", strerror(errno));
+            exit(1);
+        }
+        struct epoll_event ev = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conns[i].fd, &ev);
+        conns[i].spectator = i >= t->conns;
+        if (!conns[i].spectator) SendCreate(t, &conns[i]);
+    }
+
+    struct epoll_event events[128];
+    while (Now() < t->deadline + 0.5) {
+        int n = epoll_wait(epfd, events, 128, 100);
+        for (int i = 0; i < n; ++i) {
+            LoadConn* c = &conns[events[i].data.u32];
+            ssize_t got = read(c->fd, c->rbuf + c->rlen, sizeof(c->rbuf) - (size_t)c->rlen);
+            if (got <= 0) { t->errors++; epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL); continue; }
+            c->rlen += (int)got;
+
+            int frameLen;
+            while ((frameLen = ProtoFrameLength(c->rbuf, c->rlen)) > 0) {
+                HandleFrame(t, c, c->rbuf + PROTO_HEADER_SIZE, frameLen - PROTO_HEADER_SIZE);
+                c->rlen -= frameLen;
+                memmove(c->rbuf, c->rbuf + frameLen, (size_t)c->rlen);
+            }
+        }
+    }
+
+    for (int i = 0; i < total; ++i) close(conns[i].fd);
+    close(epfd);
+    free(conns);
+    return NULL;
+}
+
+static int CompareDouble(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv)
+{
+    int conns = 256, threads = 4, spectators = 0;
+    double seconds = 5.0;
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--tcp") == 0 && hasValue)           gTcp = argv[++i];
+        else if (strcmp(argv[i], "--unix") == 0 && hasValue)     gUnix = argv[++i];
+        else if (strcmp(argv[i], "--conns") == 0 && hasValue)    conns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue)  threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue)  seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--spectators") == 0 && hasValue) spectators = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--players") == 0 && hasValue)  gPlayers = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--tcp host:port | --unix path] [--conns N] [--threads T] [--seconds S] [--spectators N]\n"
+                            "       [--players N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (conns < threads) conns = threads;
+
+    LoadThread* ts = calloc((size_t)threads, sizeof(LoadThread));
+    pthread_t* handles = calloc((size_t)threads, sizeof(pthread_t));
+    double start = Now();
+    for (int i = 0; i < threads; ++i) {
+        ts[i].index = i;
+        ts[i].conns = conns / threads + (i < conns % threads ? 1 : 0);
+        ts[i].spectators = spectators / threads + (i < spectators % threads ? 1 : 0);
+        ts[i].deadline = start + seconds;
+        ts[i].rng = RngSeedFromTime() + (uint64_t)i;
+        ts[i].sampleCap = 1 << 22;
+        ts[i].samples = malloc((size_t)ts[i].sampleCap * sizeof(double));
+        pthread_create(&handles[i], NULL, LoadThreadMain, &ts[i]);
+    }
+
+    int total = 0;
+    uint64_t mismatches = 0, games = 0, errors = 0, deltas = 0, deltaBytes = 0;
+    for (int i = 0; i < threads; ++i) {
+        pthread_join(handles[i], NULL);
+        total += ts[i].sampleCount;
+        mismatches += ts[i].mismatches;
+        games += ts[i].games;
+        errors += ts[i].errors;
+        deltas += ts[i].deltas;
+        deltaBytes += ts[i].deltaBytes;
+    }
+
+    double* all = malloc((size_t)(total > 0 ? total : 1) * sizeof(double));
+    int k = 0;
+    for (int i = 0; i < threads; ++i) {
+        memcpy(all + k, ts[i].samples, (size_t)ts[i].sampleCount * sizeof(double));
+        k += ts[i].sampleCount;
+        free(ts[i].samples);
+    }
+    qsort(all, (size_t)total, sizeof(double), CompareDouble);
+
+    printf("reefload: %d conns, %d actions in %.1fs (%.0f/s), %llu games, %llu mismatches, %llu errors\n",
+           conns, total, seconds, total / seconds, (unsigned long long)games,
+           (unsigned long long)mismatches, (unsigned long long)errors);
+    if (deltas > 0) {
+        printf("reefload: %d spectators, %llu deltas, %.1f bytes/delta\n", spectators,
+               (unsigned long long)deltas, (double)deltaBytes / (double)deltas);
+    }
+    if (total > 0) {
+        printf("reefload: rtt p50 %.1fus  p99 %.1fus  p99.9 %.1fus  max %.1fus\n",
+               all[total / 2] * 1e6, all[(int)(total * 0.99)] * 1e6,
+               all[(int)(total * 0.999)] * 1e6, all[total - 1] * 1e6);
+    }
+
+    free(all);
+    free(ts);
+    free(handles);
+    return mismatches == 0 && errors == 0 ? 0 : 1;
+}
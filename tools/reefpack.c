@@ -0,0 +1,178 @@
+// reefpack: decode resources once at build time into a single mmap-able bundle
+//
+//   reefpack <out.pak> <fontSize> <file.png|file.ttf>...
+//
+// Images keep the pixel format they decode to; fonts are rasterized into an
+// atlas at fontSize with their glyph metrics stored alongside.
+#include "raylib.h"
+#include "bundle.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    BundleEntry entry;
+    const void* pixels;
+    BundleGlyph* glyphs;
+    Image image;
+} PackItem;
+
+static const char* BaseName(const char* path)
+{
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static bool HasExtension(const char* path, const char* ext)
+{
+    size_t n = strlen(path), e = strlen(ext);
+    return n > e && strcmp(path + n - e, ext) == 0;
+}
+
+static uint64_t AlignUp(uint64_t v)
+{
+    return (v + BUNDLE_ALIGN - 1) & ~(uint64_t)(BUNDLE_ALIGN - 1);
+}
+
+static bool PackImage(PackItem* item, const char* path)
+{
+    item->image = LoadImage(path);
+    if (item->image.data == NULL) return false;
+
+    item->entry.kind   = BUNDLE_ENTRY_IMAGE;
+    item->entry.width  = item->image.width;
+    item->entry.height = item->image.height;
+    item->entry.format = item->image.format;
+    item->entry.size   = (uint64_t)GetPixelDataSize(item->image.width, item->image.height, item->image.format);
+    item->pixels = item->image.data;
+    return true;
+}
+
+static bool PackFont(PackItem* item, const char* path, int fontSize)
+{
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(path, &dataSize);
+    if (data == NULL) return false;
+
+    // Same parameters LoadFontEx uses: default 95 ASCII glyphs, padding 4
+    const int glyphCount = 95;
+    const int padding = 4;
+    GlyphInfo* glyphs = LoadFontData(data, dataSize, fontSize, NULL, glyphCount, FONT_DEFAULT);
+    UnloadFileData(data);
+    if (glyphs == NULL) return false;
+
+    Rectangle* recs = NULL;
+    item->image = GenImageFontAtlas(glyphs, &recs, glyphCount, fontSize, padding, 0);
+
+    item->glyphs = calloc((size_t)glyphCount, sizeof(BundleGlyph));
+    for (int i = 0; i < glyphCount; ++i) {
+        item->glyphs[i].value    = glyphs[i].value;
+        item->glyphs[i].offsetX  = glyphs[i].offsetX;
+        item->glyphs[i].offsetY  = glyphs[i].offsetY;
+        item->glyphs[i].advanceX = glyphs[i].advanceX;
+        item->glyphs[i].x        = recs[i].x;
+        item->glyphs[i].y        = recs[i].y;
+        item->glyphs[i].width    = recs[i].width;
+        item->glyphs[i].height   = recs[i].height;
+    }
+    UnloadFontData(glyphs, glyphCount);
+    MemFree(recs);
+
+    item->entry.kind         = BUNDLE_ENTRY_FONT;
+    item->entry.width        = item->image.width;
+    item->entry.height       = item->image.height;
+    item->entry.format       = item->image.format;
+    item->entry.size         = (uint64_t)GetPixelDataSize(item->image.width, item->image.height, item->image.format);
+    item->entry.baseSize     = fontSize;
+    item->entry.glyphCount   = glyphCount;
+    item->entry.glyphPadding = padding;
+    item->pixels = item->image.data;
+    return true;
+}
+
+static bool WritePadding(FILE* f, uint64_t target)
+{
+    static const uint8_t zeros[BUNDLE_ALIGN];
+    long pos = ftell(f);
+    if (pos < 0) return false;
+    uint64_t pad = target - (uint64_t)pos;
+    return pad == 0 || fwrite(zeros, 1, (size_t)pad, f) == pad;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <out.pak> <fontSize> <files...>\n", argv[0]);
+        return 1;
+    }
+
+    const char* outPath = argv[1];
+    int fontSize = atoi(argv[2]);
+    int count = argc - 3;
+    PackItem* items = calloc((size_t)count, sizeof(PackItem));
+
+    for (int i = 0; i < count; ++i) {
+        const char* path = argv[3 + i];
+        PackItem* item = &items[i];
+        snprintf(item->entry.name, BUNDLE_NAME_MAX, "%s", BaseName(path));
+
+        bool ok = (HasExtension(path, ".ttf") || HasExtension(path, ".otf"))
+            ? PackFont(item, path, fontSize)
+            : PackImage(item, path);
+        if (!ok) {
+            fprintf(stderr, "reefpack: failed to decode %s\n", path);
+            return 1;
+        }
+    }
+
+    // Assign page-aligned offsets after the entry table
+    uint64_t offset = AlignUp(sizeof(BundleHeader) + (uint64_t)count * sizeof(BundleEntry));
+    for (int i = 0; i < count; ++i) {
+        items[i].entry.offset = offset;
+        offset = AlignUp(offset + items[i].entry.size);
+        if (items[i].entry.kind == BUNDLE_ENTRY_FONT) {
+            items[i].entry.glyphOffset = offset;
+            offset = AlignUp(offset + (uint64_t)items[i].entry.glyphCount * sizeof(BundleGlyph));
+        }
+    }
+
+    // Write to a temporary name so a failed pack never leaves a torn bundle
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", outPath);
+    FILE* f = fopen(tmpPath, "wb");
+    if (f == NULL) {
+        fprintf(stderr, "reefpack: cannot write %s\n", tmpPath);
+        return 1;
+    }
+
+    BundleHeader header = { BUNDLE_MAGIC, BUNDLE_VERSION, (uint32_t)count, 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    for (int i = 0; i < count && ok; ++i) {
+        ok = fwrite(&items[i].entry, sizeof(BundleEntry), 1, f) == 1;
+    }
+    for (int i = 0; i < count && ok; ++i) {
+        const BundleEntry* e = &items[i].entry;
+        ok = WritePadding(f, e->offset) && fwrite(items[i].pixels, 1, (size_t)e->size, f) == e->size;
+        if (ok && e->kind == BUNDLE_ENTRY_FONT) {
+            ok = WritePadding(f, e->glyphOffset) &&
+                 fwrite(items[i].glyphs, sizeof(BundleGlyph), (size_t)e->glyphCount, f) == (size_t)e->glyphCount;
+        }
+    }
+    ok = WritePadding(f, offset) && ok;
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmpPath, outPath) != 0) {
+        fprintf(stderr, "reefpack: failed writing %s\n", outPath);
+        remove(tmpPath);
+        return 1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        printf("reefpack: %-24s %4dx%-4d %8llu bytes\n", items[i].entry.name,
+               items[i].entry.width, items[i].entry.height, (unsigned long long)items[i].entry.size);
+        UnloadImage(items[i].image);
+        free(items[i].glyphs);
+    }
+    free(items);
+    return 0;
+}
@@ -0,0 +1,361 @@
+// reefsynergy: measure card synergy over sampled boards and write the
+// tables of synergy.h.
+//
+//   reefsynergy [--threads T] [--pin] [--games N] [--seed S] [--players N]
+//               [--bot SPEC] [--report SEC] [--out FILE]
+//
+// Boards come from self-play by the bot (greedy by default). Its synergy
+// weight is forced to zero, so the tables never shape the boards they are
+// measured on. At the start of every turn the mover's board is a sample:
+// for each card kind the two pieces are placed in every legal way (piece1
+// first, as the rules do) and every kind's score change is recorded. Pair
+// entries are the best change of one kind's score, triple entries the best
+// change of two kinds' scores together; both are averaged per board stage.
+// Kinds carrying the same two colors share the work.
+//
+// Games run as a parallel-for on the job system in chunks, each worker
+// summing into its own tables. Game i is dealt from seed + i, so a run is
+// reproducible whatever the thread count. The output (src/synergy_data.c
+// by default) is written to a temporary file and renamed into place.
+#define _GNU_SOURCE
+#include "bot.h"
+#include "cards.h"
+#include "jobs.h"
+#include "patterns.h"
+#include "rng.h"
+#include "synergy.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    SYNERGY_CHUNK = 16  // games per job; a game is a few hundred ms of boards
+};
+
+// Sums of best score changes, in points; every field is an int64_t
+typedef struct {
+    int64_t pair[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT];
+    int64_t triple[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS];
+    int64_t boards[SYNERGY_STAGES];
+    int64_t games;
+} SynergySums;
+
+typedef struct {
+    _Alignas(64) SynergySums sums;  // one cache line apart from the next worker's
+} WorkerSums;
+
+// Distinct (piece1, piece2) color pairs and the kinds that carry each
+typedef struct {
+    CoralColor first, second;
+    uint64_t kinds;
+} PieceCombo;
+
+typedef struct {
+    BotConfig bot;
+    int players;
+    uint64_t seed;
+    int games;
+    PieceCombo combos[CARD_KIND_COUNT];
+    int comboCount;
+    WorkerSums* perWorker;
+    _Alignas(64) atomic_int done;
+} Run;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void FindCombos(Run* run)
+{
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+        CoralColor first = CARD_KINDS[k].piece1, second = CARD_KINDS[k].piece2;
+        int c = 0;
+        while (c < run->comboCount && (run->combos[c].first != first || run->combos[c].second != second)) ++c;
+        if (c == run->comboCount) run->combos[run->comboCount++] = (PieceCombo){ first, second, 0 };
+        run->combos[c].kinds |= (uint64_t)1 << k;
+    }
+}
+
+static int Pieces(const Player* pl)
+{
+    int pieces = 0;
+    for (int r = 0; r < BOARD_SIZE; ++r) {
+        for (int c = 0; c < BOARD_SIZE; ++c) pieces += pl->board[r][c].height;
+    }
+    return pieces;
+}
+
+static bool Push(Player* pl, int cell, CoralColor color)
+{
+    CoralStack* s = &pl->board[cell / BOARD_SIZE][cell % BOARD_SIZE];
+    if (color == CORAL_NONE || s->height >= MAX_STACK_HEIGHT) return false;
+    s->pieces[s->height++] = color;
+    return true;
+}
+
+static void Pop(Player* pl, int cell)
+{
+    CoralStack* s = &pl->board[cell / BOARD_SIZE][cell % BOARD_SIZE];
+    s->pieces[--s->height] = CORAL_NONE;
+}
+
+// Every kind's score change with the pieces down, into the best so far
+static void Measure(const Player* work, const int* base, int* pairBest, int* tripleBest)
+{
+    BoardMasks masks;
+    BoardMasksBuild(work, &masks);
+    int d[CARD_KIND_COUNT];
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) {
+        d[k] = ScoreCompiled(&masks, &CARD_PATTERNS[k]) - base[k];
+        if (d[k] > pairBest[k]) pairBest[k] = d[k];
+    }
+    int i = 0;
+    for (int b = 0; b < CARD_KIND_COUNT; ++b) {
+        for (int c = b; c < CARD_KIND_COUNT; ++c, ++i) {
+            if (d[b] + d[c] > tripleBest[i]) tripleBest[i] = d[b] + d[c];
+        }
+    }
+}
+
+static void SampleBoard(const Run* run, const Player* pl, SynergySums* s)
+{
+    int stage = SynergyStage(Pieces(pl));
+    BoardMasks masks;
+    BoardMasksBuild(pl, &masks);
+    int base[CARD_KIND_COUNT];
+    for (int k = 0; k < CARD_KIND_COUNT; ++k) base[k] = ScoreCompiled(&masks, &CARD_PATTERNS[k]);
+
+    Player work = *pl;
+    for (int u = 0; u < run->comboCount; ++u) {
+        const PieceCombo* combo = &run->combos[u];
+        int pairBest[CARD_KIND_COUNT], tripleBest[SYNERGY_KIND_PAIRS];
+        for (int k = 0; k < CARD_KIND_COUNT; ++k) pairBest[k] = INT_MIN;
+        for (int i = 0; i < SYNERGY_KIND_PAIRS; ++i) tripleBest[i] = INT_MIN;
+
+        // A second piece with no room is forfeited, as in play; with no
+        // room for either nothing changes
+        bool measured = false;
+        for (int x = 0; x < BOARD_SIZE * BOARD_SIZE; ++x) {
+            if (!Push(&work, x, combo->first)) continue;
+            bool second = false;
+            for (int y = 0; y < BOARD_SIZE * BOARD_SIZE; ++y) {
+                if (!Push(&work, y, combo->second)) continue;
+                Measure(&work, base, pairBest, tripleBest);
+                second = true;
+                Pop(&work, y);
+            }
+            if (!second) Measure(&work, base, pairBest, tripleBest);
+            measured = true;
+            Pop(&work, x);
+        }
+        if (!measured) Measure(&work, base, pairBest, tripleBest);
+
+        for (int a = 0; a < CARD_KIND_COUNT; ++a) {
+            if (!(combo->kinds & ((uint64_t)1 << a))) continue;
+            for (int k = 0; k < CARD_KIND_COUNT; ++k) s->pair[stage][a][k] += pairBest[k];
+            for (int i = 0; i < SYNERGY_KIND_PAIRS; ++i) s->triple[stage][a][i] += tripleBest[i];
+        }
+    }
+    s->boards[stage]++;
+}
+
+static void PlayGame(const Run* run, uint64_t seed, SynergySums* s)
+{
+    uint64_t botRng = seed ^ 0x9E3779B97F4A7C15ull;
+    GameState g;
+    RulesNewGame(&g, run->players, seed);
+    while (!g.gameEnded) {
+        if (!g.placement.active) SampleBoard(run, &g.players[g.currentPlayer], s);
+        Action a = BotChooseAction(&g, &run->bot, &botRng);
+        if (!RulesApply(&g, a)) {
+            fprintf(stderr, "reefsynergy: %s chose an illegal action\n", run->bot.name);
+            exit(1);
+        }
+    }
+    s->games++;
+}
+
+static void PlayGames(void* ctx, int begin, int end)
+{
+    Run* run = ctx;
+    SynergySums* s = &run->perWorker[JobsWorkerIndex() + 1].sums;  // slot 0: not on a worker
+    for (int i = begin; i < end; ++i) PlayGame(run, run->seed + (uint64_t)i, s);
+    atomic_fetch_add_explicit(&run->done, end - begin, memory_order_relaxed);
+}
+
+static void Merge(SynergySums* into, const SynergySums* from)
+{
+    int64_t* dst = (int64_t*)into;
+    const int64_t* src = (const int64_t*)from;
+    for (size_t i = 0; i < sizeof(SynergySums) / sizeof(int64_t); ++i) dst[i] += src[i];
+}
+
+// Mean points as a table entry, clamped to what a uint8_t holds
+static int Entry(int64_t sum, int64_t boards, int* clamped)
+{
+    if (boards == 0) return 0;
+    double v = (double)sum / (double)boards * SYNERGY_UNIT + 0.5;
+    if (v < 0.0) return 0;
+    if (v > UINT8_MAX) {
+        (*clamped)++;
+        return UINT8_MAX;
+    }
+    return (int)v;
+}
+
+static void EmitRow(FILE* f, const int64_t* sums, int count, int64_t boards, int* clamped)
+{
+    fprintf(f, "{");
+    for (int i = 0; i < count; ++i) {
+        if (i % 20 == 0 && count > 20) fprintf(f, "\n            ");
+        else fprintf(f, " ");
+        fprintf(f, "%d%s", Entry(sums[i], boards, clamped), i + 1 < count ? "," : "");
+    }
+    fprintf(f, count > 20 ? "\n        }" : " }");
+}
+
+static bool Write(const char* path, const Run* run, const SynergySums* s)
+{
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "w");
+    if (f == NULL) return false;
+
+    int64_t boards = 0;
+    for (int st = 0; st < SYNERGY_STAGES; ++st) boards += s->boards[st];
+    fprintf(f, "// Generated by tools/reefsynergy: %lld boards from %lld games (%d players, %s, seed %llu).\n"
+               "// Do not edit.\n", (long long)boards, (long long)s->games, run->players, run->bot.name,
+            (unsigned long long)run->seed);
+    fprintf(f, "#include \"synergy.h\"\n");
+    // Another card list changes the table sizes; until it is measured again
+    // the tables are zero (no synergy) rather than a build error
+    fprintf(f, "\n#if CARD_KIND_COUNT != %d\n"
+               "const uint8_t SYNERGY_PAIR[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT];\n"
+               "const uint8_t SYNERGY_TRIPLE[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS];\n"
+               "#else\n", CARD_KIND_COUNT);
+
+    int clamped = 0;
+    fprintf(f, "\nconst uint8_t SYNERGY_PAIR[SYNERGY_STAGES][CARD_KIND_COUNT][CARD_KIND_COUNT] = {\n");
+    for (int st = 0; st < SYNERGY_STAGES; ++st) {
+        fprintf(f, "    [%d] = {  // %lld boards\n", st, (long long)s->boards[st]);
+        for (int a = 0; a < CARD_KIND_COUNT; ++a) {
+            fprintf(f, "        ");
+            EmitRow(f, s->pair[st][a], CARD_KIND_COUNT, s->boards[st], &clamped);
+            fprintf(f, "%s\n", a + 1 < CARD_KIND_COUNT ? "," : "");
+        }
+        fprintf(f, "    }%s\n", st + 1 < SYNERGY_STAGES ? "," : "");
+    }
+    fprintf(f, "};\n");
+
+    fprintf(f, "\nconst uint8_t SYNERGY_TRIPLE[SYNERGY_STAGES][CARD_KIND_COUNT][SYNERGY_KIND_PAIRS] = {\n");
+    for (int st = 0; st < SYNERGY_STAGES; ++st) {
+        fprintf(f, "    [%d] = {\n", st);
+        for (int a = 0; a < CARD_KIND_COUNT; ++a) {
+            fprintf(f, "        ");
+            EmitRow(f, s->triple[st][a], SYNERGY_KIND_PAIRS, s->boards[st], &clamped);
+            fprintf(f, "%s\n", a + 1 < CARD_KIND_COUNT ? "," : "");
+        }
+        fprintf(f, "    }%s\n", st + 1 < SYNERGY_STAGES ? "," : "");
+    }
+    fprintf(f, "};\n");
+    fprintf(f, "#endif\n");
+
+    bool ok = !ferror(f);
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return false;
+    }
+    if (clamped > 0) fprintf(stderr, "reefsynergy: %d entries clamped to %d\n", clamped, UINT8_MAX);
+    return true;
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--threads T] [--pin] [--games N] [--seed S] [--players N]\n"
+                    "       [--bot SPEC] [--report SEC] [--out FILE]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    static Run run;
+    int threads = JobsCpuCount();
+    bool pin = false;
+    double reportEvery = 5.0;
+    const char* outPath = "src/synergy_data.c";
+    run.players = PLAYERS_MIN;
+    run.seed = 1;
+    run.games = 2000;
+    BotDefaultConfig(&run.bot, BOT_GREEDY);
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue)      threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pin") == 0)                 pin = true;
+        else if (strcmp(argv[i], "--games") == 0 && hasValue)   run.games = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)    run.seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--players") == 0 && hasValue) run.players = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--report") == 0 && hasValue)  reportEvery = atof(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)     outPath = argv[++i];
+        else if (strcmp(argv[i], "--bot") == 0 && hasValue) {
+            if (!BotParseConfig(argv[++i], &run.bot)) {
+                fprintf(stderr, "reefsynergy: bad bot spec '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (run.players < PLAYERS_MIN || run.players > PLAYERS_MAX || run.games < 1) { Usage(argv[0]); return 1; }
+    if (threads < 1) threads = 1;
+    if (run.bot.useBook) {
+        fprintf(stderr, "reefsynergy: book bots are not supported\n");
+        return 1;
+    }
+    run.bot.weights[BOT_W_SYNERGY] = 0.0f;
+    FindCombos(&run);
+
+    run.perWorker = aligned_alloc(64, sizeof(WorkerSums) * (size_t)(threads + 1));
+    if (run.perWorker == NULL || !JobsStart(threads, pin)) { perror("reefsynergy"); return 1; }
+    memset(run.perWorker, 0, sizeof(WorkerSums) * (size_t)(threads + 1));
+    atomic_init(&run.done, 0);
+
+    double start = Now(), nextReport = start + reportEvery;
+    JobGroup group = { 0 };
+    JobRange range;
+    JobParallelForAsync(&group, &range, run.games, SYNERGY_CHUNK, PlayGames, &run);
+    while (!JobGroupDone(&group)) {
+        usleep(50 * 1000);
+        if (reportEvery > 0 && Now() >= nextReport) {
+            int done = atomic_load_explicit(&run.done, memory_order_relaxed);
+            fprintf(stderr, "reefsynergy: %d of %d games, %.1f/s\n", done, run.games, done / (Now() - start));
+            nextReport += reportEvery;
+        }
+    }
+    JobWait(&group);
+    JobsStop();
+
+    static SynergySums total;
+    for (int i = 0; i <= threads; ++i) Merge(&total, &run.perWorker[i].sums);
+    double elapsed = Now() - start;
+    fprintf(stderr, "reefsynergy: %lld games of %d players in %.1fs on %d threads; boards by stage",
+            (long long)total.games, run.players, elapsed, threads);
+    for (int st = 0; st < SYNERGY_STAGES; ++st) fprintf(stderr, " %lld", (long long)total.boards[st]);
+    fprintf(stderr, "\n");
+
+    bool ok = Write(outPath, &run, &total);
+    free(run.perWorker);
+    if (!ok) {
+        fprintf(stderr, "reefsynergy: cannot write %s\n", outPath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,345 @@
+// reeftourney: round-robin bot tournament with live Elo and SPRT stopping.
+//
+//   reeftourney [--threads T] [--pairs N] [--seed S] [--report SEC]
+//               [--sprt elo0,elo1] [--alpha A] [--beta B] [--book FILE]
+//               [--record DIR] bot bot [bot...]
+//
+// Bots use BotParseConfig syntax, e.g. "base=greedy" "v2=greedy:hand=0.8";
+// bots with "book=1" play from the --book opening book.
+//
+// Every pairing plays game pairs: two games from the same seed (so the same
+// deck order) with seats swapped, which cancels most of the luck of the
+// deal. Each pairing stops after --pairs N pairs, 2N games (2000 pairs by
+// default), or as soon as its SPRT accepts H0 (elo <= elo0) or H1
+// (elo >= elo1). Pairs run as a parallel-for on the job system,
+// interleaved across pairings; the pairs of a closed pairing are skipped.
+// Pair k of every pairing is dealt from seed + k.
+//
+// With --record, every game is also written to DIR as a game record
+// (record.h), named <seat 0>-<seat 1>-<seed>.record, for `reef --replay`.
+#define _GNU_SOURCE
+#include "book.h"
+#include "bot.h"
+#include "cards.h"
+#include "jobs.h"
+#include "record.h"
+#include "rng.h"
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+enum {
+    TOURNEY_MAX_BOTS = 16,
+    SPRT_MIN_PAIRS   = 16   // the variance estimate is meaningless before this
+};
+
+typedef enum {
+    PAIRING_RUNNING = 0,
+    PAIRING_H0,             // SPRT: not better than elo0
+    PAIRING_H1,             // SPRT: at least elo1 better
+    PAIRING_DONE            // game budget used up
+} PairingStatus;
+
+// Results are kept from a's point of view. A game pair scores 0..2 in half
+// points; penta[k] counts pairs that scored k/2.
+typedef struct {
+    int a, b;
+    int pairs;
+    uint64_t penta[5];
+    int wins, draws, losses;
+    double llr;
+    PairingStatus status;
+} Pairing;
+
+typedef struct {
+    BotConfig bots[TOURNEY_MAX_BOTS];
+    int botCount;
+    Pairing* pairings;
+    int pairingCount;
+    int maxPairs;
+    uint64_t seed;
+    const char* recordDir;       // NULL: games are not recorded
+
+    bool sprt;
+    double elo0, elo1, lowerBound, upperBound;
+
+    pthread_mutex_t lock;        // pairing results
+} Tourney;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double EloToScore(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+static double ScoreToElo(double score)
+{
+    if (score < 1e-6) score = 1e-6;
+    if (score > 1.0 - 1e-6) score = 1.0 - 1e-6;
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Mean and variance of the per-game score of one pair, in [0, 1]
+static void PairStats(const Pairing* p, double* mean, double* var)
+{
+    double n = 0.0, sum = 0.0, sq = 0.0;
+    for (int k = 0; k < 5; ++k) {
+        double x = k / 4.0;
+        n += (double)p->penta[k];
+        sum += x * (double)p->penta[k];
+        sq += x * x * (double)p->penta[k];
+    }
+    *mean = n > 0 ? sum / n : 0.5;
+    *var = n > 0 ? sq / n - *mean * *mean : 0.0;
+}
+
+// Elo estimate with a 95% interval from the pair variance
+static void PairElo(const Pairing* p, double* elo, double* lo, double* hi)
+{
+    double mean, var;
+    PairStats(p, &mean, &var);
+    double se = p->pairs > 0 ? sqrt(var / p->pairs) : 0.5;
+    *elo = ScoreToElo(mean);
+    *lo = ScoreToElo(mean - 1.96 * se);
+    *hi = ScoreToElo(mean + 1.96 * se);
+}
+
+// Generalized SPRT on the pair scores (normal approximation)
+static double PairLlr(const Pairing* p, double elo0, double elo1)
+{
+    double mean, var;
+    PairStats(p, &mean, &var);
+    // A one-sided pairing has no spread at all; floor the variance at what
+    // one pair scoring a quarter point the other way would give, so a
+    // pairing that never loses a pair still decides
+    double n = (double)p->pairs;
+    double floorVar = (n - 1.0) / (16.0 * n * n);
+    if (var < floorVar) var = floorVar;
+    double s0 = EloToScore(elo0), s1 = EloToScore(elo1);
+    return p->pairs * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * var);
+}
+
+// +1 if seat 0 won, -1 if seat 1 won, 0 for a draw
+static int PlayGame(const Tourney* t, const BotConfig* seat0, const BotConfig* seat1, uint64_t seed)
+{
+    const BotConfig* seats[2] = { seat0, seat1 };
+    uint64_t botRng = seed ^ 0x9E3779B97F4A7C15ull;
+    GameState g;
+    RulesNewGame(&g, 2, seed);  // head to head
+    Record record;
+    RecordInit(&record, seed, 2);
+
+    while (!g.gameEnded) {
+        Action a = BotChooseAction(&g, seats[g.currentPlayer], &botRng);
+        if (!RulesApply(&g, a)) {
+            fprintf(stderr, "reeftourney: %s chose an illegal action\n", seats[g.currentPlayer]->name);
+            exit(1);
+        }
+        if (t->recordDir != NULL) RecordAdd(&record, a);
+    }
+    if (t->recordDir != NULL) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s-%s-%llu.record", t->recordDir, seat0->name, seat1->name,
+                 (unsigned long long)seed);
+        if (!RecordWrite(&record, path)) fprintf(stderr, "reeftourney: cannot write %s\n", path);
+        RecordFree(&record);
+    }
+    int diff = g.players[0].points - g.players[1].points;
+    return (diff > 0) - (diff < 0);
+}
+
+static void RecordPair(Tourney* t, Pairing* p, int first, int second)
+{
+    // first: a in seat 0; second: a in seat 1 (already from a's side)
+    pthread_mutex_lock(&t->lock);
+    p->penta[first + second + 2]++;
+    p->pairs++;
+    for (int k = 0; k < 2; ++k) {
+        int r = k == 0 ? first : second;
+        if (r > 0) p->wins++;
+        else if (r < 0) p->losses++;
+        else p->draws++;
+    }
+
+    if (p->status == PAIRING_RUNNING) {
+        if (t->sprt && p->pairs >= SPRT_MIN_PAIRS) {
+            p->llr = PairLlr(p, t->elo0, t->elo1);
+            if (p->llr >= t->upperBound) p->status = PAIRING_H1;
+            else if (p->llr <= t->lowerBound) p->status = PAIRING_H0;
+        }
+        if (p->status == PAIRING_RUNNING && p->pairs >= t->maxPairs) p->status = PAIRING_DONE;
+    }
+    pthread_mutex_unlock(&t->lock);
+}
+
+static bool PairingOpen(Tourney* t, const Pairing* p)
+{
+    pthread_mutex_lock(&t->lock);
+    bool open = p->status == PAIRING_RUNNING;
+    pthread_mutex_unlock(&t->lock);
+    return open;
+}
+
+// Slot i is pair i / pairingCount of pairing i % pairingCount
+static void PlayPairs(void* ctx, int begin, int end)
+{
+    Tourney* t = ctx;
+    for (int i = begin; i < end; ++i) {
+        Pairing* p = &t->pairings[i % t->pairingCount];
+        if (!PairingOpen(t, p)) continue;
+        uint64_t seed = t->seed + (uint64_t)(i / t->pairingCount);
+        const BotConfig* a = &t->bots[p->a];
+        const BotConfig* b = &t->bots[p->b];
+        int first = PlayGame(t, a, b, seed);
+        int second = -PlayGame(t, b, a, seed);
+        RecordPair(t, p, first, second);
+    }
+}
+
+static const char* StatusName(PairingStatus s)
+{
+    switch (s) {
+        case PAIRING_H0:   return "H0";
+        case PAIRING_H1:   return "H1";
+        case PAIRING_DONE: return "done";
+        default:           return "running";
+    }
+}
+
+static void Report(Tourney* t, double elapsed)
+{
+    pthread_mutex_lock(&t->lock);
+    int games = 0;
+    for (int i = 0; i < t->pairingCount; ++i) games += 2 * t->pairings[i].pairs;
+    printf("--- %.1fs, %d games (%.0f/s)\n", elapsed, games, elapsed > 0 ? games / elapsed : 0.0);
+
+    for (int i = 0; i < t->pairingCount; ++i) {
+        const Pairing* p = &t->pairings[i];
+        double elo, lo, hi;
+        PairElo(p, &elo, &lo, &hi);
+        printf("%-16s vs %-16s %5d-%d-%d  elo %+7.1f [%+7.1f, %+7.1f]",
+               t->bots[p->a].name, t->bots[p->b].name, p->wins, p->draws, p->losses, elo, lo, hi);
+        if (t->sprt) printf("  llr %+5.2f [%.2f, %.2f]", p->llr, t->lowerBound, t->upperBound);
+        printf("  %s\n", StatusName(p->status));
+    }
+
+    // With more than two bots, also rate each one against the whole field
+    if (t->botCount > 2) {
+        for (int b = 0; b < t->botCount; ++b) {
+            double score = 0.0;
+            int n = 0;
+            for (int i = 0; i < t->pairingCount; ++i) {
+                const Pairing* p = &t->pairings[i];
+                int total = p->wins + p->draws + p->losses;
+                if (p->a == b) { score += p->wins + 0.5 * p->draws; n += total; }
+                else if (p->b == b) { score += p->losses + 0.5 * p->draws; n += total; }
+            }
+            printf("  %-16s %+7.1f vs field over %d games\n", t->bots[b].name,
+                   n > 0 ? ScoreToElo(score / n) : 0.0, n);
+        }
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&t->lock);
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--threads T] [--pairs N] [--seed S] [--report SEC]\n"
+                    "       [--sprt elo0,elo1] [--alpha A] [--beta B] [--book FILE] [--record DIR]\n"
+                    "       bot bot [bot...]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    static Tourney t;
+    int threads = JobsCpuCount();
+    double alpha = 0.05, beta = 0.05, reportEvery = 2.0;
+    const char* bookPath = NULL;
+    t.maxPairs = 2000;
+    t.seed = RngSeedFromTime();
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue)     threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pairs") == 0 && hasValue)  t.maxPairs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)   t.seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--report") == 0 && hasValue) reportEvery = atof(argv[++i]);
+        else if (strcmp(argv[i], "--alpha") == 0 && hasValue)  alpha = atof(argv[++i]);
+        else if (strcmp(argv[i], "--beta") == 0 && hasValue)   beta = atof(argv[++i]);
+        else if (strcmp(argv[i], "--book") == 0 && hasValue)   bookPath = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0 && hasValue) t.recordDir = argv[++i];
+        else if (strcmp(argv[i], "--sprt") == 0 && hasValue) {
+            if (sscanf(argv[++i], "%lf,%lf", &t.elo0, &t.elo1) != 2 || t.elo1 <= t.elo0) { Usage(argv[0]); return 1; }
+            t.sprt = true;
+        } else if (argv[i][0] != '-' && t.botCount < TOURNEY_MAX_BOTS) {
+            if (!BotParseConfig(argv[i], &t.bots[t.botCount])) {
+                fprintf(stderr, "reeftourney: bad bot spec '%s'\n", argv[i]);
+                return 1;
+            }
+            t.botCount++;
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (t.botCount < 2 || t.maxPairs < 1) { Usage(argv[0]); return 1; }
+    if (threads < 1) threads = 1;
+    if (t.maxPairs > INT_MAX / TOURNEY_MAX_BOTS / TOURNEY_MAX_BOTS) t.maxPairs = INT_MAX / TOURNEY_MAX_BOTS / TOURNEY_MAX_BOTS;
+    t.lowerBound = log(beta / (1.0 - alpha));
+    t.upperBound = log((1.0 - beta) / alpha);
+
+    t.pairings = calloc((size_t)(t.botCount * (t.botCount - 1) / 2), sizeof(Pairing));
+    for (int a = 0; a < t.botCount; ++a) {
+        for (int b = a + 1; b < t.botCount; ++b) {
+            t.pairings[t.pairingCount].a = a;
+            t.pairings[t.pairingCount].b = b;
+            t.pairingCount++;
+        }
+    }
+
+    Book book = { 0 };
+    if (bookPath != NULL && !BookOpen(&book, bookPath)) {
+        fprintf(stderr, "reeftourney: cannot open book %s (missing, or built for other cards)\n", bookPath);
+        return 1;
+    }
+    for (int i = 0; i < t.botCount; ++i) {
+        if (!t.bots[i].useBook) continue;
+        if (bookPath == NULL) { fprintf(stderr, "reeftourney: %s wants a book; pass --book\n", t.bots[i].name); return 1; }
+        t.bots[i].book = &book;
+    }
+
+    pthread_mutex_init(&t.lock, NULL);
+    if (!JobsStart(threads, false)) { perror("reeftourney"); return 1; }
+
+    double start = Now(), nextReport = start + reportEvery;
+    JobGroup group = { 0 };
+    JobRange range;
+    JobParallelForAsync(&group, &range, t.pairingCount * t.maxPairs, 1, PlayPairs, &t);
+
+    while (!JobGroupDone(&group)) {
+        usleep(50 * 1000);
+        if (reportEvery > 0 && Now() >= nextReport) {
+            Report(&t, Now() - start);
+            nextReport += reportEvery;
+        }
+    }
+    JobWait(&group);
+    JobsStop();
+    Report(&t, Now() - start);
+
+    pthread_mutex_destroy(&t.lock);
+    BookClose(&book);
+    free(t.pairings);
+    return 0;
+}
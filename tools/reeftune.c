@@ -0,0 +1,325 @@
+// reeftune: tune the greedy bot's evaluation weights by SPSA self-play.
+//
+//   reeftune [--threads T] [--pin] [--iterations N] [--pairs P] [--seed S]
+//            [--start SPEC] [--tune NAME,...] [--a A] [--c C]
+//            [--checkpoint FILE] [--report SEC]
+//
+// SPSA (simultaneous perturbation stochastic approximation): every
+// iteration moves all tuned weights at once, each by +c_k or -c_k at
+// random, plays the two perturbed bots against each other for P game pairs
+// and steps the weights along the signs by a_k times the score difference
+// over 2 c_k. Two bots and one match per iteration however many weights
+// are tuned; the noise averages out across iterations. The gains decay as
+// in Spall's guidelines, a_k = a / (k + 1 + N / 10)^0.602 and
+// c_k = c / (k + 1)^0.101, both relative to each weight's scale (its
+// starting value, at least 0.2). The points weight sets the scale of the
+// evaluation and is not tuned unless --tune names it.
+//
+// Both games of a pair are dealt from one seed with seats swapped, and
+// both candidates play the same seeds (common random numbers), so the luck
+// of the deal cancels in the difference. An iteration's pairs run as a
+// parallel-for on the job system; iteration k uses seeds seed + k * P on,
+// so a run is reproducible whatever the thread count.
+//
+// With --checkpoint the state is rewritten after every iteration (under a
+// temporary name, then renamed) and a run started with an existing file
+// resumes from it, settings included. The result is printed as a bot spec
+// for reeftourney.
+#define _GNU_SOURCE
+#include "bot.h"
+#include "jobs.h"
+#include "rng.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TUNE_CHECKPOINT_VERSION 1
+#define TUNE_MIN_SCALE          0.2f
+
+typedef struct {
+    // Settings, kept in the checkpoint
+    int iterations;
+    int pairs;
+    uint64_t seed;
+    double a, c;
+    uint32_t tuned;                    // bit per BotWeight
+    float scale[BOT_WEIGHT_COUNT];
+    float start[BOT_WEIGHT_COUNT];
+
+    // Progress
+    int iteration;                     // next to play
+    float weights[BOT_WEIGHT_COUNT];
+    int64_t games;
+} Tune;
+
+// One iteration's match
+typedef struct {
+    BotConfig plus, minus;
+    uint64_t seed;
+    int* results;                      // per pair, -2..2 from plus's side
+} Match;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// +1 if seat 0 won, -1 if seat 1 won, 0 for a draw
+static int PlayGame(const BotConfig* seat0, const BotConfig* seat1, uint64_t seed)
+{
+    const BotConfig* seats[2] = { seat0, seat1 };
+    uint64_t botRng = seed ^ 0x9E3779B97F4A7C15ull;
+    GameState g;
+    RulesNewGame(&g, 2, seed);
+
+    while (!g.gameEnded) {
+        Action a = BotChooseAction(&g, seats[g.currentPlayer], &botRng);
+        if (!RulesApply(&g, a)) {
+            fprintf(stderr, "reeftune: a bot chose an illegal action\n");
+            exit(1);
+        }
+    }
+    int diff = g.players[0].points - g.players[1].points;
+    return (diff > 0) - (diff < 0);
+}
+
+static void PlayPairs(void* ctx, int begin, int end)
+{
+    Match* m = ctx;
+    for (int i = begin; i < end; ++i) {
+        uint64_t seed = m->seed + (uint64_t)i;
+        m->results[i] = PlayGame(&m->plus, &m->minus, seed) - PlayGame(&m->minus, &m->plus, seed);
+    }
+}
+
+static void SpecString(const float* weights, char* out, size_t size)
+{
+    int n = snprintf(out, size, "tuned=greedy:");
+    for (int w = 0; w < BOT_WEIGHT_COUNT && n > 0 && (size_t)n < size; ++w) {
+        n += snprintf(out + n, size - (size_t)n, "%s%s=%.4g", w ? "," : "", BOT_WEIGHT_NAME[w], weights[w]);
+    }
+}
+
+static bool SaveCheckpoint(const char* path, const Tune* t)
+{
+    char tmpPath[512];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE* f = fopen(tmpPath, "w");
+    if (f == NULL) return false;
+
+    fprintf(f, "reeftune %d\n", TUNE_CHECKPOINT_VERSION);
+    fprintf(f, "iterations %d\npairs %d\nseed %llu\na %.17g\nc %.17g\ntuned %u\n", t->iterations, t->pairs,
+            (unsigned long long)t->seed, t->a, t->c, (unsigned)t->tuned);
+    fprintf(f, "iteration %d\ngames %lld\n", t->iteration, (long long)t->games);
+    for (int w = 0; w < BOT_WEIGHT_COUNT; ++w) {
+        fprintf(f, "weight %s %.9g %.9g %.9g\n", BOT_WEIGHT_NAME[w], t->weights[w], t->start[w], t->scale[w]);
+    }
+
+    bool ok = !ferror(f) && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return false;
+    }
+    return true;
+}
+
+// False if the file is missing (errno set) or not a checkpoint of this
+// version (errno 0)
+static bool LoadCheckpoint(const char* path, Tune* t)
+{
+    FILE* f = fopen(path, "r");
+    if (f == NULL) return false;
+
+    Tune in = *t;
+    int version = 0, seen = 0;
+    unsigned long long seed = 0;
+    long long games = 0;
+    char line[256];
+    bool ok = fgets(line, sizeof(line), f) != NULL && sscanf(line, "reeftune %d", &version) == 1 &&
+              version == TUNE_CHECKPOINT_VERSION;
+    while (ok && fgets(line, sizeof(line), f) != NULL) {
+        char name[32];
+        float weight, start, scale;
+        if (sscanf(line, "iterations %d", &in.iterations) == 1 || sscanf(line, "pairs %d", &in.pairs) == 1 ||
+            sscanf(line, "a %lf", &in.a) == 1 || sscanf(line, "c %lf", &in.c) == 1 ||
+            sscanf(line, "tuned %u", &in.tuned) == 1 || sscanf(line, "iteration %d", &in.iteration) == 1) {
+            continue;
+        }
+        if (sscanf(line, "seed %llu", &seed) == 1) { in.seed = seed; continue; }
+        if (sscanf(line, "games %lld", &games) == 1) { in.games = games; continue; }
+        if (sscanf(line, "weight %31s %f %f %f", name, &weight, &start, &scale) == 4) {
+            int w = 0;
+            while (w < BOT_WEIGHT_COUNT && strcmp(name, BOT_WEIGHT_NAME[w]) != 0) ++w;
+            ok = w < BOT_WEIGHT_COUNT;
+            if (ok) {
+                in.weights[w] = weight;
+                in.start[w] = start;
+                in.scale[w] = scale;
+                seen |= 1 << w;
+            }
+            continue;
+        }
+        ok = false;
+    }
+    fclose(f);
+
+    ok = ok && seen == (1 << BOT_WEIGHT_COUNT) - 1 && in.pairs > 0 && in.iteration >= 0;
+    if (ok) *t = in;
+    else errno = 0;
+    return ok;
+}
+
+static bool ParseTuned(const char* list, uint32_t* tuned)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    *tuned = 0;
+    for (char* tok = strtok(buf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int w = 0;
+        while (w < BOT_WEIGHT_COUNT && strcmp(tok, BOT_WEIGHT_NAME[w]) != 0) ++w;
+        if (w == BOT_WEIGHT_COUNT) return false;
+        *tuned |= 1u << w;
+    }
+    return *tuned != 0;
+}
+
+// Play iteration t->iteration and step the weights; returns the score
+// difference, plus's score minus minus's, per game
+static double Iterate(Tune* t, int* results)
+{
+    int k = t->iteration;
+    double bigA = t->iterations / 10.0;
+    double ak = t->a / pow(k + 1 + bigA, 0.602);
+    double ck = t->c / pow(k + 1, 0.101);
+
+    uint64_t rng = t->seed ^ (0xD1B54A32D192ED03ull * (uint64_t)(k + 1));
+    float delta[BOT_WEIGHT_COUNT] = { 0 };
+    Match m;
+    BotDefaultConfig(&m.plus, BOT_GREEDY);
+    BotDefaultConfig(&m.minus, BOT_GREEDY);
+    for (int w = 0; w < BOT_WEIGHT_COUNT; ++w) {
+        if (t->tuned & (1u << w)) delta[w] = RngRange(&rng, 2) ? 1.0f : -1.0f;
+        float step = (float)ck * t->scale[w] * delta[w];
+        m.plus.weights[w] = t->weights[w] + step;
+        m.minus.weights[w] = t->weights[w] - step;
+    }
+    m.seed = t->seed + (uint64_t)k * (uint64_t)t->pairs;
+    m.results = results;
+    JobParallelFor(t->pairs, 1, PlayPairs, &m);
+
+    int64_t sum = 0;
+    for (int i = 0; i < t->pairs; ++i) sum += results[i];
+    double diff = (double)sum / (2.0 * t->pairs);  // in [-1, 1]
+
+    for (int w = 0; w < BOT_WEIGHT_COUNT; ++w) {
+        if (delta[w] == 0.0f) continue;
+        t->weights[w] += (float)(ak * diff / (2.0 * ck * delta[w])) * t->scale[w];
+    }
+    t->games += 2 * t->pairs;
+    t->iteration++;
+    return diff;
+}
+
+static void Usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s [--threads T] [--pin] [--iterations N] [--pairs P] [--seed S]\n"
+                    "       [--start SPEC] [--tune NAME,...] [--a A] [--c C]\n"
+                    "       [--checkpoint FILE] [--report SEC]\n", argv0);
+}
+
+int main(int argc, char** argv)
+{
+    static Tune t;
+    int threads = JobsCpuCount();
+    bool pin = false;
+    double reportEvery = 10.0;
+    const char* checkpoint = NULL;
+    BotConfig start;
+    BotDefaultConfig(&start, BOT_GREEDY);
+    t.iterations = 2000;
+    t.pairs = 64;
+    t.seed = 1;
+    t.a = 2.0;
+    t.c = 0.2;
+    t.tuned = ((1u << BOT_WEIGHT_COUNT) - 1) & ~(1u << BOT_W_POINTS);
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--threads") == 0 && hasValue)         threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pin") == 0)                    pin = true;
+        else if (strcmp(argv[i], "--iterations") == 0 && hasValue) t.iterations = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pairs") == 0 && hasValue)      t.pairs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && hasValue)       t.seed = strtoull(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "--a") == 0 && hasValue)          t.a = atof(argv[++i]);
+        else if (strcmp(argv[i], "--c") == 0 && hasValue)          t.c = atof(argv[++i]);
+        else if (strcmp(argv[i], "--checkpoint") == 0 && hasValue) checkpoint = argv[++i];
+        else if (strcmp(argv[i], "--report") == 0 && hasValue)     reportEvery = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tune") == 0 && hasValue) {
+            if (!ParseTuned(argv[++i], &t.tuned)) {
+                fprintf(stderr, "reeftune: bad weight list '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--start") == 0 && hasValue) {
+            if (!BotParseConfig(argv[++i], &start) || start.kind != BOT_GREEDY) {
+                fprintf(stderr, "reeftune: bad greedy bot spec '%s'\n", argv[i]);
+                return 1;
+            }
+        } else {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+    if (t.iterations < 1 || t.pairs < 1 || t.a <= 0.0 || t.c <= 0.0) { Usage(argv[0]); return 1; }
+    if (threads < 1) threads = 1;
+
+    for (int w = 0; w < BOT_WEIGHT_COUNT; ++w) {
+        t.start[w] = t.weights[w] = start.weights[w];
+        t.scale[w] = fabsf(start.weights[w]) > TUNE_MIN_SCALE ? fabsf(start.weights[w]) : TUNE_MIN_SCALE;
+    }
+    if (checkpoint != NULL) {
+        if (LoadCheckpoint(checkpoint, &t)) {
+            fprintf(stderr, "reeftune: resuming %s at iteration %d of %d\n", checkpoint, t.iteration, t.iterations);
+        } else if (errno != ENOENT) {
+            fprintf(stderr, "reeftune: %s is not a reeftune checkpoint\n", checkpoint);
+            return 1;
+        }
+    }
+
+    int* results = calloc((size_t)t.pairs, sizeof(int));
+    if (results == NULL || !JobsStart(threads, pin)) { perror("reeftune"); return 1; }
+
+    char spec[256];
+    double begin = Now(), nextReport = begin + reportEvery;
+    int64_t gamesBefore = t.games;
+    double recent = 0.0;  // smoothed score difference, for the report
+    while (t.iteration < t.iterations) {
+        recent = 0.95 * recent + 0.05 * Iterate(&t, results);
+        if (checkpoint != NULL && !SaveCheckpoint(checkpoint, &t)) {
+            fprintf(stderr, "reeftune: cannot write %s\n", checkpoint);
+            break;
+        }
+        if (reportEvery > 0 && Now() >= nextReport) {
+            double rate = (double)(t.games - gamesBefore) / (Now() - begin);
+            SpecString(t.weights, spec, sizeof(spec));
+            fprintf(stderr, "reeftune: iteration %d of %d, %.0f games/s (%.0fk/h), diff %+.3f  %s\n", t.iteration,
+                    t.iterations, rate, rate * 3.6, recent, spec);
+            nextReport += reportEvery;
+        }
+    }
+    JobsStop();
+    free(results);
+
+    double elapsed = Now() - begin;
+    fprintf(stderr, "reeftune: %lld games this run in %.1fs on %d threads, %lld in all\n",
+            (long long)(t.games - gamesBefore), elapsed, threads, (long long)t.games);
+    SpecString(t.weights, spec, sizeof(spec));
+    printf("%s\n", spec);
+    return t.iteration < t.iterations;
+}